@@ -1,11 +1,21 @@
 /*
- * 双电机控制主程序
+ * 多电机底盘控制主程序
+ *
+ * 电机轴数量和引脚由 motor_axis.c 中的轴描述表决定 (MOTOR_AXIS_NUM),
+ * 控制线程每个节拍对所有轴循环一次
  *
  * 主要功能已拆分到各个模块:
+ * - motor_axis.c: 电机轴描述表
  * - motor_control.c: 电机控制函数和 MSH 命令
  * - encoder.c: 编码器计数和打印线程
  * - motor_pwm.c: PWM 驱动
  * - motor_gpio.c: GPIO 方向控制
+ * - setpoint.c: 轨迹插值和目标值加速度限制
+ * - chassis_kin.c: 差速运动学和里程计积分
+ * - motor_shm.c: 大小核共享内存状态块
+ * - autotune.c: PID 自整定 (阶跃 / 继电实验)
+ * - ff_table.c: 前馈查表和开环标定
+ * - health.c: 指令超时、堵转和编码器无脉冲检测
  */
 
 #include <rtdevice.h>
@@ -14,37 +24,433 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "autotune.h"
+#include "bench.h"
+#include "chassis_kin.h"
 #include "common.h"
+#include "control_tick.h"
 #include "encoder.h"
+#include "ff_table.h"
+#include "health.h"
+#include "hrtime.h"
+#include "motor_axis.h"
 #include "motor_control.h"
 #include "motor_gpio.h"
 #include "motor_pwm.h"
+#include "motor_shm.h"
 
 #include "pid.h"
+#include "pid_fixed.h"
+#include "profiler.h"
 #include "rpmsg_motor.h"
+#include "seqlock.h"
+#include "setpoint.h"
+#include "telemetry.h"
+#include "trace.h"
 
 /* ================= 目标速度控制 ================= */
 
-/* 电机目标方向: 0=停止, 1=正转, 2=反转 */
-static int motor1_target_dir = 0;
-static int motor2_target_dir = 0;
+/*
+ * 目标值邮箱: RPMsg 回调 / MSH 写, 底盘控制线程读
+ * 使用 seqlock, 写端不阻塞, 读端不获取内核对象
+ */
+struct chassis_target {
+  int dir[MOTOR_AXIS_NUM];       /* 各轴目标方向: 0=停止, 1=正转, 2=反转 */
+  double speed[MOTOR_AXIS_NUM];  /* 各轴目标转速: 单位 转/秒 (r/s) */
+  rt_uint32_t generation;        /* 每次写入递增 */
+  rt_bool_t immediate;           /* 急停: 不经过加速度限制直接生效 */
+  /* 时延测量: 来自二进制 CMD 帧的目标值带序号和时间戳 */
+  rt_bool_t cmd_tagged;
+  rt_uint32_t cmd_seq;          /* CMD 帧序号 */
+  rt_uint32_t cmd_timestamp_us; /* CMD 帧发送方时间戳 (原样回显) */
+  rt_uint64_t cmd_rx_hr;        /* 小核收到 CMD 的 hrtime */
+};
+
+static struct chassis_target target_box;
+static seqlock_t target_lock = SEQLOCK_INIT;
+
+/*
+ * 状态邮箱: 底盘控制线程每周期写, RPMsg 反馈线程读
+ */
+struct chassis_status {
+  int dir[MOTOR_AXIS_NUM];
+  int speed_mrs[MOTOR_AXIS_NUM];    /* 实际转速 (毫转/秒) */
+  int setpoint_mrs[MOTOR_AXIS_NUM]; /* 本周期使用的目标转速 (毫转/秒, 符号表示方向) */
+  rt_uint32_t generation;           /* 本周期使用的目标值序号 */
+  struct chassis_cmd_echo echo;     /* 最近一条已输出到 PWM 的 CMD */
+};
+
+static struct chassis_status status_box;
+static seqlock_t status_lock = SEQLOCK_INIT;
+
+/*
+ * 参数邮箱: CFG 写, 底盘控制线程在周期开始时检查 generation 并应用
+ */
+struct chassis_cfg {
+  double reduction_ratio; /* 编码器减速比 */
+  double ff_factor;       /* 前馈控制系数 (转速到占空比) */
+  double kp;
+  double ki;
+  double kd;
+  rt_uint32_t generation;
+};
+
+static struct chassis_cfg cfg_box = {
+    MOTOR_REDUCTION_RATIO, 0.3, 0.05, 0.2, 0.01, 0,
+};
+static seqlock_t cfg_lock = SEQLOCK_INIT;
+
+/*
+ * PID 控制器类型
+ * 定义 PID_USING_FIXED (SConscript) 时使用 Q16.16 定点实现
+ */
+#ifdef PID_USING_FIXED
+typedef PID_Fixed_Controller chassis_pid_t;
+#else
+typedef PID_Controller chassis_pid_t;
+#endif
+
+/*
+ * 各轴控制状态 (只在底盘控制线程中访问)
+ * 按字段连续存放 (SoA), 控制循环逐字段遍历所有轴
+ */
+static struct {
+  chassis_pid_t pid[MOTOR_AXIS_NUM];
+  float actual_speed[MOTOR_AXIS_NUM]; /* 沿目标方向的实测转速 (转/秒) */
+  float duty[MOTOR_AXIS_NUM];         /* 本周期输出占空比 */
+  struct setpoint_shaper shaper[MOTOR_AXIS_NUM]; /* 目标值加速度限制 */
+  struct ff_table ff[MOTOR_AXIS_NUM];            /* 前馈表副本, 版本变化时更新 */
+  int applied_dir[MOTOR_AXIS_NUM];    /* 上一节拍输出的方向 */
+} chassis_axes;
+
+/* 每个指令通道的反馈轴 (轴描述表中该通道的第一个轴) */
+static int chassis_channel_axis[MOTOR_PROTO_WHEELS];
+
+/**
+ * @brief 读取目标值快照
+ */
+static void chassis_target_read(struct chassis_target *out) {
+  rt_uint32_t seq;
+
+  do {
+    seq = seqlock_read_begin(&target_lock);
+    *out = target_box;
+  } while (seqlock_read_retry(&target_lock, seq));
+}
+
+/**
+ * @brief 读取参数快照
+ */
+static void chassis_cfg_read(struct chassis_cfg *out) {
+  rt_uint32_t seq;
+
+  do {
+    seq = seqlock_read_begin(&cfg_lock);
+    *out = cfg_box;
+  } while (seqlock_read_retry(&cfg_lock, seq));
+}
+
+/**
+ * @brief 读取状态快照
+ */
+static void chassis_status_read(struct chassis_status *out) {
+  rt_uint32_t seq;
+
+  do {
+    seq = seqlock_read_begin(&status_lock);
+    *out = status_box;
+  } while (seqlock_read_retry(&status_lock, seq));
+}
 
-/* 电机目标转速: 单位 转/秒 (r/s) */
-static double motor1_target_speed = 0.0;
-static double motor2_target_speed = 0.0;
+/**
+ * @brief 方向 + 转速转换为有符号毫转/秒
+ */
+static int chassis_signed_mrs(int dir, double speed) {
+  if (dir == 1)
+    return (int)(speed * 1000);
+  if (dir == 2)
+    return -(int)(speed * 1000);
+  return 0;
+}
 
-/* 前馈控制系数 (转速到占空比) */
-static double ff_factor = 0.3;
+/**
+ * @brief 方向 + 转速转换为有符号转/秒
+ */
+static float chassis_signed_speed(int dir, double speed) {
+  if (dir == 1)
+    return (float)speed;
+  if (dir == 2)
+    return -(float)speed;
+  return 0.0f;
+}
+
+/**
+ * @brief 沿目标方向的实测转速 (转/秒)
+ *        正交模式下轮子与目标方向相反转动时为负值, PID 会加大输出
+ */
+static float chassis_speed_along(int dir, float sspeed, float speed) {
+#ifdef ENCODER_USING_QUADRATURE
+  (void)speed;
+  return (dir == 2) ? -sspeed : sspeed;
+#else
+  (void)dir;
+  (void)sspeed;
+  return speed;
+#endif
+}
+
+/**
+ * @brief 编码器增量按转动方向补符号
+ *        A 相模式下取产生这段增量时输出的方向
+ */
+static rt_int32_t chassis_signed_delta(int dir, rt_int32_t sdelta) {
+#ifdef ENCODER_USING_QUADRATURE
+  (void)dir;
+  return sdelta;
+#else
+  return (dir == 2) ? -sdelta : sdelta;
+#endif
+}
 
-/* 编码器减速比 */
-static double reduction_ratio = MOTOR_REDUCTION_RATIO;
+/**
+ * @brief 有符号转速对应的方向 (0=停止, 1=正转, 2=反转)
+ */
+static int chassis_measured_dir(float sspeed) {
+  if (sspeed > 0.0f)
+    return 1;
+  if (sspeed < 0.0f)
+    return 2;
+  return 0;
+}
+
+/**
+ * @brief 初始化 PID 控制器, 可选项取 common.h 中的 CHASSIS_PID_*
+ */
+static void chassis_pid_init(chassis_pid_t *pid, const struct chassis_cfg *cfg,
+                             float dt) {
+  /* 参数: kp, ki, kd, dt, i_limit, out_limit */
+#ifdef PID_USING_FIXED
+  PID_Fixed_Init(pid, (float)cfg->kp, (float)cfg->ki, (float)cfg->kd, dt,
+                 10.0f, 1.0f);
+  PID_Fixed_Set_AntiWindup(pid, CHASSIS_PID_AW_MODE, CHASSIS_PID_AW_KB,
+                           (float)cfg->kp, (float)cfg->ki, dt);
+  PID_Fixed_Set_Derivative(pid, CHASSIS_PID_D_ON_MEAS, CHASSIS_PID_D_TAU, dt);
+  PID_Fixed_Set_Slew(pid, CHASSIS_PID_SLEW_RATE, dt);
+#else
+  PID_Controller_Init(pid, (float)cfg->kp, (float)cfg->ki, (float)cfg->kd, dt,
+                      10.0f, 1.0f);
+  PID_Set_AntiWindup(pid, CHASSIS_PID_AW_MODE, CHASSIS_PID_AW_KB);
+  PID_Set_Derivative(pid, CHASSIS_PID_D_ON_MEAS, CHASSIS_PID_D_TAU);
+  PID_Set_Slew(pid, CHASSIS_PID_SLEW_RATE);
+#endif
+}
+
+/**
+ * @brief 前馈 + PID 闭环, 返回占空比
+ */
+static float chassis_pid_update(chassis_pid_t *pid, float setpoint,
+                                float feedback, float pwm_ff) {
+#ifdef PID_USING_FIXED
+  pid->setpoint = PID_Q16_FROM_FLOAT(setpoint);
+  return PID_Q16_TO_FLOAT(PID_Fixed_FF_Update(
+      pid, PID_Q16_FROM_FLOAT(feedback), PID_Q16_FROM_FLOAT(pwm_ff)));
+#else
+  pid->setpoint = setpoint;
+  return PID_FF_Update(pid, feedback, pwm_ff);
+#endif
+}
+
+/**
+ * @brief 读取 PID 各项输出 (遥测使用)
+ */
+static void chassis_pid_terms(const chassis_pid_t *pid, float *p_out,
+                              float *i_out, float *d_out) {
+#ifdef PID_USING_FIXED
+  *p_out = PID_Q16_TO_FLOAT(pid->p_out);
+  *i_out = PID_Q16_TO_FLOAT(pid->i_out);
+  *d_out = PID_Q16_TO_FLOAT(pid->d_out);
+#else
+  *p_out = pid->p_out;
+  *i_out = pid->i_out;
+  *d_out = pid->d_out;
+#endif
+}
+
+/**
+ * @brief 转换为遥测定点值 (1/10000), 超出 int16 范围时饱和
+ */
+static rt_int16_t chassis_telemetry_q4(float value) {
+  float scaled = value * 10000.0f;
+
+  if (scaled > 32767.0f)
+    return 32767;
+  if (scaled < -32768.0f)
+    return -32768;
+  return (rt_int16_t)scaled;
+}
+
+/**
+ * @brief 填充单个轮子的遥测数据
+ *        A 相模式下增量和转速没有方向, 按目标方向补符号
+ */
+static void chassis_telemetry_wheel(struct motor_proto_telemetry_wheel *wheel,
+                                    int dir, double target_speed,
+                                    rt_int32_t sdelta, float sspeed,
+                                    float duty, const chassis_pid_t *pid) {
+  float sign = (dir == 2) ? -1.0f : 1.0f;
+  float p_out, i_out, d_out;
+
+#ifdef ENCODER_USING_QUADRATURE
+  wheel->delta = sdelta;
+  wheel->speed_mrs = (int32_t)(sspeed * 1000);
+#else
+  wheel->delta = (dir == 2) ? -sdelta : sdelta;
+  wheel->speed_mrs = (int32_t)(sign * sspeed * 1000);
+#endif
+  wheel->setpoint_mrs = chassis_signed_mrs(dir, target_speed);
+  wheel->duty = chassis_telemetry_q4(sign * duty);
+  chassis_pid_terms(pid, &p_out, &i_out, &d_out);
+  wheel->p_out = chassis_telemetry_q4(sign * p_out);
+  wheel->i_out = chassis_telemetry_q4(sign * i_out);
+  wheel->d_out = chassis_telemetry_q4(sign * d_out);
+}
+
+/**
+ * @brief 计算本节拍进入 PID 的目标值 (只在底盘控制线程中调用)
+ *        有轨迹时取轨迹插值, 否则取 CMD 目标值, 之后逐轴限制加速度;
+ *        急停跳过限制, 已到达 CMD 目标值时原样使用
+ * @param[out] dir 各轴方向
+ * @param[out] speed 各轴转速 (转/秒)
+ * @return RT_TRUE 本节拍目标值取自轨迹
+ */
+static rt_bool_t chassis_reference_update(const struct chassis_target *target,
+                                          rt_uint64_t now, int *dir,
+                                          double *speed) {
+  struct setpoint_limits lim;
+  float current[MOTOR_PROTO_WHEELS];
+  float traj[MOTOR_PROTO_WHEELS];
+  float dt = control_tick_get_dt();
+  rt_bool_t traj_active;
+  float want, value;
+  int ch, i;
+
+  for (ch = 0; ch < MOTOR_PROTO_WHEELS; ch++)
+    current[ch] = chassis_axes.shaper[chassis_channel_axis[ch]].value;
+  traj_active = setpoint_traj_sample(now, current, traj);
+  setpoint_get_limits(&lim);
+
+  for (i = 0; i < MOTOR_AXIS_NUM; i++) {
+    if (traj_active) {
+      ch = (motor_axis_table[i].cmd_channel == MOTOR_AXIS_CHANNEL_LEFT) ? 0 : 1;
+      want = traj[ch];
+    } else {
+      want = chassis_signed_speed(target->dir[i], target->speed[i]);
+      if (target->immediate)
+        setpoint_shaper_reset(&chassis_axes.shaper[i], want);
+    }
+
+    value = setpoint_shaper_step(&chassis_axes.shaper[i], want, dt, &lim);
+    if (!traj_active && value == want) {
+      dir[i] = target->dir[i];
+      speed[i] = target->speed[i];
+    } else {
+      dir[i] = chassis_measured_dir(value);
+      speed[i] = (value < 0.0f) ? -value : value;
+    }
+  }
+  return traj_active;
+}
+
+/**
+ * @brief 填写共享内存状态块 (轮速记录与遥测相同, 位姿取里程计快照)
+ */
+static void chassis_shm_fill(struct motor_shm_state *state,
+                             const struct motor_proto_telemetry_record *rec,
+                             rt_bool_t traj_active, rt_uint32_t cmd_seq,
+                             rt_uint32_t faults) {
+  static rt_uint32_t last_overruns = 0;
+  struct chassis_odom odom;
+  rt_uint32_t overruns = control_tick_get_overruns();
+  int i;
+
+  chassis_kin_get_odom(&odom);
+  state->tick++;
+  state->timestamp_us = rec->timestamp_us;
+  state->flags = traj_active ? MOTOR_SHM_FLAG_TRAJ : 0;
+  if (autotune_active() || ff_cal_active())
+    state->flags |= MOTOR_SHM_FLAG_TUNING;
+  for (i = 0; i < MOTOR_AXIS_NUM; i++) {
+    if (chassis_axes.duty[i] >= 1.0f || chassis_axes.duty[i] <= -1.0f)
+      state->flags |= MOTOR_SHM_FLAG_SATURATED;
+  }
+  if (overruns != last_overruns)
+    state->flags |= MOTOR_SHM_FLAG_OVERRUN;
+  state->flags |= (faults << MOTOR_SHM_FLAG_FAULT_SHIFT) & MOTOR_SHM_FLAG_FAULT_MASK;
+  last_overruns = overruns;
+  state->overruns = overruns;
+  state->cmd_seq = cmd_seq;
+  state->x_mm = (int32_t)(odom.x * 1000.0);
+  state->y_mm = (int32_t)(odom.y * 1000.0);
+  state->yaw_urad = (int32_t)(odom.yaw * 1000000.0);
+  state->v_mmps = (int32_t)(odom.v * 1000.0f);
+  state->w_mradps = (int32_t)(odom.w * 1000.0f);
+  rt_memcpy(state->wheel, rec->wheel, sizeof(state->wheel));
+}
+
+/**
+ * @brief 前馈占空比: 有标定表时查表 (含死区补偿), 否则线性 ff_factor * 转速
+ */
+static float chassis_feedforward(int axis, const struct chassis_cfg *cfg,
+                                 double speed) {
+  if (chassis_axes.ff[axis].points >= 2)
+    return ff_table_eval(&chassis_axes.ff[axis], (float)speed);
+  return (float)(cfg->ff_factor * speed);
+}
+
+/**
+ * @brief 故障快速关断 (底盘控制线程中, 检测到故障的同一节拍)
+ *        脉宽置 0 后两个方向引脚拉高刹车; 锁存故障同时把目标值置 0,
+ *        清除后不恢复之前的目标值
+ */
+static void chassis_fault_cutoff(rt_uint32_t faults, rt_uint32_t new_faults) {
+  motors_stop();
+  motors_brake();
+  /* 绕过了执行器缓存, 恢复后重新写入驱动 */
+  motor_actuator_invalidate(-1);
+  if (new_faults & HEALTH_FAULT_LATCHED)
+    chassis_emergency_stop();
+  TRACE(TRACE_LEVEL_ERROR, TRACE_EVT_FAULT, (rt_int32_t)faults,
+        (rt_int32_t)health_get_fault_axes());
+}
+
+/**
+ * @brief 使用参数快照初始化所有轴的 PID 控制器
+ */
+static void chassis_apply_cfg(const struct chassis_cfg *cfg) {
+  float dt = control_tick_get_dt();
+  int i;
 
-/* 互斥锁保护目标值 */
-static rt_mutex_t target_mutex = RT_NULL;
+  for (i = 0; i < MOTOR_AXIS_NUM; i++)
+    chassis_pid_init(&chassis_axes.pid[i], cfg, dt);
+}
 
-/* PID 控制器实例 */
-static PID_Controller pid_motor1;
-static PID_Controller pid_motor2;
+/**
+ * @brief 按轴描述表建立指令通道到反馈轴的映射
+ *        没有登记轴的通道退回到同号轴
+ */
+static void chassis_channel_map_init(void) {
+  int ch, i;
+
+  for (ch = 0; ch < MOTOR_PROTO_WHEELS; ch++) {
+    chassis_channel_axis[ch] = ch;
+    for (i = 0; i < MOTOR_AXIS_NUM; i++) {
+      if (motor_axis_table[i].cmd_channel == ch) {
+        chassis_channel_axis[ch] = i;
+        break;
+      }
+    }
+  }
+}
 
 /* ================= 底盘控制线程 ================= */
 
@@ -54,60 +460,229 @@ static PID_Controller pid_motor2;
 
 static rt_thread_t chassis_ctrl_thread = RT_NULL;
 
+/* 控制节拍信号量 */
+static rt_sem_t chassis_tick_sem = RT_NULL;
+
+/* 基准测试: 控制线程记录接下来 chassis_bench_left 个节拍的执行时间 */
+static struct bench_stats *volatile chassis_bench_stats = RT_NULL;
+static volatile rt_uint32_t chassis_bench_left = 0;
+
 /**
  * @brief 底盘控制线程入口函数
- *        以 30Hz 频率执行前馈控制 + PID 闭环控制
+ *        每个控制节拍执行一次 采样 -> 前馈控制 + PID 闭环控制 -> PWM
+ *        未定义 ENCODER_SAMPLE_INLINE 时采样线程优先级更高, 同一节拍内先完成采样
  */
 static void chassis_ctrl_thread_entry(void *parameter) {
   (void)parameter;
 
-  int dir1, dir2;
-  double target_speed1, target_speed2;
-  double duty1, duty2;
+  struct chassis_target target;
+  int ref_dir[MOTOR_AXIS_NUM];
+  double ref_speed[MOTOR_AXIS_NUM];
+  struct chassis_cfg cfg;
+  struct encoder_sample sample;
+  struct motor_proto_telemetry_record telemetry_rec;
+  struct motor_shm_state shm_state;
+  rt_bool_t traj_active;
+  rt_bool_t tuning = RT_FALSE;
+  rt_uint32_t faults, last_faults = 0;
+  rt_int32_t odom_counts[MOTOR_PROTO_WHEELS];
+  rt_uint32_t odom_sample_seq = 0;
+  rt_uint64_t telemetry_last_hr;
+  rt_uint32_t telemetry_us = 0;
+  rt_uint32_t cfg_generation;
+  rt_uint32_t rate_generation;
+  rt_uint32_t applied_generation = 0;
+  rt_uint32_t ff_generation;
+  rt_uint64_t apply_hr;
+  rt_uint64_t tick_start;
+  rt_base_t level;
+  int i, axis;
+
+  chassis_cfg_read(&cfg);
+  cfg_generation = cfg.generation;
+  rate_generation = control_tick_get_generation();
+  ff_generation = ff_table_snapshot(chassis_axes.ff);
+  telemetry_last_hr = hrtime_now();
+  rt_memset(&shm_state, 0, sizeof(shm_state));
 
   while (1) {
-    /* 从编码器模块获取共享的速度值 (转/秒) */
-    float actual_speed1 = encoder_get_shared_speed1();
-    float actual_speed2 = encoder_get_shared_speed2();
-
-    /* 获取 delta 用于调试 */
-    rt_uint32_t delta1 = encoder_get_shared_delta1();
-    rt_uint32_t delta2 = encoder_get_shared_delta2();
-
-    /* 获取目标值 (加锁保护) */
-    rt_mutex_take(target_mutex, RT_WAITING_FOREVER);
-    dir1 = motor1_target_dir;
-    dir2 = motor2_target_dir;
-    target_speed1 = motor1_target_speed; // 转/秒
-    target_speed2 = motor2_target_speed;
-    rt_mutex_release(target_mutex);
-
-    /* 使用前馈模型计算 PWM 占空比 */
-    float pwm_ff1 = ff_factor * target_speed1; // 简单线性前馈
-    float pwm_ff2 = ff_factor * target_speed2;
-
-    /* 设置 PID 控制器的目标值 */
-    pid_motor1.setpoint = (float)target_speed1;
-    pid_motor2.setpoint = (float)target_speed2;
-
-    /* 使用 PID_FF_Update 进行前馈+PID闭环控制 */
-    // 转速到 PWM 占空比系数约为 0.25~0.28, 最大占空比 1.0
-    duty1 = PID_FF_Update(&pid_motor1, actual_speed1, pwm_ff1);
-    duty2 = PID_FF_Update(&pid_motor2, actual_speed2, pwm_ff2);
-
-    /* 执行电机控制 */
-    motor_control(1, dir1, (float)duty1);
-    motor_control(2, dir2, (float)duty2);
-
-    /* 调试打印 (速度单位: 转/秒, mr/s = 毫转/秒) */
-    rt_kprintf(
-        "[Chassis] D1=%u D2=%u S1=%d S2=%d mr/s | T:%d,%d mr/s D:%d%%,%d%%\n",
-        delta1, delta2, (int)(actual_speed1 * 1000),
-        (int)(actual_speed2 * 1000), (int)(target_speed1 * 1000),
-        (int)(target_speed2 * 1000), (int)(duty1 * 100), (int)(duty2 * 100));
-
-    /* 休眠 CHASSIS_CTRL_INTERVAL_MS, 实现 1000/CHASSIS_CTRL_INTERVAL_MS Hz 控制频率 */
-    rt_thread_mdelay(CHASSIS_CTRL_INTERVAL_MS);
+    /* 等待控制节拍 */
+    rt_sem_take(chassis_tick_sem, RT_WAITING_FOREVER);
+    tick_start = hrtime_now();
+    profiler_loop_begin();
+
+    /* 参数变化时在周期边界重新初始化 PID */
+    chassis_cfg_read(&cfg);
+    if (cfg.generation != cfg_generation) {
+      chassis_apply_cfg(&cfg);
+      cfg_generation = cfg.generation;
+      TRACE(TRACE_LEVEL_INFO, TRACE_EVT_CFG, (rt_int32_t)cfg.generation,
+            (rt_int32_t)(cfg.kp * 1000), (rt_int32_t)(cfg.ki * 1000),
+            (rt_int32_t)(cfg.kd * 1000), (rt_int32_t)(cfg.ff_factor * 1000));
+    }
+    if (ff_table_generation() != ff_generation)
+      ff_generation = ff_table_snapshot(chassis_axes.ff);
+
+    /* 控制频率变化: PID 按新的 dt 重新初始化; 开环实验按节拍计时, 直接中止 */
+    if (control_tick_get_generation() != rate_generation) {
+      rate_generation = control_tick_get_generation();
+      autotune_abort();
+      ff_cal_abort();
+      chassis_apply_cfg(&cfg);
+      TRACE(TRACE_LEVEL_INFO, TRACE_EVT_RATE, (rt_int32_t)control_tick_get_hz(),
+            (rt_int32_t)rate_generation);
+    }
+
+#ifdef ENCODER_SAMPLE_INLINE
+    /* 在控制节拍内对所有编码器同时采样 */
+    encoder_sample_update();
+#endif
+
+    /* 获取各轴时间一致的采样结果 (转/秒) */
+    encoder_get_sample(&sample);
+
+    /* 里程计: 每个指令通道取其反馈轴的原始增量, 每个采样只积分一次 */
+    if (sample.seq != odom_sample_seq) {
+      for (i = 0; i < MOTOR_PROTO_WHEELS; i++) {
+        axis = chassis_channel_axis[i];
+        odom_counts[i] =
+            chassis_signed_delta(chassis_axes.applied_dir[axis], sample.sdelta[axis]);
+      }
+      chassis_kin_odom_update(odom_counts, encoder_get_counts_per_rev(),
+                              sample.hr_time);
+      odom_sample_seq = sample.seq;
+    }
+
+    /* 获取目标值快照 (无锁) */
+    chassis_target_read(&target);
+
+    /* 本节拍目标值: 轨迹插值或 CMD, 经加速度限制 */
+    traj_active = chassis_reference_update(&target, tick_start, ref_dir, ref_speed);
+
+    /* 自整定 / 前馈标定结束: PID 从零开始, 目标值从静止开始加速 */
+    if (tuning && !autotune_active() && !ff_cal_active()) {
+      chassis_apply_cfg(&cfg);
+      for (i = 0; i < MOTOR_AXIS_NUM; i++)
+        setpoint_shaper_reset(&chassis_axes.shaper[i], 0.0f);
+    }
+    tuning = autotune_active() || ff_cal_active();
+
+    /* 开环实验期间各轴正转, 目标值不生效 */
+    if (tuning) {
+      for (i = 0; i < MOTOR_AXIS_NUM; i++) {
+        ref_dir[i] = 1;
+        ref_speed[i] = 0.0;
+      }
+    }
+
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
+      chassis_axes.actual_speed[i] =
+          chassis_speed_along(ref_dir[i], sample.sspeed[i], sample.speed[i]);
+
+    /* 健康检查: 上一节拍的占空比对照本节拍的编码器增量 */
+    faults = health_update(&sample, chassis_axes.duty, tuning,
+                           control_tick_get_dt());
+    if (faults != 0) {
+      /* 故障期间输出保持为 0, 首次检测到时立即关断并刹车 */
+      if (faults & ~last_faults)
+        chassis_fault_cutoff(faults, faults & ~last_faults);
+      for (i = 0; i < MOTOR_AXIS_NUM; i++) {
+        ref_dir[i] = 0;
+        ref_speed[i] = 0.0;
+        chassis_axes.duty[i] = 0.0f;
+      }
+    } else if (last_faults != 0) {
+      /* 故障清除: PID 从零开始, 目标值从静止开始加速 */
+      chassis_apply_cfg(&cfg);
+      for (i = 0; i < MOTOR_AXIS_NUM; i++)
+        setpoint_shaper_reset(&chassis_axes.shaper[i], 0.0f);
+    }
+    last_faults = faults;
+
+    /* 前馈+PID闭环控制 (浮点 PID_FF_Update 或定点 PID_Fixed_FF_Update) */
+    // 前馈查表或线性前馈, 转速到 PWM 占空比系数约为 0.25~0.28, 最大占空比 1.0
+    if (faults == 0 &&
+        (!tuning ||
+         !(autotune_update(chassis_axes.actual_speed, control_tick_get_dt(),
+                           chassis_axes.duty) ||
+           ff_cal_update(chassis_axes.actual_speed, control_tick_get_dt(),
+                         chassis_axes.duty)))) {
+      for (i = 0; i < MOTOR_AXIS_NUM; i++)
+        chassis_axes.duty[i] = chassis_pid_update(
+            &chassis_axes.pid[i], (float)ref_speed[i],
+            chassis_axes.actual_speed[i],
+            chassis_feedforward(i, &cfg, ref_speed[i]));
+    }
+
+    /* 执行电机控制 (各轴脉宽在同一个临界区内更新), 故障期间保持刹车 */
+    if (faults == 0)
+      motors_control_all(ref_dir, chassis_axes.duty);
+    apply_hr = hrtime_now();
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
+      chassis_axes.applied_dir[i] = ref_dir[i];
+
+    /* 发布状态快照 */
+    level = seqlock_write_begin(&status_lock);
+    if (target.generation != applied_generation && target.cmd_tagged) {
+      /* 新的 CMD 在本周期首次输出到 PWM */
+      status_box.echo.valid = RT_TRUE;
+      status_box.echo.cmd_seq = target.cmd_seq;
+      status_box.echo.cmd_timestamp_us = target.cmd_timestamp_us;
+      status_box.echo.rx_to_apply_us = hrtime_to_us(apply_hr - target.cmd_rx_hr);
+      status_box.echo.apply_hr = apply_hr;
+    }
+    applied_generation = target.generation;
+    for (i = 0; i < MOTOR_AXIS_NUM; i++) {
+#ifdef ENCODER_USING_QUADRATURE
+      /* 正交模式: 方向取自实测转速符号, 被动转动时也正确 */
+      status_box.dir[i] = chassis_measured_dir(sample.sspeed[i]);
+#else
+      /* A 相模式编码器不带方向信息, 以目标方向作为实际方向 */
+      status_box.dir[i] = ref_dir[i];
+#endif
+      status_box.speed_mrs[i] = (int)(sample.speed[i] * 1000);
+      status_box.setpoint_mrs[i] = chassis_signed_mrs(ref_dir[i], ref_speed[i]);
+    }
+    status_box.generation = target.generation;
+    seqlock_write_end(&status_lock, level);
+
+    /* 逐周期记录 (每个指令通道取其反馈轴), 时间戳由 hrtime 增量累加 (us, 允许回绕) */
+    telemetry_us += hrtime_to_us(sample.hr_time - telemetry_last_hr);
+    telemetry_last_hr = sample.hr_time;
+    telemetry_rec.timestamp_us = telemetry_us;
+    for (i = 0; i < MOTOR_PROTO_WHEELS; i++) {
+      axis = chassis_channel_axis[i];
+      chassis_telemetry_wheel(&telemetry_rec.wheel[i], ref_dir[axis],
+                              ref_speed[axis], sample.sdelta[axis],
+                              sample.sspeed[axis], chassis_axes.duty[axis],
+                              &chassis_axes.pid[axis]);
+    }
+    if (telemetry_is_enabled())
+      telemetry_push(&telemetry_rec);
+
+    /* 共享内存状态块 (大核随时读取, 不经过 RPMsg) */
+    chassis_shm_fill(&shm_state, &telemetry_rec, traj_active,
+                     status_box.echo.cmd_seq, faults);
+    motor_shm_publish(&shm_state);
+
+    /* 通知反馈线程 (按抽取系数发送, 与本节拍同相) */
+    rpmsg_motor_notify_sample();
+
+    /* 调试记录 (速度单位: mr/s = 毫转/秒), 用 msh "trace dump" 查看 */
+    TRACE(TRACE_LEVEL_DEBUG, TRACE_EVT_CHASSIS, (rt_int32_t)sample.delta[0],
+          (rt_int32_t)sample.delta[1],
+          (rt_int32_t)(chassis_axes.actual_speed[0] * 1000),
+          (rt_int32_t)(chassis_axes.actual_speed[1] * 1000),
+          (rt_int32_t)(ref_speed[0] * 1000),
+          (rt_int32_t)(ref_speed[1] * 1000),
+          (rt_int32_t)(chassis_axes.duty[0] * 100),
+          (rt_int32_t)(chassis_axes.duty[1] * 100));
+
+    if (chassis_bench_left > 0) {
+      bench_stats_add(chassis_bench_stats, hrtime_now() - tick_start);
+      chassis_bench_left--;
+    }
+    profiler_loop_end();
   }
 }
 
@@ -116,13 +691,20 @@ static void chassis_ctrl_thread_entry(void *parameter) {
  * @return RT_EOK 成功, -RT_ERROR 失败
  */
 static rt_err_t chassis_ctrl_thread_start(void) {
+  chassis_tick_sem = rt_sem_create("chs_tk", 0, RT_IPC_FLAG_FIFO);
+  if (chassis_tick_sem == RT_NULL ||
+      control_tick_attach(chassis_tick_sem) != RT_EOK) {
+    rt_kprintf("[Chassis] Failed to attach control tick!\n");
+    return -RT_ERROR;
+  }
+
   chassis_ctrl_thread = rt_thread_create(
       "chassis", chassis_ctrl_thread_entry, RT_NULL,
       CHASSIS_CTRL_THREAD_STACK_SIZE, CHASSIS_CTRL_THREAD_PRIORITY,
       CHASSIS_CTRL_THREAD_TIMESLICE);
   if (chassis_ctrl_thread != RT_NULL) {
     rt_thread_startup(chassis_ctrl_thread);
-    rt_kprintf("[Chassis] Control thread started (%dHz)\n", 1000 / CHASSIS_CTRL_INTERVAL_MS);
+    rt_kprintf("[Chassis] Control thread started (%dHz)\n", control_tick_get_hz());
     return RT_EOK;
   } else {
     rt_kprintf("[Chassis] Failed to create control thread!\n");
@@ -132,28 +714,108 @@ static rt_err_t chassis_ctrl_thread_start(void) {
 
 /* ================= 供 RPMsg 模块调用的接口 ================= */
 
+/**
+ * @brief 写入按指令通道分配的目标值
+ *        写入直接目标值时取消正在执行的轨迹
+ * @param tagged 目标值是否来自带序号的 CMD 帧 (用于时延回显)
+ * @param immediate 跳过加速度限制 (急停)
+ */
+static void chassis_write_target(int dir1, double speed1, int dir2,
+                                 double speed2, rt_bool_t tagged,
+                                 rt_uint32_t cmd_seq,
+                                 rt_uint32_t cmd_timestamp_us,
+                                 rt_bool_t immediate) {
+  rt_uint64_t rx_hr = hrtime_now();
+  rt_base_t level;
+  int i;
+
+  setpoint_traj_cancel();
+  health_kick();
+
+  level = seqlock_write_begin(&target_lock);
+  target_box.immediate = immediate;
+  target_box.cmd_tagged = tagged;
+  target_box.cmd_seq = cmd_seq;
+  target_box.cmd_timestamp_us = cmd_timestamp_us;
+  target_box.cmd_rx_hr = rx_hr;
+  for (i = 0; i < MOTOR_AXIS_NUM; i++) {
+    if (motor_axis_table[i].cmd_channel == MOTOR_AXIS_CHANNEL_LEFT) {
+      target_box.dir[i] = dir1;
+      target_box.speed[i] = speed1;
+    } else {
+      target_box.dir[i] = dir2;
+      target_box.speed[i] = speed2;
+    }
+  }
+  target_box.generation++;
+  seqlock_write_end(&target_lock, level);
+}
+
 /**
  * @brief 设置电机目标速度 (供 RPMsg 模块调用)
- * @param dir1 电机1方向 (0=停止, 1=正转, 2=反转)
- * @param speed1 电机1目标转速 (转/秒)
- * @param dir2 电机2方向
- * @param speed2 电机2目标转速
+ *        按轴描述表的指令通道分配到各轴, 写入目标值邮箱,
+ *        不阻塞, 可在 RPMsg 回调中调用
+ * @param dir1 通道 0 (电机1/左侧) 方向 (0=停止, 1=正转, 2=反转)
+ * @param speed1 通道 0 目标转速 (转/秒)
+ * @param dir2 通道 1 (电机2/右侧) 方向
+ * @param speed2 通道 1 目标转速
  */
 void chassis_set_target(int dir1, double speed1, int dir2, double speed2) {
-  rt_mutex_take(target_mutex, RT_WAITING_FOREVER);
-  motor1_target_dir = dir1;
-  motor1_target_speed = speed1;
-  motor2_target_dir = dir2;
-  motor2_target_speed = speed2;
-  rt_mutex_release(target_mutex);
+  chassis_write_target(dir1, speed1, dir2, speed2, RT_FALSE, 0, 0, RT_FALSE);
 
   // rt_kprintf(
   //     "[Chassis] Target set: M1(dir=%d, speed=%d mr/s), M2(dir=%d, speed=%d mr/s)\n",
   //     dir1, (int)(speed1 * 1000), dir2, (int)(speed2 * 1000));
 }
 
+/**
+ * @brief 设置来自二进制 CMD 帧的目标速度, 记录序号和时间戳用于时延回显
+ * @param cmd_seq CMD 帧序号
+ * @param cmd_timestamp_us CMD 帧发送方时间戳
+ */
+void chassis_set_target_cmd(int dir1, double speed1, int dir2, double speed2,
+                            rt_uint32_t cmd_seq, rt_uint32_t cmd_timestamp_us) {
+  chassis_write_target(dir1, speed1, dir2, speed2, RT_TRUE, cmd_seq,
+                       cmd_timestamp_us, RT_FALSE);
+}
+
+/**
+ * @brief 急停: 所有轴目标值置 0, 取消轨迹、自整定和前馈标定, 不经过加速度限制
+ */
+void chassis_emergency_stop(void) {
+  autotune_abort();
+  ff_cal_abort();
+  chassis_write_target(0, 0.0, 0, 0.0, RT_FALSE, 0, 0, RT_TRUE);
+}
+
+/**
+ * @brief 逐轴设置目标速度 (不经过指令通道映射, 如麦克纳姆轮逆解结果)
+ * @param dir 各轴方向, num 项
+ * @param speed 各轴目标转速 (转/秒), num 项
+ * @param num 轴数, 超出 MOTOR_AXIS_NUM 的部分忽略, 不足的轴停止
+ */
+void chassis_set_axis_targets(const int *dir, const double *speed, int num) {
+  rt_base_t level;
+  int i;
+
+  setpoint_traj_cancel();
+  health_kick();
+
+  level = seqlock_write_begin(&target_lock);
+  for (i = 0; i < MOTOR_AXIS_NUM; i++) {
+    target_box.dir[i] = (i < num) ? dir[i] : 0;
+    target_box.speed[i] = (i < num) ? speed[i] : 0.0;
+  }
+  target_box.cmd_tagged = RT_FALSE;
+  target_box.immediate = RT_FALSE;
+  target_box.generation++;
+  seqlock_write_end(&target_lock, level);
+}
+
 /**
  * @brief 获取电机实际状态 (供 RPMsg 模块读取反馈)
+ *        读取控制线程发布的状态快照, 不与控制线程竞争锁,
+ *        每个指令通道报告其反馈轴
  * @param[out] dir1 电机1实际方向
  * @param[out] speed1_mrs 电机1实际转速 (毫转/秒)
  * @param[out] dir2 电机2实际方向
@@ -161,71 +823,152 @@ void chassis_set_target(int dir1, double speed1, int dir2, double speed2) {
  */
 void chassis_get_status(int *dir1, int *speed1_mrs, int *dir2,
                         int *speed2_mrs) {
-  /* 获取实际速度 */
-  float actual_speed1 = encoder_get_shared_speed1();
-  float actual_speed2 = encoder_get_shared_speed2();
+  struct chassis_status status;
 
-  /* 获取目标方向作为实际方向 (编码器不带方向信息) */
-  rt_mutex_take(target_mutex, RT_WAITING_FOREVER);
-  *dir1 = motor1_target_dir;
-  *dir2 = motor2_target_dir;
-  rt_mutex_release(target_mutex);
+  chassis_status_read(&status);
 
-  /* 转换为毫转/秒 */
-  *speed1_mrs = (int)(actual_speed1 * 1000);
-  *speed2_mrs = (int)(actual_speed2 * 1000);
+  *dir1 = status.dir[chassis_channel_axis[0]];
+  *dir2 = status.dir[chassis_channel_axis[1]];
+  *speed1_mrs = status.speed_mrs[chassis_channel_axis[0]];
+  *speed2_mrs = status.speed_mrs[chassis_channel_axis[1]];
+}
+
+/**
+ * @brief 获取电机目标速度 (供 RPMsg 模块填充二进制反馈)
+ * @param[out] setpoint1_mrs 电机1目标转速 (毫转/秒, 符号表示方向)
+ * @param[out] setpoint2_mrs 电机2目标转速 (毫转/秒, 符号表示方向)
+ */
+void chassis_get_setpoint(int *setpoint1_mrs, int *setpoint2_mrs) {
+  struct chassis_status status;
+
+  chassis_status_read(&status);
+
+  *setpoint1_mrs = status.setpoint_mrs[chassis_channel_axis[0]];
+  *setpoint2_mrs = status.setpoint_mrs[chassis_channel_axis[1]];
+}
+
+/**
+ * @brief 获取最近一条已输出到 PWM 的 CMD 回显信息 (供 RPMsg 模块填充时延回显)
+ * @param[out] echo 回显信息, 还没有 CMD 输出过时 valid 为 RT_FALSE
+ */
+void chassis_get_cmd_echo(struct chassis_cmd_echo *echo) {
+  struct chassis_status status;
+
+  chassis_status_read(&status);
+
+  *echo = status.echo;
 }
 
 /**
  * @brief 设置底盘控制参数 (供 RPMsg 模块调用)
+ *        写入参数邮箱, 由控制线程在下一周期开始时应用
  */
 void chassis_set_cfg(double ratio, double ff, double kp, double ki, double kd) {
-  rt_mutex_take(target_mutex, RT_WAITING_FOREVER);
-  reduction_ratio = ratio;
-  ff_factor = ff;
-
-  PID_Controller_Init(&pid_motor1, (float)kp, (float)ki, (float)kd, 0.033f, 10.0f, 1.0f);
-  PID_Controller_Init(&pid_motor2, (float)kp, (float)ki, (float)kd, 0.033f, 10.0f, 1.0f);
-  rt_mutex_release(target_mutex);
+  rt_base_t level = seqlock_write_begin(&cfg_lock);
+  cfg_box.reduction_ratio = ratio;
+  cfg_box.ff_factor = ff;
+  cfg_box.kp = kp;
+  cfg_box.ki = ki;
+  cfg_box.kd = kd;
+  cfg_box.generation++;
+  seqlock_write_end(&cfg_lock, level);
 
   encoder_set_reduction_ratio((float)ratio);
 
   rt_kprintf(
       "[Chassis] CFG updated: ratio=%d ff=%d kp=%d ki=%d kd=%d (x1000)\n",
-      (int)(reduction_ratio * 1000), (int)(ff_factor * 1000),
+      (int)(ratio * 1000), (int)(ff * 1000),
       (int)(kp * 1000), (int)(ki * 1000), (int)(kd * 1000));
 }
 
+/**
+ * @brief 读取底盘控制参数 (参数邮箱中的最新值, 控制线程可能还没有应用)
+ */
+void chassis_get_cfg(double *ratio, double *ff, double *kp, double *ki,
+                     double *kd) {
+  struct chassis_cfg cfg;
+
+  chassis_cfg_read(&cfg);
+  *ratio = cfg.reduction_ratio;
+  *ff = cfg.ff_factor;
+  *kp = cfg.kp;
+  *ki = cfg.ki;
+  *kd = cfg.kd;
+}
+
+/**
+ * @brief 记录接下来 ticks 个控制节拍的执行时间 (供 bench 命令调用)
+ *        从节拍唤醒到本周期处理结束, 阻塞等待控制线程完成
+ */
+rt_err_t chassis_bench_ticks(struct bench_stats *st, rt_uint32_t ticks) {
+  rt_int32_t wait_ms;
+
+  if (chassis_bench_left > 0) {
+    return -RT_EBUSY;
+  }
+
+  bench_stats_reset(st);
+  chassis_bench_stats = st;
+  __sync_synchronize();
+  chassis_bench_left = ticks;
+
+  /* 最多等待理论时间的 2 倍 */
+  wait_ms = (rt_int32_t)(2 * ticks * 1000 / control_tick_get_hz()) + 100;
+  while (chassis_bench_left > 0 && wait_ms > 0) {
+    rt_thread_mdelay(10);
+    wait_ms -= 10;
+  }
+  if (chassis_bench_left > 0) {
+    chassis_bench_left = 0;
+    /* 等控制线程退出可能正在进行的记录, st 之后可能失效 */
+    rt_thread_mdelay(1000 / control_tick_get_hz() + 1);
+    return -RT_ETIMEOUT;
+  }
+  return RT_EOK;
+}
+
 int main(void) {
   rt_kprintf("==========================================\n");
-  rt_kprintf("  Dual Motor Control System\n");
+  rt_kprintf("  Motor Control System (%d axes)\n", MOTOR_AXIS_NUM);
   rt_kprintf("==========================================\n\n");
 
-  /* 创建目标值互斥锁 */
-  target_mutex = rt_mutex_create("tgt_mtx", RT_IPC_FLAG_PRIO);
-  if (target_mutex == RT_NULL) {
-    rt_kprintf("[Error] Failed to create target mutex!\n");
-    return -1;
-  }
+  struct chassis_cfg cfg;
+
+  /* 指令通道到反馈轴的映射 */
+  chassis_channel_map_init();
 
   /* 初始化电机 GPIO 和 PWM */
   motors_gpio_init();
   motors_pwm_init();
 
+  /* 初始化高精度时间戳 (编码器测周使用) */
+  hrtime_init();
+
+  /* 线程剖析: 调度钩子须在创建各线程之前安装 */
+  profiler_init();
+
+  /* 初始化控制节拍 (编码器和底盘线程订阅) */
+  control_tick_init(CONTROL_TICK_DEFAULT_HZ);
+
   /* 初始化编码器并启动读取线程 */
   encoders_init();
-  encoder_set_reduction_ratio((float)reduction_ratio);
+  chassis_cfg_read(&cfg);
+  encoder_set_reduction_ratio((float)cfg.reduction_ratio);
   encoder_print_thread_start();
 
-  /* 初始化 PID 控制器 (30Hz 控制频率, dt=0.033s) */
-  /* 参数: kp, ki, kd, dt, i_limit, out_limit */
-  PID_Controller_Init(&pid_motor1, 0.05f, 0.2f, 0.01f, 0.033f, 10.0f, 1.0f);
-  PID_Controller_Init(&pid_motor2, 0.05f, 0.2f, 0.01f, 0.033f, 10.0f, 1.0f);
+  /* 初始化 PID 控制器 (dt 取控制节拍周期) */
+  chassis_apply_cfg(&cfg);
   rt_kprintf("[PID] Controllers initialized (Kp=50 Ki=200 Kd=10, x1000)\n");
 
+  /* 共享内存状态块须在底盘线程发布之前初始化 */
+  motor_shm_init();
+
   /* 启动底盘控制线程 (前馈+PID闭环控制) */
   chassis_ctrl_thread_start();
 
+  /* 所有订阅者就绪后启动控制节拍 */
+  control_tick_start();
+
   /* 启动 RPMsg 电机控制服务 */
   rpmsg_motor_init();
 
@@ -328,13 +1071,8 @@ static int cmd_speed(int argc, char *argv[]) {
       return -1;
   }
 
-  /* 设置目标值 (加锁保护) */
-  rt_mutex_take(target_mutex, RT_WAITING_FOREVER);
-  motor1_target_dir = dir1;
-  motor2_target_dir = dir2;
-  motor1_target_speed = speed1;
-  motor2_target_speed = speed2;
-  rt_mutex_release(target_mutex);
+  /* 设置目标值 (写入目标值邮箱) */
+  chassis_set_target(dir1, speed1, dir2, speed2);
 
   rt_kprintf("[cmd_speed] Motor1: dir=%d, speed=%d mr/s\n", dir1,
              (int)(speed1 * 1000));
@@ -345,6 +1083,51 @@ static int cmd_speed(int argc, char *argv[]) {
 }
 MSH_CMD_EXPORT(cmd_speed, Set motor target speed in r / s);
 
+/**
+ * @brief MSH命令: 逐轴设置目标速度 (不经过指令通道映射)
+ *
+ * 用法: cmd_axis_speed 1,2.0;1,2.0;2,1.0;2,1.0
+ * 按分号依次对应轴 0 ~ 轴 N-1, 缺省的轴停止
+ */
+static int cmd_axis_speed(int argc, char *argv[]) {
+  char *cmd;
+  char *semicolon;
+  char buf[128];
+  int dir[MOTOR_AXIS_NUM];
+  double speed[MOTOR_AXIS_NUM];
+  int num, i;
+
+  if (argc < 2) {
+    rt_kprintf("Usage: cmd_axis_speed <dir,speed>[;<dir,speed>...] (up to %d axes)\n",
+               MOTOR_AXIS_NUM);
+    rt_kprintf("  dir: 0=stop, 1=forward, 2=backward\n");
+    rt_kprintf("  speed: rotation speed in r/s\n");
+    return -1;
+  }
+
+  strncpy(buf, argv[1], sizeof(buf) - 1);
+  buf[sizeof(buf) - 1] = '\0';
+
+  cmd = buf;
+  for (num = 0; num < MOTOR_AXIS_NUM && cmd != RT_NULL; num++) {
+    semicolon = strchr(cmd, ';');
+    if (semicolon != RT_NULL)
+      *semicolon = '\0';
+    if (parse_speed_cmd(cmd, &dir[num], &speed[num]) != RT_EOK)
+      return -1;
+    cmd = (semicolon != RT_NULL) ? semicolon + 1 : RT_NULL;
+  }
+
+  chassis_set_axis_targets(dir, speed, num);
+
+  for (i = 0; i < num; i++) {
+    rt_kprintf("[cmd_axis_speed] Axis%d: dir=%d, speed=%d mr/s\n", i, dir[i],
+               (int)(speed[i] * 1000));
+  }
+  return 0;
+}
+MSH_CMD_EXPORT(cmd_axis_speed, Set per - axis target speed in r / s);
+
 /**
  * @brief MSH命令: 紧急停止所有电机
  */
@@ -352,13 +1135,8 @@ static int cmd_chassis_stop(int argc, char *argv[]) {
   (void)argc;
   (void)argv;
 
-  /* 设置目标值为0 */
-  rt_mutex_take(target_mutex, RT_WAITING_FOREVER);
-  motor1_target_dir = 0;
-  motor2_target_dir = 0;
-  motor1_target_speed = 0.0;
-  motor2_target_speed = 0.0;
-  rt_mutex_release(target_mutex);
+  /* 目标值置 0, 不经过加速度限制 */
+  chassis_emergency_stop();
 
   rt_kprintf("[cmd_chassis_stop] All motors stopped.\n");
   return 0;
@@ -0,0 +1,116 @@
+/*
+ * PID 自整定 - 头文件
+ *
+ * 底盘控制线程每个节拍调用 autotune_update(), 自整定期间各轴正转,
+ * 占空比由实验直接给出, 不经过 PID:
+ * - 阶跃 (step): 低占空比保持 -> 高占空比保持, 由两段稳态转速得到增益 K 和
+ *   前馈斜率, 由阶跃响应的 28.3% / 63.2% 时刻 (两点法) 得到时间常数 tau
+ *   和纯滞后 L, 按 SIMC 规则计算 PI 参数
+ * - 继电 (relay): 先做同样的阶跃, 再在两段稳态转速的中点做带滞环的继电反馈,
+ *   由振荡幅值和周期得到临界增益 Ku / 周期 Tu, 按 Tyreus-Luyben 规则计算 PI 参数
+ *
+ * 两种模式都给出 kd = 0: 速度环近似一阶对象, 微分项只放大编码器测速噪声
+ *
+ * 实验期间 CMD / 轨迹目标值被忽略, autotune_abort() 或急停中止;
+ * 电机带动负载转动, 底盘须架空
+ */
+
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <rtthread.h>
+#include "common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUTOTUNE_MODE_STEP  0
+#define AUTOTUNE_MODE_RELAY 1
+
+/* 实验状态 */
+#define AUTOTUNE_STATE_IDLE    0
+#define AUTOTUNE_STATE_RUNNING 1
+#define AUTOTUNE_STATE_DONE    2
+#define AUTOTUNE_STATE_ABORTED 3
+
+/* 单轴结果错误码 */
+#define AUTOTUNE_ERR_NONE           0
+#define AUTOTUNE_ERR_NO_RESPONSE    1 /* 高占空比下转速没有明显升高 */
+#define AUTOTUNE_ERR_NO_OSCILLATION 2 /* 继电反馈在超时内没有稳定振荡 */
+#define AUTOTUNE_ERR_INCOMPLETE     3 /* 实验没有完成 (中止或仍在进行) */
+
+struct autotune_config
+{
+    int mode;         /* AUTOTUNE_MODE_* */
+    float duty_low;   /* 低占空比, 0 < duty_low < duty_high */
+    float duty_high;  /* 高占空比, 不超过 1 */
+    rt_bool_t apply;  /* 完成后把各轴结果的平均值写入底盘参数 */
+    rt_bool_t notify; /* 通过 RPMsg 文本消息上报结果 */
+};
+
+struct autotune_result
+{
+    int error;        /* AUTOTUNE_ERR_* */
+    float gain;       /* K: 转速增量 / 占空比增量 (r/s) */
+    float tau;        /* 时间常数 (s) */
+    float dead_time;  /* 纯滞后 (s) */
+    float offset;     /* 零转速对应的占空比 (静摩擦), 只供参考 */
+    float ku;         /* 临界增益, 仅继电模式 */
+    float tu;         /* 临界周期 (s), 仅继电模式 */
+    float kp;
+    float ki;
+    float kd;
+    float ff;         /* 前馈系数 (占空比 / (r/s)) */
+};
+
+/**
+ * @brief 填充默认实验参数 (common.h 中的 AUTOTUNE_*)
+ */
+void autotune_config_default(struct autotune_config *cfg, int mode);
+
+/**
+ * @brief 开始实验 (不阻塞), 由底盘控制线程从下一个节拍开始执行
+ * @return RT_EOK 成功, -RT_EBUSY 已在进行 (或前馈标定中), -RT_EINVAL 参数错误
+ */
+rt_err_t autotune_begin(const struct autotune_config *cfg);
+
+/**
+ * @brief 开始实验并创建报告线程: 等待完成, 打印 / 上报结果, 按配置应用参数,
+ *        最后把底盘目标值置 0
+ * @return RT_EOK 成功, -RT_EBUSY 上一次实验还没有报告完, 其他同 autotune_begin
+ */
+rt_err_t autotune_start(const struct autotune_config *cfg);
+
+/**
+ * @brief 请求中止 (不阻塞), 没有实验时无效
+ */
+void autotune_abort(void);
+
+/**
+ * @brief 实验是否正在进行 (底盘控制线程每个节拍开始时调用)
+ */
+rt_bool_t autotune_active(void);
+
+/**
+ * @brief 执行一个节拍 (只在底盘控制线程中调用)
+ * @param speed 各轴正转方向的实测转速 (r/s), MOTOR_AXIS_NUM 项
+ * @param dt 节拍周期 (s)
+ * @param[out] duty 各轴本节拍占空比
+ * @return RT_TRUE 本节拍占空比由自整定给出, RT_FALSE 没有实验
+ */
+rt_bool_t autotune_update(const float *speed, float dt, float *duty);
+
+int autotune_get_state(void);
+
+/**
+ * @brief 由实验数据计算单轴结果 (实验结束后调用, 不在控制线程中计算)
+ * @return RT_EOK 结果有效, -RT_ERROR 见 out->error
+ */
+rt_err_t autotune_get_result(int axis, struct autotune_result *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AUTOTUNE_H */
@@ -0,0 +1,54 @@
+/*
+ * 控制环基准测试 - 头文件
+ *
+ * 用 hrtime 计数器对控制路径上的各个函数计时, 输入序列固定, 结果可复现
+ * msh 命令 "bench" 输出每项的 min/mean/max/stddev (ns)
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <rtthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BENCH_DEFAULT_ITERATIONS 1000
+#define BENCH_MAX_ITERATIONS     100000
+#define BENCH_DEFAULT_TICKS      200 /* 控制节拍测试的节拍数 */
+
+/* 单项耗时统计 (hrtime 计数) */
+struct bench_stats
+{
+    rt_uint32_t count;
+    rt_uint64_t min;
+    rt_uint64_t max;
+    rt_uint64_t sum;
+    rt_uint64_t sum_sq;
+};
+
+/**
+ * @brief 清空统计
+ */
+void bench_stats_reset(struct bench_stats *st);
+
+/**
+ * @brief 记录一次耗时 (hrtime 计数)
+ */
+void bench_stats_add(struct bench_stats *st, rt_uint64_t counts);
+
+/* ================= 外部接口声明 (由 control_main.c 实现) ================= */
+
+/**
+ * @brief 在底盘控制线程中记录接下来 ticks 个节拍的执行时间
+ *        (节拍唤醒后到本周期处理结束), 阻塞等待完成
+ * @return RT_EOK 完成, -RT_EBUSY 已有测试在进行, -RT_ETIMEOUT 控制线程未运行
+ */
+extern rt_err_t chassis_bench_ticks(struct bench_stats *st, rt_uint32_t ticks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BENCH_H */
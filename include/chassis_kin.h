@@ -0,0 +1,79 @@
+/*
+ * 底盘运动学与里程计 - 头文件
+ *
+ * - 逆运动学: 差速底盘 (v, w) -> 左右轮目标转速, 几何参数由 CFG 下发
+ * - 里程计: 底盘控制线程每个节拍用编码器原始增量积分位姿, 不受反馈频率和
+ *   大核采样时刻影响; 反馈线程 / MSH 读取快照
+ *
+ * 指令通道 0 为左轮, 1 为右轮 (MOTOR_AXIS_CHANNEL_LEFT / RIGHT)
+ */
+
+#ifndef CHASSIS_KIN_H
+#define CHASSIS_KIN_H
+
+#include <rtthread.h>
+#include "common.h"
+#include "motor_proto.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct chassis_geometry
+{
+    float wheel_radius_m;
+    float wheel_base_m;
+    float motor_factor[MOTOR_PROTO_WHEELS]; /* 指令轮速修正系数, 只用于逆解 */
+};
+
+struct chassis_odom
+{
+    double x;                           /* m */
+    double y;                           /* m */
+    double yaw;                         /* rad, 范围 [-pi, pi) */
+    float v;                            /* 最近一个节拍的线速度 m/s */
+    float w;                            /* 最近一个节拍的角速度 rad/s */
+    float wheel_v[MOTOR_PROTO_WHEELS];  /* 最近一个节拍的轮缘速度 m/s */
+    rt_uint64_t hr_time;                /* 最近一次积分的采样时刻 */
+    rt_uint32_t updates;                /* 积分次数 */
+};
+
+/**
+ * @brief 设置几何参数 (不阻塞), 非正的轮半径 / 轮距 / 系数被忽略
+ */
+void chassis_kin_set_geometry(const struct chassis_geometry *geo);
+
+void chassis_kin_get_geometry(struct chassis_geometry *out);
+
+/**
+ * @brief 逆运动学: 底盘速度换算为各指令通道目标转速 (已乘电机系数)
+ * @param v 线速度 m/s
+ * @param w 角速度 rad/s
+ * @param[out] wheel_rps 各通道转速 (转/秒, 带符号), 轮缘速度低于 1mm/s 时为 0
+ */
+void chassis_kin_inverse(float v, float w, float *wheel_rps);
+
+/**
+ * @brief 积分一个节拍的编码器增量 (只在底盘控制线程中调用)
+ * @param counts 各指令通道有符号增量
+ * @param counts_per_rev 轮子每转计数
+ * @param hr_time 采样时刻 (hrtime), 与上次之差作为速度的时间基准
+ */
+void chassis_kin_odom_update(const rt_int32_t *counts, float counts_per_rev,
+                             rt_uint64_t hr_time);
+
+/**
+ * @brief 读取里程计快照
+ */
+void chassis_kin_get_odom(struct chassis_odom *out);
+
+/**
+ * @brief 请求把位姿清零, 底盘控制线程在下一次积分时执行
+ */
+void chassis_kin_odom_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CHASSIS_KIN_H */
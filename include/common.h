@@ -5,16 +5,95 @@
 
 // 线程频率控制
 #define DEFAULT_FEEDBACK_INTERVAL_MS 50 /* 默认反馈间隔 50ms (20Hz) */
-#define ENCODER_INTERVAL_MS 50 /* 编码器读取线程周期 50ms (20Hz) */
-#define CHASSIS_CTRL_INTERVAL_MS 50 /* 底盘控制线程周期 50ms (20Hz) */
+
+// 批量遥测: 每周期记录一条, 攒够批量或超过时延后打包成一条 RPMsg 消息
+#define TELEMETRY_RING_SIZE     64 /* 环形缓冲区记录数 (2 的幂) */
+#define TELEMETRY_BATCH_DEFAULT 10 /* 每帧记录数, 不超过 MOTOR_PROTO_TELEMETRY_MAX_RECORDS */
+#define TELEMETRY_MAX_AGE_MS    20 /* 最早一条记录的最大时延 */
+
+// 跟踪缓冲区: 实时路径只写二进制记录, 由 msh "trace" 命令格式化输出
+#define TRACE_RING_SIZE     256 /* 记录条数 (2 的幂), 每条 48 字节 */
+#define TRACE_COMPILE_LEVEL 3   /* 0=关闭 1=ERROR 2=INFO 3=DEBUG, 高于此级别的 TRACE() 不编译 */
+
+// 时延统计: min/avg/max 覆盖全部样本, p99 取最近 N 个样本
+#define LATENCY_STATS_WINDOW 256 /* 每项统计保留的样本数, 每个样本 4 字节 */
+
+// 线程剖析: 调度钩子统计各线程 CPU 占用 (需 RT_USING_HOOK), msh "prof" 查看
+#define PROFILER_MAX_THREADS       16    /* 跟踪的线程数, 超出的线程计入 untracked */
+#define PROFILER_REPORT_MS_DEFAULT 0     /* RPMsg 剖析帧上报周期, 0=关闭 */
+#define PROFILER_REPORT_MS_MAX     60000 /* 上报周期上限 */
+
+// 目标值队列: 轨迹帧航点在控制线程中插值, 目标值进入 PID 前限制加速度, msh "traj" 查看
+#define SETPOINT_QUEUE_SIZE    32   /* 每条轨迹保留的航点数, 超出部分丢弃 */
+#define SETPOINT_ACCEL_DEFAULT 0.0f /* 轮速加速度上限 r/s^2, 0=不限制 */
+#define SETPOINT_JERK_DEFAULT  0.0f /* 轮速加加速度上限 r/s^3, 0=不限制 */
+
+// PID 自整定: 阶跃 / 继电实验在底盘线程中按控制节拍执行, msh "autotune" 或 RPMsg "TUNE" 触发
+#define AUTOTUNE_DUTY_LOW_DEFAULT  0.3f /* 阶跃起点占空比 */
+#define AUTOTUNE_DUTY_HIGH_DEFAULT 0.6f /* 阶跃终点占空比, 继电反馈在两者之间切换 */
+#define AUTOTUNE_HOLD_MS           1500 /* 每段阶跃保持时间, 须远大于电机时间常数 */
+#define AUTOTUNE_RELAY_CYCLES      4    /* 继电反馈参与计算的振荡周期数 (先丢弃 1 个) */
+#define AUTOTUNE_RELAY_TIMEOUT_MS  6000 /* 继电反馈超时 */
+#define AUTOTUNE_TRACE_SAMPLES     128  /* 阶跃响应记录点数 (每轴), 按保持时间抽取 */
+
+// PID 可选项 (底盘各轴): 默认全部关闭, 与只做积分限幅的 PID 一致; 提高控制频率时打开微分低通
+#define CHASSIS_PID_AW_MODE   0    /* 抗积分饱和: 0=只限幅 1=条件积分 2=反算 (pid.h PID_AW_*) */
+#define CHASSIS_PID_AW_KB     0.0f /* 反算增益 1/s, 0 = ki/kp */
+#define CHASSIS_PID_D_ON_MEAS 0    /* 1 = 微分取测量值, 目标值阶跃时没有微分冲击 */
+#define CHASSIS_PID_D_TAU     0.0f /* 微分一阶低通时间常数 s, 0 = 不滤波 */
+#define CHASSIS_PID_SLEW_RATE 0.0f /* 占空比变化率上限 1/s (含前馈), 0 = 不限制 */
+
+// 前馈查表: 每轴一张等间隔 转速 -> 占空比 表, msh "ff_cal" 开环标定, RPMsg "FF" 下发 / "FFGET" 读回
+#define FF_TABLE_POINTS         16   /* 每张表的断点数 */
+#define FF_CAL_DUTY_MAX_DEFAULT 0.9f /* 标定扫描的最高占空比 */
+#define FF_CAL_STEPS_DEFAULT    12   /* 标定扫描级数, 不超过 FF_CAL_MAX_STEPS */
+#define FF_CAL_MAX_STEPS        32
+#define FF_CAL_HOLD_MS          800  /* 每级保持时间, 后半段取平均转速 */
+
+// 健康监测: 指令超时看门狗, 编码器无脉冲 / 堵转检测, 故障时同一节拍内切断 PWM 并刹车, msh "health" 查看
+#define HEALTH_CMD_TIMEOUT_MS 500  /* 收到指令后超过此时间没有新指令则停车, 0=关闭 (msh "health timeout") */
+#define HEALTH_ENC_DUTY       0.4f /* 编码器无脉冲: 占空比不低于此值, */
+#define HEALTH_ENC_LOSS_MS    300  /*   且持续此时间增量为 0 */
+#define HEALTH_STALL_DUTY     0.8f /* 堵转: 占空比不低于此值, */
+#define HEALTH_STALL_SPEED    0.2f /*   有脉冲但转速低于此值 (r/s), */
+#define HEALTH_STALL_MS       500  /*   且持续此时间 */
+
+// 底盘运动学: (v, w) 指令逆解和里程计积分的默认几何参数, CFG 可覆盖, msh "odom" 查看
+#define CHASSIS_WHEEL_RADIUS_M 0.0335f /* 轮半径 (m) */
+#define CHASSIS_WHEEL_BASE_M   0.183f  /* 轮距 (m) */
+
+// 共享内存状态块: 底盘线程每节拍发布状态, 大核 mmap 后直接读取, msh "shm" 查看
+// #define MOTOR_SHM_BASE_ADDR 0x00000000 /* 定义后状态块放在该地址 (需在设备树中保留 MOTOR_SHM_SIZE 字节), 否则放在固件静态区 */
+#define MOTOR_SHM_PHYS_OFFSET 0 /* 小核地址 + 偏移 = 大核物理地址, 在 HELLO 应答中通告 */
+
+// 控制节拍: 硬定时器每节拍释放一次 采样 -> PID -> PWM 流水线
+#define CONTROL_TICK_DEFAULT_HZ 50   /* 默认控制频率 50Hz */
+#define CONTROL_TICK_MIN_HZ     50   /* 最低控制频率 */
+#define CONTROL_TICK_MAX_HZ     1000 /* 最高控制频率, rt_timer 模式下不超过 RT_TICK_PER_SECOND */
+// #define CONTROL_TICK_HWTIMER_DEV "timer0" /* 定义后使用硬件定时器设备代替 rt_timer (需 RT_USING_HWTIMER) */
+#define ENCODER_SAMPLE_INLINE /* 编码器采样在底盘控制线程内执行; 注释掉则使用独立采样线程 */
 
 // PWM
 #define PWM_CHANNEL     1           /* PWM通道号 */
 #define PWM_PERIOD      100000      /* 周期: 100us = 100000ns (10KHz) */
+#define MOTOR_ACTUATOR_REFRESH_CYCLES 100 /* 方向/脉宽不变时每 N 次控制强制重写一次驱动, 0=只在变化时写 */
 
 #define MOTOR_ENCODER_PPR     13
 #define MOTOR_REDUCTION_RATIO 56 // 减速比
 
+// 编码器正交解码: 定义后使用 A/B 两相 4 倍频计数, 测得转速带方向
+// #define ENCODER_USING_QUADRATURE
+
+// 编码器测速 (M/T 法)
+#define ENCODER_SPEED_MODE_DEFAULT 2   /* 0=M 法, 1=T 法, 2=自动 */
+#define ENCODER_MT_LOW_PULSES      2   /* 窗口内脉冲数不超过此值时使用 T 法 */
+#define ENCODER_MT_HIGH_PULSES     8   /* 窗口内脉冲数不少于此值时使用 M 法 */
+#define ENCODER_T_TIMEOUT_MS       200 /* 超过此时间没有脉冲认为已停止 */
+
+// 电机轴: 每个轴的 PWM/方向/编码器引脚在 src/motor_axis.c 的描述表中登记
+// 四轮底盘改为 4, 并在下方补充 Motor3/Motor4 引脚、在描述表中追加两项
+#define MOTOR_AXIS_NUM 2
+
 // Motor1 -------------------------------------------------------------------------------------------------
 
 /* ================= GPIO 输出引脚定义, 控制电机正反转的 ================= */
@@ -28,6 +107,7 @@
 
 /* ================= 编码器引脚参数设置 ================= */
 #define ENCODER_GPIO_MOTOR1_A   158
+#define ENCODER_GPIO_MOTOR1_B   159     /* R.GPIO[31] (GPIO 114), 仅正交模式使用 */
 
 // Motor2 --------------------------------------------------------------------------------------------------
 
@@ -41,6 +121,7 @@
 
 /* ================= 编码器引脚参数设置 ================= */
 #define ENCODER_GPIO_MOTOR2_A   163
+#define ENCODER_GPIO_MOTOR2_B   146     /* R.GPIO[18] (GPIO 63), 仅正交模式使用 */
 
 
 #endif  // MYCOMMON_H
\ No newline at end of file
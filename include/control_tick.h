@@ -0,0 +1,81 @@
+/*
+ * 控制节拍模块 - 头文件
+ *
+ * 由 rt_timer 硬定时器 (或硬件定时器设备) 周期触发,
+ * 每个节拍释放所有订阅者的信号量, 使 采样 -> PID -> PWM 锁相运行,
+ * 不受各线程执行时间影响而漂移
+ *
+ * 运行中可以修改频率 (msh "ctrl_tick hz <n>" / RPMsg "CFG,rate,..."):
+ * 新频率在下一个节拍中断中与周期一起切换, 频率版本号同时递增,
+ * 订阅者在节拍开始时比较版本号, 按新的 dt 重新计算
+ */
+
+#ifndef CONTROL_TICK_H
+#define CONTROL_TICK_H
+
+#include <rtthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 最多订阅者数量 */
+#define CONTROL_TICK_MAX_SUBSCRIBERS 4
+
+/**
+ * @brief 初始化控制节拍
+ * @param hz 控制频率, 限制在 CONTROL_TICK_MIN_HZ ~ CONTROL_TICK_MAX_HZ
+ * @return RT_EOK 成功, 其他值表示失败
+ */
+rt_err_t control_tick_init(rt_uint32_t hz);
+
+/**
+ * @brief 启动控制节拍 (所有订阅者注册完成后调用)
+ * @return RT_EOK 成功, 其他值表示失败
+ */
+rt_err_t control_tick_start(void);
+
+/**
+ * @brief 订阅控制节拍, 每个节拍释放一次 sem
+ * @param sem 订阅者等待的信号量
+ * @return RT_EOK 成功, -RT_EFULL 订阅者已满
+ */
+rt_err_t control_tick_attach(rt_sem_t sem);
+
+/**
+ * @brief 运行中修改控制频率 (不阻塞), 在下一个节拍边界生效; 未启动时立即生效
+ * @param hz 限制在 CONTROL_TICK_MIN_HZ ~ CONTROL_TICK_MAX_HZ
+ * @return 按定时器分辨率取整后的频率, 未初始化时返回 0
+ */
+rt_uint32_t control_tick_set_hz(rt_uint32_t hz);
+
+/**
+ * @brief 频率版本号, 每次频率切换时递增 (与 hz / dt 在同一个节拍中断中更新)
+ */
+rt_uint32_t control_tick_get_generation(void);
+
+/**
+ * @brief 获取实际控制频率 (按定时器分辨率取整后)
+ */
+rt_uint32_t control_tick_get_hz(void);
+
+/**
+ * @brief 获取控制周期 (秒), 用于 PID dt
+ */
+float control_tick_get_dt(void);
+
+/**
+ * @brief 获取节拍计数
+ */
+rt_uint32_t control_tick_get_count(void);
+
+/**
+ * @brief 获取超时计数 (节拍到来时订阅者仍未处理上一个节拍)
+ */
+rt_uint32_t control_tick_get_overruns(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONTROL_TICK_H */
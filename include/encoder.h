@@ -6,20 +6,50 @@
 #define ENCODER_H
 
 #include <rtthread.h>
+#include "motor_axis.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* 初始化 */
+/* 测速模式 */
+#define ENCODER_SPEED_MODE_M    0   /* M 法: 脉冲数 / 窗口时间 */
+#define ENCODER_SPEED_MODE_T    1   /* T 法: 1 / 边沿周期 */
+#define ENCODER_SPEED_MODE_AUTO 2   /* 按窗口内脉冲数在 M/T 之间过渡 */
+
+/* 一次采样结果: 所有编码器在同一时刻、同一窗口内的增量和速度 (按轴下标) */
+struct encoder_sample
+{
+    rt_uint32_t delta[MOTOR_AXIS_NUM];  /* 窗口内脉冲增量 (绝对值) */
+    rt_int32_t sdelta[MOTOR_AXIS_NUM];  /* 窗口内有符号增量 (A 相模式下与 delta 相同) */
+    float speed[MOTOR_AXIS_NUM];        /* 转速 (转/秒, 绝对值) */
+    float sspeed[MOTOR_AXIS_NUM];       /* 有符号转速 (转/秒, 正交模式下负值表示反转) */
+    rt_tick_t tick;         /* 采样时刻 (系统节拍) */
+    rt_tick_t window;       /* 采样窗口 (系统节拍) */
+    rt_uint64_t hr_time;    /* 采样时刻 (hrtime 计数) */
+    rt_uint32_t seq;        /* 采样序号 */
+};
+
+/* 按轴操作 (轴号 0 ~ MOTOR_AXIS_NUM-1, 引脚取自轴描述表) */
+rt_err_t encoder_axis_init(int axis);
+rt_uint32_t encoder_axis_get_count(int axis);
+rt_int32_t encoder_axis_get_signed_count(int axis);
+rt_uint32_t encoder_axis_get_delta(int axis);
+void encoder_axis_reset(int axis);
+
+/* 初始化 (encoders_init 初始化所有轴) */
 rt_err_t encoder1_init(void);
 rt_err_t encoder2_init(void);
 rt_err_t encoders_init(void);
 
-/* 获取脉冲计数 (只累加，无方向) */
+/* 获取脉冲计数 (A 相模式只累加，无方向) */
 rt_uint32_t encoder1_get_count(void);
 rt_uint32_t encoder2_get_count(void);
 
+/* 获取有符号计数 (ENCODER_USING_QUADRATURE 时正转递增、反转递减) */
+rt_int32_t encoder1_get_signed_count(void);
+rt_int32_t encoder2_get_signed_count(void);
+
 /* 获取周期内脉冲增量 (调用后更新last_count) */
 rt_uint32_t encoder1_get_delta(void);
 rt_uint32_t encoder2_get_delta(void);
@@ -29,20 +59,40 @@ void encoder1_reset(void);
 void encoder2_reset(void);
 void encoders_reset(void);
 
-/* 启动编码器读取线程 (20Hz) */
+/* 启动编码器采样 (由控制节拍驱动, 需先调用 control_tick_init) */
 rt_err_t encoder_print_thread_start(void);
 
+/* 执行一次采样 (ENCODER_SAMPLE_INLINE 模式下由底盘控制线程每节拍调用) */
+void encoder_sample_update(void);
+
+/* 获取最新一次采样结果 (无锁, 各轴数据时间一致) */
+void encoder_get_sample(struct encoder_sample *out);
+
 /* 获取共享的速度值 (转/秒，供底盘控制线程读取) */
 float encoder_get_shared_speed1(void);
 float encoder_get_shared_speed2(void);
 
+/* 获取共享的有符号速度 (转/秒, 正交模式下负值表示反转) */
+float encoder_get_signed_speed1(void);
+float encoder_get_signed_speed2(void);
+
+/* 设置/获取测速模式 (ENCODER_SPEED_MODE_*) */
+void encoder_set_speed_mode(int mode);
+int encoder_get_speed_mode(void);
+
 /* 动态设置编码器测速减速比 */
 void encoder_set_reduction_ratio(float ratio);
 
+/* 轮子每转计数 (编码器线数 x 倍频 x 减速比), 用于把增量换算为转数 */
+float encoder_get_counts_per_rev(void);
+
 /* 获取共享的 delta 值 (用于调试) */
 rt_uint32_t encoder_get_shared_delta1(void);
 rt_uint32_t encoder_get_shared_delta2(void);
 
+/* 调用一次中断回调并返回其耗时 (hrtime 计数), 不改变计数状态 (基准测试用) */
+rt_uint64_t encoder_bench_isr(int axis);
+
 #ifdef __cplusplus
 }
 #endif
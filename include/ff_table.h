@@ -0,0 +1,127 @@
+/*
+ * 前馈查表 - 头文件
+ *
+ * 每个电机轴一张 转速 -> 占空比 表, 断点按转速等间隔排列, 查表时直接由转速
+ * 算出区间下标, 不需要搜索. 第 0 点为零转速对应的占空比 (克服静摩擦的死区补偿),
+ * 目标转速为 0 时前馈为 0; 超出最后一个断点时按最后一段斜率外推, 不超过 1
+ *
+ * 表由 msh "ff_cal" 开环扫描标定, 也可以由大核 "FF,..." 指令下发 / "FFGET" 读回;
+ * 没有表的轴使用 CFG 中的线性前馈 ff_factor * 转速
+ *
+ * 表只按转速大小查, 正反转共用
+ */
+
+#ifndef FF_TABLE_H
+#define FF_TABLE_H
+
+#include <rtthread.h>
+#include "common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FF_TABLE_DUTY_SCALE 10000 /* 表中占空比单位 1e-4 */
+
+struct ff_table
+{
+    rt_uint16_t step_mrs;              /* 断点间隔 (mr/s) */
+    rt_uint8_t points;                 /* 有效断点数, 0 = 没有表, 否则不少于 2 */
+    rt_uint8_t reserved;
+    rt_uint16_t duty[FF_TABLE_POINTS]; /* 第 i 点对应转速 i * step_mrs, 单调不减 */
+};
+
+/**
+ * @brief 查表 (底盘控制线程每个节拍调用)
+ * @param speed 目标转速大小 (r/s)
+ * @return 前馈占空比 [0, 1]
+ */
+static inline float ff_table_eval(const struct ff_table *t, float speed)
+{
+    float pos, frac, duty;
+    int i;
+
+    if (speed <= 0.0f)
+    {
+        return 0.0f;
+    }
+
+    pos = speed * 1000.0f / (float)t->step_mrs;
+    i = (int)pos;
+    if (i > t->points - 2)
+    {
+        i = t->points - 2;
+    }
+    frac = pos - (float)i;
+    duty = ((float)t->duty[i] + frac * (float)(t->duty[i + 1] - t->duty[i])) /
+           (float)FF_TABLE_DUTY_SCALE;
+    return (duty > 1.0f) ? 1.0f : duty;
+}
+
+/**
+ * @brief 设置一个轴的表 (不阻塞), 由底盘控制线程在下一个节拍开始时使用
+ * @param t points 为 0 时删除该轴的表
+ * @return RT_EOK 成功, -RT_EINVAL 轴号或表不合法 (断点数、间隔为 0、占空比超出或递减)
+ */
+rt_err_t ff_table_set(int axis, const struct ff_table *t);
+
+void ff_table_get(int axis, struct ff_table *out);
+
+/**
+ * @brief 表的版本号, 每次设置递增
+ */
+rt_uint32_t ff_table_generation(void);
+
+/**
+ * @brief 读取所有轴的表 (MOTOR_AXIS_NUM 项)
+ * @return 读到的表对应的版本号
+ */
+rt_uint32_t ff_table_snapshot(struct ff_table *tables);
+
+/**
+ * @brief 按 RPMsg 格式输出一个轴的表: "FF,<axis>,<step_mrs>,<d0>,..." 或 "FF,<axis>,off"
+ * @return 输出长度 (同 rt_snprintf)
+ */
+int ff_table_format(int axis, char *buf, int size);
+
+/**
+ * @brief 解析 "FF,<axis>,<step_mrs>,<d0>,<d1>,..." 或 "FF,<axis>,off" (RPMsg 指令格式)
+ * @param[out] t off 时 points 为 0
+ * @return RT_EOK 成功, -RT_ERROR 格式错误 (不检查表内容, 由 ff_table_set 检查)
+ */
+rt_err_t ff_table_parse(const char *text, int *axis, struct ff_table *t);
+
+/* ================= 开环标定 ================= */
+
+/**
+ * @brief 开始标定扫描 (不阻塞): 各轴正转, 占空比从 duty_max / steps 起分 steps 级
+ *        升到 duty_max, 每级保持 FF_CAL_HOLD_MS, 记录后半段平均转速
+ * @return RT_EOK 成功, -RT_EBUSY 已在扫描或自整定中, -RT_EINVAL 参数错误
+ */
+rt_err_t ff_cal_begin(float duty_max, int steps);
+
+void ff_cal_abort(void);
+
+/**
+ * @brief 标定是否正在进行 (底盘控制线程每个节拍开始时调用)
+ */
+rt_bool_t ff_cal_active(void);
+
+/**
+ * @brief 执行一个节拍 (只在底盘控制线程中调用), 参数同 autotune_update
+ */
+rt_bool_t ff_cal_update(const float *speed, float dt, float *duty);
+
+/**
+ * @brief 由上一次完成的扫描生成一个轴的表 (扫描结束后调用)
+ *        转速区间按最高实测转速等分, 占空比由实测曲线反插值得到,
+ *        第 0 点为最低两级有效转速连线的零转速截距
+ * @return RT_EOK 成功, -RT_ERROR 没有完成的扫描或转速没有响应
+ */
+rt_err_t ff_cal_build(int axis, struct ff_table *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FF_TABLE_H */
@@ -0,0 +1,75 @@
+/*
+ * 电机健康监测 - 头文件
+ *
+ * 底盘控制线程每个节拍调用 health_update(), 用上一节拍输出的占空比与本节拍
+ * 编码器增量对照:
+ * - 指令超时: 收到指令后超过 cmd_timeout 没有新的指令 (CMD / TWIST / 轨迹帧 /
+ *   MSH), 大核程序退出或卡死时停车; 收到新指令后自动清除
+ * - 编码器无脉冲: 占空比不低于 HEALTH_ENC_DUTY 且增量持续 HEALTH_ENC_LOSS_MS 为 0
+ *   (编码器断线, 或轮子被完全卡住 - 没有电流检测时两者无法区分)
+ * - 堵转: 占空比不低于 HEALTH_STALL_DUTY, 有脉冲但转速持续 HEALTH_STALL_MS
+ *   低于 HEALTH_STALL_SPEED
+ * 后两种故障锁存, 由 health_clear() (msh "health clear" / RPMsg "FAULTCLR") 清除
+ *
+ * 有故障时底盘控制线程在同一节拍内切断 PWM 并刹车, 清除前保持输出为 0;
+ * 故障标志与 motor_proto.h 的 MOTOR_PROTO_FAULT_* 相同, 随状态帧上报
+ */
+
+#ifndef HEALTH_H
+#define HEALTH_H
+
+#include <rtthread.h>
+#include "common.h"
+#include "encoder.h"
+#include "motor_proto.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 锁存的故障 */
+#define HEALTH_FAULT_LATCHED (MOTOR_PROTO_FAULT_STALL | MOTOR_PROTO_FAULT_ENCODER)
+
+/**
+ * @brief 收到指令, 复位指令超时 (不阻塞, 可在 RPMsg 回调中调用)
+ */
+void health_kick(void);
+
+/**
+ * @brief 执行一个节拍的检查 (只在底盘控制线程中调用, 计算本节拍输出之前)
+ * @param sample 本节拍编码器采样
+ * @param duty 上一节拍各轴输出的占空比
+ * @param open_loop 正在执行自整定 / 前馈标定, 不检查指令超时
+ * @param dt 节拍周期 (s)
+ * @return 当前故障标志 MOTOR_PROTO_FAULT_*
+ */
+rt_uint32_t health_update(const struct encoder_sample *sample, const float *duty,
+                          rt_bool_t open_loop, float dt);
+
+/**
+ * @brief 当前故障标志 (任意线程读取)
+ */
+rt_uint32_t health_get_faults(void);
+
+/**
+ * @brief 发生过锁存故障的轴 (bit i 对应轴 i)
+ */
+rt_uint32_t health_get_fault_axes(void);
+
+/**
+ * @brief 请求清除锁存故障 (不阻塞), 下一个节拍生效
+ */
+void health_clear(void);
+
+/**
+ * @brief 设置指令超时 (ms), 0 关闭
+ */
+void health_set_cmd_timeout(rt_uint32_t ms);
+
+rt_uint32_t health_get_cmd_timeout(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HEALTH_H */
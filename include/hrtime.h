@@ -0,0 +1,57 @@
+/*
+ * 高精度时间戳 - 头文件
+ *
+ * 基于 RT-Thread cputime (RT_USING_CPUTIME), 未开启时退化为系统节拍
+ * 用于编码器边沿测周、耗时统计等需要亚毫秒分辨率的场合
+ */
+
+#ifndef HRTIME_H
+#define HRTIME_H
+
+#include <rtthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 初始化 (缓存计数器分辨率), 使用其他接口前调用一次
+ */
+void hrtime_init(void);
+
+/**
+ * @brief 读取当前计数值 (单调递增, 可在中断中调用)
+ */
+rt_uint64_t hrtime_now(void);
+
+/**
+ * @brief 计数差值转换为秒
+ */
+float hrtime_to_sec(rt_uint64_t counts);
+
+/**
+ * @brief 计数差值转换为微秒
+ */
+rt_uint32_t hrtime_to_us(rt_uint64_t counts);
+
+/**
+ * @brief 计数值 (时刻, 不是差值) 转换为微秒 (允许回绕), hrtime_init 之后可用
+ *        用于协议时间戳等绝对时刻, 整数运算, 不丢分辨率
+ */
+rt_uint32_t hrtime_abs_to_us(rt_uint64_t counts);
+
+/**
+ * @brief 当前时刻 (us, 允许回绕), 即 hrtime_abs_to_us(hrtime_now()), 可在中断中调用
+ */
+rt_uint32_t hrtime_now_us(void);
+
+/**
+ * @brief 微秒转换为计数差值
+ */
+rt_uint64_t hrtime_from_us(rt_uint32_t us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HRTIME_H */
@@ -0,0 +1,60 @@
+/*
+ * 时延统计 - 头文件
+ *
+ * 每项统计记录全部样本的 min/avg/max, 并保留最近 LATENCY_STATS_WINDOW 个样本,
+ * 查询时排序求 p99; 写入只做几次整数运算, 可在实时线程中调用
+ */
+
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <rtthread.h>
+#include "common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct latency_stats
+{
+    rt_uint32_t count;  /* 累计样本数 */
+    rt_uint32_t min_us;
+    rt_uint32_t max_us;
+    rt_uint64_t sum_us;
+    rt_uint32_t window[LATENCY_STATS_WINDOW]; /* 最近样本, 环形覆盖 */
+};
+
+struct latency_summary
+{
+    rt_uint32_t count;
+    rt_uint32_t min_us;
+    rt_uint32_t avg_us;
+    rt_uint32_t p99_us; /* 最近 LATENCY_STATS_WINDOW 个样本的 99 分位 */
+    rt_uint32_t max_us;
+};
+
+/**
+ * @brief 清空统计
+ */
+void latency_stats_reset(struct latency_stats *st);
+
+/**
+ * @brief 记录一个样本 (us), 短暂关中断, 可与查询并发
+ */
+void latency_stats_add(struct latency_stats *st, rt_uint32_t us);
+
+/**
+ * @brief 计算统计结果 (在调用方线程中排序, 不可重入, 只用于 MSH 命令)
+ */
+void latency_stats_summary(const struct latency_stats *st, struct latency_summary *out);
+
+/**
+ * @brief 打印一行统计结果
+ */
+void latency_stats_print(const char *name, const struct latency_stats *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LATENCY_STATS_H */
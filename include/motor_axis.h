@@ -0,0 +1,56 @@
+/*
+ * 电机轴描述表 - 头文件
+ *
+ * 每个轴一项, 登记 PWM 设备、方向引脚、编码器引脚和所跟随的指令通道,
+ * PWM/GPIO/编码器/底盘控制按轴下标循环, 不再按电机编号写重复代码
+ *
+ * 指令通道: RPMsg 协议只有左右两路 (MOTOR_PROTO_WHEELS),
+ * 四轮差速底盘同侧两个轴登记同一个通道即可跟随同一目标
+ */
+
+#ifndef MOTOR_AXIS_H
+#define MOTOR_AXIS_H
+
+#include <rtthread.h>
+#include "common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 状态反馈和遥测按通道取前两个轴, 至少需要两个轴 */
+#if MOTOR_AXIS_NUM < 2
+#error "MOTOR_AXIS_NUM must be at least 2"
+#endif
+
+/* 多轴同步写入以 32 位掩码选择轴 */
+#if MOTOR_AXIS_NUM > 32
+#error "MOTOR_AXIS_NUM must not exceed 32"
+#endif
+
+/* 指令通道 */
+#define MOTOR_AXIS_CHANNEL_LEFT  0 /* 电机1 / 协议 wheel[0] */
+#define MOTOR_AXIS_CHANNEL_RIGHT 1 /* 电机2 / 协议 wheel[1] */
+
+/* 轴下标是否有效 */
+#define MOTOR_AXIS_VALID(axis) ((axis) >= 0 && (axis) < MOTOR_AXIS_NUM)
+
+struct motor_axis_desc
+{
+    const char *pwm_dev;     /* PWM 设备名称 */
+    rt_uint8_t pwm_channel;  /* PWM 通道号 */
+    rt_uint8_t cmd_channel;  /* 跟随的指令通道 (MOTOR_AXIS_CHANNEL_*) */
+    rt_base_t dir_pin0;      /* 方向引脚 0 (正转时为高) */
+    rt_base_t dir_pin1;      /* 方向引脚 1 (反转时为高) */
+    rt_base_t enc_pin_a;     /* 编码器 A 相 */
+    rt_base_t enc_pin_b;     /* 编码器 B 相, 仅正交模式使用 */
+};
+
+/* 轴描述表, 下标即轴号 (电机 N 对应轴 N-1), 共 MOTOR_AXIS_NUM 项 */
+extern const struct motor_axis_desc motor_axis_table[];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MOTOR_AXIS_H */
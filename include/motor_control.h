@@ -17,13 +17,43 @@ extern "C" {
 #define MOTOR_DIR_BACKWARD  2
 
 /**
- * @brief 控制单个电机
- * @param motor_id 电机编号 (1 或 2)
+ * @brief 控制单个轴
+ *        方向和按 PWM_PERIOD 量化后的脉宽都未变化时跳过驱动调用,
+ *        每 MOTOR_ACTUATOR_REFRESH_CYCLES 次强制重写一次
+ * @param axis 轴号 (0 ~ MOTOR_AXIS_NUM-1)
+ * @param direction 方向 (0=停止, 1=正转, 2=反转)
+ * @param duty 占空比 (0.0 ~ 1.0)
+ */
+void motor_axis_control(int axis, int direction, float duty);
+
+/**
+ * @brief 同时控制所有轴 (带缓存), 变化的脉宽在同一个临界区内写入
+ * @param direction 各轴方向, MOTOR_AXIS_NUM 项
+ * @param duty 各轴占空比, MOTOR_AXIS_NUM 项
+ */
+void motors_control_all(const int *direction, const float *duty);
+
+/**
+ * @brief 控制单个电机 (等价于 motor_axis_control(motor_id - 1, ...))
+ * @param motor_id 电机编号 (1 ~ MOTOR_AXIS_NUM)
  * @param direction 方向 (0=停止, 1=正转, 2=反转)
  * @param duty 占空比 (0.0 ~ 1.0)
  */
 void motor_control(int motor_id, int direction, float duty);
 
+/**
+ * @brief 使执行器缓存失效, 下一次控制必定写入驱动
+ *        绕过 motor_control 直接操作 motor_pwm/motor_gpio 后需要调用
+ * @param axis 轴号, -1 表示所有轴
+ */
+void motor_actuator_invalidate(int axis);
+
+/**
+ * @brief 设置强制刷新间隔
+ * @param cycles 每 cycles 次调用强制写一次驱动, 0 表示只在变化时写入
+ */
+void motor_actuator_set_refresh(rt_uint32_t cycles);
+
 #ifdef __cplusplus
 }
 #endif
@@ -13,6 +13,42 @@
 extern "C" {
 #endif
 
+/* ==================== 按轴控制 (轴号 0 ~ MOTOR_AXIS_NUM-1) ==================== */
+
+/**
+ * @brief 初始化一个轴的方向引脚 (初始为滑行)
+ * @param axis 轴号, 无效时忽略
+ */
+void motor_axis_gpio_init(int axis);
+
+/**
+ * @brief 设置一个轴的两个方向引脚电平
+ * @param axis 轴号, 无效时忽略
+ * @param pin0_level GPIO_0引脚电平 (0: LOW, 非0: HIGH)
+ * @param pin1_level GPIO_1引脚电平 (0: LOW, 非0: HIGH)
+ */
+void motor_axis_set_pins(int axis, rt_uint8_t pin0_level, rt_uint8_t pin1_level);
+
+/**
+ * @brief 正转 (pin0=HIGH, pin1=LOW)
+ */
+void motor_axis_forward(int axis);
+
+/**
+ * @brief 反转 (pin0=LOW, pin1=HIGH)
+ */
+void motor_axis_backward(int axis);
+
+/**
+ * @brief 刹车 (pin0=HIGH, pin1=HIGH)
+ */
+void motor_axis_brake(int axis);
+
+/**
+ * @brief 滑行/停止 (pin0=LOW, pin1=LOW)
+ */
+void motor_axis_coast(int axis);
+
 /* ==================== 初始化函数 ==================== */
 
 /**
@@ -26,11 +62,11 @@ void motor1_gpio_init(void);
 void motor2_gpio_init(void);
 
 /**
- * @brief 初始化两个电机的GPIO引脚
+ * @brief 初始化所有电机的GPIO引脚
  */
 void motors_gpio_init(void);
 
-/* ==================== 电机1 GPIO 控制 ==================== */
+/* ==================== 电机1 GPIO 控制 (轴 0) ==================== */
 
 /**
  * @brief 设置电机1的GPIO_0引脚电平
@@ -71,7 +107,7 @@ void motor1_brake(void);
  */
 void motor1_coast(void);
 
-/* ==================== 电机2 GPIO 控制 ==================== */
+/* ==================== 电机2 GPIO 控制 (轴 1) ==================== */
 
 /**
  * @brief 设置电机2的GPIO_0引脚电平
@@ -112,25 +148,25 @@ void motor2_brake(void);
  */
 void motor2_coast(void);
 
-/* ==================== 两个电机同时控制 ==================== */
+/* ==================== 所有电机同时控制 ==================== */
 
 /**
- * @brief 两个电机同时正转
+ * @brief 所有电机同时正转
  */
 void motors_forward(void);
 
 /**
- * @brief 两个电机同时反转
+ * @brief 所有电机同时反转
  */
 void motors_backward(void);
 
 /**
- * @brief 两个电机同时刹车
+ * @brief 所有电机同时刹车
  */
 void motors_brake(void);
 
 /**
- * @brief 两个电机同时滑行/停止
+ * @brief 所有电机同时滑行/停止
  */
 void motors_coast(void);
 
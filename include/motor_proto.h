@@ -0,0 +1,565 @@
+/*
+ * RPMsg 电机控制二进制协议 - 头文件
+ *
+ * 大核 (k3_src) 与小核共用, 只依赖 <stdint.h>, 不依赖 RT-Thread
+ *
+ * 帧布局 (小端, packed, 定长):
+ *   magic(1) version(1) type(1) flags(1) seq(4) timestamp_us(4)
+ *   setpoint_mrs[2](8) measured_mrs[2](8) crc16(2)
+ *
+ * 遥测帧 (TELEMETRY, 变长): 帧头 + 批次信息 + count 条逐周期记录 + crc16,
+ *   一条 RPMsg 消息携带多个控制周期的数据
+ *
+ * 剖析帧 (PROFILE, 变长): 帧头 + 窗口信息 + count 条线程记录 + crc16,
+ *   小核按设置的周期上报各线程 CPU 占用、循环耗时和栈高水位
+ *
+ * 轨迹帧 (TRAJ, 变长): 帧头 + 限幅设置 + count 个航点 + crc16, 大核->小核,
+ *   小核按控制节拍在航点之间插值, 一条消息覆盖一段时间的目标值
+ *
+ * 底盘速度帧 (TWIST / ODOM, 定长): 大核直接下发 (v, w), 小核完成逆运动学;
+ *   小核按控制节拍积分里程计, 以位姿 + 速度代替轮速反馈
+ *
+ * 时延回显 (可选): FEEDBACK / TELEMETRY / ODOM 帧之后可追加 motor_proto_echo 尾部,
+ *   回显最近一条已输出到 PWM 的 CMD 帧序号和时间戳, 按长度识别;
+ *   旧版接收方只校验原帧长度, 会忽略尾部
+ *
+ * 故障标志: 小核发送的 FEEDBACK / TELEMETRY / ODOM 帧头 flags 为当前故障
+ *   MOTOR_PROTO_FAULT_*, 其他帧置 0
+ *
+ * 协商:
+ * - 大核创建端点后发送 HELLO 帧
+ * - 小核回复 HELLO 帧, 之后反馈改用二进制帧;
+ *   应答中 setpoint_mrs[0] / [1] 为共享内存状态块物理地址的低 / 高 32 位,
+ *   measured_mrs[0] 为其大小 (见 motor_shm.h), 大小为 0 表示没有状态块
+ * - 大核收到 HELLO 应答后, 速度指令改用二进制帧
+ * - 旧固件不认识 HELLO 时不会应答, 双方继续使用文本协议
+ */
+
+#ifndef MOTOR_PROTO_H
+#define MOTOR_PROTO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MOTOR_PROTO_MAGIC   0xA5
+#define MOTOR_PROTO_VERSION 1
+#define MOTOR_PROTO_WHEELS  2
+
+/* 帧类型 */
+#define MOTOR_PROTO_TYPE_HELLO    0x01 /* 协商请求/应答 */
+#define MOTOR_PROTO_TYPE_CMD      0x02 /* 大核->小核 速度指令 */
+#define MOTOR_PROTO_TYPE_FEEDBACK 0x03 /* 小核->大核 状态反馈 */
+#define MOTOR_PROTO_TYPE_TELEMETRY 0x04 /* 小核->大核 批量遥测 (变长) */
+#define MOTOR_PROTO_TYPE_PROFILE  0x05 /* 小核->大核 线程剖析 (变长) */
+#define MOTOR_PROTO_TYPE_TRAJ     0x06 /* 大核->小核 轨迹航点 (变长) */
+#define MOTOR_PROTO_TYPE_TWIST    0x07 /* 大核->小核 底盘速度指令 (v, w) */
+#define MOTOR_PROTO_TYPE_ODOM     0x08 /* 小核->大核 位姿与底盘速度反馈 */
+
+/* 故障标志 (状态帧 hdr.flags) */
+#define MOTOR_PROTO_FAULT_CMD_TIMEOUT 0x01 /* 指令超时, 已停车, 收到新指令后清除 */
+#define MOTOR_PROTO_FAULT_STALL       0x02 /* 堵转: 高占空比下转速过低, 锁存 */
+#define MOTOR_PROTO_FAULT_ENCODER     0x04 /* 编码器无脉冲: 高占空比下增量持续为 0, 锁存 */
+
+/* 单条 RPMsg 消息最大负载 (512 字节缓冲区减去 16 字节 rpmsg 头) */
+#define MOTOR_PROTO_MAX_PAYLOAD 496
+
+/* 通用帧头 */
+struct motor_proto_hdr {
+    uint8_t magic;         /* MOTOR_PROTO_MAGIC */
+    uint8_t version;       /* MOTOR_PROTO_VERSION */
+    uint8_t type;          /* MOTOR_PROTO_TYPE_* */
+    uint8_t flags;         /* 状态帧为 MOTOR_PROTO_FAULT_*, 其他帧置 0 */
+    uint32_t seq;          /* 发送方递增序号 */
+    uint32_t timestamp_us; /* 发送方单调时间 (us, 允许回绕) */
+} __attribute__((packed));
+
+/*
+ * 轮速帧 (HELLO / CMD / FEEDBACK 共用)
+ * 轮速单位 mr/s (毫转/秒), 符号表示方向: >0 正转, <0 反转, 0 停止
+ * CMD 只使用 setpoint_mrs, FEEDBACK 两者都填
+ */
+struct motor_proto_wheel_frame {
+    struct motor_proto_hdr hdr;
+    int32_t setpoint_mrs[MOTOR_PROTO_WHEELS];
+    int32_t measured_mrs[MOTOR_PROTO_WHEELS];
+    uint16_t crc; /* CRC-16/CCITT-FALSE, 覆盖 crc 之前的所有字节 */
+} __attribute__((packed));
+
+/* 两端编译器布局必须一致 */
+typedef char motor_proto_wheel_frame_size_check
+    [(sizeof(struct motor_proto_wheel_frame) == 30) ? 1 : -1];
+
+/*
+ * 底盘速度指令: 小核按 CFG 下发的轮半径、轮距和电机系数换算为轮速,
+ * 之后与 CMD 相同 (取消轨迹, 参与时延回显)
+ */
+struct motor_proto_twist_frame {
+    struct motor_proto_hdr hdr;
+    int32_t v_mmps;   /* 线速度 mm/s, 前进为正 */
+    int32_t w_mradps; /* 角速度 mrad/s, 逆时针为正 */
+    uint16_t crc;     /* CRC-16/CCITT-FALSE, 覆盖 crc 之前的所有字节 */
+} __attribute__((packed));
+
+typedef char motor_proto_twist_frame_size_check
+    [(sizeof(struct motor_proto_twist_frame) == 22) ? 1 : -1];
+
+/*
+ * 位姿反馈: 小核每个控制节拍用编码器原始增量积分, 原点为上电或 odom reset 时的位姿
+ */
+struct motor_proto_odom_frame {
+    struct motor_proto_hdr hdr;
+    int32_t x_mm;
+    int32_t y_mm;
+    int32_t yaw_urad;                        /* 航向 urad, 范围 [-pi, pi) */
+    int32_t v_mmps;                          /* 最近一个节拍的线速度 */
+    int32_t w_mradps;                        /* 最近一个节拍的角速度 */
+    int32_t measured_mrs[MOTOR_PROTO_WHEELS]; /* 实测轮速 mr/s, 带符号 */
+    uint32_t odom_us;                        /* 最近一次积分的采样时刻 (us, 允许回绕) */
+    uint16_t crc;
+} __attribute__((packed));
+
+typedef char motor_proto_odom_frame_size_check
+    [(sizeof(struct motor_proto_odom_frame) == 46) ? 1 : -1];
+
+/*
+ * 遥测记录中单个轮子的数据
+ * 占空比和 PID 各项单位 1/10000 (占空比), 符号与方向一致
+ */
+struct motor_proto_telemetry_wheel {
+    int32_t delta;        /* 本周期编码器计数 (正交模式带符号) */
+    int32_t speed_mrs;    /* 实测转速 mr/s, 带符号 */
+    int32_t setpoint_mrs; /* 目标转速 mr/s, 带符号 */
+    int16_t duty;         /* 输出占空比 */
+    int16_t p_out;        /* PID 比例项 */
+    int16_t i_out;        /* PID 积分项 */
+    int16_t d_out;        /* PID 微分项 */
+} __attribute__((packed));
+
+/* 一个控制周期的遥测记录 */
+struct motor_proto_telemetry_record {
+    uint32_t timestamp_us; /* 采样时刻 (us, 允许回绕) */
+    struct motor_proto_telemetry_wheel wheel[MOTOR_PROTO_WHEELS];
+} __attribute__((packed));
+
+typedef char motor_proto_telemetry_record_size_check
+    [(sizeof(struct motor_proto_telemetry_record) == 44) ? 1 : -1];
+
+/* 遥测帧头 (records 之后紧跟 crc16) */
+struct motor_proto_telemetry_frame {
+    struct motor_proto_hdr hdr;
+    uint8_t count;    /* 本帧记录数 */
+    uint8_t reserved; /* 置 0 */
+    uint16_t dropped; /* 累计丢弃记录数 (允许回绕) */
+    struct motor_proto_telemetry_record records[];
+} __attribute__((packed));
+
+/* 满帧不超过一条 RPMsg 消息 */
+#define MOTOR_PROTO_TELEMETRY_MAX_RECORDS \
+    ((MOTOR_PROTO_MAX_PAYLOAD - sizeof(struct motor_proto_telemetry_frame) - \
+      sizeof(uint16_t)) / sizeof(struct motor_proto_telemetry_record))
+
+/**
+ * @brief 含 count 条记录的遥测帧总长度 (含 crc16)
+ */
+static inline size_t motor_proto_telemetry_size(size_t count)
+{
+    return sizeof(struct motor_proto_telemetry_frame) +
+           count * sizeof(struct motor_proto_telemetry_record) + sizeof(uint16_t);
+}
+
+/* 剖析帧中一个线程的记录, 占用率按上报窗口计算, 其余项自 prof reset 起累计 */
+struct motor_proto_profile_thread {
+    char name[8];           /* 线程名, 不足补 0, 满 8 字节时不以 0 结尾 */
+    uint16_t cpu_permille;  /* 窗口内 CPU 占用, 1/1000 */
+    uint8_t priority;
+    uint8_t alive;          /* 0: 线程已退出 */
+    uint32_t stack_size;    /* 字节 */
+    uint32_t stack_used;    /* 栈高水位, 字节 */
+    uint32_t exec_max_us;   /* 单次迭代最大 CPU 时间, 未统计循环时为 0 */
+    uint32_t resp_max_us;   /* 单次迭代最大响应时间 (含被抢占) */
+} __attribute__((packed));
+
+typedef char motor_proto_profile_thread_size_check
+    [(sizeof(struct motor_proto_profile_thread) == 28) ? 1 : -1];
+
+/* 剖析帧头 (threads 之后紧跟 crc16) */
+struct motor_proto_profile_frame {
+    struct motor_proto_hdr hdr;
+    uint8_t count;              /* 本帧线程数 */
+    uint8_t reserved;           /* 置 0 */
+    uint16_t cpu_load_permille; /* 窗口内非空闲时间占比, 调度钩子未开启时为 0xFFFF */
+    uint16_t irq_permille;      /* 窗口内中断处理时间占比 */
+    uint32_t window_us;         /* 窗口长度 */
+    struct motor_proto_profile_thread threads[];
+} __attribute__((packed));
+
+#define MOTOR_PROTO_PROFILE_MAX_THREADS \
+    ((MOTOR_PROTO_MAX_PAYLOAD - sizeof(struct motor_proto_profile_frame) - \
+      sizeof(uint16_t)) / sizeof(struct motor_proto_profile_thread))
+
+/**
+ * @brief 含 count 条记录的剖析帧总长度 (含 crc16)
+ */
+static inline size_t motor_proto_profile_size(size_t count)
+{
+    return sizeof(struct motor_proto_profile_frame) +
+           count * sizeof(struct motor_proto_profile_thread) + sizeof(uint16_t);
+}
+
+/*
+ * 轨迹航点: 相对小核收到本帧时刻的偏移, 轮速单位同 CMD (mr/s, 带符号)
+ * 航点按 t_us 递增排列; 第一个航点之前从当前目标值线性过渡, 最后一个航点之后保持
+ */
+struct motor_proto_traj_point {
+    uint32_t t_us;
+    int32_t setpoint_mrs[MOTOR_PROTO_WHEELS];
+} __attribute__((packed));
+
+typedef char motor_proto_traj_point_size_check
+    [(sizeof(struct motor_proto_traj_point) == 12) ? 1 : -1];
+
+/* flags: 本帧携带的限幅值有效, 否则小核保持当前限幅 */
+#define MOTOR_PROTO_TRAJ_FLAG_LIMITS 0x01
+
+/* 轨迹帧头 (points 之后紧跟 crc16), 新的轨迹帧整体替换小核上尚未执行的航点 */
+struct motor_proto_traj_frame {
+    struct motor_proto_hdr hdr;
+    uint8_t count;          /* 本帧航点数, 0 表示取消轨迹 (回到 CMD 目标值) */
+    uint8_t flags;          /* MOTOR_PROTO_TRAJ_FLAG_* */
+    uint16_t reserved;      /* 置 0 */
+    uint32_t accel_mrs2;    /* 轮速加速度上限 mr/s^2, 0 不限制 */
+    uint32_t jerk_mrs3;     /* 轮速加加速度上限 mr/s^3, 0 不限制 */
+    struct motor_proto_traj_point points[];
+} __attribute__((packed));
+
+#define MOTOR_PROTO_TRAJ_MAX_POINTS \
+    ((MOTOR_PROTO_MAX_PAYLOAD - sizeof(struct motor_proto_traj_frame) - \
+      sizeof(uint16_t)) / sizeof(struct motor_proto_traj_point))
+
+/**
+ * @brief 含 count 个航点的轨迹帧总长度 (含 crc16)
+ */
+static inline size_t motor_proto_traj_size(size_t count)
+{
+    return sizeof(struct motor_proto_traj_frame) +
+           count * sizeof(struct motor_proto_traj_point) + sizeof(uint16_t);
+}
+
+/*
+ * 时延回显尾部 (紧跟 FEEDBACK 轮速帧、TELEMETRY 或 ODOM 帧的 crc16 之后)
+ * cmd_timestamp_us 原样回显 CMD 帧头的时间戳, 大核用自己的时钟计算往返时延
+ */
+struct motor_proto_echo {
+    uint32_t cmd_seq;          /* 最近一条已输出到 PWM 的 CMD 帧序号 */
+    uint32_t cmd_timestamp_us; /* 该 CMD 帧的发送方时间戳 */
+    uint32_t rx_to_apply_us;   /* 小核: 收到 CMD -> PWM 更新 */
+    uint32_t apply_to_tx_us;   /* 小核: PWM 更新 -> 本帧发送 */
+    uint16_t crc;              /* CRC-16/CCITT-FALSE, 只覆盖本尾部 */
+} __attribute__((packed));
+
+typedef char motor_proto_echo_size_check
+    [(sizeof(struct motor_proto_echo) == 18) ? 1 : -1];
+
+/**
+ * @brief CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+ *        逐位计算, 不占查表内存, 耗时只与长度有关
+ */
+static inline uint16_t motor_proto_crc16(const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    uint16_t crc = 0xFFFF;
+    size_t i;
+    int bit;
+
+    for (i = 0; i < len; i++) {
+        crc ^= (uint16_t)p[i] << 8;
+        for (bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021)
+                                 : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief 填充帧头并计算 CRC
+ * @param flags 帧头 flags (FEEDBACK 为故障标志, 其他为 0)
+ */
+static inline void motor_proto_finalize(struct motor_proto_wheel_frame *frame,
+                                        uint8_t type, uint8_t flags, uint32_t seq,
+                                        uint32_t timestamp_us)
+{
+    frame->hdr.magic = MOTOR_PROTO_MAGIC;
+    frame->hdr.version = MOTOR_PROTO_VERSION;
+    frame->hdr.type = type;
+    frame->hdr.flags = flags;
+    frame->hdr.seq = seq;
+    frame->hdr.timestamp_us = timestamp_us;
+    frame->crc = motor_proto_crc16(frame, offsetof(struct motor_proto_wheel_frame, crc));
+}
+
+/**
+ * @brief 在变长帧的 body 之后写入 CRC
+ *        CRC 位置随记录数变化, 可能不对齐, 逐字节写入 (小端)
+ */
+static inline void motor_proto_put_tail_crc(void *frame, size_t body)
+{
+    uint8_t *tail = (uint8_t *)frame + body;
+    uint16_t crc = motor_proto_crc16(frame, body);
+
+    tail[0] = (uint8_t)(crc & 0xFF);
+    tail[1] = (uint8_t)(crc >> 8);
+}
+
+/**
+ * @brief 校验变长帧 body 之后的 CRC
+ */
+static inline int motor_proto_tail_crc_ok(const void *frame, size_t body)
+{
+    const uint8_t *tail = (const uint8_t *)frame + body;
+
+    return (uint16_t)(tail[0] | (tail[1] << 8)) == motor_proto_crc16(frame, body);
+}
+
+static inline void motor_proto_fill_hdr(struct motor_proto_hdr *hdr, uint8_t type,
+                                        uint8_t flags, uint32_t seq, uint32_t timestamp_us)
+{
+    hdr->magic = MOTOR_PROTO_MAGIC;
+    hdr->version = MOTOR_PROTO_VERSION;
+    hdr->type = type;
+    hdr->flags = flags;
+    hdr->seq = seq;
+    hdr->timestamp_us = timestamp_us;
+}
+
+/**
+ * @brief 填充定长帧 (TWIST / ODOM) 的帧头并计算末尾 CRC
+ * @param size 帧结构体大小 (含 crc16)
+ * @param flags 帧头 flags (ODOM 为故障标志, TWIST 为 0)
+ */
+static inline void motor_proto_fixed_finalize(void *frame, size_t size, uint8_t type,
+                                              uint8_t flags, uint32_t seq,
+                                              uint32_t timestamp_us)
+{
+    motor_proto_fill_hdr((struct motor_proto_hdr *)frame, type, flags, seq, timestamp_us);
+    motor_proto_put_tail_crc(frame, size - sizeof(uint16_t));
+}
+
+/**
+ * @brief 填充遥测帧头并在记录之后写入 CRC (records/count/dropped 由调用方填写)
+ * @param flags 故障标志
+ * @return 帧总长度
+ */
+static inline size_t motor_proto_telemetry_finalize(
+    struct motor_proto_telemetry_frame *frame, uint8_t flags, uint32_t seq,
+    uint32_t timestamp_us)
+{
+    size_t body = motor_proto_telemetry_size(frame->count) - sizeof(uint16_t);
+
+    motor_proto_fill_hdr(&frame->hdr, MOTOR_PROTO_TYPE_TELEMETRY, flags, seq, timestamp_us);
+    frame->reserved = 0;
+    motor_proto_put_tail_crc(frame, body);
+    return body + sizeof(uint16_t);
+}
+
+/**
+ * @brief 填充剖析帧头并在记录之后写入 CRC (count 及其余字段由调用方填写)
+ * @return 帧总长度
+ */
+static inline size_t motor_proto_profile_finalize(
+    struct motor_proto_profile_frame *frame, uint32_t seq, uint32_t timestamp_us)
+{
+    size_t body = motor_proto_profile_size(frame->count) - sizeof(uint16_t);
+
+    motor_proto_fill_hdr(&frame->hdr, MOTOR_PROTO_TYPE_PROFILE, 0, seq, timestamp_us);
+    frame->reserved = 0;
+    motor_proto_put_tail_crc(frame, body);
+    return body + sizeof(uint16_t);
+}
+
+/**
+ * @brief 填充轨迹帧头并在航点之后写入 CRC (count 及其余字段由调用方填写)
+ * @return 帧总长度
+ */
+static inline size_t motor_proto_traj_finalize(
+    struct motor_proto_traj_frame *frame, uint32_t seq, uint32_t timestamp_us)
+{
+    size_t body = motor_proto_traj_size(frame->count) - sizeof(uint16_t);
+
+    motor_proto_fill_hdr(&frame->hdr, MOTOR_PROTO_TYPE_TRAJ, 0, seq, timestamp_us);
+    frame->reserved = 0;
+    motor_proto_put_tail_crc(frame, body);
+    return body + sizeof(uint16_t);
+}
+
+/**
+ * @brief 计算时延回显尾部的 CRC (其余字段由调用方填写)
+ */
+static inline void motor_proto_echo_finalize(struct motor_proto_echo *echo)
+{
+    echo->crc = motor_proto_crc16(echo, offsetof(struct motor_proto_echo, crc));
+}
+
+/**
+ * @brief 判断收到的数据是否为二进制帧 (只看 magic, 文本帧首字节不会是 0xA5)
+ */
+static inline int motor_proto_is_binary(const void *data, size_t len)
+{
+    return len > 0 && ((const uint8_t *)data)[0] == MOTOR_PROTO_MAGIC;
+}
+
+/**
+ * @brief 校验遥测帧
+ * @return 0 合法, -1 长度/CRC 错误
+ */
+static inline int motor_proto_telemetry_check(const void *data, size_t len)
+{
+    const struct motor_proto_telemetry_frame *frame =
+        (const struct motor_proto_telemetry_frame *)data;
+
+    if (len < motor_proto_telemetry_size(0) ||
+        len < motor_proto_telemetry_size(frame->count)) {
+        return -1;
+    }
+    if (!motor_proto_tail_crc_ok(data, motor_proto_telemetry_size(frame->count) -
+                                           sizeof(uint16_t))) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 校验剖析帧
+ * @return 0 合法, -1 长度/CRC 错误
+ */
+static inline int motor_proto_profile_check(const void *data, size_t len)
+{
+    const struct motor_proto_profile_frame *frame =
+        (const struct motor_proto_profile_frame *)data;
+
+    if (len < motor_proto_profile_size(0) ||
+        len < motor_proto_profile_size(frame->count)) {
+        return -1;
+    }
+    if (!motor_proto_tail_crc_ok(data, motor_proto_profile_size(frame->count) -
+                                           sizeof(uint16_t))) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 校验轨迹帧
+ * @return 0 合法, -1 长度/CRC 错误
+ */
+static inline int motor_proto_traj_check(const void *data, size_t len)
+{
+    const struct motor_proto_traj_frame *frame =
+        (const struct motor_proto_traj_frame *)data;
+
+    if (len < motor_proto_traj_size(0) ||
+        len < motor_proto_traj_size(frame->count)) {
+        return -1;
+    }
+    if (!motor_proto_tail_crc_ok(data, motor_proto_traj_size(frame->count) -
+                                           sizeof(uint16_t))) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 校验定长帧 (TWIST / ODOM)
+ * @param size 帧结构体大小 (含 crc16)
+ * @return 0 合法, -1 长度/CRC 错误
+ */
+static inline int motor_proto_fixed_check(const void *data, size_t len, size_t size)
+{
+    if (len < size || !motor_proto_tail_crc_ok(data, size - sizeof(uint16_t))) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 校验二进制帧 (按帧类型区分定长轮速帧、底盘速度帧和变长遥测/剖析/轨迹帧)
+ * @return 0 合法, -1 长度/magic/版本/CRC 错误
+ */
+static inline int motor_proto_check(const void *data, size_t len)
+{
+    const struct motor_proto_wheel_frame *frame =
+        (const struct motor_proto_wheel_frame *)data;
+
+    if (len < sizeof(struct motor_proto_hdr)) {
+        return -1;
+    }
+    if (frame->hdr.magic != MOTOR_PROTO_MAGIC ||
+        frame->hdr.version != MOTOR_PROTO_VERSION) {
+        return -1;
+    }
+    if (frame->hdr.type == MOTOR_PROTO_TYPE_TELEMETRY) {
+        return motor_proto_telemetry_check(data, len);
+    }
+    if (frame->hdr.type == MOTOR_PROTO_TYPE_PROFILE) {
+        return motor_proto_profile_check(data, len);
+    }
+    if (frame->hdr.type == MOTOR_PROTO_TYPE_TRAJ) {
+        return motor_proto_traj_check(data, len);
+    }
+    if (frame->hdr.type == MOTOR_PROTO_TYPE_TWIST) {
+        return motor_proto_fixed_check(data, len, sizeof(struct motor_proto_twist_frame));
+    }
+    if (frame->hdr.type == MOTOR_PROTO_TYPE_ODOM) {
+        return motor_proto_fixed_check(data, len, sizeof(struct motor_proto_odom_frame));
+    }
+    if (len < sizeof(*frame)) {
+        return -1;
+    }
+    if (frame->crc !=
+        motor_proto_crc16(frame, offsetof(struct motor_proto_wheel_frame, crc))) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 查找已校验帧之后的时延回显尾部
+ * @param data 已通过 motor_proto_check 的 FEEDBACK / TELEMETRY / ODOM 帧
+ * @return 尾部地址 (可能不对齐, 只能按 packed 结构体访问), 没有或校验失败返回 NULL
+ */
+static inline const struct motor_proto_echo *motor_proto_echo_find(const void *data,
+                                                                   size_t len)
+{
+    const struct motor_proto_hdr *hdr = (const struct motor_proto_hdr *)data;
+    const struct motor_proto_echo *echo;
+    size_t base;
+
+    if (hdr->type == MOTOR_PROTO_TYPE_FEEDBACK) {
+        base = sizeof(struct motor_proto_wheel_frame);
+    } else if (hdr->type == MOTOR_PROTO_TYPE_TELEMETRY) {
+        base = motor_proto_telemetry_size(
+            ((const struct motor_proto_telemetry_frame *)data)->count);
+    } else if (hdr->type == MOTOR_PROTO_TYPE_ODOM) {
+        base = sizeof(struct motor_proto_odom_frame);
+    } else {
+        return NULL;
+    }
+    if (len < base + sizeof(*echo)) {
+        return NULL;
+    }
+    echo = (const struct motor_proto_echo *)((const uint8_t *)data + base);
+    if (echo->crc != motor_proto_crc16(echo, offsetof(struct motor_proto_echo, crc))) {
+        return NULL;
+    }
+    return echo;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MOTOR_PROTO_H */
@@ -11,6 +11,73 @@
 extern "C" {
 #endif
 
+/* ==================== 按轴控制 (轴号 0 ~ MOTOR_AXIS_NUM-1) ==================== */
+
+/**
+ * @brief 初始化一个轴的PWM (设备和通道取自轴描述表)
+ * @param axis 轴号
+ * @return RT_EOK 成功, -RT_EINVAL 轴号无效, 其他值表示失败
+ */
+rt_err_t motor_axis_pwm_init(int axis);
+
+/**
+ * @brief 设置一个轴的占空比
+ * @param axis 轴号
+ * @param duty 占空比 (0.0 ~ 1.0)
+ * @return RT_EOK 成功, 其他值表示失败
+ */
+rt_err_t motor_axis_set_duty(int axis, float duty);
+
+/**
+ * @brief 设置一个轴的原始脉冲宽度
+ * @param axis 轴号
+ * @param pulse_ns 脉冲宽度 (纳秒), 0 ~ PWM_PERIOD
+ * @return RT_EOK 成功, 其他值表示失败
+ */
+rt_err_t motor_axis_set_pulse(int axis, rt_uint32_t pulse_ns);
+
+/**
+ * @brief 停止一个轴 (占空比设为0)
+ * @return RT_EOK 成功, 其他值表示失败
+ */
+rt_err_t motor_axis_stop(int axis);
+
+/* ==================== 多轴同步更新 ==================== */
+
+/* 同步更新统计 */
+struct motor_pwm_sync_stats
+{
+    rt_uint32_t count;           /* 同步更新次数 */
+    rt_uint32_t last_latency_ns; /* 调用到最后一个通道写入完成 */
+    rt_uint32_t max_latency_ns;
+    rt_uint32_t last_skew_ns;    /* 第一个到最后一个通道写入完成 */
+    rt_uint32_t max_skew_ns;
+};
+
+/**
+ * @brief 在同一个临界区内写入多个轴的脉宽, 减小轮间偏差
+ * @param pulse_ns 各轴脉宽 (纳秒), MOTOR_AXIS_NUM 项, 超过 PWM_PERIOD 时截断
+ * @param mask 需要写入的轴 (bit i 对应轴 i)
+ * @return RT_EOK 成功, 任一轴失败返回 -RT_ERROR
+ */
+rt_err_t motors_set_pulses(const rt_uint32_t *pulse_ns, rt_uint32_t mask);
+
+/**
+ * @brief 同步设置电机1/电机2的占空比
+ * @param duty1 电机1占空比 (0.0 ~ 1.0)
+ * @param duty2 电机2占空比 (0.0 ~ 1.0)
+ * @return RT_EOK 成功, 其他值表示失败
+ */
+rt_err_t motors_set_duty_pair(float duty1, float duty2);
+
+/**
+ * @brief 获取同步更新的延迟和通道间偏差
+ *        实际生效还需等控制器在当前周期结束时装载, 最坏再加一个 PWM_PERIOD
+ */
+void motors_pwm_get_sync_stats(struct motor_pwm_sync_stats *out);
+
+/* ==================== 电机1/电机2 (轴 0/轴 1) ==================== */
+
 /**
  * @brief 初始化电机1的PWM
  * @return RT_EOK 成功, 其他值表示失败
@@ -24,7 +91,7 @@ rt_err_t motor1_pwm_init(void);
 rt_err_t motor2_pwm_init(void);
 
 /**
- * @brief 初始化两个电机的PWM
+ * @brief 初始化所有电机的PWM
  * @return RT_EOK 成功, 其他值表示失败
  */
 rt_err_t motors_pwm_init(void);
@@ -70,7 +137,7 @@ rt_err_t motor1_stop(void);
 rt_err_t motor2_stop(void);
 
 /**
- * @brief 停止两个电机
+ * @brief 停止所有电机
  * @return RT_EOK 成功, 其他值表示失败
  */
 rt_err_t motors_stop(void);
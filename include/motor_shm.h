@@ -0,0 +1,137 @@
+/*
+ * 大小核共享内存状态块 - 头文件
+ *
+ * 大核 (k3_src) 与小核共用, 只依赖 <stdint.h> 和 motor_proto.h, 不依赖 RT-Thread
+ *
+ * 小核底盘控制线程每个节拍把轮速、PID 输出、位姿和状态标志写入状态块,
+ * 大核 mmap 该区域后随时读取, 不经过 RPMsg, 不产生中断;
+ * RPMsg 只用于指令和事件
+ *
+ * 布局 (小端, 字段自然对齐, 没有填充):
+ *   magic(4) version(2) state_size(2) seq(4) reserved(4) state
+ *   不使用 packed: seq 须按 32 位整字访问, 否则读端可能看到拆开的写入
+ *
+ * 读写规则 (单写者 seqlock):
+ * - 写端 (小核): seq 加 1 (奇数) -> 写 state -> seq 加 1 (偶数);
+ *   不带缓存一致性时每一步之后写回对应的缓存行 (见 motor_shm.c)
+ * - 读端 (大核): 读 seq, 为奇数时重试; 拷贝 state; 再读 seq, 变化时重试
+ * - 新版本只在 state 末尾追加字段, state_size 给出小核实际写入的长度
+ *
+ * 地址: 小核在 HELLO 应答中通告 (见 motor_proto.h), 大核也可以直接指定
+ */
+
+#ifndef MOTOR_SHM_H
+#define MOTOR_SHM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "motor_proto.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MOTOR_SHM_MAGIC   0x4D48534DU /* "MSHM" */
+#define MOTOR_SHM_VERSION 1
+#define MOTOR_SHM_SIZE    4096        /* 保留区域大小 (一页) */
+
+/* 状态标志 */
+#define MOTOR_SHM_FLAG_TRAJ      0x00000001U /* 正在执行轨迹 */
+#define MOTOR_SHM_FLAG_SATURATED 0x00000002U /* 有轴占空比达到上限 */
+#define MOTOR_SHM_FLAG_OVERRUN   0x00000004U /* 本节拍之前发生过节拍超时 */
+#define MOTOR_SHM_FLAG_TUNING    0x00000008U /* 正在执行 PID 自整定或前馈标定 */
+#define MOTOR_SHM_FLAG_FAULT_SHIFT 8           /* bit8~15: 故障标志 MOTOR_PROTO_FAULT_* */
+#define MOTOR_SHM_FLAG_FAULT_MASK  0x0000FF00U
+
+/* 一个控制节拍的状态快照 */
+struct motor_shm_state {
+    uint32_t tick;         /* 发布次数 */
+    uint32_t timestamp_us; /* 采样时刻 (us, 允许回绕), 与遥测记录同一时基 */
+    uint32_t flags;        /* MOTOR_SHM_FLAG_* */
+    uint32_t overruns;     /* 控制节拍超时累计次数 */
+    uint32_t cmd_seq;      /* 最近一条已输出到 PWM 的 CMD 帧序号 */
+    int32_t x_mm;          /* 里程计位姿 */
+    int32_t y_mm;
+    int32_t yaw_urad;      /* 范围 [-pi, pi) */
+    int32_t v_mmps;        /* 底盘线速度 */
+    int32_t w_mradps;      /* 底盘角速度 */
+    struct motor_proto_telemetry_wheel wheel[MOTOR_PROTO_WHEELS]; /* 与遥测记录相同 */
+};
+
+typedef char motor_shm_state_size_check
+    [(sizeof(struct motor_shm_state) == 80) ? 1 : -1];
+
+struct motor_shm_block {
+    uint32_t magic;      /* MOTOR_SHM_MAGIC, 小核初始化完成后写入 */
+    uint16_t version;    /* MOTOR_SHM_VERSION */
+    uint16_t state_size; /* sizeof(struct motor_shm_state) */
+    uint32_t seq;        /* 奇数表示写入中 */
+    uint32_t reserved;
+    struct motor_shm_state state;
+};
+
+typedef char motor_shm_block_size_check
+    [(sizeof(struct motor_shm_block) == 96 &&
+      offsetof(struct motor_shm_block, state) == 16) ? 1 : -1];
+
+/**
+ * @brief 检查状态块头部 (大核映射后调用)
+ * @return 0 合法, -1 magic/版本不匹配
+ */
+static inline int motor_shm_check(const volatile struct motor_shm_block *blk)
+{
+    if (blk->magic != MOTOR_SHM_MAGIC || blk->version != MOTOR_SHM_VERSION ||
+        blk->state_size < sizeof(struct motor_shm_state)) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 无锁读取状态快照
+ * @param max_tries 写端一直在写时最多重试的次数
+ * @return 0 成功, -1 超过重试次数
+ */
+static inline int motor_shm_read(const volatile struct motor_shm_block *blk,
+                                 struct motor_shm_state *out, int max_tries)
+{
+    uint32_t seq;
+
+    while (max_tries-- > 0) {
+        seq = blk->seq;
+        if (seq & 1U) {
+            continue;
+        }
+        __sync_synchronize();
+        memcpy(out, (const void *)&blk->state, sizeof(*out));
+        __sync_synchronize();
+        if (blk->seq == seq) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/* ================= 小核接口 (src/motor_shm.c) ================= */
+
+/**
+ * @brief 初始化状态块 (清零并写入头部), 底盘控制线程启动前调用
+ */
+void motor_shm_init(void);
+
+/**
+ * @brief 发布一个节拍的状态 (只在底盘控制线程中调用, 不阻塞)
+ */
+void motor_shm_publish(const struct motor_shm_state *state);
+
+/**
+ * @brief 大核看到的状态块物理地址 (小核地址加 MOTOR_SHM_PHYS_OFFSET)
+ */
+uint64_t motor_shm_get_phys_addr(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MOTOR_SHM_H */
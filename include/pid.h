@@ -3,6 +3,20 @@
 
 #include <math.h>
 
+/*
+ * 可选项 (PID_Controller_Init 之后默认全部关闭, 行为与只做积分限幅的原实现一致):
+ * - 抗积分饱和: 条件积分 (输出饱和且误差使其更饱和时停止积分) 或反算
+ *   (饱和量 u_sat - u 乘以 kb 回馈到积分)
+ * - 微分取测量值 (目标值阶跃时没有微分冲击), 微分一阶低通
+ * - 输出变化率限制 (含前馈, 作用在限幅之前)
+ * 用 PID_Set_* 在 Init 之后设置, 参数换算依赖 dt
+ */
+
+/* 抗积分饱和方式 */
+#define PID_AW_NONE      0  // 只做积分限幅
+#define PID_AW_CLAMP     1  // 条件积分
+#define PID_AW_BACK_CALC 2  // 反算
+
 typedef struct
 {
     /* 参数 */
@@ -30,6 +44,17 @@ typedef struct
     /* 时间 */
     float dt;
 
+    /* 可选项 */
+    int aw_mode;        // PID_AW_*
+    float aw_kb;        // 反算增益 (1/s)
+    int d_on_meas;      // 非 0: 微分取 -d(feedback)/dt
+    float d_alpha;      // 微分低通系数 dt / (tau + dt), 1 = 不滤波
+    float slew_step;    // 每次更新输出最大变化量, 0 = 不限制
+
+    /* 可选项状态 */
+    float last_feedback;
+    float d_filt;       // 滤波后的微分 (误差变化率)
+
 } PID_Controller;
 
 void PID_Controller_Init(PID_Controller *pid,
@@ -38,6 +63,15 @@ void PID_Controller_Init(PID_Controller *pid,
               float i_limit,
               float out_limit);
 
+// 抗积分饱和, kb <= 0 时取 ki / kp (1 / Ti)
+void PID_Set_AntiWindup(PID_Controller *pid, int mode, float kb);
+
+// 微分取测量值 / 低通时间常数 (s, 0 = 不滤波)
+void PID_Set_Derivative(PID_Controller *pid, int on_measurement, float filter_tau);
+
+// 输出变化率上限 (每秒, 0 = 不限制)
+void PID_Set_Slew(PID_Controller *pid, float rate);
+
 // 普通PID
 float PID_Update(PID_Controller *pid, float feedback);
 
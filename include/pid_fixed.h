@@ -0,0 +1,93 @@
+#ifndef MYPID_FIXED_H
+#define MYPID_FIXED_H
+
+/*
+ * Q16.16 定点 PID
+ *
+ * 与 pid.h 接口一一对应, 内部只做整数运算:
+ * - ki*dt、kd/dt 在初始化时预先计算, 每次更新没有除法
+ * - 积分直接累加 ki*dt*err (即 i_out), 限幅为 ki*i_limit, 与浮点版本等价;
+ *   ki*dt 在 1kHz 时只有十几个 Q16 LSB, 累加器和 ki*dt、kb*dt 用 Q32.32 (int64),
+ *   每次累加四舍五入, 小误差不会被截掉, 负误差也不会系统性向下取整
+ * - 乘法结果四舍五入到 Q16.16
+ * - 可选项 (抗积分饱和 / 微分取测量值与低通 / 输出变化率) 与 pid.h 相同,
+ *   增益和系数同样在 PID_Fixed_Set_* 中预先换算
+ * 在 SConscript 中打开 PID_USING_FIXED 后由底盘控制线程使用
+ */
+
+#include <stdint.h>
+#include "pid.h"    // PID_AW_*
+
+typedef int32_t pid_q16_t;
+
+#define PID_Q16_SHIFT 16
+#define PID_Q16_ONE   ((pid_q16_t)1 << PID_Q16_SHIFT)
+
+#define PID_Q16_FROM_FLOAT(x) ((pid_q16_t)((x) * (float)PID_Q16_ONE))
+#define PID_Q16_TO_FLOAT(x)   ((float)(x) / (float)PID_Q16_ONE)
+
+/* 积分累加器定点格式 Q32.32 */
+#define PID_Q32_SHIFT 32
+#define PID_Q32_FROM_FLOAT(x) ((int64_t)((double)(x) * 4294967296.0))
+
+typedef struct
+{
+    /* 参数 (预计算) */
+    pid_q16_t kp;
+    int64_t ki_dt;          // ki * dt, Q32.32
+    pid_q16_t kd_dt;        // kd / dt
+
+    /* 运行状态 */
+    pid_q16_t setpoint;     // 目标值
+    pid_q16_t feedback;     // 测量值
+    pid_q16_t err;
+    pid_q16_t last_err;
+
+    /* 输出 */
+    pid_q16_t p_out;
+    pid_q16_t i_out;        // 积分项
+    int64_t i_acc;          // 积分累加器 (i_out 的 Q32.32 值)
+    pid_q16_t d_out;
+    pid_q16_t output;
+
+    /* 限制 */
+    pid_q16_t i_out_limit;  // ki * i_limit
+    int64_t i_acc_limit;    // i_out_limit, Q32.32
+    pid_q16_t out_limit;
+
+    /* 可选项 (预计算) */
+    int aw_mode;            // PID_AW_*
+    int64_t aw_kb_dt;       // kb * dt, Q32.32
+    int d_on_meas;
+    pid_q16_t d_alpha;      // dt / (tau + dt), PID_Q16_ONE = 不滤波
+    pid_q16_t slew_step;    // rate * dt, 0 = 不限制
+
+    /* 可选项状态 */
+    pid_q16_t last_feedback;
+    pid_q16_t d_filt;       // 滤波后的每周期误差变化量
+
+} PID_Fixed_Controller;
+
+void PID_Fixed_Init(PID_Fixed_Controller *pid,
+              float kp, float ki, float kd,
+              float dt,
+              float i_limit,
+              float out_limit);
+
+// 可选项, 参数同 PID_Set_*
+void PID_Fixed_Set_AntiWindup(PID_Fixed_Controller *pid, int mode, float kb, float kp, float ki,
+              float dt);
+void PID_Fixed_Set_Derivative(PID_Fixed_Controller *pid, int on_measurement, float filter_tau,
+              float dt);
+void PID_Fixed_Set_Slew(PID_Fixed_Controller *pid, float rate, float dt);
+
+// 普通PID
+pid_q16_t PID_Fixed_Update(PID_Fixed_Controller *pid, pid_q16_t feedback);
+
+// 前馈控制
+pid_q16_t PID_Fixed_FF_Update(PID_Fixed_Controller *pid, pid_q16_t feedback, pid_q16_t pwm_ff);
+
+// BangBang PID
+pid_q16_t PID_Fixed_BangBang_Update(PID_Fixed_Controller *pid, pid_q16_t feedback);
+
+#endif
@@ -0,0 +1,113 @@
+/*
+ * 线程剖析 - 头文件
+ *
+ * - CPU 占用: 调度钩子在每次线程切换时把上一段时间记到被切出的线程上,
+ *   中断钩子把中断处理时间单独记为 irq (需 RT_USING_HOOK, 未开启时只有下面两项)
+ * - 循环耗时: 线程在每次迭代前后调用 profiler_loop_begin/end, 记录单次迭代的
+ *   CPU 时间 (不含被抢占和中断) 与响应时间 (含被抢占) 的最大值
+ * - 栈高水位: 查询时扫描线程栈中未被改写的填充字节 ('#'), 不占用实时路径
+ *
+ * 统计从 profiler_reset 开始累计, msh "prof" 查看;
+ * 设置上报周期后反馈线程定期发送 MOTOR_PROTO_TYPE_PROFILE 帧, 占用率按上报窗口计算
+ *
+ * 线程优先级可以在运行中修改 (msh "prof prio <thread> <n>" / RPMsg "CFG,prio,..."),
+ * 用于对比不同优先级安排下的循环耗时和响应时间
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <rtthread.h>
+#include "common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct profiler_thread_info
+{
+    char name[RT_NAME_MAX + 1];
+    rt_bool_t alive;           /* 线程已退出时为 RT_FALSE, 保留退出前的统计 */
+    rt_uint8_t priority;
+    rt_uint32_t switches;      /* 被切入次数 */
+    rt_uint64_t runtime;       /* 累计运行时间 (hrtime 计数) */
+    rt_uint32_t stack_size;    /* 字节, 线程已退出时为 0 */
+    rt_uint32_t stack_used;    /* 栈高水位, 字节 */
+    rt_uint32_t loops;         /* 已统计的迭代次数 */
+    rt_uint64_t exec_sum;      /* 迭代 CPU 时间累计 (hrtime 计数) */
+    rt_uint64_t exec_max;      /* 单次迭代最大 CPU 时间 */
+    rt_uint64_t resp_max;      /* 单次迭代最大响应时间 */
+};
+
+struct profiler_summary
+{
+    rt_uint64_t elapsed;       /* 统计时长 (hrtime 计数) */
+    rt_uint64_t idle;          /* 空闲线程运行时间 */
+    rt_uint64_t irq;           /* 中断处理时间 */
+    rt_uint64_t other;         /* 超出 PROFILER_MAX_THREADS 的线程运行时间 */
+    rt_bool_t hooked;          /* 调度钩子是否生效 (否则 runtime 无效) */
+};
+
+/**
+ * @brief 初始化并安装调度/中断钩子, 在创建线程之前调用
+ */
+rt_err_t profiler_init(void);
+
+/**
+ * @brief 清空全部统计 (已退出线程的记录一并清除)
+ */
+void profiler_reset(void);
+
+/**
+ * @brief 标记当前线程一次迭代的开始 (每个线程只统计一个循环)
+ */
+void profiler_loop_begin(void);
+
+/**
+ * @brief 标记当前线程一次迭代的结束, 与 profiler_loop_begin 成对调用
+ */
+void profiler_loop_end(void);
+
+/**
+ * @brief 获取各线程统计, 同时扫描栈高水位 (锁调度器, 耗时与栈的未用部分成正比)
+ * @param out 输出数组
+ * @param max 数组容量
+ * @param summary 输出总计, 可为 RT_NULL
+ * @return 写入的线程数
+ */
+rt_size_t profiler_snapshot(struct profiler_thread_info *out, rt_size_t max,
+                            struct profiler_summary *summary);
+
+/**
+ * @brief 获取上报窗口 (上次调用至今) 内的统计并开始下一个窗口, 只由上报线程调用
+ *        runtime/elapsed/idle/irq/other 为窗口内的增量, 其余字段同 profiler_snapshot
+ */
+rt_size_t profiler_report(struct profiler_thread_info *out, rt_size_t max,
+                          struct profiler_summary *summary);
+
+/**
+ * @brief 设置 RPMsg 剖析帧上报周期
+ * @param ms 周期, 0 关闭
+ */
+void profiler_set_report_ms(rt_uint32_t ms);
+
+rt_uint32_t profiler_get_report_ms(void);
+
+/**
+ * @brief 上报周期已开启且距上次上报已满一个周期
+ */
+rt_bool_t profiler_report_due(void);
+
+/**
+ * @brief 修改线程优先级 (不在实时路径中调用), 重启后恢复为代码中的默认值
+ * @param name 线程名
+ * @param priority 0 ~ RT_THREAD_PRIORITY_MAX - 2 (最低优先级留给空闲线程)
+ * @return RT_EOK 成功, -RT_EEMPTY 没有该线程, -RT_EINVAL 优先级超出范围或为空闲线程
+ */
+rt_err_t profiler_set_priority(const char *name, rt_uint8_t priority);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROFILER_H */
@@ -5,8 +5,13 @@
  *
  * 协议:
  * - 速度指令: "dir1,speed1;dir2,speed2"
- * - 参数指令: "CFG,ratio,ff,kp,ki,kd[,feedback_enable]"
+ * - 参数指令: "CFG,ratio,ff,kp,ki,kd[,feedback_enable[,radius,base[,factor1,factor2]]]"
+ *   feedback_enable: 0=关闭, 1=状态反馈, 2=批量遥测, 3=里程计位姿 (2/3 需二进制协议)
+ *   radius/base: 轮半径 / 轮距 (m), factor: 逆运动学轮速修正系数, 0 保持当前值
  * - 状态反馈: "dir1,speed1_mrs;dir2,speed2_mrs"
+ * - 二进制帧: 见 motor_proto.h, 大核发送 HELLO 协商后启用
+ * - 诊断通道: "rpmsg:motor_diag" 端点 (1004 <-> 1005) 只处理配置与诊断,
+ *   应答走请求所在的端点, "DIAG" 应答 "DIAG,ok" (见 rpmsg_motor.c)
  */
 
 #ifndef RPMSG_MOTOR_H
@@ -27,14 +32,72 @@ rt_err_t rpmsg_motor_init(void);
 
 /**
  * @brief 设置状态反馈间隔
+ *        采样模式下换算为每 N 个控制节拍发送一次
  * @param ms 反馈间隔 (毫秒), 最小 10ms
  */
 void rpmsg_motor_set_feedback_interval(int ms);
 
+/**
+ * @brief 通知有新采样 (底盘控制线程每周期发布状态后调用)
+ *        不阻塞; 端点未绑定或反馈关闭时不唤醒反馈线程
+ */
+void rpmsg_motor_notify_sample(void);
+
+/**
+ * @brief 解析文本速度指令 "dir1,speed1;dir2,speed2" (不修改输入, 也供 bench 调用)
+ * @return RT_EOK 成功, -RT_ERROR 空指令
+ */
+rt_err_t parse_speed_command(const char *cmd, int *dir1, double *speed1,
+                             int *dir2, double *speed2);
+
+/**
+ * @brief 解析文本参数指令 "CFG,ratio,ff,kp,ki,kd[,feedback_enable]" (也供 bench 调用)
+ * @param[out] feedback_enable 可为 RT_NULL; 指令中没有该项时为 -1
+ * @return RT_EOK 成功, -RT_ERROR 格式错误
+ */
+rt_err_t parse_cfg_command(const char *cmd, double *ratio, double *ff,
+                           double *kp, double *ki, double *kd,
+                           int *feedback_enable);
+
+/**
+ * @brief 发送一条文本事件 (如自整定结果), 不受反馈开关影响
+ *        最近一条请求来自诊断端点时从诊断端点发送
+ * @return RT_EOK 成功, -RT_ERROR 端点未绑定或发送失败
+ */
+rt_err_t rpmsg_motor_send_event(const char *text);
+
+struct autotune_config;
+
+/**
+ * @brief 解析自整定指令 "TUNE,step|relay[,duty_low,duty_high[,apply]]"
+ * @return RT_EOK 成功, -RT_ERROR 格式错误
+ */
+rt_err_t parse_tune_command(const char *cmd, struct autotune_config *cfg);
+
+struct chassis_geometry;
+
+/**
+ * @brief 解析参数指令中的底盘几何参数 (feedback_enable 之后的字段)
+ * @param[out] geo 没有的修正系数为 0
+ * @return RT_EOK 成功, -RT_ERROR 指令中没有几何参数
+ */
+rt_err_t parse_cfg_geometry(const char *cmd, struct chassis_geometry *geo);
+
 /* ================= 外部接口声明 (由 control_main.c 实现) ================= */
 
+/*
+ * 最近一条已输出到 PWM 的 CMD 帧 (时延回显)
+ */
+struct chassis_cmd_echo {
+  rt_bool_t valid;              /* 还没有 CMD 输出过时为 RT_FALSE */
+  rt_uint32_t cmd_seq;          /* CMD 帧序号 */
+  rt_uint32_t cmd_timestamp_us; /* CMD 帧发送方时间戳 */
+  rt_uint32_t rx_to_apply_us;   /* 收到 CMD -> PWM 更新 */
+  rt_uint64_t apply_hr;         /* PWM 更新时刻 (hrtime) */
+};
+
 /**
- * @brief 设置电机目标速度
+ * @brief 设置电机目标速度 (按轴描述表的指令通道分配到各轴)
  * @param dir1 电机1方向 (0=停止, 1=正转, 2=反转)
  * @param speed1 电机1目标转速 (转/秒)
  * @param dir2 电机2方向
@@ -43,6 +106,29 @@ void rpmsg_motor_set_feedback_interval(int ms);
 extern void chassis_set_target(int dir1, double speed1, int dir2,
                                double speed2);
 
+/**
+ * @brief 设置来自二进制 CMD 帧的目标速度, 同时记录帧序号和时间戳用于时延回显
+ * @param cmd_seq CMD 帧序号
+ * @param cmd_timestamp_us CMD 帧发送方时间戳
+ */
+extern void chassis_set_target_cmd(int dir1, double speed1, int dir2,
+                                   double speed2, rt_uint32_t cmd_seq,
+                                   rt_uint32_t cmd_timestamp_us);
+
+/**
+ * @brief 急停: 所有轴目标值置 0 并取消轨迹, 不经过加速度限制
+ */
+extern void chassis_emergency_stop(void);
+
+/**
+ * @brief 逐轴设置目标速度 (不经过指令通道映射)
+ * @param dir 各轴方向 (0=停止, 1=正转, 2=反转), num 项
+ * @param speed 各轴目标转速 (转/秒), num 项
+ * @param num 轴数, 不足 MOTOR_AXIS_NUM 的轴停止
+ */
+extern void chassis_set_axis_targets(const int *dir, const double *speed,
+                                     int num);
+
 /**
  * @brief 获取电机实际状态
  * @param[out] dir1 电机1实际方向
@@ -53,6 +139,19 @@ extern void chassis_set_target(int dir1, double speed1, int dir2,
 extern void chassis_get_status(int *dir1, int *speed1_mrs, int *dir2,
                                int *speed2_mrs);
 
+/**
+ * @brief 获取电机目标速度 (用于二进制反馈帧)
+ * @param[out] setpoint1_mrs 电机1目标转速 (毫转/秒, 符号表示方向)
+ * @param[out] setpoint2_mrs 电机2目标转速 (毫转/秒, 符号表示方向)
+ */
+extern void chassis_get_setpoint(int *setpoint1_mrs, int *setpoint2_mrs);
+
+/**
+ * @brief 获取最近一条已输出到 PWM 的 CMD 回显信息
+ * @param[out] echo 回显信息
+ */
+extern void chassis_get_cmd_echo(struct chassis_cmd_echo *echo);
+
 /**
  * @brief 更新底盘控制参数
  * @param reduction_ratio 减速比
@@ -64,6 +163,12 @@ extern void chassis_get_status(int *dir1, int *speed1_mrs, int *dir2,
 extern void chassis_set_cfg(double reduction_ratio, double ff, double kp,
                             double ki, double kd);
 
+/**
+ * @brief 读取底盘控制参数 (供自整定等模块在修改部分参数前读取)
+ */
+extern void chassis_get_cfg(double *reduction_ratio, double *ff, double *kp,
+                            double *ki, double *kd);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,93 @@
+/*
+ * 顺序锁 (seqlock) - 头文件
+ *
+ * 用于线程/中断之间传递小块数据:
+ * - 写端: 关中断期间完成 seq 自增 + 数据拷贝, 不会阻塞, 可在 RPMsg 回调和 ISR 中调用
+ * - 读端: 不获取任何内核对象, 读到写入中途的数据时重试
+ *
+ * 用法:
+ *   // 写
+ *   rt_base_t level = seqlock_write_begin(&lock);
+ *   data = new_value;
+ *   seqlock_write_end(&lock, level);
+ *
+ *   // 读
+ *   rt_uint32_t seq;
+ *   do {
+ *       seq = seqlock_read_begin(&lock);
+ *       copy = data;
+ *   } while (seqlock_read_retry(&lock, seq));
+ */
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <rtthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    volatile rt_uint32_t seq; /* 奇数表示写入中 */
+} seqlock_t;
+
+#define SEQLOCK_INIT { 0 }
+
+/* 编译器 + 内存屏障 */
+#define seqlock_barrier() __sync_synchronize()
+
+/**
+ * @brief 开始写入 (关中断, 多个写端之间互斥)
+ * @return 关中断前的中断状态, 传给 seqlock_write_end
+ */
+static inline rt_base_t seqlock_write_begin(seqlock_t *sl)
+{
+    rt_base_t level = rt_hw_interrupt_disable();
+    sl->seq++;
+    seqlock_barrier();
+    return level;
+}
+
+/**
+ * @brief 结束写入 (恢复中断)
+ */
+static inline void seqlock_write_end(seqlock_t *sl, rt_base_t level)
+{
+    seqlock_barrier();
+    sl->seq++;
+    rt_hw_interrupt_enable(level);
+}
+
+/**
+ * @brief 开始读取
+ * @return 读取开始时的序号, 传给 seqlock_read_retry
+ */
+static inline rt_uint32_t seqlock_read_begin(const seqlock_t *sl)
+{
+    rt_uint32_t seq;
+
+    /* 单核上写端关中断, 读端不会看到奇数; 多核时短暂自旋 */
+    while ((seq = sl->seq) & 1U)
+    {
+    }
+    seqlock_barrier();
+    return seq;
+}
+
+/**
+ * @brief 判断读取期间是否发生了写入
+ * @return 非 0 需要重新读取
+ */
+static inline int seqlock_read_retry(const seqlock_t *sl, rt_uint32_t start)
+{
+    seqlock_barrier();
+    return sl->seq != start;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SEQLOCK_H */
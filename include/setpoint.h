@@ -0,0 +1,88 @@
+/*
+ * 目标值队列与整形 - 头文件
+ *
+ * - 轨迹队列: 大核一次发送一段带时间偏移的轮速航点 (MOTOR_PROTO_TYPE_TRAJ),
+ *   底盘控制线程每个节拍按当前时刻在相邻航点之间线性插值;
+ *   时间偏移相对小核收到轨迹帧的时刻, 两端不需要对时
+ * - 整形: 目标值进入 PID 之前经过加速度 / 加加速度限制 (逐轴, 单位 r/s^2、r/s^3),
+ *   轨迹和 CMD 目标值都经过限制, 限制值为 0 时不生效
+ *
+ * 新的轨迹整体替换未执行完的航点; CMD / MSH 写入目标值时取消轨迹
+ */
+
+#ifndef SETPOINT_H
+#define SETPOINT_H
+
+#include <rtthread.h>
+#include "common.h"
+#include "motor_proto.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct setpoint_limits
+{
+    float accel;  /* 加速度上限 r/s^2, 0 不限制 */
+    float jerk;   /* 加加速度上限 r/s^3, 0 不限制 */
+};
+
+/* 单轴整形器状态 (只在底盘控制线程中访问) */
+struct setpoint_shaper
+{
+    float value;  /* 整形后的目标值 r/s, 带符号 */
+    float rate;   /* 当前变化率 r/s^2 */
+};
+
+/**
+ * @brief 装载轨迹 (不阻塞, 可在 RPMsg 回调中调用)
+ *        超过 SETPOINT_QUEUE_SIZE 或时间不递增的航点被丢弃
+ * @param points 航点, 轮速单位 mr/s
+ * @param count 航点数, 0 取消轨迹
+ * @return 实际装载的航点数
+ */
+rt_uint32_t setpoint_traj_load(const struct motor_proto_traj_point *points,
+                               rt_uint32_t count);
+
+/**
+ * @brief 取消轨迹, 目标值回到 CMD / MSH 写入的值
+ */
+void setpoint_traj_cancel(void);
+
+/**
+ * @brief 计算当前时刻的轨迹目标值 (只在底盘控制线程中调用)
+ * @param now 当前时刻 (hrtime)
+ * @param current 各指令通道当前目标值 (r/s), 新轨迹从该值过渡到第一个航点
+ * @param[out] out 各指令通道轨迹目标值 (r/s, 带符号)
+ * @return RT_TRUE 轨迹有效, RT_FALSE 没有轨迹 (out 不修改)
+ */
+rt_bool_t setpoint_traj_sample(rt_uint64_t now, const float *current, float *out);
+
+/**
+ * @brief 设置加速度 / 加加速度上限, 负值按 0 处理
+ */
+void setpoint_set_limits(float accel, float jerk);
+
+void setpoint_get_limits(struct setpoint_limits *out);
+
+/**
+ * @brief 整形器直接跳到 value (急停或关闭限制时使用)
+ */
+void setpoint_shaper_reset(struct setpoint_shaper *s, float value);
+
+/**
+ * @brief 整形器前进一个节拍
+ *        只限加速度时按斜坡逼近; 同时限加加速度时变化率按 jerk 斜坡变化,
+ *        并按剩余误差提前减小变化率, 到达目标时变化率为 0
+ * @param target 本节拍目标值 (r/s)
+ * @param dt 节拍周期 (秒)
+ * @return 整形后的目标值
+ */
+float setpoint_shaper_step(struct setpoint_shaper *s, float target, float dt,
+                           const struct setpoint_limits *lim);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SETPOINT_H */
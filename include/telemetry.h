@@ -0,0 +1,68 @@
+/*
+ * 批量遥测 - 头文件
+ *
+ * 底盘控制线程每个周期写入一条记录 (单生产者), 反馈线程批量取出 (单消费者),
+ * 打包成 MOTOR_PROTO_TYPE_TELEMETRY 帧一次发送, 避免逐周期发送 RPMsg 消息
+ *
+ * 满足以下任一条件时需要发送:
+ * - 待发送记录数达到批量大小
+ * - 最早一条待发送记录已超过最大时延
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <rtthread.h>
+#include "motor_proto.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 开启/关闭遥测采集, 开启时丢弃环形缓冲区中的旧记录
+ */
+void telemetry_set_enabled(rt_bool_t on);
+
+/**
+ * @brief 遥测采集是否开启
+ */
+rt_bool_t telemetry_is_enabled(void);
+
+/**
+ * @brief 写入一条记录 (只在底盘控制线程中调用), 缓冲区满时丢弃并计数
+ */
+void telemetry_push(const struct motor_proto_telemetry_record *rec);
+
+/**
+ * @brief 是否达到发送条件 (记录数或时延)
+ */
+rt_bool_t telemetry_flush_due(void);
+
+/**
+ * @brief 取出最多 max 条记录 (只在反馈线程中调用)
+ * @param out 输出位置, 可直接指向发送缓冲区
+ * @return 实际取出的记录数
+ */
+rt_uint32_t telemetry_pop(struct motor_proto_telemetry_record *out, rt_uint32_t max);
+
+/**
+ * @brief 累计丢弃的记录数
+ */
+rt_uint32_t telemetry_get_dropped(void);
+
+/**
+ * @brief 设置批量大小, 限制在 1 ~ MOTOR_PROTO_TELEMETRY_MAX_RECORDS
+ */
+void telemetry_set_batch(rt_uint32_t count);
+
+/**
+ * @brief 设置最大时延 (毫秒)
+ */
+void telemetry_set_max_age_ms(rt_uint32_t ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TELEMETRY_H */
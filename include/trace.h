@@ -0,0 +1,96 @@
+/*
+ * 二进制跟踪缓冲区 - 头文件
+ *
+ * 实时路径只写一条定长记录 (事件号 + 最多 TRACE_MAX_ARGS 个整数),
+ * 格式化打印由 MSH 命令或 trace 线程在实时路径之外完成
+ *
+ * 级别过滤:
+ * - 编译期: 高于 TRACE_COMPILE_LEVEL 的 TRACE() 整条语句被编译器删除
+ * - 运行期: 高于 trace_level 的记录不写入 (msh: trace level <n>)
+ *
+ * 用法:
+ *   TRACE(TRACE_LEVEL_DEBUG, TRACE_EVT_CHASSIS, delta1, delta2, ...);
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <rtthread.h>
+#include "common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 级别 */
+#define TRACE_LEVEL_OFF   0
+#define TRACE_LEVEL_ERROR 1
+#define TRACE_LEVEL_INFO  2
+#define TRACE_LEVEL_DEBUG 3
+
+#ifndef TRACE_COMPILE_LEVEL
+#define TRACE_COMPILE_LEVEL TRACE_LEVEL_DEBUG
+#endif
+
+#define TRACE_MAX_ARGS 8
+
+/* 事件号, 与 trace.c 中的格式表一一对应 */
+enum trace_event
+{
+    TRACE_EVT_CHASSIS = 0, /* 底盘控制周期: D1 D2 S1 S2 T1 T2 duty1 duty2 */
+    TRACE_EVT_CFG,         /* 参数生效: generation kp ki kd ff (x1000) */
+    TRACE_EVT_FAULT,       /* 故障关断: faults axes */
+    TRACE_EVT_RATE,        /* 控制频率切换: hz generation */
+    TRACE_EVT_NUM,
+};
+
+/* 一条跟踪记录 */
+struct trace_record
+{
+    rt_uint32_t seq;    /* 写入序号 + 1, 0 表示空; 最后写入, 读端据此判断记录完整 */
+    rt_uint32_t tick;   /* 系统节拍 */
+    rt_uint32_t hr;     /* hrtime 计数低 32 位, 用于计算相邻记录间隔 */
+    rt_uint16_t event;  /* enum trace_event */
+    rt_uint8_t level;
+    rt_uint8_t reserved;
+    rt_int32_t arg[TRACE_MAX_ARGS];
+};
+
+/* 运行期级别 (只读, 通过 trace_set_level 修改) */
+extern volatile rt_uint8_t trace_level;
+
+/**
+ * @brief 写入一条记录 (可在线程和中断中调用, 缓冲区满时覆盖最旧记录)
+ * @param args TRACE_MAX_ARGS 个参数
+ */
+void trace_write(rt_uint8_t level, rt_uint16_t event, const rt_int32_t *args);
+
+/**
+ * @brief 设置运行期级别
+ */
+void trace_set_level(rt_uint8_t level);
+
+/**
+ * @brief 清空缓冲区
+ */
+void trace_clear(void);
+
+/*
+ * 记录一个事件, 未给出的参数为 0
+ * 编译期级别不满足时整条语句为空, 参数表达式也不会求值
+ */
+#define TRACE(level, event, ...)                                               \
+    do                                                                         \
+    {                                                                          \
+        if ((level) <= TRACE_COMPILE_LEVEL && (level) <= trace_level)          \
+        {                                                                      \
+            trace_write((level), (event),                                      \
+                        (const rt_int32_t[TRACE_MAX_ARGS]){__VA_ARGS__});      \
+        }                                                                      \
+    } while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_H */
@@ -8,35 +8,102 @@
  *
  * Protocol with RCPU:
  *   send speed: "dir1,speed1;dir2,speed2"  speed unit: r/s
- *   send cfg:   "CFG,ratio,ff,kp,ki,kd,feedback_enable"
+ *   send cfg:   "CFG,ratio,ff,kp,ki,kd,feedback_enable,radius,base,factor1,factor2"
  *   recv fb:    "dir1,speed1_mrs;dir2,speed2_mrs" speed unit: mr/s
+ *
+ * Binary protocol (../include/motor_proto.h):
+ *   A HELLO frame is sent right after the endpoint is created. If the RCPU
+ *   answers with HELLO, speed commands and feedback switch to fixed-layout
+ *   binary frames; otherwise the text protocol above is kept.
+ *   With --telemetry (CFG feedback_enable=2) the RCPU sends TELEMETRY frames
+ *   carrying several control cycles each; odometry is integrated per cycle
+ *   using the RCPU sample timestamps.
+ *   Feedback and telemetry frames may carry an echo trailer with the seq and
+ *   timestamp of the last CMD frame the RCPU applied to the PWM; it is used
+ *   for round-trip latency statistics ("lat" command).
+ *   After "prof report <ms>" on the RCPU shell, PROFILE frames with per-thread
+ *   CPU load, loop time and stack usage arrive periodically; the latest one
+ *   is shown by the "prof" command.
+ *   With --rcpu-kin (CFG feedback_enable=3) commands go out as TWIST frames
+ *   (v, w) and the RCPU runs the inverse kinematics with the geometry appended
+ *   to CFG; it integrates odometry every control tick from raw encoder counts
+ *   and reports the pose in ODOM frames, which replace local integration.
+ *   With --shm the RCPU feedback is turned off and status is read from the
+ *   shared-memory block (../include/motor_shm.h) whose address arrives in the
+ *   HELLO reply; it is mapped from /dev/mem and read without any messaging.
+ *   Status frames carry the RCPU fault flags (command timeout, stall, encoder
+ *   loss) in hdr.flags, and every change is also sent as a "FAULT,<flags>,<axes>"
+ *   text event. The RCPU cuts the motors off on a fault; stall and encoder
+ *   faults stay latched until "fault clear".
+ *
+ * Threading:
+ *   The command (v, w, stamp) is written only by the stdin thread and the
+ *   odometry only by the receive thread. Each is published through a
+ *   single-writer seqlock snapshot, so the send loop and printers never block
+ *   on the other threads. --rt-prio / --send-cpu / --recv-cpu / --mlock put
+ *   the send and receive threads on SCHED_FIFO, pin them, and lock memory.
+ *   The data endpoint is non-blocking: a command that finds no free vring TX
+ *   buffer is parked in a single latest-wins slot that the receive thread
+ *   sends on POLLOUT, so the send loop never stalls in write().
+ *
+ * Channels and fan-out:
+ *   With --diag a second endpoint "rpmsg:motor_diag" (1005 -> 1004) carries
+ *   configuration and diagnostics. "DIAG" is sent on it at startup; once the
+ *   RCPU answers "DIAG,ok", CFG / TUNE / FF / FAULTCLR and their replies and
+ *   PROFILE frames use it. The RCPU defers everything on that endpoint to its
+ *   worker thread, so speed commands on the data endpoint are never queued
+ *   behind diagnostics. Without the answer (older firmware) the data endpoint
+ *   is used as before.
+ *   With --fanout <path> every message received from the RCPU is also copied
+ *   to the processes connected to a SOCK_SEQPACKET unix socket. A full client
+ *   socket drops that copy, so a slow subscriber never delays the receive
+ *   thread. Clients may send config and diagnostic text requests (CFG, TUNE,
+ *   FF, FAULTCLR), which are forwarded without waiting for a TX buffer; speed
+ *   commands stay with this process. --attach <path> runs this program as
+ *   such a client: it decodes feedback, odometry, faults and profiles and
+ *   accepts the config commands in -i mode, but sends no speed commands.
  */
 
-#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
 
+#include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <math.h>
 #include <poll.h>
 #include <pthread.h>
+#include <sched.h>
 #include <signal.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <time.h>
 #include <unistd.h>
 
+#include "motor_proto.h"
+#include "motor_shm.h"
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
 #define DEFAULT_RPMSG_CTRL_DEV "/dev/rpmsg_ctrl0"
-#define DEFAULT_RPMSG_DATA_DEV "/dev/rpmsg0"
+#define DEFAULT_RPMSG_DATA_DEV "/dev/rpmsg0" /* used when /sys/class/rpmsg has no match */
 #define DEFAULT_RPMSG_SERVICE_NAME "rpmsg:motor_ctrl"
 #define DEFAULT_RPMSG_LOCAL_ADDR 1003U
 #define DEFAULT_RPMSG_REMOTE_ADDR 1002U
+#define DEFAULT_RPMSG_DIAG_DEV "/dev/rpmsg1"
+#define RPMSG_SYSFS_CLASS "/sys/class/rpmsg"
+#define DEFAULT_RPMSG_DIAG_SERVICE_NAME "rpmsg:motor_diag"
+#define DEFAULT_RPMSG_DIAG_LOCAL_ADDR 1005U
+#define DEFAULT_RPMSG_DIAG_REMOTE_ADDR 1004U
 
 #define DEFAULT_SEND_HZ 20.0
 #define DEFAULT_CMD_TIMEOUT_SEC 0.4
@@ -45,11 +112,19 @@
 #define DEFAULT_MOTOR1_FACTOR 1.0
 #define DEFAULT_MOTOR2_FACTOR 1.0
 #define DEFAULT_REDUCTION_RATIO 56.0
+#define DEFAULT_TUNE_DUTY_LOW 0.3 /* RCPU AUTOTUNE_DUTY_*_DEFAULT */
+#define DEFAULT_TUNE_DUTY_HIGH 0.6
 #define DEFAULT_FF_FACTOR 0.3
 #define DEFAULT_PID_KP 0.05
 #define DEFAULT_PID_KI 0.2
 #define DEFAULT_PID_KD 0.01
 #define DEFAULT_FEEDBACK_ENABLE 1
+#define DEFAULT_HORIZON_POINTS 5
+#define PREFAULT_STACK_BYTES (64 * 1024)
+#define JITTER_HIST_BUCKETS 16 /* bucket i: lateness < 2^i us, last bucket open */
+#define LATENCY_WINDOW 1024    /* samples kept per latency statistic for p99 */
+#define TX_WAIT_MS 200         /* control messages wait this long for a TX buffer */
+#define FANOUT_MAX_CLIENTS 8   /* --fanout subscribers */
 
 struct rpmsg_endpoint_info {
     char name[32];
@@ -85,21 +160,177 @@ typedef struct {
     int interactive;
     double init_v;
     double init_w;
+    int text_protocol;
+
+    int rt_prio;  /* SCHED_FIFO priority for send/recv threads, 0 = off */
+    int send_cpu; /* CPU for the send loop, -1 = no affinity */
+    int recv_cpu; /* CPU for the receive thread, -1 = no affinity */
+    int mlock;    /* mlockall(MCL_CURRENT | MCL_FUTURE) at startup */
+
+    double horizon_sec;  /* > 0: send TRAJ waypoint batches covering this span */
+    int horizon_points;  /* waypoints per batch */
+    double accel_mps2;   /* wheel acceleration limit sent with TRAJ, 0 = leave RCPU's */
+    double jerk_mps3;    /* wheel jerk limit sent with TRAJ, 0 = leave RCPU's */
+    int rcpu_kin;        /* send TWIST and take the pose from ODOM (binary only) */
+    int shm;             /* read status from the shared-memory block */
+    uint64_t shm_addr;   /* physical address of the block, 0 = from HELLO */
+
+    int diag;                /* create the diag endpoint for config and diagnostics */
+    const char *diag_dev;
+    const char *fanout_path; /* serve RCPU traffic to other processes, NULL = off */
+    const char *attach_path; /* run as a client of another instance's --fanout */
 } chassis_config_t;
 
+/*
+ * Single-writer seqlock: the writer makes seq odd, updates the data and
+ * makes it even again; readers retry when seq was odd or changed.
+ * Readers never block the writer and never take a lock.
+ */
+typedef struct {
+    atomic_uint seq;
+} snapshot_seq_t;
+
+typedef struct {
+    double v;
+    double w;
+    struct timespec stamp; /* CLOCK_MONOTONIC time of the last command */
+} cmd_snapshot_t;
+
+/*
+ * Absolute-deadline periodic timer for the send loop. Deadlines advance by
+ * exactly one period, so loop cost does not lower the rate. When a deadline
+ * has already passed the cycle counts as an overrun and the missed periods
+ * are skipped instead of being sent back to back.
+ * Counters are written by the send loop and read by the "stats" command.
+ */
+typedef struct {
+    struct timespec next;
+    long period_ns;
+
+    atomic_ulong cycles;
+    atomic_ulong overruns;
+    atomic_ulong skipped;
+    atomic_ulong late_sum_ns;
+    atomic_long late_min_ns;
+    atomic_long late_max_ns;
+    atomic_ulong hist[JITTER_HIST_BUCKETS];
+} period_timer_t;
+
+/*
+ * Latest-wins command slot. Speed commands (CMD, TWIST, TRAJ or text) that
+ * find no free TX buffer are parked here instead of blocking; a newer command
+ * overwrites a parked one, so only the freshest setpoint is ever sent late.
+ * The receive thread watches POLLOUT while the slot is full and sends it.
+ * Control messages (HELLO, CFG, TUNE, FF, ...) bypass the slot and wait up
+ * to TX_WAIT_MS for a buffer, since they must not be replaced.
+ */
+typedef struct {
+    pthread_mutex_t lock; /* held only around memcpy and non-blocking write */
+    uint8_t buf[MOTOR_PROTO_MAX_PAYLOAD];
+    size_t len;  /* parked command, 0 = empty */
+    int wake_fd; /* eventfd: the slot filled, receive thread adds POLLOUT */
+
+    atomic_ulong sent;
+    atomic_ulong deferred;  /* submits that found no TX buffer */
+    atomic_ulong coalesced; /* parked commands overwritten by a newer one */
+    atomic_ulong dropped;   /* commands lost to a write error */
+} cmd_tx_t;
+
+/*
+ * Fan-out subscribers. The socket table is touched only by the receive
+ * thread; the counters are read by the "stats" command.
+ */
+typedef struct {
+    int listen_fd;
+    int fds[FANOUT_MAX_CLIENTS]; /* -1 = free slot */
+    atomic_int clients;
+
+    atomic_ulong forwarded; /* RCPU messages copied to a client */
+    atomic_ulong dropped;   /* copies skipped because the client socket was full */
+    atomic_ulong requests;  /* client requests sent to the RCPU */
+    atomic_ulong rejected;  /* client requests refused or without a TX buffer */
+} fanout_t;
+
+/*
+ * Latency samples in microseconds. min/avg/max cover all samples since the
+ * last reset, p99 the most recent LATENCY_WINDOW samples.
+ */
+typedef struct {
+    unsigned long count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t window[LATENCY_WINDOW];
+} latency_stat_t;
+
+/*
+ * Command latency measured from feedback echoes, one sample per applied CMD.
+ * Written only by the receive thread (published through lat_seq); "lat reset"
+ * only raises a flag that the receive thread acts on.
+ */
+typedef struct {
+    latency_stat_t rtt;         /* CMD sent -> echo received on Linux */
+    latency_stat_t rx_to_apply; /* RCPU: CMD received -> PWM updated */
+    latency_stat_t apply_to_tx; /* RCPU: PWM updated -> echo sent */
+    latency_stat_t transport;   /* rtt minus RCPU time: both RPMsg hops */
+    uint32_t last_seq;
+    int have_seq;
+} latency_set_t;
+
+typedef struct {
+    double x;
+    double y;
+    double yaw;
+    double v_l;
+    double v_r;
+    int dir_l;
+    int dir_r;
+} odom_snapshot_t;
+
 typedef struct {
     int rpmsg_ctrl_fd;
-    int rpmsg_fd;
+    int rpmsg_fd;      /* data endpoint, or the fan-out socket with --attach */
+    int rpmsg_diag_fd; /* diag endpoint, -1 = not created */
+    volatile sig_atomic_t diag_up; /* the RCPU answered DIAG on the diag endpoint */
     volatile sig_atomic_t running;
     pthread_t recv_thread;
-    pthread_mutex_t lock;
+    pthread_mutex_t lock; /* protects cfg updates from the stdin thread */
 
     chassis_config_t cfg;
 
-    double cmd_v;
-    double cmd_w;
-    struct timespec last_cmd_time;
+    volatile sig_atomic_t binary_proto;
+    atomic_uint tx_seq;
+    cmd_tx_t cmd_tx;
+    fanout_t fanout;
+
+    /* mapped once (main or receive thread), then read by anyone */
+    const volatile struct motor_shm_block *_Atomic shm;
+    void *shm_map;
+    size_t shm_map_len;
+
+    /* written by the stdin thread, read by the send loop */
+    snapshot_seq_t cmd_seq;
+    cmd_snapshot_t cmd;
+
+    /* written by the receive thread, read by printers */
+    snapshot_seq_t odom_seq;
+    odom_snapshot_t odom;
+
+    /* send loop deadline scheduler and jitter statistics */
+    period_timer_t send_timer;
 
+    /* written by the receive thread, read by the "lat" command */
+    snapshot_seq_t lat_seq;
+    latency_set_t lat;
+    atomic_int lat_reset_req;
+
+    /* written by the receive thread, read by the "prof" command */
+    snapshot_seq_t prof_seq;
+    uint8_t prof_frame[MOTOR_PROTO_MAX_PAYLOAD];
+    size_t prof_len;
+    unsigned long prof_frames;
+
+    /* receive thread private state */
     double feedback_v_l;
     double feedback_v_r;
     int feedback_dir_l;
@@ -109,6 +340,12 @@ typedef struct {
     double odom_y;
     double odom_yaw;
     struct timespec last_odom_time;
+
+    uint32_t last_sample_us;
+    int sample_time_valid;
+    uint32_t telemetry_records;
+    uint16_t telemetry_dropped;
+    uint8_t fault_flags;
 } chassis_controller_t;
 
 static volatile sig_atomic_t g_stop_requested = 0;
@@ -126,15 +363,201 @@ static double monotonic_elapsed_sec(const struct timespec *start,
            (double)(end->tv_nsec - start->tv_nsec) / 1000000000.0;
 }
 
-static void sleep_period(double hz)
+static void snapshot_write_begin(snapshot_seq_t *sl)
+{
+    unsigned int seq = atomic_load_explicit(&sl->seq, memory_order_relaxed);
+    atomic_store_explicit(&sl->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static void snapshot_write_end(snapshot_seq_t *sl)
+{
+    unsigned int seq = atomic_load_explicit(&sl->seq, memory_order_relaxed);
+    atomic_store_explicit(&sl->seq, seq + 1, memory_order_release);
+}
+
+static unsigned int snapshot_read_begin(snapshot_seq_t *sl)
+{
+    unsigned int seq;
+
+    while ((seq = atomic_load_explicit(&sl->seq, memory_order_acquire)) & 1U) {
+        sched_yield();
+    }
+    return seq;
+}
+
+static int snapshot_read_retry(snapshot_seq_t *sl, unsigned int start)
+{
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&sl->seq, memory_order_relaxed) != start;
+}
+
+static void timespec_add_ns(struct timespec *ts, long ns)
+{
+    ts->tv_nsec += ns;
+    while (ts->tv_nsec >= 1000000000L) {
+        ts->tv_nsec -= 1000000000L;
+        ts->tv_sec++;
+    }
+}
+
+static long long timespec_diff_ns(const struct timespec *a, const struct timespec *b)
+{
+    return (long long)(a->tv_sec - b->tv_sec) * 1000000000LL +
+           (long long)(a->tv_nsec - b->tv_nsec);
+}
+
+static void period_timer_reset_stats(period_timer_t *t)
+{
+    int i;
+
+    atomic_store_explicit(&t->cycles, 0, memory_order_relaxed);
+    atomic_store_explicit(&t->overruns, 0, memory_order_relaxed);
+    atomic_store_explicit(&t->skipped, 0, memory_order_relaxed);
+    atomic_store_explicit(&t->late_sum_ns, 0, memory_order_relaxed);
+    atomic_store_explicit(&t->late_min_ns, -1, memory_order_relaxed);
+    atomic_store_explicit(&t->late_max_ns, 0, memory_order_relaxed);
+    for (i = 0; i < JITTER_HIST_BUCKETS; ++i) {
+        atomic_store_explicit(&t->hist[i], 0, memory_order_relaxed);
+    }
+}
+
+static void period_timer_init(period_timer_t *t, double hz)
 {
-    struct timespec ts;
     if (hz <= 0.0) {
         hz = DEFAULT_SEND_HZ;
     }
-    ts.tv_sec = (time_t)(1.0 / hz);
-    ts.tv_nsec = (long)(((1.0 / hz) - (double)ts.tv_sec) * 1000000000.0);
-    nanosleep(&ts, NULL);
+    t->period_ns = (long)(1000000000.0 / hz);
+    if (t->period_ns <= 0) {
+        t->period_ns = 1;
+    }
+    period_timer_reset_stats(t);
+    clock_gettime(CLOCK_MONOTONIC, &t->next);
+}
+
+static void period_timer_record(period_timer_t *t, long long late_ns)
+{
+    long long us = late_ns / 1000;
+    long min;
+    int bucket = 0;
+
+    while (bucket < JITTER_HIST_BUCKETS - 1 && us >= (1LL << bucket)) {
+        bucket++;
+    }
+    atomic_fetch_add_explicit(&t->hist[bucket], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&t->cycles, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&t->late_sum_ns, (unsigned long)late_ns, memory_order_relaxed);
+
+    /* only the send loop writes min/max, plain load + store is enough */
+    min = atomic_load_explicit(&t->late_min_ns, memory_order_relaxed);
+    if (min < 0 || late_ns < min) {
+        atomic_store_explicit(&t->late_min_ns, (long)late_ns, memory_order_relaxed);
+    }
+    if (late_ns > atomic_load_explicit(&t->late_max_ns, memory_order_relaxed)) {
+        atomic_store_explicit(&t->late_max_ns, (long)late_ns, memory_order_relaxed);
+    }
+}
+
+/* Sleep until the next absolute deadline and record how late the wakeup was. */
+static void period_timer_wait(period_timer_t *t)
+{
+    struct timespec now;
+    long long behind;
+    long long late;
+
+    timespec_add_ns(&t->next, t->period_ns);
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    behind = timespec_diff_ns(&now, &t->next);
+    if (behind >= 0) {
+        /* the work of this cycle ran past the next deadline */
+        long long missed = behind / t->period_ns + 1;
+
+        atomic_fetch_add_explicit(&t->overruns, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&t->skipped, (unsigned long)(missed - 1),
+                                  memory_order_relaxed);
+        t->next.tv_sec += (time_t)((missed * t->period_ns) / 1000000000LL);
+        timespec_add_ns(&t->next, (long)((missed * t->period_ns) % 1000000000LL));
+    }
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t->next, NULL) == EINTR) {
+        if (g_stop_requested) {
+            return;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    late = timespec_diff_ns(&now, &t->next);
+    period_timer_record(t, late < 0 ? 0 : late);
+}
+
+static void period_timer_print(period_timer_t *t)
+{
+    unsigned long cycles = atomic_load_explicit(&t->cycles, memory_order_relaxed);
+    unsigned long sum = atomic_load_explicit(&t->late_sum_ns, memory_order_relaxed);
+    long min = atomic_load_explicit(&t->late_min_ns, memory_order_relaxed);
+    long max = atomic_load_explicit(&t->late_max_ns, memory_order_relaxed);
+    unsigned long n;
+    int i;
+
+    printf("send timer: period=%.1f us, cycles=%lu, overruns=%lu, skipped=%lu\n",
+           (double)t->period_ns / 1000.0, cycles,
+           atomic_load_explicit(&t->overruns, memory_order_relaxed),
+           atomic_load_explicit(&t->skipped, memory_order_relaxed));
+    if (cycles == 0) {
+        return;
+    }
+    printf("wakeup latency: min=%.1f avg=%.1f max=%.1f us\n",
+           (double)(min < 0 ? 0 : min) / 1000.0,
+           (double)sum / (double)cycles / 1000.0, (double)max / 1000.0);
+    for (i = 0; i < JITTER_HIST_BUCKETS; ++i) {
+        n = atomic_load_explicit(&t->hist[i], memory_order_relaxed);
+        if (n == 0) {
+            continue;
+        }
+        if (i == JITTER_HIST_BUCKETS - 1) {
+            printf("  >= %6ld us : %lu (%.2f%%)\n", 1L << (i - 1), n,
+                   100.0 * (double)n / (double)cycles);
+        } else {
+            printf("  <  %6ld us : %lu (%.2f%%)\n", 1L << i, n,
+                   100.0 * (double)n / (double)cycles);
+        }
+    }
+}
+
+static void latency_stat_add(latency_stat_t *st, uint32_t us)
+{
+    if (st->count == 0 || us < st->min_us) {
+        st->min_us = us;
+    }
+    if (us > st->max_us) {
+        st->max_us = us;
+    }
+    st->sum_us += us;
+    st->window[st->count % LATENCY_WINDOW] = us;
+    st->count++;
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* st is a private copy; its window is sorted in place. */
+static void latency_stat_print(const char *name, latency_stat_t *st)
+{
+    size_t n = st->count < LATENCY_WINDOW ? (size_t)st->count : LATENCY_WINDOW;
+
+    if (n == 0) {
+        printf("  %-12s n=0\n", name);
+        return;
+    }
+    qsort(st->window, n, sizeof(st->window[0]), compare_u32);
+    printf("  %-12s n=%lu min=%u avg=%.1f p99=%u max=%u us\n", name,
+           st->count, st->min_us, (double)st->sum_us / (double)st->count,
+           st->window[(n * 99 + 99) / 100 - 1], st->max_us);
 }
 
 static void print_usage(const char *prog)
@@ -150,12 +573,42 @@ static void print_usage(const char *prog)
     printf("  -t <sec>           Command timeout. Default: %.2f\n", DEFAULT_CMD_TIMEOUT_SEC);
     printf("  --no-cfg           Do not send CFG on startup.\n");
     printf("  --no-feedback      Disable RCPU feedback by CFG.\n");
+    printf("  --text             Use text protocol only, skip binary negotiation.\n");
+    printf("  --telemetry        Request batched per-cycle telemetry (binary only).\n");
+    printf("  --rt-prio <1-99>   Run send/recv threads with SCHED_FIFO at this priority.\n");
+    printf("  --send-cpu <n>     Pin the send loop to CPU n.\n");
+    printf("  --recv-cpu <n>     Pin the receive thread to CPU n.\n");
+    printf("  --mlock            Lock all current and future memory (mlockall).\n");
+    printf("  --horizon <sec>    Send waypoint batches covering this span instead of\n");
+    printf("                     single commands (binary only); use with a low -s.\n");
+    printf("  --horizon-points <n> Waypoints per batch. Default: %d\n", DEFAULT_HORIZON_POINTS);
+    printf("  --accel <m/s^2>    Wheel acceleration limit applied on the RCPU.\n");
+    printf("  --jerk <m/s^3>     Wheel jerk limit applied on the RCPU.\n");
+    printf("  --rcpu-kin         Run kinematics and odometry on the RCPU (binary only).\n");
+    printf("  --shm              Read status from RCPU shared memory, feedback off.\n");
+    printf("  --shm-addr <phys>  Shared memory address, instead of the one in HELLO.\n");
+    printf("  --diag             Use a separate RPMsg endpoint for config and diagnostics.\n");
+    printf("  --diag-dev <path>  Device of the diag endpoint when it is not found in\n");
+    printf("                     %s. Default: %s\n", RPMSG_SYSFS_CLASS, DEFAULT_RPMSG_DIAG_DEV);
+    printf("  --fanout <path>    Copy RCPU traffic to clients of this unix socket.\n");
+    printf("  --attach <path>    Subscribe to another instance's --fanout socket.\n");
     printf("  -h, --help         Show this help.\n");
     printf("\nInteractive commands:\n");
     printf("  cmd <v_mps> <w_radps>    Set chassis velocity.\n");
     printf("  stop                     Stop chassis.\n");
-    printf("  cfg <ratio> <ff> <kp> <ki> <kd> <fb0_or_1>\n");
+    printf("  cfg <ratio> <ff> <kp> <ki> <kd> <fb0_to_3>\n");
     printf("  odom                     Print current odometry.\n");
+    printf("  stats [reset]            Print or reset send period jitter statistics.\n");
+    printf("  lat [reset]              Print or reset command round-trip latency.\n");
+    printf("  prof                     Print the latest RCPU thread profile.\n");
+    printf("  shm                      Print the RCPU shared-memory status block.\n");
+    printf("  tune <step|relay|stop> [duty_low duty_high] [apply]\n");
+    printf("                           Run PID auto-tuning on the RCPU (chassis lifted).\n");
+    printf("  ff <get|off <axis>|load <file>>\n");
+    printf("                           Read, clear or upload the RCPU feed-forward tables.\n");
+    printf("  fault clear              Clear latched RCPU stall / encoder faults.\n");
+    printf("  rate <hz> [feedback_ms]  Change the RCPU control rate (PIDs restart).\n");
+    printf("  prio <thread> <n>        Change an RCPU thread priority.\n");
     printf("  quit                     Stop and exit.\n");
 }
 
@@ -182,6 +635,22 @@ static void config_init(chassis_config_t *cfg)
     cfg->interactive = 0;
     cfg->init_v = 0.0;
     cfg->init_w = 0.0;
+    cfg->text_protocol = 0;
+    cfg->rt_prio = 0;
+    cfg->send_cpu = -1;
+    cfg->recv_cpu = -1;
+    cfg->mlock = 0;
+    cfg->horizon_sec = 0.0;
+    cfg->horizon_points = DEFAULT_HORIZON_POINTS;
+    cfg->accel_mps2 = 0.0;
+    cfg->jerk_mps3 = 0.0;
+    cfg->rcpu_kin = 0;
+    cfg->shm = 0;
+    cfg->shm_addr = 0;
+    cfg->diag = 0;
+    cfg->diag_dev = DEFAULT_RPMSG_DIAG_DEV;
+    cfg->fanout_path = NULL;
+    cfg->attach_path = NULL;
 }
 
 static int parse_args(int argc, char **argv, chassis_config_t *cfg)
@@ -206,6 +675,43 @@ static int parse_args(int argc, char **argv, chassis_config_t *cfg)
             cfg->cfg_send_on_startup = 0;
         } else if (strcmp(argv[i], "--no-feedback") == 0) {
             cfg->feedback_enable = 0;
+        } else if (strcmp(argv[i], "--text") == 0) {
+            cfg->text_protocol = 1;
+        } else if (strcmp(argv[i], "--telemetry") == 0) {
+            cfg->feedback_enable = 2;
+        } else if (strcmp(argv[i], "--rt-prio") == 0 && i + 1 < argc) {
+            cfg->rt_prio = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--send-cpu") == 0 && i + 1 < argc) {
+            cfg->send_cpu = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--recv-cpu") == 0 && i + 1 < argc) {
+            cfg->recv_cpu = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--mlock") == 0) {
+            cfg->mlock = 1;
+        } else if (strcmp(argv[i], "--horizon") == 0 && i + 1 < argc) {
+            cfg->horizon_sec = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--horizon-points") == 0 && i + 1 < argc) {
+            cfg->horizon_points = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--accel") == 0 && i + 1 < argc) {
+            cfg->accel_mps2 = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--jerk") == 0 && i + 1 < argc) {
+            cfg->jerk_mps3 = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--rcpu-kin") == 0) {
+            cfg->rcpu_kin = 1;
+            cfg->feedback_enable = 3;
+        } else if (strcmp(argv[i], "--shm") == 0) {
+            cfg->shm = 1;
+        } else if (strcmp(argv[i], "--shm-addr") == 0 && i + 1 < argc) {
+            cfg->shm = 1;
+            cfg->shm_addr = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--diag") == 0) {
+            cfg->diag = 1;
+        } else if (strcmp(argv[i], "--diag-dev") == 0 && i + 1 < argc) {
+            cfg->diag = 1;
+            cfg->diag_dev = argv[++i];
+        } else if (strcmp(argv[i], "--fanout") == 0 && i + 1 < argc) {
+            cfg->fanout_path = argv[++i];
+        } else if (strcmp(argv[i], "--attach") == 0 && i + 1 < argc) {
+            cfg->attach_path = argv[++i];
         } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
             print_usage(argv[0]);
             return 1;
@@ -215,9 +721,200 @@ static int parse_args(int argc, char **argv, chassis_config_t *cfg)
             return -1;
         }
     }
+    if (cfg->horizon_points < 1 || cfg->horizon_points > (int)MOTOR_PROTO_TRAJ_MAX_POINTS) {
+        fprintf(stderr, "--horizon-points must be 1..%d\n", (int)MOTOR_PROTO_TRAJ_MAX_POINTS);
+        return -1;
+    }
+    if (cfg->shm && cfg->text_protocol && cfg->shm_addr == 0) {
+        fprintf(stderr, "warning: --shm without --shm-addr needs the binary protocol, "
+                        "keeping RPMsg feedback\n");
+        cfg->shm = 0;
+    }
+    if (cfg->shm) {
+        /* RPMsg carries commands only; restored if the block cannot be mapped */
+        cfg->feedback_enable = 0;
+    }
+    if (cfg->rcpu_kin && cfg->text_protocol) {
+        fprintf(stderr, "warning: --rcpu-kin needs the binary protocol, "
+                        "falling back to local kinematics\n");
+    }
+    if (cfg->attach_path != NULL && (cfg->fanout_path != NULL || cfg->diag || cfg->shm)) {
+        fprintf(stderr, "warning: --attach uses the owner's endpoints, "
+                        "ignoring --fanout / --diag / --shm\n");
+        cfg->fanout_path = NULL;
+        cfg->diag = 0;
+        cfg->shm = 0;
+    }
+    if (cfg->horizon_sec > 0.0 && cfg->send_hz > 0.0 && cfg->horizon_sec * cfg->send_hz < 1.0) {
+        fprintf(stderr, "warning: --horizon is shorter than the send period, "
+                        "the RCPU holds the last waypoint in between\n");
+    }
+    return 0;
+}
+
+/* Failures are reported and ignored: the controller still works without RT. */
+static void apply_thread_rt(pthread_t thread, const char *name, int prio, int cpu)
+{
+    struct sched_param param;
+    cpu_set_t set;
+    int ret;
+
+    if (prio > 0) {
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = prio;
+        ret = pthread_setschedparam(thread, SCHED_FIFO, &param);
+        if (ret != 0) {
+            fprintf(stderr, "%s: SCHED_FIFO %d failed: %s\n", name, prio, strerror(ret));
+        }
+    }
+
+    if (cpu >= 0) {
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        ret = pthread_setaffinity_np(thread, sizeof(set), &set);
+        if (ret != 0) {
+            fprintf(stderr, "%s: affinity to CPU %d failed: %s\n", name, cpu, strerror(ret));
+        }
+    }
+}
+
+/* Touch the stack once so the send loop never takes a page fault on it. */
+static void prefault_stack(void)
+{
+    volatile unsigned char buf[PREFAULT_STACK_BYTES];
+    size_t i;
+
+    for (i = 0; i < sizeof(buf); i += 4096) {
+        buf[i] = 0;
+    }
+}
+
+static void lock_memory(void)
+{
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        fprintf(stderr, "mlockall failed: %s\n", strerror(errno));
+        return;
+    }
+    prefault_stack();
+}
+
+static int cmd_tx_init(chassis_controller_t *ctl)
+{
+    ctl->cmd_tx.wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (ctl->cmd_tx.wake_fd < 0) {
+        fprintf(stderr, "eventfd failed: %s\n", strerror(errno));
+        return -1;
+    }
+    pthread_mutex_init(&ctl->cmd_tx.lock, NULL);
+    return 0;
+}
+
+static void rpmsg_cleanup(chassis_controller_t *ctl)
+{
+    if (ctl->rpmsg_diag_fd >= 0) {
+        /* RPMSG_DESTROY_EPT_IOCTL acts on the endpoint device, not on rpmsg_ctrl */
+        ioctl(ctl->rpmsg_diag_fd, RPMSG_DESTROY_EPT_IOCTL);
+        close(ctl->rpmsg_diag_fd);
+        ctl->rpmsg_diag_fd = -1;
+    }
+    if (ctl->rpmsg_fd >= 0) {
+        /* in --attach mode rpmsg_fd is the fan-out socket, not an eptdev */
+        if (ctl->cfg.attach_path == NULL) {
+            ioctl(ctl->rpmsg_fd, RPMSG_DESTROY_EPT_IOCTL);
+        }
+        close(ctl->rpmsg_fd);
+        ctl->rpmsg_fd = -1;
+    }
+    if (ctl->rpmsg_ctrl_fd >= 0) {
+        close(ctl->rpmsg_ctrl_fd);
+        ctl->rpmsg_ctrl_fd = -1;
+    }
+    if (ctl->cmd_tx.wake_fd >= 0) {
+        close(ctl->cmd_tx.wake_fd);
+        ctl->cmd_tx.wake_fd = -1;
+        pthread_mutex_destroy(&ctl->cmd_tx.lock);
+    }
+}
+
+static int sysfs_read_line(const char *dir, const char *attr, char *buf, size_t size)
+{
+    char path[sizeof(RPMSG_SYSFS_CLASS) + 2 * 256];
+    FILE *fp;
+    int ok;
+
+    snprintf(path, sizeof(path), "%s/%s/%s", RPMSG_SYSFS_CLASS, dir, attr);
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        return -1;
+    }
+    ok = fgets(buf, (int)size, fp) != NULL;
+    fclose(fp);
+    if (!ok) {
+        return -1;
+    }
+    buf[strcspn(buf, "\n")] = '\0';
     return 0;
 }
 
+/*
+ * Find the eptdev the kernel created for an endpoint by its name/src/dst
+ * attributes. The rpmsgN numbering follows creation order across all
+ * rpmsg_char users, so a fixed device path can name someone else's endpoint.
+ */
+static int rpmsg_find_eptdev(const struct rpmsg_endpoint_info *ep, char *path, size_t size)
+{
+    char buf[64];
+    struct dirent *de;
+    DIR *dir;
+    int found = 0;
+
+    dir = opendir(RPMSG_SYSFS_CLASS);
+    if (dir == NULL) {
+        return -1;
+    }
+    while (!found && (de = readdir(dir)) != NULL) {
+        if (strncmp(de->d_name, "rpmsg", 5) != 0 || strncmp(de->d_name, "rpmsg_ctrl", 10) == 0) {
+            continue;
+        }
+        if (sysfs_read_line(de->d_name, "name", buf, sizeof(buf)) != 0 ||
+            strcmp(buf, ep->name) != 0 ||
+            sysfs_read_line(de->d_name, "src", buf, sizeof(buf)) != 0 ||
+            strtoul(buf, NULL, 0) != ep->src ||
+            sysfs_read_line(de->d_name, "dst", buf, sizeof(buf)) != 0 ||
+            strtoul(buf, NULL, 0) != ep->dst) {
+            continue;
+        }
+        snprintf(path, size, "/dev/%s", de->d_name);
+        found = 1;
+    }
+    closedir(dir);
+    return found ? 0 : -1;
+}
+
+/*
+ * Open the eptdev of an endpoint just created through the control device.
+ * The endpoint is destroyed through its own eptdev, so when that cannot be
+ * opened the endpoint stays in the kernel; say so instead of leaking silently.
+ */
+static int rpmsg_open_eptdev(const struct rpmsg_endpoint_info *ep, const char *fallback)
+{
+    char path[sizeof("/dev/") + 256]; /* d_name is at most 255 characters */
+    const char *dev = fallback;
+    int fd;
+
+    if (rpmsg_find_eptdev(ep, path, sizeof(path)) == 0) {
+        dev = path;
+    }
+    fd = open(dev, O_RDWR | O_NONBLOCK);
+    if (fd < 0) {
+        fprintf(stderr, "open %s failed: %s\n", dev, strerror(errno));
+        fprintf(stderr, "endpoint %s src=%u dst=%u left in the kernel, "
+                        "remove it with RPMSG_DESTROY_EPT_IOCTL on its eptdev\n",
+                ep->name, ep->src, ep->dst);
+    }
+    return fd;
+}
+
 static int rpmsg_init(chassis_controller_t *ctl)
 {
     struct rpmsg_endpoint_info epinfo;
@@ -240,98 +937,530 @@ static int rpmsg_init(chassis_controller_t *ctl)
         return -1;
     }
 
-    ctl->rpmsg_fd = open(ctl->cfg.data_dev, O_RDWR);
+    ctl->rpmsg_fd = rpmsg_open_eptdev(&epinfo, ctl->cfg.data_dev);
     if (ctl->rpmsg_fd < 0) {
-        fprintf(stderr, "open %s failed: %s\n", ctl->cfg.data_dev, strerror(errno));
         close(ctl->rpmsg_ctrl_fd);
         ctl->rpmsg_ctrl_fd = -1;
         return -1;
     }
 
+    if (cmd_tx_init(ctl) != 0) {
+        rpmsg_cleanup(ctl);
+        return -1;
+    }
+
     printf("RPMsg ready: service=%s src=%u dst=%u\n",
            ctl->cfg.service_name, ctl->cfg.local_addr, ctl->cfg.remote_addr);
     return 0;
 }
 
-static void rpmsg_cleanup(chassis_controller_t *ctl)
+/* Failures are reported and ignored: everything then goes over the data endpoint. */
+static void rpmsg_diag_init(chassis_controller_t *ctl)
 {
-    if (ctl->rpmsg_fd >= 0) {
-        close(ctl->rpmsg_fd);
-        ctl->rpmsg_fd = -1;
+    struct rpmsg_endpoint_info epinfo;
+
+    memset(&epinfo, 0, sizeof(epinfo));
+    strncpy(epinfo.name, DEFAULT_RPMSG_DIAG_SERVICE_NAME, sizeof(epinfo.name) - 1);
+    epinfo.src = DEFAULT_RPMSG_DIAG_LOCAL_ADDR;
+    epinfo.dst = DEFAULT_RPMSG_DIAG_REMOTE_ADDR;
+
+    if (ioctl(ctl->rpmsg_ctrl_fd, RPMSG_CREATE_EPT_IOCTL, &epinfo) < 0) {
+        fprintf(stderr, "create rpmsg diag endpoint failed: %s\n", strerror(errno));
+        return;
     }
-    if (ctl->rpmsg_ctrl_fd >= 0) {
-        ioctl(ctl->rpmsg_ctrl_fd, RPMSG_DESTROY_EPT_IOCTL);
-        close(ctl->rpmsg_ctrl_fd);
-        ctl->rpmsg_ctrl_fd = -1;
+    ctl->rpmsg_diag_fd = rpmsg_open_eptdev(&epinfo, ctl->cfg.diag_dev);
+    if (ctl->rpmsg_diag_fd < 0) {
+        return;
     }
+    printf("RPMsg diag ready: service=%s src=%u dst=%u\n",
+           DEFAULT_RPMSG_DIAG_SERVICE_NAME, epinfo.src, epinfo.dst);
 }
 
-static int send_raw(chassis_controller_t *ctl, const char *msg)
+/* --attach: the owner's fan-out socket stands in for the data endpoint */
+static int attach_init(chassis_controller_t *ctl)
 {
-    ssize_t ret;
-    if (ctl->rpmsg_fd < 0) {
+    struct sockaddr_un addr;
+    int fd;
+
+    if (strlen(ctl->cfg.attach_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "socket path too long: %s\n", ctl->cfg.attach_path);
+        return -1;
+    }
+    fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        fprintf(stderr, "socket failed: %s\n", strerror(errno));
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, ctl->cfg.attach_path, sizeof(addr.sun_path) - 1);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        fcntl(fd, F_SETFL, O_NONBLOCK) != 0) {
+        fprintf(stderr, "connect %s failed: %s\n", ctl->cfg.attach_path, strerror(errno));
+        close(fd);
         return -1;
     }
 
-    ret = write(ctl->rpmsg_fd, msg, strlen(msg) + 1);
-    if (ret < 0) {
-        fprintf(stderr, "rpmsg write failed: %s\n", strerror(errno));
+    ctl->rpmsg_fd = fd;
+    if (cmd_tx_init(ctl) != 0) {
+        rpmsg_cleanup(ctl);
         return -1;
     }
+    printf("Attached to %s\n", ctl->cfg.attach_path);
     return 0;
 }
 
-static int send_cfg(chassis_controller_t *ctl)
+static void fanout_init(fanout_t *fo)
 {
-    char cmd[128];
-    snprintf(cmd, sizeof(cmd), "CFG,%.3f,%.3f,%.3f,%.3f,%.3f,%d",
-             ctl->cfg.reduction_ratio, ctl->cfg.ff_factor, ctl->cfg.pid_kp,
-             ctl->cfg.pid_ki, ctl->cfg.pid_kd, ctl->cfg.feedback_enable ? 1 : 0);
+    int i;
 
-    printf("Send CFG: %s\n", cmd);
-    return send_raw(ctl, cmd);
+    fo->listen_fd = -1;
+    for (i = 0; i < FANOUT_MAX_CLIENTS; ++i) {
+        fo->fds[i] = -1;
+    }
 }
 
-static void velocity_to_motor(const chassis_config_t *cfg, double v,
-                              int *dir, double *speed_rps)
+static int fanout_listen(fanout_t *fo, const char *path)
 {
-    if (fabs(v) < 1e-3) {
-        *dir = 0;
-        *speed_rps = 0.0;
-        return;
-    }
+    struct sockaddr_un addr;
 
-    *dir = v > 0.0 ? 1 : 2;
-    *speed_rps = fabs(v) / (2.0 * M_PI * cfg->wheel_radius_m);
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "socket path too long: %s\n", path);
+        return -1;
+    }
+    fo->listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fo->listen_fd < 0) {
+        fprintf(stderr, "socket failed: %s\n", strerror(errno));
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    unlink(path); /* stale socket of an earlier run */
+    if (bind(fo->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(fo->listen_fd, FANOUT_MAX_CLIENTS) != 0) {
+        fprintf(stderr, "listen on %s failed: %s\n", path, strerror(errno));
+        close(fo->listen_fd);
+        fo->listen_fd = -1;
+        return -1;
+    }
+    printf("Fan-out listening on %s\n", path);
+    return 0;
 }
 
-static int send_chassis_command(chassis_controller_t *ctl, double v, double w)
+static void fanout_close(fanout_t *fo, int i)
 {
-    double v_l = v - w * ctl->cfg.wheel_base_m / 2.0;
-    double v_r = v + w * ctl->cfg.wheel_base_m / 2.0;
-    int dir1, dir2;
-    double speed1, speed2;
-    char cmd[96];
+    close(fo->fds[i]);
+    fo->fds[i] = -1;
+    atomic_fetch_sub_explicit(&fo->clients, 1, memory_order_relaxed);
+    printf("fan-out: client %d disconnected\n", i);
+}
 
-    velocity_to_motor(&ctl->cfg, v_l, &dir1, &speed1);
-    velocity_to_motor(&ctl->cfg, v_r, &dir2, &speed2);
-    speed1 *= ctl->cfg.motor1_factor;
-    speed2 *= ctl->cfg.motor2_factor;
+static void fanout_cleanup(fanout_t *fo, const char *path)
+{
+    int i;
 
-    snprintf(cmd, sizeof(cmd), "%d,%.3f;%d,%.3f", dir1, speed1, dir2, speed2);
-    return send_raw(ctl, cmd);
+    for (i = 0; i < FANOUT_MAX_CLIENTS; ++i) {
+        if (fo->fds[i] >= 0) {
+            fanout_close(fo, i);
+        }
+    }
+    if (fo->listen_fd >= 0) {
+        close(fo->listen_fd);
+        fo->listen_fd = -1;
+        unlink(path);
+    }
 }
 
-static void update_odometry(chassis_controller_t *ctl, double v_l, double v_r)
+/*
+ * Map the RCPU status block read-only. O_SYNC gives an uncached mapping, so
+ * every read goes to memory and sees the RCPU writes without any flush.
+ */
+static int shm_attach(chassis_controller_t *ctl, uint64_t phys, size_t size)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    uint64_t base = phys & ~(uint64_t)(page - 1);
+    size_t len = (size_t)(phys - base) + size;
+    const volatile struct motor_shm_block *blk;
+    void *map;
+    int fd;
+
+    if (atomic_load(&ctl->shm) != NULL) {
+        return 0;
+    }
+    if (phys == 0 || size < sizeof(struct motor_shm_block)) {
+        fprintf(stderr, "shm: no status block address\n");
+        return -1;
+    }
+
+    fd = open("/dev/mem", O_RDONLY | O_SYNC);
+    if (fd < 0) {
+        fprintf(stderr, "shm: open /dev/mem failed: %s\n", strerror(errno));
+        return -1;
+    }
+    map = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, (off_t)base);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "shm: mmap 0x%llx failed: %s\n", (unsigned long long)phys,
+                strerror(errno));
+        return -1;
+    }
+
+    blk = (const volatile struct motor_shm_block *)((uint8_t *)map + (phys - base));
+    if (motor_shm_check(blk) != 0) {
+        fprintf(stderr, "shm: bad status block at 0x%llx (magic 0x%08x)\n",
+                (unsigned long long)phys, blk->magic);
+        munmap(map, len);
+        return -1;
+    }
+
+    ctl->shm_map = map;
+    ctl->shm_map_len = len;
+    atomic_store(&ctl->shm, blk);
+    printf("shm: status block mapped at 0x%llx\n", (unsigned long long)phys);
+    return 0;
+}
+
+static void shm_detach(chassis_controller_t *ctl)
+{
+    if (ctl->shm_map != NULL) {
+        atomic_store(&ctl->shm, NULL);
+        munmap(ctl->shm_map, ctl->shm_map_len);
+        ctl->shm_map = NULL;
+    }
+}
+
+/*
+ * One non-blocking write: 1 = sent, 0 = no free TX buffer, -1 = error.
+ * rpmsg_char maps a failed rpmsg_trysend() to ENOMEM rather than EAGAIN.
+ */
+static int tx_try_write(int fd, const void *buf, size_t len)
+{
+    if (write(fd, buf, len) >= 0) {
+        return 1;
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOMEM || errno == EINTR) {
+        return 0;
+    }
+    return -1;
+}
+
+/* control messages: wait for POLLOUT, at most TX_WAIT_MS */
+static int tx_write_wait(int fd, const void *buf, size_t len)
+{
+    struct timespec start, now;
+    struct pollfd pfd;
+    int left_ms;
+    int ret;
+
+    if (fd < 0) {
+        return -1;
+    }
+
+    memset(&pfd, 0, sizeof(pfd));
+    pfd.fd = fd;
+    pfd.events = POLLOUT;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while ((ret = tx_try_write(fd, buf, len)) == 0) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        left_ms = TX_WAIT_MS - (int)(monotonic_elapsed_sec(&start, &now) * 1000.0);
+        if (left_ms <= 0) {
+            fprintf(stderr, "rpmsg write timed out (no TX buffer)\n");
+            return -1;
+        }
+        poll(&pfd, 1, left_ms);
+    }
+    if (ret < 0) {
+        fprintf(stderr, "rpmsg write failed: %s\n", strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+/* send the parked command if a TX buffer is free; cmd_tx.lock held */
+static void cmd_tx_flush_locked(chassis_controller_t *ctl)
+{
+    cmd_tx_t *tx = &ctl->cmd_tx;
+    int ret;
+
+    if (tx->len == 0) {
+        return;
+    }
+    ret = tx_try_write(ctl->rpmsg_fd, tx->buf, tx->len);
+    if (ret == 0) {
+        return;
+    }
+    if (ret > 0) {
+        atomic_fetch_add_explicit(&tx->sent, 1, memory_order_relaxed);
+    } else {
+        atomic_fetch_add_explicit(&tx->dropped, 1, memory_order_relaxed);
+        fprintf(stderr, "rpmsg write failed: %s\n", strerror(errno));
+    }
+    tx->len = 0;
+}
+
+/* speed commands: never block, a newer command replaces a parked one */
+static int cmd_tx_submit(chassis_controller_t *ctl, const void *buf, size_t len)
+{
+    cmd_tx_t *tx = &ctl->cmd_tx;
+    uint64_t one = 1;
+    int parked;
+
+    if (ctl->rpmsg_fd < 0 || len > sizeof(tx->buf)) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&tx->lock);
+    if (tx->len != 0) {
+        atomic_fetch_add_explicit(&tx->coalesced, 1, memory_order_relaxed);
+    }
+    memcpy(tx->buf, buf, len);
+    tx->len = len;
+    cmd_tx_flush_locked(ctl);
+    parked = tx->len != 0;
+    pthread_mutex_unlock(&tx->lock);
+
+    if (parked) {
+        atomic_fetch_add_explicit(&tx->deferred, 1, memory_order_relaxed);
+        if (write(tx->wake_fd, &one, sizeof(one)) < 0) {
+            /* counter already non-zero, the receive thread is awake anyway */
+        }
+    }
+    return 0;
+}
+
+/* shutdown: the parked command (the final stop) gets TX_WAIT_MS like a control message */
+static void cmd_tx_drain(chassis_controller_t *ctl)
+{
+    cmd_tx_t *tx = &ctl->cmd_tx;
+    uint8_t buf[MOTOR_PROTO_MAX_PAYLOAD];
+    size_t len;
+
+    pthread_mutex_lock(&tx->lock);
+    len = tx->len;
+    memcpy(buf, tx->buf, len);
+    tx->len = 0;
+    pthread_mutex_unlock(&tx->lock);
+
+    if (len == 0) {
+        return;
+    }
+    if (tx_write_wait(ctl->rpmsg_fd, buf, len) == 0) {
+        atomic_fetch_add_explicit(&tx->sent, 1, memory_order_relaxed);
+    } else {
+        atomic_fetch_add_explicit(&tx->dropped, 1, memory_order_relaxed);
+    }
+}
+
+static void cmd_tx_reset_stats(cmd_tx_t *tx)
+{
+    atomic_store_explicit(&tx->sent, 0, memory_order_relaxed);
+    atomic_store_explicit(&tx->deferred, 0, memory_order_relaxed);
+    atomic_store_explicit(&tx->coalesced, 0, memory_order_relaxed);
+    atomic_store_explicit(&tx->dropped, 0, memory_order_relaxed);
+}
+
+static void cmd_tx_print(cmd_tx_t *tx)
+{
+    printf("cmd tx: sent=%lu, deferred=%lu, coalesced=%lu, dropped=%lu\n",
+           atomic_load_explicit(&tx->sent, memory_order_relaxed),
+           atomic_load_explicit(&tx->deferred, memory_order_relaxed),
+           atomic_load_explicit(&tx->coalesced, memory_order_relaxed),
+           atomic_load_explicit(&tx->dropped, memory_order_relaxed));
+}
+
+/* config and diagnostic requests: the diag endpoint once the RCPU answered DIAG */
+static int request_fd(chassis_controller_t *ctl)
+{
+    return (ctl->diag_up && ctl->rpmsg_diag_fd >= 0) ? ctl->rpmsg_diag_fd : ctl->rpmsg_fd;
+}
+
+static int send_raw(chassis_controller_t *ctl, const char *msg)
+{
+    return tx_write_wait(request_fd(ctl), msg, strlen(msg) + 1);
+}
+
+static uint32_t monotonic_us(void)
 {
     struct timespec now;
-    double dt;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000ULL +
+                      (uint64_t)now.tv_nsec / 1000ULL);
+}
+
+static int send_frame(chassis_controller_t *ctl, uint8_t type,
+                      int32_t setpoint1_mrs, int32_t setpoint2_mrs)
+{
+    struct motor_proto_wheel_frame frame;
+
+    memset(&frame, 0, sizeof(frame));
+    frame.setpoint_mrs[0] = setpoint1_mrs;
+    frame.setpoint_mrs[1] = setpoint2_mrs;
+    motor_proto_finalize(&frame, type, 0,
+                         atomic_fetch_add_explicit(&ctl->tx_seq, 1, memory_order_relaxed),
+                         monotonic_us());
+
+    if (type == MOTOR_PROTO_TYPE_CMD) {
+        return cmd_tx_submit(ctl, &frame, sizeof(frame));
+    }
+    return tx_write_wait(ctl->rpmsg_fd, &frame, sizeof(frame));
+}
+
+static int send_hello(chassis_controller_t *ctl)
+{
+    printf("Send HELLO (binary protocol v%d)\n", MOTOR_PROTO_VERSION);
+    return send_frame(ctl, MOTOR_PROTO_TYPE_HELLO, 0, 0);
+}
+
+/* the answer arrives on the receive thread; wait for it before the startup CFG */
+static void send_diag_hello(chassis_controller_t *ctl)
+{
+    int waited_ms;
+
+    if (tx_write_wait(ctl->rpmsg_diag_fd, "DIAG", sizeof("DIAG")) != 0) {
+        return;
+    }
+    for (waited_ms = 0; !ctl->diag_up && waited_ms < TX_WAIT_MS; waited_ms += 10) {
+        usleep(10000);
+    }
+    if (!ctl->diag_up) {
+        printf("RCPU did not answer DIAG, config stays on the data endpoint\n");
+    }
+}
+
+static int send_cfg(chassis_controller_t *ctl)
+{
+    char cmd[160];
+
+    /* older RCPU firmware stops parsing after feedback_enable */
+    snprintf(cmd, sizeof(cmd), "CFG,%.3f,%.3f,%.3f,%.3f,%.3f,%d,%.5f,%.5f,%.4f,%.4f",
+             ctl->cfg.reduction_ratio, ctl->cfg.ff_factor, ctl->cfg.pid_kp,
+             ctl->cfg.pid_ki, ctl->cfg.pid_kd, ctl->cfg.feedback_enable,
+             ctl->cfg.wheel_radius_m, ctl->cfg.wheel_base_m,
+             ctl->cfg.motor1_factor, ctl->cfg.motor2_factor);
+
+    printf("Send CFG: %s\n", cmd);
+    return send_raw(ctl, cmd);
+}
+
+static void velocity_to_motor(const chassis_config_t *cfg, double v,
+                              int *dir, double *speed_rps)
+{
+    if (fabs(v) < 1e-3) {
+        *dir = 0;
+        *speed_rps = 0.0;
+        return;
+    }
+
+    *dir = v > 0.0 ? 1 : 2;
+    *speed_rps = fabs(v) / (2.0 * M_PI * cfg->wheel_radius_m);
+}
+
+static void chassis_to_wheels(const chassis_config_t *cfg, double v, double w,
+                              int *dir1, double *speed1, int *dir2, double *speed2)
+{
+    double v_l = v - w * cfg->wheel_base_m / 2.0;
+    double v_r = v + w * cfg->wheel_base_m / 2.0;
+
+    velocity_to_motor(cfg, v_l, dir1, speed1);
+    velocity_to_motor(cfg, v_r, dir2, speed2);
+    *speed1 *= cfg->motor1_factor;
+    *speed2 *= cfg->motor2_factor;
+}
+
+static int32_t wheel_signed_mrs(int dir, double speed_rps)
+{
+    int32_t mrs = (int32_t)lround(speed_rps * 1000.0);
+
+    return dir == 2 ? -mrs : (dir == 0 ? 0 : mrs);
+}
+
+/* --rcpu-kin: the RCPU converts (v, w) with the geometry sent in CFG */
+static int send_twist(chassis_controller_t *ctl, double v, double w)
+{
+    struct motor_proto_twist_frame frame;
+
+    memset(&frame, 0, sizeof(frame));
+    frame.v_mmps = (int32_t)lround(v * 1000.0);
+    frame.w_mradps = (int32_t)lround(w * 1000.0);
+    motor_proto_fixed_finalize(&frame, sizeof(frame), MOTOR_PROTO_TYPE_TWIST, 0,
+                               atomic_fetch_add_explicit(&ctl->tx_seq, 1,
+                                                         memory_order_relaxed),
+                               monotonic_us());
+
+    return cmd_tx_submit(ctl, &frame, sizeof(frame));
+}
+
+static int send_chassis_command(chassis_controller_t *ctl, double v, double w)
+{
+    int dir1, dir2;
+    double speed1, speed2;
+    char cmd[96];
+
+    if (ctl->binary_proto && ctl->cfg.rcpu_kin) {
+        return send_twist(ctl, v, w);
+    }
+
+    chassis_to_wheels(&ctl->cfg, v, w, &dir1, &speed1, &dir2, &speed2);
+
+    if (ctl->binary_proto) {
+        return send_frame(ctl, MOTOR_PROTO_TYPE_CMD, wheel_signed_mrs(dir1, speed1),
+                          wheel_signed_mrs(dir2, speed2));
+    }
+
+    snprintf(cmd, sizeof(cmd), "%d,%.3f;%d,%.3f", dir1, speed1, dir2, speed2);
+    return cmd_tx_submit(ctl, cmd, strlen(cmd) + 1);
+}
+
+/*
+ * Horizon mode: one TRAJ frame carries the command over the next
+ * horizon_sec as evenly spaced waypoints, and the RCPU interpolates them at
+ * its control rate. Waypoints past the command timeout are zero, so the
+ * chassis ramps to a stop on its own if this process stops sending.
+ */
+static int send_trajectory(chassis_controller_t *ctl, const cmd_snapshot_t *cmd,
+                           const struct timespec *now)
+{
+    uint8_t buf[MOTOR_PROTO_MAX_PAYLOAD];
+    struct motor_proto_traj_frame *frame = (struct motor_proto_traj_frame *)buf;
+    const chassis_config_t *cfg = &ctl->cfg;
+    double rev_m = 2.0 * M_PI * cfg->wheel_radius_m;
+    double age = monotonic_elapsed_sec(&cmd->stamp, now);
+    int dir1, dir2;
+    double speed1, speed2;
+    size_t len;
+    int i;
+
+    chassis_to_wheels(cfg, cmd->v, cmd->w, &dir1, &speed1, &dir2, &speed2);
+
+    memset(buf, 0, sizeof(buf));
+    frame->count = (uint8_t)cfg->horizon_points;
+    if (cfg->accel_mps2 > 0.0 || cfg->jerk_mps3 > 0.0) {
+        frame->flags = MOTOR_PROTO_TRAJ_FLAG_LIMITS;
+        frame->accel_mrs2 = (uint32_t)lround(cfg->accel_mps2 / rev_m * 1000.0);
+        frame->jerk_mrs3 = (uint32_t)lround(cfg->jerk_mps3 / rev_m * 1000.0);
+    }
+    for (i = 0; i < cfg->horizon_points; ++i) {
+        double t = cfg->horizon_sec * (double)(i + 1) / (double)cfg->horizon_points;
+        int live = age + t <= cfg->cmd_timeout_sec;
+
+        frame->points[i].t_us = (uint32_t)lround(t * 1e6);
+        frame->points[i].setpoint_mrs[0] = live ? wheel_signed_mrs(dir1, speed1) : 0;
+        frame->points[i].setpoint_mrs[1] = live ? wheel_signed_mrs(dir2, speed2) : 0;
+    }
+    len = motor_proto_traj_finalize(
+        frame, atomic_fetch_add_explicit(&ctl->tx_seq, 1, memory_order_relaxed),
+        monotonic_us());
+
+    return cmd_tx_submit(ctl, buf, len);
+}
+
+static void integrate_odometry(chassis_controller_t *ctl, double v_l,
+                               double v_r, double dt)
+{
     double v;
     double w;
 
-    clock_gettime(CLOCK_MONOTONIC, &now);
-    dt = monotonic_elapsed_sec(&ctl->last_odom_time, &now);
-    ctl->last_odom_time = now;
     if (dt <= 0.0 || dt > 1.0) {
         return;
     }
@@ -344,16 +1473,45 @@ static void update_odometry(chassis_controller_t *ctl, double v_l, double v_r)
     ctl->odom_y += v * sin(ctl->odom_yaw) * dt;
 }
 
-static void parse_feedback(chassis_controller_t *ctl, const char *buf)
+/* Called by the receive thread after each feedback/telemetry update. */
+static void publish_odometry(chassis_controller_t *ctl)
 {
-    int dir1 = 0, dir2 = 0;
-    int speed1_mrs = 0, speed2_mrs = 0;
-    double rps1, rps2, v1, v2;
+    snapshot_write_begin(&ctl->odom_seq);
+    ctl->odom.x = ctl->odom_x;
+    ctl->odom.y = ctl->odom_y;
+    ctl->odom.yaw = ctl->odom_yaw;
+    ctl->odom.v_l = ctl->feedback_v_l;
+    ctl->odom.v_r = ctl->feedback_v_r;
+    ctl->odom.dir_l = ctl->feedback_dir_l;
+    ctl->odom.dir_r = ctl->feedback_dir_r;
+    snapshot_write_end(&ctl->odom_seq);
+}
 
-    if (sscanf(buf, "%d,%d;%d,%d", &dir1, &speed1_mrs, &dir2, &speed2_mrs) != 4) {
-        printf("[RPMsg] %s\n", buf);
-        return;
-    }
+static void read_odometry(chassis_controller_t *ctl, odom_snapshot_t *out)
+{
+    unsigned int seq;
+
+    do {
+        seq = snapshot_read_begin(&ctl->odom_seq);
+        *out = ctl->odom;
+    } while (snapshot_read_retry(&ctl->odom_seq, seq));
+}
+
+static void update_odometry(chassis_controller_t *ctl, double v_l, double v_r)
+{
+    struct timespec now;
+    double dt;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    dt = monotonic_elapsed_sec(&ctl->last_odom_time, &now);
+    ctl->last_odom_time = now;
+    integrate_odometry(ctl, v_l, v_r, dt);
+}
+
+static void apply_feedback(chassis_controller_t *ctl, int dir1, int speed1_mrs,
+                           int dir2, int speed2_mrs)
+{
+    double rps1, rps2, v1, v2;
 
     rps1 = (double)speed1_mrs / 1000.0;
     rps2 = (double)speed2_mrs / 1000.0;
@@ -372,28 +1530,524 @@ static void parse_feedback(chassis_controller_t *ctl, const char *buf)
         v2 = 0.0;
     }
 
-    pthread_mutex_lock(&ctl->lock);
     ctl->feedback_dir_l = dir1;
     ctl->feedback_dir_r = dir2;
     ctl->feedback_v_l = v1;
     ctl->feedback_v_r = v2;
     update_odometry(ctl, v1, v2);
+    publish_odometry(ctl);
+}
+
+static double mrs_to_mps(const chassis_config_t *cfg, int32_t mrs)
+{
+    return (double)mrs / 1000.0 * 2.0 * M_PI * cfg->wheel_radius_m;
+}
+
+static void apply_telemetry(chassis_controller_t *ctl,
+                            const struct motor_proto_telemetry_frame *frame)
+{
+    const struct motor_proto_telemetry_record *rec;
+    double v1 = 0.0, v2 = 0.0;
+    uint8_t i;
+
+    for (i = 0; i < frame->count; ++i) {
+        rec = &frame->records[i];
+        v1 = mrs_to_mps(&ctl->cfg, rec->wheel[0].speed_mrs);
+        v2 = mrs_to_mps(&ctl->cfg, rec->wheel[1].speed_mrs);
+
+        /* dt comes from the RCPU sample clock, not from message arrival */
+        if (ctl->sample_time_valid) {
+            integrate_odometry(ctl, v1, v2,
+                               (double)(uint32_t)(rec->timestamp_us -
+                                                  ctl->last_sample_us) / 1000000.0);
+        }
+        ctl->last_sample_us = rec->timestamp_us;
+        ctl->sample_time_valid = 1;
+    }
+
+    if (frame->dropped != ctl->telemetry_dropped) {
+        fprintf(stderr, "[RPMsg] telemetry dropped %u records on RCPU\n",
+                (unsigned)(uint16_t)(frame->dropped - ctl->telemetry_dropped));
+        ctl->telemetry_dropped = frame->dropped;
+    }
+    ctl->telemetry_records += frame->count;
+
+    ctl->feedback_v_l = v1;
+    ctl->feedback_v_r = v2;
+    ctl->feedback_dir_l = v1 > 0.0 ? 1 : (v1 < 0.0 ? 2 : 0);
+    ctl->feedback_dir_r = v2 > 0.0 ? 1 : (v2 < 0.0 ? 2 : 0);
+    /* keep per-message odometry from double counting if feedback mode returns */
+    clock_gettime(CLOCK_MONOTONIC, &ctl->last_odom_time);
+    publish_odometry(ctl);
+}
+
+static int mrs_to_dir(int32_t mrs)
+{
+    if (mrs > 0) {
+        return 1;
+    }
+    return mrs < 0 ? 2 : 0;
+}
+
+/* The RCPU integrates every control tick; its pose replaces the local one. */
+static void apply_odom(chassis_controller_t *ctl,
+                       const struct motor_proto_odom_frame *frame)
+{
+    ctl->odom_x = (double)frame->x_mm / 1000.0;
+    ctl->odom_y = (double)frame->y_mm / 1000.0;
+    ctl->odom_yaw = (double)frame->yaw_urad / 1000000.0;
+    ctl->feedback_v_l = mrs_to_mps(&ctl->cfg, frame->measured_mrs[0]);
+    ctl->feedback_v_r = mrs_to_mps(&ctl->cfg, frame->measured_mrs[1]);
+    ctl->feedback_dir_l = mrs_to_dir(frame->measured_mrs[0]);
+    ctl->feedback_dir_r = mrs_to_dir(frame->measured_mrs[1]);
+    ctl->sample_time_valid = 0;
+    clock_gettime(CLOCK_MONOTONIC, &ctl->last_odom_time);
+    publish_odometry(ctl);
+}
+
+/* Called by the receive thread for every feedback frame with an echo trailer. */
+static void record_echo(chassis_controller_t *ctl,
+                        const struct motor_proto_echo *echo)
+{
+    uint32_t rtt = monotonic_us() - echo->cmd_timestamp_us;
+    uint32_t rcpu = echo->rx_to_apply_us + echo->apply_to_tx_us;
+    latency_set_t *lat = &ctl->lat;
+
+    if (atomic_exchange_explicit(&ctl->lat_reset_req, 0, memory_order_relaxed)) {
+        snapshot_write_begin(&ctl->lat_seq);
+        memset(lat, 0, sizeof(*lat));
+        snapshot_write_end(&ctl->lat_seq);
+    }
+
+    /* the same CMD is echoed until the next one is applied */
+    if (lat->have_seq && echo->cmd_seq == lat->last_seq) {
+        return;
+    }
+
+    snapshot_write_begin(&ctl->lat_seq);
+    latency_stat_add(&lat->rtt, rtt);
+    latency_stat_add(&lat->rx_to_apply, echo->rx_to_apply_us);
+    latency_stat_add(&lat->apply_to_tx, echo->apply_to_tx_us);
+    latency_stat_add(&lat->transport, rtt > rcpu ? rtt - rcpu : 0);
+    lat->last_seq = echo->cmd_seq;
+    lat->have_seq = 1;
+    snapshot_write_end(&ctl->lat_seq);
+}
+
+static void print_latency(chassis_controller_t *ctl)
+{
+    static latency_set_t lat; /* too large for comfort on the stack */
+    unsigned int seq;
+
+    do {
+        seq = snapshot_read_begin(&ctl->lat_seq);
+        lat = ctl->lat;
+    } while (snapshot_read_retry(&ctl->lat_seq, seq));
+
+    if (!lat.have_seq) {
+        printf("latency: no echo received (text protocol or old RCPU firmware)\n");
+        return;
+    }
+    printf("latency: last applied seq=%u\n", lat.last_seq);
+    latency_stat_print("rtt", &lat.rtt);
+    latency_stat_print("rx_to_apply", &lat.rx_to_apply);
+    latency_stat_print("apply_to_tx", &lat.apply_to_tx);
+    latency_stat_print("transport", &lat.transport);
+}
+
+static void record_profile(chassis_controller_t *ctl, const void *buf, size_t len)
+{
+    if (len > sizeof(ctl->prof_frame)) {
+        return;
+    }
+    snapshot_write_begin(&ctl->prof_seq);
+    memcpy(ctl->prof_frame, buf, len);
+    ctl->prof_len = len;
+    ctl->prof_frames++;
+    snapshot_write_end(&ctl->prof_seq);
+}
+
+static void print_profile(chassis_controller_t *ctl)
+{
+    static uint8_t buf[MOTOR_PROTO_MAX_PAYLOAD];
+    const struct motor_proto_profile_frame *frame =
+        (const struct motor_proto_profile_frame *)buf;
+    const struct motor_proto_profile_thread *t;
+    unsigned long frames;
+    unsigned int seq;
+    size_t len;
+    char name[sizeof(t->name) + 1];
+    int i;
+
+    do {
+        seq = snapshot_read_begin(&ctl->prof_seq);
+        len = ctl->prof_len;
+        frames = ctl->prof_frames;
+        memcpy(buf, ctl->prof_frame, len);
+    } while (snapshot_read_retry(&ctl->prof_seq, seq));
+
+    if (frames == 0) {
+        printf("no PROFILE frame received (run \"prof report <ms>\" on the RCPU)\n");
+        return;
+    }
+
+    printf("RCPU profile #%lu: window %.1f ms", frames, frame->window_us / 1000.0);
+    if (frame->cpu_load_permille == 0xFFFF) {
+        printf(", cpu load n/a (RT_USING_HOOK off)\n");
+    } else {
+        printf(", cpu load %.1f%%, irq %.1f%%\n", frame->cpu_load_permille / 10.0,
+               frame->irq_permille / 10.0);
+    }
+    printf("%-8s %4s %6s %15s %6s %12s %12s\n", "thread", "pri", "cpu%",
+           "stack used/size", "used%", "exec_max_us", "resp_max_us");
+    for (i = 0; i < frame->count; i++) {
+        t = &frame->threads[i];
+        memcpy(name, t->name, sizeof(t->name));
+        name[sizeof(t->name)] = '\0';
+        if (!t->alive) {
+            printf("%-8s %4u %6.1f %15s\n", name, t->priority,
+                   t->cpu_permille / 10.0, "(exited)");
+            continue;
+        }
+        printf("%-8s %4u %6.1f %7u/%-7u %5.1f%% %12u %12u\n", name, t->priority,
+               t->cpu_permille / 10.0, t->stack_used, t->stack_size,
+               t->stack_size ? 100.0 * t->stack_used / t->stack_size : 0.0,
+               t->exec_max_us, t->resp_max_us);
+    }
+}
+
+/* HELLO reply: setpoint_mrs = address low/high, measured_mrs[0] = size */
+static void attach_advertised_shm(chassis_controller_t *ctl,
+                                  const struct motor_proto_wheel_frame *hello)
+{
+    uint64_t phys = ctl->cfg.shm_addr;
+    size_t size = (size_t)(uint32_t)hello->measured_mrs[0];
+
+    if (phys == 0) {
+        phys = (uint64_t)(uint32_t)hello->setpoint_mrs[0] |
+               ((uint64_t)(uint32_t)hello->setpoint_mrs[1] << 32);
+    } else if (size == 0) {
+        size = MOTOR_SHM_SIZE;
+    }
+    if (shm_attach(ctl, phys, size) == 0 || ctl->cfg.feedback_enable != 0) {
+        return;
+    }
+
+    /* fall back to RPMsg feedback */
+    fprintf(stderr, "shm: falling back to RPMsg feedback\n");
+    pthread_mutex_lock(&ctl->lock);
+    ctl->cfg.feedback_enable = 1;
     pthread_mutex_unlock(&ctl->lock);
+    send_cfg(ctl);
+}
+
+/* print the RCPU fault flags when they change; axes < 0 when only hdr.flags is known */
+static void report_faults(chassis_controller_t *ctl, unsigned int flags, int axes)
+{
+    if (flags == ctl->fault_flags) {
+        return;
+    }
+    ctl->fault_flags = (uint8_t)flags;
+    if (flags == 0) {
+        printf("[RPMsg] faults cleared\n");
+        return;
+    }
+    printf("[RPMsg] FAULT 0x%02x%s%s%s", flags,
+           (flags & MOTOR_PROTO_FAULT_CMD_TIMEOUT) ? " cmd_timeout" : "",
+           (flags & MOTOR_PROTO_FAULT_STALL) ? " stall" : "",
+           (flags & MOTOR_PROTO_FAULT_ENCODER) ? " encoder" : "");
+    if (axes >= 0) {
+        printf(" axes=0x%02x", axes);
+    }
+    printf(", motors cut off\n");
+}
+
+static void parse_binary_feedback(chassis_controller_t *ctl, const void *buf,
+                                  size_t len)
+{
+    const struct motor_proto_echo *echo;
+    const struct motor_proto_wheel_frame *frame =
+        (const struct motor_proto_wheel_frame *)buf;
+    int32_t m1, m2;
+
+    if (motor_proto_check(buf, len) != 0) {
+        fprintf(stderr, "[RPMsg] bad binary frame (len=%zu)\n", len);
+        return;
+    }
+
+    echo = motor_proto_echo_find(buf, len);
+    if (echo != NULL) {
+        record_echo(ctl, echo);
+    }
+
+    switch (frame->hdr.type) {
+    case MOTOR_PROTO_TYPE_HELLO:
+        if (!ctl->binary_proto) {
+            ctl->binary_proto = 1;
+            printf("RPMsg binary protocol v%d negotiated\n", frame->hdr.version);
+            if (ctl->cfg.shm) {
+                attach_advertised_shm(ctl, frame);
+            }
+        }
+        break;
+    case MOTOR_PROTO_TYPE_FEEDBACK:
+        report_faults(ctl, frame->hdr.flags, -1);
+        m1 = frame->measured_mrs[0];
+        m2 = frame->measured_mrs[1];
+        apply_feedback(ctl, mrs_to_dir(m1), m1 < 0 ? -m1 : m1,
+                       mrs_to_dir(m2), m2 < 0 ? -m2 : m2);
+        ctl->sample_time_valid = 0;
+        break;
+    case MOTOR_PROTO_TYPE_TELEMETRY:
+        report_faults(ctl, frame->hdr.flags, -1);
+        apply_telemetry(ctl, (const struct motor_proto_telemetry_frame *)buf);
+        break;
+    case MOTOR_PROTO_TYPE_PROFILE:
+        record_profile(ctl, buf, len);
+        break;
+    case MOTOR_PROTO_TYPE_ODOM:
+        report_faults(ctl, frame->hdr.flags, -1);
+        apply_odom(ctl, (const struct motor_proto_odom_frame *)buf);
+        break;
+    default:
+        fprintf(stderr, "[RPMsg] unknown binary frame type %d\n", frame->hdr.type);
+        break;
+    }
+}
+
+/* autotune events: TUNE,<axis>,<status>,... per axis, then TUNE,applied,ff,kp,ki,kd (x1000) */
+static void apply_tune_event(chassis_controller_t *ctl, const char *buf)
+{
+    int ff, kp, ki, kd;
+
+    printf("[RPMsg] %s\n", buf);
+    if (sscanf(buf, "TUNE,applied,%d,%d,%d,%d", &ff, &kp, &ki, &kd) != 4) {
+        return;
+    }
+
+    /* keep the tuned gains for later CFG resends */
+    pthread_mutex_lock(&ctl->lock);
+    ctl->cfg.ff_factor = ff / 1000.0;
+    ctl->cfg.pid_kp = kp / 1000.0;
+    ctl->cfg.pid_ki = ki / 1000.0;
+    ctl->cfg.pid_kd = kd / 1000.0;
+    pthread_mutex_unlock(&ctl->lock);
+    printf("autotune applied: ff=%.3f kp=%.3f ki=%.3f kd=%.3f\n", ff / 1000.0,
+           kp / 1000.0, ki / 1000.0, kd / 1000.0);
+}
+
+static void parse_feedback(chassis_controller_t *ctl, const char *buf, size_t len)
+{
+    int dir1 = 0, dir2 = 0;
+    int speed1_mrs = 0, speed2_mrs = 0;
+    unsigned int flags, axes;
+
+    if (motor_proto_is_binary(buf, len)) {
+        parse_binary_feedback(ctl, buf, len);
+        return;
+    }
+    if (strcmp(buf, "DIAG,ok") == 0) {
+        /* only ever sent on the diag endpoint, in reply to our DIAG */
+        if (!ctl->diag_up && ctl->rpmsg_diag_fd >= 0) {
+            ctl->diag_up = 1;
+            printf("RPMsg diag channel active\n");
+        }
+        return;
+    }
+    if (strncmp(buf, "TUNE,", 5) == 0) {
+        apply_tune_event(ctl, buf);
+        return;
+    }
+    if (strncmp(buf, "FF,", 3) == 0) {
+        /* table echo / FFGET reply, same format as the lines "ff load" accepts */
+        printf("[RPMsg] %s\n", buf);
+        return;
+    }
+    if (sscanf(buf, "FAULT,%u,%u", &flags, &axes) == 2) {
+        /* the only fault report in text mode; may repeat a change hdr.flags showed */
+        report_faults(ctl, flags, (int)axes);
+        return;
+    }
+
+    if (sscanf(buf, "%d,%d;%d,%d", &dir1, &speed1_mrs, &dir2, &speed2_mrs) != 4) {
+        printf("[RPMsg] %s\n", buf);
+        return;
+    }
+
+    apply_feedback(ctl, dir1, speed1_mrs, dir2, speed2_mrs);
 }
 
+/* copy one RCPU message to every subscriber; a full socket skips the copy */
+static void fanout_publish(fanout_t *fo, const void *buf, size_t len)
+{
+    int i;
+
+    for (i = 0; i < FANOUT_MAX_CLIENTS; ++i) {
+        if (fo->fds[i] < 0) {
+            continue;
+        }
+        if (send(fo->fds[i], buf, len, MSG_DONTWAIT | MSG_NOSIGNAL) >= 0) {
+            atomic_fetch_add_explicit(&fo->forwarded, 1, memory_order_relaxed);
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            atomic_fetch_add_explicit(&fo->dropped, 1, memory_order_relaxed);
+        } else {
+            fanout_close(fo, i);
+        }
+    }
+}
+
+static void fanout_accept(fanout_t *fo)
+{
+    int fd = accept4(fo->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    int i;
+
+    if (fd < 0) {
+        return;
+    }
+    for (i = 0; i < FANOUT_MAX_CLIENTS; ++i) {
+        if (fo->fds[i] < 0) {
+            fo->fds[i] = fd;
+            atomic_fetch_add_explicit(&fo->clients, 1, memory_order_relaxed);
+            printf("fan-out: client %d connected\n", i);
+            return;
+        }
+    }
+    fprintf(stderr, "fan-out: %d clients already connected, refusing\n", FANOUT_MAX_CLIENTS);
+    close(fd);
+}
+
+/* clients configure and diagnose; speed commands stay with this process */
+static int fanout_request_allowed(const char *buf, size_t len)
+{
+    if (len == 0 || motor_proto_is_binary(buf, len) || memchr(buf, '\0', len) == NULL) {
+        return 0;
+    }
+    return strncmp(buf, "CFG,", 4) == 0 || strncmp(buf, "TUNE,", 5) == 0 ||
+           strncmp(buf, "FF", 2) == 0 || strcmp(buf, "FAULTCLR") == 0;
+}
+
+/* forward a client request without waiting: the receive thread must not block */
+static void fanout_request(chassis_controller_t *ctl, int i)
+{
+    fanout_t *fo = &ctl->fanout;
+    char buf[MOTOR_PROTO_MAX_PAYLOAD];
+    ssize_t n;
+
+    n = recv(fo->fds[i], buf, sizeof(buf), MSG_DONTWAIT);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return;
+    }
+    if (n <= 0) {
+        fanout_close(fo, i);
+        return;
+    }
+    if (!fanout_request_allowed(buf, (size_t)n)) {
+        atomic_fetch_add_explicit(&fo->rejected, 1, memory_order_relaxed);
+        fprintf(stderr, "fan-out: client %d request refused (CFG/TUNE/FF/FAULTCLR text only)\n",
+                i);
+        return;
+    }
+    if (tx_try_write(request_fd(ctl), buf, (size_t)n) > 0) {
+        atomic_fetch_add_explicit(&fo->requests, 1, memory_order_relaxed);
+    } else {
+        atomic_fetch_add_explicit(&fo->rejected, 1, memory_order_relaxed);
+        fprintf(stderr, "fan-out: client %d request dropped (no TX buffer)\n", i);
+    }
+}
+
+static void fanout_reset_stats(fanout_t *fo)
+{
+    atomic_store_explicit(&fo->forwarded, 0, memory_order_relaxed);
+    atomic_store_explicit(&fo->dropped, 0, memory_order_relaxed);
+    atomic_store_explicit(&fo->requests, 0, memory_order_relaxed);
+    atomic_store_explicit(&fo->rejected, 0, memory_order_relaxed);
+}
+
+static void fanout_print(fanout_t *fo)
+{
+    if (fo->listen_fd < 0) {
+        return;
+    }
+    printf("fan-out: clients=%d, forwarded=%lu, dropped=%lu, requests=%lu, rejected=%lu\n",
+           atomic_load_explicit(&fo->clients, memory_order_relaxed),
+           atomic_load_explicit(&fo->forwarded, memory_order_relaxed),
+           atomic_load_explicit(&fo->dropped, memory_order_relaxed),
+           atomic_load_explicit(&fo->requests, memory_order_relaxed),
+           atomic_load_explicit(&fo->rejected, memory_order_relaxed));
+}
+
+/*
+ * Read and handle one message, then pass it on to the subscribers.
+ * Returns the message length, 0 when there was none, -1 on a fatal error.
+ */
+static int recv_message(chassis_controller_t *ctl, int fd, char *buf, size_t size)
+{
+    int ret;
+
+    memset(buf, 0, size);
+    ret = (int)read(fd, buf, size - 1);
+    if (ret < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return 0;
+        }
+        fprintf(stderr, "read failed: %s\n", strerror(errno));
+        return -1;
+    }
+    if (ret == 0) {
+        if (ctl->cfg.attach_path != NULL) {
+            fprintf(stderr, "fan-out owner closed the connection\n");
+            return -1;
+        }
+        return 0;
+    }
+
+    parse_feedback(ctl, buf, (size_t)ret);
+    fanout_publish(&ctl->fanout, buf, (size_t)ret);
+    return ret;
+}
+
+enum {
+    PFD_DATA,
+    PFD_WAKE,
+    PFD_DIAG,
+    PFD_LISTEN,
+    PFD_CLIENT0,
+    PFD_NUM = PFD_CLIENT0 + FANOUT_MAX_CLIENTS,
+};
+
 static void *recv_thread_entry(void *arg)
 {
     chassis_controller_t *ctl = (chassis_controller_t *)arg;
-    char recv_buf[256];
-    struct pollfd pfd;
+    char recv_buf[MOTOR_PROTO_MAX_PAYLOAD + 16];
+    struct pollfd pfd[PFD_NUM];
+    odom_snapshot_t odom;
+    uint64_t wakeups;
     int print_count = 0;
+    int i;
 
-    memset(&pfd, 0, sizeof(pfd));
-    pfd.fd = ctl->rpmsg_fd;
-    pfd.events = POLLIN;
+    memset(pfd, 0, sizeof(pfd));
+    pfd[PFD_DATA].fd = ctl->rpmsg_fd;
+    pfd[PFD_WAKE].fd = ctl->cmd_tx.wake_fd;
+    pfd[PFD_WAKE].events = POLLIN;
+    /* poll() skips negative fds: no diag endpoint, no fan-out, free slots */
+    pfd[PFD_DIAG].fd = ctl->rpmsg_diag_fd;
+    pfd[PFD_DIAG].events = POLLIN;
+    pfd[PFD_LISTEN].fd = ctl->fanout.listen_fd;
+    pfd[PFD_LISTEN].events = POLLIN;
 
     while (ctl->running && !g_stop_requested) {
-        int ret = poll(&pfd, 1, 100);
+        int ret;
+
+        /* POLLOUT only while a command is parked, otherwise it fires constantly */
+        pthread_mutex_lock(&ctl->cmd_tx.lock);
+        pfd[PFD_DATA].events = ctl->cmd_tx.len != 0 ? POLLIN | POLLOUT : POLLIN;
+        pthread_mutex_unlock(&ctl->cmd_tx.lock);
+        for (i = 0; i < FANOUT_MAX_CLIENTS; ++i) {
+            pfd[PFD_CLIENT0 + i].fd = ctl->fanout.fds[i];
+            pfd[PFD_CLIENT0 + i].events = POLLIN;
+        }
+
+        ret = poll(pfd, PFD_NUM, 100);
         if (ret < 0) {
             if (errno == EINTR) {
                 continue;
@@ -401,52 +2055,212 @@ static void *recv_thread_entry(void *arg)
             fprintf(stderr, "poll failed: %s\n", strerror(errno));
             break;
         }
-        if (ret == 0 || !(pfd.revents & POLLIN)) {
+        if (ret == 0) {
             continue;
         }
-
-        memset(recv_buf, 0, sizeof(recv_buf));
-        ret = (int)read(ctl->rpmsg_fd, recv_buf, sizeof(recv_buf) - 1);
-        if (ret < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
-                continue;
+        if (pfd[PFD_WAKE].revents & POLLIN) {
+            if (read(ctl->cmd_tx.wake_fd, &wakeups, sizeof(wakeups)) < 0) {
+                /* EAGAIN: an earlier round already consumed it */
             }
-            fprintf(stderr, "read failed: %s\n", strerror(errno));
-            break;
+        }
+        if (pfd[PFD_DATA].revents & POLLOUT) {
+            pthread_mutex_lock(&ctl->cmd_tx.lock);
+            cmd_tx_flush_locked(ctl);
+            pthread_mutex_unlock(&ctl->cmd_tx.lock);
         }
 
-        if (ret > 0) {
-            parse_feedback(ctl, recv_buf);
-            if (++print_count >= 10) {
-                pthread_mutex_lock(&ctl->lock);
+        /* feedback first, diagnostics and subscribers after it */
+        if (pfd[PFD_DATA].revents & (POLLIN | POLLHUP)) {
+            ret = recv_message(ctl, ctl->rpmsg_fd, recv_buf, sizeof(recv_buf));
+            if (ret < 0) {
+                break;
+            }
+            if (ret > 0 && ++print_count >= 10) {
+                read_odometry(ctl, &odom);
                 printf("[FB] vl=%.3f m/s vr=%.3f m/s | odom x=%.3f y=%.3f yaw=%.3f\n",
-                       ctl->feedback_v_l, ctl->feedback_v_r,
-                       ctl->odom_x, ctl->odom_y, ctl->odom_yaw);
-                pthread_mutex_unlock(&ctl->lock);
+                       odom.v_l, odom.v_r, odom.x, odom.y, odom.yaw);
                 print_count = 0;
             }
         }
+        if ((pfd[PFD_DIAG].revents & POLLIN) &&
+            recv_message(ctl, ctl->rpmsg_diag_fd, recv_buf, sizeof(recv_buf)) < 0) {
+            break;
+        }
+        if (pfd[PFD_LISTEN].revents & POLLIN) {
+            fanout_accept(&ctl->fanout);
+        }
+        for (i = 0; i < FANOUT_MAX_CLIENTS; ++i) {
+            if (ctl->fanout.fds[i] >= 0 &&
+                (pfd[PFD_CLIENT0 + i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                fanout_request(ctl, i);
+            }
+        }
     }
 
+    if (ctl->cfg.attach_path != NULL) {
+        g_stop_requested = 1;
+    }
     return NULL;
 }
 
+/* Only the stdin thread (or main before threads start) writes the command. */
 static void set_command(chassis_controller_t *ctl, double v, double w)
 {
-    pthread_mutex_lock(&ctl->lock);
-    ctl->cmd_v = v;
-    ctl->cmd_w = w;
-    clock_gettime(CLOCK_MONOTONIC, &ctl->last_cmd_time);
-    pthread_mutex_unlock(&ctl->lock);
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    snapshot_write_begin(&ctl->cmd_seq);
+    ctl->cmd.v = v;
+    ctl->cmd.w = w;
+    ctl->cmd.stamp = now;
+    snapshot_write_end(&ctl->cmd_seq);
+}
+
+static void read_command(chassis_controller_t *ctl, cmd_snapshot_t *out)
+{
+    unsigned int seq;
+
+    do {
+        seq = snapshot_read_begin(&ctl->cmd_seq);
+        *out = ctl->cmd;
+    } while (snapshot_read_retry(&ctl->cmd_seq, seq));
+}
+
+static int read_shm(chassis_controller_t *ctl, struct motor_shm_state *state)
+{
+    const volatile struct motor_shm_block *blk = atomic_load(&ctl->shm);
+
+    if (blk == NULL) {
+        return -1;
+    }
+    if (motor_shm_read(blk, state, 1000) != 0) {
+        fprintf(stderr, "shm: status block busy\n");
+        return -1;
+    }
+    return 0;
+}
+
+static void print_shm(chassis_controller_t *ctl)
+{
+    struct motor_shm_state st;
+    unsigned int faults;
+    int i;
+
+    if (read_shm(ctl, &st) != 0) {
+        printf("shm: not mapped (start with --shm and the binary protocol)\n");
+        return;
+    }
+    faults = (st.flags & MOTOR_SHM_FLAG_FAULT_MASK) >> MOTOR_SHM_FLAG_FAULT_SHIFT;
+    printf("shm: tick=%u t=%u us flags=0x%08x%s%s%s%s%s%s overruns=%u cmd_seq=%u\n",
+           st.tick, st.timestamp_us, st.flags,
+           (st.flags & MOTOR_SHM_FLAG_TRAJ) ? " traj" : "",
+           (st.flags & MOTOR_SHM_FLAG_SATURATED) ? " saturated" : "",
+           (st.flags & MOTOR_SHM_FLAG_OVERRUN) ? " overrun" : "",
+           (faults & MOTOR_PROTO_FAULT_CMD_TIMEOUT) ? " cmd_timeout" : "",
+           (faults & MOTOR_PROTO_FAULT_STALL) ? " stall" : "",
+           (faults & MOTOR_PROTO_FAULT_ENCODER) ? " encoder" : "", st.overruns,
+           st.cmd_seq);
+    printf("  pose: x=%.3f y=%.3f yaw=%.4f v=%.3f w=%.3f\n", st.x_mm / 1000.0,
+           st.y_mm / 1000.0, st.yaw_urad / 1e6, st.v_mmps / 1000.0, st.w_mradps / 1000.0);
+    for (i = 0; i < MOTOR_PROTO_WHEELS; ++i) {
+        printf("  wheel%d: set=%d meas=%d mr/s delta=%d duty=%.4f pid=%.4f/%.4f/%.4f\n", i,
+               st.wheel[i].setpoint_mrs, st.wheel[i].speed_mrs, st.wheel[i].delta,
+               st.wheel[i].duty / 10000.0, st.wheel[i].p_out / 10000.0,
+               st.wheel[i].i_out / 10000.0, st.wheel[i].d_out / 10000.0);
+    }
 }
 
 static void print_odom(chassis_controller_t *ctl)
 {
-    pthread_mutex_lock(&ctl->lock);
+    struct motor_shm_state st;
+    odom_snapshot_t odom;
+
+    if (read_shm(ctl, &st) == 0) {
+        printf("odom (shm): x=%.4f y=%.4f yaw=%.4f | fb_l=%.4f fb_r=%.4f\n",
+               st.x_mm / 1000.0, st.y_mm / 1000.0, st.yaw_urad / 1e6,
+               mrs_to_mps(&ctl->cfg, st.wheel[0].speed_mrs),
+               mrs_to_mps(&ctl->cfg, st.wheel[1].speed_mrs));
+        return;
+    }
+
+    read_odometry(ctl, &odom);
     printf("odom: x=%.4f y=%.4f yaw=%.4f | fb_l=%.4f fb_r=%.4f\n",
-           ctl->odom_x, ctl->odom_y, ctl->odom_yaw,
-           ctl->feedback_v_l, ctl->feedback_v_r);
-    pthread_mutex_unlock(&ctl->lock);
+           odom.x, odom.y, odom.yaw, odom.v_l, odom.v_r);
+}
+
+/* tune <step|relay|stop> [duty_low duty_high] [apply] */
+static int send_tune(chassis_controller_t *ctl, const char *line)
+{
+    char mode[16], word[16];
+    char cmd[96];
+    double lo, hi;
+    int n;
+
+    n = sscanf(line, "%*s %15s %lf %lf %15s", mode, &lo, &hi, word);
+    if (n >= 1 && strcmp(mode, "stop") == 0) {
+        return send_raw(ctl, "TUNE,stop");
+    }
+    if (n < 1 || (strcmp(mode, "step") != 0 && strcmp(mode, "relay") != 0)) {
+        printf("Usage: tune <step|relay|stop> [duty_low duty_high] [apply]\n");
+        return -1;
+    }
+
+    if (n >= 3) {
+        snprintf(cmd, sizeof(cmd), "TUNE,%s,%.3f,%.3f,%d", mode, lo, hi,
+                 n == 4 && strcmp(word, "apply") == 0);
+    } else if (sscanf(line, "%*s %*s %15s", word) == 1 && strcmp(word, "apply") == 0) {
+        snprintf(cmd, sizeof(cmd), "TUNE,%s,%.3f,%.3f,1", mode, DEFAULT_TUNE_DUTY_LOW,
+                 DEFAULT_TUNE_DUTY_HIGH);
+    } else {
+        snprintf(cmd, sizeof(cmd), "TUNE,%s", mode);
+    }
+
+    /* commanding zero keeps the send loop from restarting the wheels afterwards */
+    set_command(ctl, 0.0, 0.0);
+    printf("Send TUNE: %s\n", cmd);
+    return send_raw(ctl, cmd);
+}
+
+/* ff get | ff off <axis> | ff load <file>: the file holds "FF,..." lines as printed by the
+ * RCPU "ff_cal" command or echoed by "ff get", other lines are skipped */
+static int send_ff(chassis_controller_t *ctl, const char *line)
+{
+    char sub[16], arg[200];
+    char cmd[MOTOR_PROTO_MAX_PAYLOAD];
+    FILE *fp;
+    int n, sent = 0;
+
+    n = sscanf(line, "%*s %15s %199s", sub, arg);
+    if (n >= 1 && strcmp(sub, "get") == 0) {
+        return send_raw(ctl, "FFGET");
+    }
+    if (n == 2 && strcmp(sub, "off") == 0) {
+        snprintf(cmd, sizeof(cmd), "FF,%d,off", atoi(arg));
+        return send_raw(ctl, cmd);
+    }
+    if (n != 2 || strcmp(sub, "load") != 0) {
+        printf("Usage: ff <get|off <axis>|load <file>>\n");
+        return -1;
+    }
+
+    fp = fopen(arg, "r");
+    if (fp == NULL) {
+        printf("ff load: cannot open %s: %s\n", arg, strerror(errno));
+        return -1;
+    }
+    while (fgets(cmd, sizeof(cmd), fp) != NULL) {
+        cmd[strcspn(cmd, "\r\n")] = '\0';
+        if (strncmp(cmd, "FF,", 3) != 0) {
+            continue;
+        }
+        if (send_raw(ctl, cmd) != 0) {
+            break;
+        }
+        sent++;
+    }
+    fclose(fp);
+    printf("ff load: sent %d table(s) from %s\n", sent, arg);
+    return sent > 0 ? 0 : -1;
 }
 
 static void *stdin_thread_entry(void *arg)
@@ -464,7 +2278,10 @@ static void *stdin_thread_entry(void *arg)
             continue;
         }
 
-        if (strcmp(op, "cmd") == 0) {
+        if ((strcmp(op, "cmd") == 0 || strcmp(op, "stop") == 0) &&
+            ctl->cfg.attach_path != NULL) {
+            printf("%s: speed commands stay with the --fanout owner\n", op);
+        } else if (strcmp(op, "cmd") == 0) {
             if (sscanf(line, "%*s %lf %lf", &a, &b) == 2) {
                 set_command(ctl, a, b);
                 printf("cmd_vel: v=%.3f m/s w=%.3f rad/s\n", a, b);
@@ -483,14 +2300,70 @@ static void *stdin_thread_entry(void *arg)
                 ctl->cfg.pid_kp = c;
                 ctl->cfg.pid_ki = d;
                 ctl->cfg.pid_kd = e;
-                ctl->cfg.feedback_enable = fb ? 1 : 0;
+                ctl->cfg.feedback_enable = (fb >= 0 && fb <= 3) ? fb : 1;
                 pthread_mutex_unlock(&ctl->lock);
                 send_cfg(ctl);
             } else {
-                printf("Usage: cfg <ratio> <ff> <kp> <ki> <kd> <fb0_or_1>\n");
+                printf("Usage: cfg <ratio> <ff> <kp> <ki> <kd> <fb0_to_3>\n");
             }
         } else if (strcmp(op, "odom") == 0) {
             print_odom(ctl);
+        } else if (strcmp(op, "stats") == 0) {
+            if (sscanf(line, "%*s %31s", op) == 1 && strcmp(op, "reset") == 0) {
+                period_timer_reset_stats(&ctl->send_timer);
+                cmd_tx_reset_stats(&ctl->cmd_tx);
+                fanout_reset_stats(&ctl->fanout);
+                printf("stats reset\n");
+            } else {
+                period_timer_print(&ctl->send_timer);
+                cmd_tx_print(&ctl->cmd_tx);
+                fanout_print(&ctl->fanout);
+            }
+        } else if (strcmp(op, "lat") == 0) {
+            if (sscanf(line, "%*s %31s", op) == 1 && strcmp(op, "reset") == 0) {
+                atomic_store_explicit(&ctl->lat_reset_req, 1, memory_order_relaxed);
+                printf("latency stats reset\n");
+            } else {
+                print_latency(ctl);
+            }
+        } else if (strcmp(op, "prof") == 0) {
+            print_profile(ctl);
+        } else if (strcmp(op, "shm") == 0) {
+            print_shm(ctl);
+        } else if (strcmp(op, "tune") == 0) {
+            send_tune(ctl, line);
+        } else if (strcmp(op, "ff") == 0) {
+            send_ff(ctl, line);
+        } else if (strcmp(op, "fault") == 0) {
+            if (sscanf(line, "%*s %31s", op) == 1 && strcmp(op, "clear") == 0) {
+                send_raw(ctl, "FAULTCLR");
+            } else {
+                printf("Usage: fault clear\n");
+            }
+        } else if (strcmp(op, "rate") == 0) {
+            char cmd[64];
+            int hz, ms;
+            int n = sscanf(line, "%*s %d %d", &hz, &ms);
+
+            if (n == 2) {
+                snprintf(cmd, sizeof(cmd), "CFG,rate,%d,%d", hz, ms);
+                send_raw(ctl, cmd);
+            } else if (n == 1) {
+                snprintf(cmd, sizeof(cmd), "CFG,rate,%d", hz);
+                send_raw(ctl, cmd);
+            } else {
+                printf("Usage: rate <hz> [feedback_ms]\n");
+            }
+        } else if (strcmp(op, "prio") == 0) {
+            char cmd[64], name[16];
+            int prio;
+
+            if (sscanf(line, "%*s %15s %d", name, &prio) == 2) {
+                snprintf(cmd, sizeof(cmd), "CFG,prio,%s,%d", name, prio);
+                send_raw(ctl, cmd);
+            } else {
+                printf("Usage: prio <thread> <n>\n");
+            }
         } else if (strcmp(op, "help") == 0) {
             print_usage("k3_chassis_control");
         } else if (strcmp(op, "quit") == 0 || strcmp(op, "exit") == 0) {
@@ -514,6 +2387,9 @@ int main(int argc, char **argv)
     memset(&ctl, 0, sizeof(ctl));
     ctl.rpmsg_ctrl_fd = -1;
     ctl.rpmsg_fd = -1;
+    ctl.rpmsg_diag_fd = -1;
+    ctl.cmd_tx.wake_fd = -1;
+    fanout_init(&ctl.fanout);
     ctl.running = 1;
     pthread_mutex_init(&ctl.lock, NULL);
     config_init(&ctl.cfg);
@@ -530,25 +2406,53 @@ int main(int argc, char **argv)
 
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+    /* a peer that goes away is seen as a write error, not a signal */
+    signal(SIGPIPE, SIG_IGN);
+
+    if (ctl.cfg.mlock) {
+        lock_memory();
+    }
 
-    clock_gettime(CLOCK_MONOTONIC, &ctl.last_cmd_time);
     clock_gettime(CLOCK_MONOTONIC, &ctl.last_odom_time);
-    ctl.cmd_v = ctl.cfg.init_v;
-    ctl.cmd_w = ctl.cfg.init_w;
+    set_command(&ctl, ctl.cfg.init_v, ctl.cfg.init_w);
 
-    if (rpmsg_init(&ctl) != 0) {
+    if ((ctl.cfg.attach_path != NULL ? attach_init(&ctl) : rpmsg_init(&ctl)) != 0) {
+        pthread_mutex_destroy(&ctl.lock);
+        return 1;
+    }
+    if (ctl.cfg.diag && ctl.cfg.attach_path == NULL) {
+        rpmsg_diag_init(&ctl);
+    }
+    if (ctl.cfg.fanout_path != NULL && fanout_listen(&ctl.fanout, ctl.cfg.fanout_path) != 0) {
+        rpmsg_cleanup(&ctl);
         pthread_mutex_destroy(&ctl.lock);
         return 1;
     }
 
     if (pthread_create(&ctl.recv_thread, NULL, recv_thread_entry, &ctl) != 0) {
         fprintf(stderr, "create receive thread failed\n");
+        fanout_cleanup(&ctl.fanout, ctl.cfg.fanout_path);
         rpmsg_cleanup(&ctl);
         pthread_mutex_destroy(&ctl.lock);
         return 1;
     }
+    apply_thread_rt(ctl.recv_thread, "recv thread", ctl.cfg.rt_prio, ctl.cfg.recv_cpu);
+
+    /* an explicit address needs no HELLO (text protocol, older RCPU firmware) */
+    if (ctl.cfg.shm && ctl.cfg.shm_addr != 0 && ctl.cfg.text_protocol &&
+        shm_attach(&ctl, ctl.cfg.shm_addr, MOTOR_SHM_SIZE) != 0) {
+        ctl.cfg.feedback_enable = 1;
+    }
+
+    if (!ctl.cfg.text_protocol && ctl.cfg.attach_path == NULL) {
+        send_hello(&ctl);
+    }
+    if (ctl.rpmsg_diag_fd >= 0) {
+        send_diag_hello(&ctl);
+    }
 
-    if (ctl.cfg.cfg_send_on_startup) {
+    /* a subscriber leaves the RCPU configuration to the owner */
+    if (ctl.cfg.cfg_send_on_startup && ctl.cfg.attach_path == NULL) {
         send_cfg(&ctl);
     }
 
@@ -560,39 +2464,70 @@ int main(int argc, char **argv)
         }
     }
 
-    printf("Controller started. Press Ctrl+C to exit.\n");
+    if (ctl.cfg.attach_path != NULL) {
+        printf("Subscribed to %s. Press Ctrl+C to exit.\n", ctl.cfg.attach_path);
+        while (!g_stop_requested) {
+            usleep(100000);
+        }
+    } else {
+        /* after the stdin thread is created so it keeps the default policy */
+        apply_thread_rt(pthread_self(), "send loop", ctl.cfg.rt_prio, ctl.cfg.send_cpu);
+
+        printf("Controller started. Press Ctrl+C to exit.\n");
+        period_timer_init(&ctl.send_timer, ctl.cfg.send_hz);
+    }
+    /* not entered with --attach */
     while (!g_stop_requested) {
         struct timespec now;
+        cmd_snapshot_t cmd;
         double v;
         double w;
         double age;
 
-        pthread_mutex_lock(&ctl.lock);
+        read_command(&ctl, &cmd);
         clock_gettime(CLOCK_MONOTONIC, &now);
-        age = monotonic_elapsed_sec(&ctl.last_cmd_time, &now);
+
+        /* single commands until the binary protocol is negotiated */
+        if (ctl.cfg.horizon_sec > 0.0 && ctl.binary_proto) {
+            send_trajectory(&ctl, &cmd, &now);
+            period_timer_wait(&ctl.send_timer);
+            continue;
+        }
+
+        age = monotonic_elapsed_sec(&cmd.stamp, &now);
         if (age > ctl.cfg.cmd_timeout_sec) {
             v = 0.0;
             w = 0.0;
         } else {
-            v = ctl.cmd_v;
-            w = ctl.cmd_w;
+            v = cmd.v;
+            w = cmd.w;
         }
-        pthread_mutex_unlock(&ctl.lock);
 
         send_chassis_command(&ctl, v, w);
-        sleep_period(ctl.cfg.send_hz);
+        period_timer_wait(&ctl.send_timer);
     }
 
     ctl.running = 0;
-    send_chassis_command(&ctl, 0.0, 0.0);
+    if (ctl.cfg.attach_path == NULL) {
+        send_chassis_command(&ctl, 0.0, 0.0);
+        cmd_tx_drain(&ctl);
+    }
     pthread_join(ctl.recv_thread, NULL);
     if (stdin_thread_started) {
         pthread_cancel(stdin_thread);
         pthread_join(stdin_thread, NULL);
     }
+    fanout_print(&ctl.fanout);
+    fanout_cleanup(&ctl.fanout, ctl.cfg.fanout_path);
     rpmsg_cleanup(&ctl);
+    shm_detach(&ctl);
     pthread_mutex_destroy(&ctl.lock);
 
+    if (ctl.cfg.attach_path == NULL) {
+        period_timer_print(&ctl.send_timer);
+        cmd_tx_print(&ctl.cmd_tx);
+    }
+    print_latency(&ctl);
     printf("Controller stopped.\n");
     return 0;
 }
@@ -0,0 +1,845 @@
+/*
+ * Host-side simulation of the RCPU chassis control stack.
+ *
+ * Links control_main.c and the src/ control modules unchanged against the
+ * RT-Thread stand-ins in rtt_sim.c, and closes the loop through a DC motor
+ * and encoder model (plant.c) on every axis of motor_axis_table. Simulated
+ * time only advances while the control thread waits for its tick, so runs
+ * are deterministic and as fast as the host allows.
+ *
+ * Scenario: all axes step from 0 to --setpoint at --step-at seconds and to
+ * --setpoint2 at the half of --duration. Step metrics are taken on the first
+ * step, IAE over the whole run. --accel/--jerk set the firmware's setpoint
+ * limits, so the metrics then include the shaped ramp. --hz2 switches the
+ * control rate at the second step through control_tick_set_hz(), the same
+ * path as the firmware's runtime rate change.
+ *
+ * Gain sweep: any of --kp/--ki/--kd/--ff may be a range "lo:hi:n". Every
+ * combination runs in its own forked process (the firmware keeps its state
+ * in file-scope statics), up to --jobs at a time, and the results are
+ * printed sorted by IAE.
+ *
+ * Auto-tuning: --autotune step|relay runs the firmware's autotune experiment
+ * from t = 0 instead of the step scenario and prints the identified plant and
+ * the suggested gains, which can then be checked with a normal run.
+ * --ff-cal runs the feed-forward calibration sweep the same way and prints
+ * the tables in the "FF,..." upload format; --ff-table installs such a
+ * table on every axis before a normal run.
+ */
+
+#define _GNU_SOURCE
+#define SIM_KEEP_MAIN
+
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "autotune.h"
+#include "common.h"
+#include "control_tick.h"
+#include "ff_table.h"
+#include "health.h"
+#include "motor_axis.h"
+#include "plant.h"
+#include "rpmsg_motor.h"
+#include "rtt_sim.h"
+#include "setpoint.h"
+
+/* the simulator runs the chassis thread only; a separate encoder thread would never wake */
+#ifndef ENCODER_SAMPLE_INLINE
+#error "chassis_sim requires ENCODER_SAMPLE_INLINE"
+#endif
+
+#define SIM_DEFAULT_HZ        CONTROL_TICK_DEFAULT_HZ
+#define SIM_DEFAULT_DURATION  5.0
+#define SIM_DEFAULT_STEP_AT   0.2
+#define SIM_DEFAULT_SETPOINT  2.0
+#define SIM_DEFAULT_SUBSTEP   50.0 /* us, well below L/R */
+#define SIM_DEFAULT_TOP       10
+#define SIM_SETTLE_BAND       0.02
+#define SIM_SAT_DUTY          0.999
+
+typedef struct {
+    double lo;
+    double hi;
+    int n;
+} sweep_range_t;
+
+typedef struct {
+    double kp;
+    double ki;
+    double kd;
+    double ff;
+} gains_t;
+
+typedef struct {
+    gains_t g;
+    double iae;          /* sum over axes, r/s * s */
+    double overshoot;    /* worst axis, % of the first step */
+    double rise_s;       /* worst axis, 10 % -> 90 % */
+    double settle_s;     /* worst axis, into the 2 % band for good (inf: never) */
+    double sse;          /* worst axis, mean |error| over the last 20 % of the step, r/s */
+    double sat;          /* worst axis, fraction of time at full duty */
+    int ok;
+} sim_result_t;
+
+typedef struct {
+    plant_params_t plant;
+    double hz;
+    double hz2;
+    double duration;
+    double step_at;
+    double setpoint;
+    double setpoint2;
+    double substep_us;
+    double accel;
+    double jerk;
+    int autotune;        /* AUTOTUNE_MODE_*, -1: step scenario */
+    int ff_cal;          /* run the feed-forward sweep instead of the step scenario */
+    struct ff_table ff_table; /* installed on every axis when points > 0 */
+    const char *csv;
+    int jobs;
+    int top;
+    int verbose;
+    sweep_range_t kp;
+    sweep_range_t ki;
+    sweep_range_t kd;
+    sweep_range_t ff;
+} sim_options_t;
+
+/* per-axis step response bookkeeping */
+typedef struct {
+    double iae;
+    double peak;
+    double t10;
+    double t90;
+    double last_out;
+    int inside;
+    double sse_sum;
+    double sse_time;
+    double sat_time;
+} axis_metrics_t;
+
+static sim_options_t opt;
+
+/* ================= per-job state (one job per process) ================= */
+
+static plant_motor_t motors[MOTOR_AXIS_NUM];
+static axis_metrics_t metrics[MOTOR_AXIS_NUM];
+static double cur_setpoint;
+static int stage;
+static uint64_t step_ns, step2_ns, end_ns, substep_ns;
+static uint64_t log_period_ns, next_log_ns;
+static const gains_t *job_gains;
+static FILE *csv_file;
+static jmp_buf done_jmp;
+
+static uint64_t sec_to_ns(double s)
+{
+    return (uint64_t)llround(s * 1e9);
+}
+
+static void apply_setpoint(double sp)
+{
+    int dir = sp > 0.0 ? 1 : (sp < 0.0 ? 2 : 0);
+
+    cur_setpoint = sp;
+    chassis_set_target(dir, fabs(sp), dir, fabs(sp));
+}
+
+static enum plant_drive axis_drive(int axis)
+{
+    const struct motor_axis_desc *d = &motor_axis_table[axis];
+    int p0 = sim_pin_output(d->dir_pin0);
+    int p1 = sim_pin_output(d->dir_pin1);
+
+    if (p0 && !p1) {
+        return PLANT_DRIVE_FORWARD;
+    }
+    if (!p0 && p1) {
+        return PLANT_DRIVE_BACKWARD;
+    }
+    return p0 ? PLANT_DRIVE_BRAKE : PLANT_DRIVE_COAST;
+}
+
+/* Emit the encoder edges crossed during one step at their interpolated times. */
+static void axis_encoder_edges(int axis, double theta0, uint64_t t0, uint64_t dt)
+{
+    const struct motor_axis_desc *d = &motor_axis_table[axis];
+    plant_motor_t *m = &motors[axis];
+    int64_t target = plant_quad_index(&opt.plant, m->theta);
+    double per_quad = 2.0 * M_PI / (opt.plant.ppr * 4.0);
+    double boundary, frac;
+
+    while (m->quad != target) {
+        boundary = (m->quad < target ? m->quad + 1 : m->quad) * per_quad;
+        frac = (boundary - theta0) / (m->theta - theta0);
+        if (frac < 0.0) {
+            frac = 0.0;
+        } else if (frac > 1.0) {
+            frac = 1.0;
+        }
+        sim_clock_set(t0 + (uint64_t)(frac * (double)dt));
+        m->quad += m->quad < target ? 1 : -1;
+        sim_pin_input(d->enc_pin_a, plant_phase_a(m->quad));
+        sim_pin_input(d->enc_pin_b, plant_phase_b(m->quad));
+    }
+}
+
+static void axis_metrics_update(int axis, double t, double dt, double duty)
+{
+    axis_metrics_t *am = &metrics[axis];
+    double y = plant_wheel_rps(&motors[axis], &opt.plant);
+    double sp = opt.setpoint;
+    double t_step = opt.step_at;
+    double t_step2 = (double)step2_ns * 1e-9;
+    double along;
+
+    am->iae += fabs(cur_setpoint - y) * dt;
+    if (duty >= SIM_SAT_DUTY) {
+        am->sat_time += dt;
+    }
+    if (stage != 1 || sp == 0.0) {
+        return;
+    }
+
+    /* first step window: normalise to the step direction */
+    along = sp > 0.0 ? y : -y;
+    sp = fabs(sp);
+    if (along > am->peak) {
+        am->peak = along;
+    }
+    if (am->t10 < 0.0 && along >= 0.1 * sp) {
+        am->t10 = t;
+    }
+    if (am->t90 < 0.0 && along >= 0.9 * sp) {
+        am->t90 = t;
+    }
+    am->inside = fabs(along - sp) <= SIM_SETTLE_BAND * sp;
+    if (!am->inside) {
+        am->last_out = t;
+    }
+    if (t >= t_step + 0.8 * (t_step2 - t_step)) {
+        am->sse_sum += fabs(sp - along) * dt;
+        am->sse_time += dt;
+    }
+}
+
+static void log_sample(double t)
+{
+    int dir1, dir2, mrs1, mrs2;
+    int i;
+
+    chassis_get_status(&dir1, &mrs1, &dir2, &mrs2);
+    fprintf(csv_file, "%.6f,%.4f", t, cur_setpoint);
+    for (i = 0; i < MOTOR_AXIS_NUM; ++i) {
+        fprintf(csv_file, ",%.4f,%.4f", plant_wheel_rps(&motors[i], &opt.plant),
+                sim_pwm_duty(motor_axis_table[i].pwm_dev, motor_axis_table[i].pwm_channel));
+    }
+    fprintf(csv_file, ",%.3f,%.3f\n", (dir1 == 2 ? -mrs1 : mrs1) / 1000.0,
+            (dir2 == 2 ? -mrs2 : mrs2) / 1000.0);
+}
+
+/* rtt_sim advance hook: integrate the plants over [from, to). */
+static void plant_advance(uint64_t from, uint64_t to)
+{
+    uint64_t t = from;
+    uint64_t dt;
+    double theta0[MOTOR_AXIS_NUM];
+    double duty[MOTOR_AXIS_NUM];
+    enum plant_drive drive[MOTOR_AXIS_NUM];
+    int i;
+
+    /*
+     * The control thread snapshots the CFG generation when it starts, so
+     * the gains go in once it first blocks, like a CFG message would.
+     */
+    if (job_gains != NULL) {
+        chassis_set_cfg(opt.plant.ratio, job_gains->ff, job_gains->kp, job_gains->ki,
+                        job_gains->kd);
+        job_gains = NULL;
+    }
+
+    while (t < to) {
+        if (t >= end_ns) {
+            longjmp(done_jmp, 1);
+        }
+        if (stage == 0 && t >= step_ns) {
+            stage = 1;
+            apply_setpoint(opt.setpoint);
+        } else if (stage == 1 && t >= step2_ns) {
+            stage = 2;
+            apply_setpoint(opt.setpoint2);
+            if (opt.hz2 > 0.0) {
+                control_tick_set_hz((rt_uint32_t)opt.hz2);
+            }
+        }
+        if (csv_file != NULL && t >= next_log_ns) {
+            log_sample((double)t * 1e-9);
+            next_log_ns += log_period_ns;
+        }
+
+        dt = to - t < substep_ns ? to - t : substep_ns;
+
+        /* sample all bridges first: edges below call into the firmware ISR */
+        for (i = 0; i < MOTOR_AXIS_NUM; ++i) {
+            drive[i] = axis_drive(i);
+            duty[i] = sim_pwm_duty(motor_axis_table[i].pwm_dev,
+                                   motor_axis_table[i].pwm_channel);
+            theta0[i] = motors[i].theta;
+            plant_motor_step(&motors[i], &opt.plant, drive[i], duty[i], (double)dt * 1e-9);
+        }
+        for (i = 0; i < MOTOR_AXIS_NUM; ++i) {
+            axis_encoder_edges(i, theta0[i], t, dt);
+            axis_metrics_update(i, (double)t * 1e-9, (double)dt * 1e-9, duty[i]);
+        }
+        t += dt;
+        sim_clock_set(t);
+    }
+}
+
+static void finish_metrics(const gains_t *g, sim_result_t *res)
+{
+    double sp = fabs(opt.setpoint);
+    int i;
+
+    memset(res, 0, sizeof(*res));
+    res->g = *g;
+    res->ok = 1;
+    for (i = 0; i < MOTOR_AXIS_NUM; ++i) {
+        axis_metrics_t *am = &metrics[i];
+        double overshoot = sp > 0.0 ? (am->peak - sp) / sp * 100.0 : 0.0;
+        double rise = (am->t10 >= 0.0 && am->t90 >= 0.0) ? am->t90 - am->t10 : INFINITY;
+        double settle = !am->inside ? INFINITY
+                        : (am->last_out >= 0.0 ? am->last_out - opt.step_at : 0.0);
+        double sse = am->sse_time > 0.0 ? am->sse_sum / am->sse_time : 0.0;
+        double sat = am->sat_time / opt.duration;
+
+        res->iae += am->iae;
+        res->overshoot = fmax(res->overshoot, fmax(overshoot, 0.0));
+        res->rise_s = fmax(res->rise_s, rise);
+        res->settle_s = fmax(res->settle_s, settle);
+        res->sse = fmax(res->sse, sse);
+        res->sat = fmax(res->sat, sat);
+    }
+}
+
+static int run_job(const gains_t *g, sim_result_t *res)
+{
+    struct autotune_config tune;
+    rt_thread_t chassis;
+    int i;
+
+    sim_set_verbose(opt.verbose);
+    sim_set_advance_hook(plant_advance);
+
+    for (i = 0; i < MOTOR_AXIS_NUM; ++i) {
+        plant_motor_init(&motors[i]);
+        memset(&metrics[i], 0, sizeof(metrics[i]));
+        metrics[i].t10 = -1.0;
+        metrics[i].t90 = -1.0;
+        metrics[i].last_out = -1.0;
+    }
+    stage = 0;
+    cur_setpoint = 0.0;
+    substep_ns = sec_to_ns(opt.substep_us * 1e-6);
+    if (substep_ns == 0) {
+        substep_ns = 1;
+    }
+    step_ns = sec_to_ns(opt.step_at);
+    step2_ns = sec_to_ns(opt.duration / 2.0);
+    end_ns = sec_to_ns(opt.duration);
+
+    /* the firmware's own control_tick_init() call is then a no-op */
+    control_tick_init((rt_uint32_t)opt.hz);
+    chassis_firmware_main();
+    setpoint_set_limits((float)opt.accel, (float)opt.jerk);
+    /* targets only change at the step times; start each job fault-free */
+    health_set_cmd_timeout(0);
+    health_clear();
+    job_gains = g;
+    for (i = 0; i < MOTOR_AXIS_NUM && opt.ff_table.points > 0; ++i) {
+        if (ff_table_set(i, &opt.ff_table) != RT_EOK) {
+            fprintf(stderr, "sim: invalid feed-forward table\n");
+            return -1;
+        }
+    }
+    if (opt.ff_cal && ff_cal_begin(FF_CAL_DUTY_MAX_DEFAULT, FF_CAL_STEPS_DEFAULT) != RT_EOK) {
+        fprintf(stderr, "sim: ff_cal_begin failed\n");
+        return -1;
+    }
+    if (opt.autotune >= 0) {
+        autotune_config_default(&tune, opt.autotune);
+        if (autotune_begin(&tune) != RT_EOK) {
+            fprintf(stderr, "sim: autotune_begin failed\n");
+            return -1;
+        }
+    }
+
+    log_period_ns = sec_to_ns(1.0 / control_tick_get_hz());
+    next_log_ns = 0;
+    if (csv_file != NULL) {
+        fprintf(csv_file, "t,setpoint");
+        for (i = 0; i < MOTOR_AXIS_NUM; ++i) {
+            fprintf(csv_file, ",wheel%d_rps,duty%d", i, i);
+        }
+        fprintf(csv_file, ",meas_ch0_rps,meas_ch1_rps\n");
+    }
+
+    chassis = sim_thread_find("chassis");
+    if (chassis == RT_NULL || !chassis->started) {
+        fprintf(stderr, "sim: chassis control thread was not started\n");
+        return -1;
+    }
+    if (setjmp(done_jmp) == 0) {
+        chassis->entry(chassis->parameter);
+    }
+
+    finish_metrics(g, res);
+    return 0;
+}
+
+/* ================= autotune ================= */
+
+static void print_autotune(void)
+{
+    struct autotune_result r;
+    int i;
+
+    if (autotune_get_state() != AUTOTUNE_STATE_DONE) {
+        printf("autotune did not finish within %.1f s\n", opt.duration);
+        return;
+    }
+    printf("%-5s %9s %8s %7s %7s %8s %7s %8s %8s %8s %7s\n", "axis", "K_rps", "tau_ms",
+           "L_ms", "offset", "Ku", "Tu_ms", "kp", "ki", "kd", "ff");
+    for (i = 0; i < MOTOR_AXIS_NUM; ++i) {
+        if (autotune_get_result(i, &r) != RT_EOK) {
+            printf("%-5d failed (error %d)\n", i, r.error);
+            continue;
+        }
+        printf("%-5d %9.3f %8.1f %7.1f %7.3f %8.3f %7.1f %8.4f %8.4f %8.4f %7.4f\n", i,
+               r.gain, r.tau * 1e3, r.dead_time * 1e3, r.offset, r.ku, r.tu * 1e3, r.kp,
+               r.ki, r.kd, r.ff);
+    }
+}
+
+static void print_ff_cal(void)
+{
+    struct ff_table t;
+    char line[160];
+    int i;
+
+    for (i = 0; i < MOTOR_AXIS_NUM; ++i) {
+        if (ff_cal_build(i, &t) != RT_EOK || ff_table_set(i, &t) != RT_EOK) {
+            printf("axis %d: calibration failed\n", i);
+            continue;
+        }
+        ff_table_format(i, line, sizeof(line));
+        printf("%s\n", line);
+    }
+}
+
+/* ================= sweep ================= */
+
+static double range_value(const sweep_range_t *r, int k)
+{
+    return r->n <= 1 ? r->lo : r->lo + (r->hi - r->lo) * k / (r->n - 1);
+}
+
+static int range_parse(const char *s, sweep_range_t *r)
+{
+    char *end;
+
+    r->lo = strtod(s, &end);
+    r->hi = r->lo;
+    r->n = 1;
+    if (end == s) {
+        return -1;
+    }
+    if (*end == '\0') {
+        return 0;
+    }
+    if (sscanf(end, ":%lf:%d", &r->hi, &r->n) != 2 || r->n < 1) {
+        return -1;
+    }
+    return 0;
+}
+
+static int compare_result(const void *a, const void *b)
+{
+    const sim_result_t *x = (const sim_result_t *)a;
+    const sim_result_t *y = (const sim_result_t *)b;
+
+    if (x->ok != y->ok) {
+        return y->ok - x->ok;
+    }
+    return (x->iae > y->iae) - (x->iae < y->iae);
+}
+
+static void print_header(void)
+{
+    printf("%8s %8s %8s %8s %9s %9s %9s %9s %9s %6s\n", "kp", "ki", "kd", "ff",
+           "IAE", "overshoot", "rise_ms", "settle_ms", "sse_mrs", "sat%");
+}
+
+static void print_result(const sim_result_t *r)
+{
+    if (!r->ok) {
+        printf("%8.4f %8.4f %8.4f %8.4f   (failed)\n", r->g.kp, r->g.ki, r->g.kd, r->g.ff);
+        return;
+    }
+    printf("%8.4f %8.4f %8.4f %8.4f %9.4f %8.1f%% %9.1f %9.1f %9.1f %6.1f\n",
+           r->g.kp, r->g.ki, r->g.kd, r->g.ff, r->iae, r->overshoot,
+           r->rise_s * 1000.0, r->settle_s * 1000.0, r->sse * 1000.0, r->sat * 100.0);
+}
+
+/* Run every gain set in a forked child, at most opt.jobs at a time. */
+static int run_sweep(const gains_t *sets, int count, sim_result_t *results)
+{
+    pid_t *pids = calloc((size_t)count, sizeof(*pids));
+    int *fds = calloc((size_t)count, sizeof(*fds));
+    int next = 0, running = 0, done = 0;
+    int i, status, fd[2];
+    pid_t pid;
+
+    if (pids == NULL || fds == NULL) {
+        free(pids);
+        free(fds);
+        return -1;
+    }
+
+    while (done < count) {
+        while (running < opt.jobs && next < count) {
+            if (pipe(fd) != 0) {
+                perror("pipe");
+                exit(1);
+            }
+            fflush(stdout);
+            pid = fork();
+            if (pid < 0) {
+                perror("fork");
+                exit(1);
+            }
+            if (pid == 0) {
+                sim_result_t res;
+
+                close(fd[0]);
+                memset(&res, 0, sizeof(res));
+                res.g = sets[next];
+                if (run_job(&sets[next], &res) != 0) {
+                    res.ok = 0;
+                }
+                if (write(fd[1], &res, sizeof(res)) != (ssize_t)sizeof(res)) {
+                    _exit(1);
+                }
+                _exit(0);
+            }
+            close(fd[1]);
+            pids[next] = pid;
+            fds[next] = fd[0];
+            next++;
+            running++;
+        }
+
+        pid = wait(&status);
+        if (pid < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("wait");
+            break;
+        }
+        for (i = 0; i < next; ++i) {
+            if (pids[i] == pid) {
+                results[i].g = sets[i];
+                results[i].ok = 0;
+                if (read(fds[i], &results[i], sizeof(results[i])) != (ssize_t)sizeof(results[i])) {
+                    results[i].g = sets[i];
+                    results[i].ok = 0;
+                }
+                close(fds[i]);
+                pids[i] = 0;
+                running--;
+                done++;
+                break;
+            }
+        }
+    }
+
+    free(pids);
+    free(fds);
+    return 0;
+}
+
+/* ================= command line ================= */
+
+static void print_usage(const char *prog)
+{
+    printf("Usage: %s [options]\n", prog);
+    printf("\nScenario:\n");
+    printf("  --hz <n>            Control rate. Default: %d\n", SIM_DEFAULT_HZ);
+    printf("  --duration <s>      Simulated time per run. Default: %.1f\n", SIM_DEFAULT_DURATION);
+    printf("  --step-at <s>       Time of the first step. Default: %.2f\n", SIM_DEFAULT_STEP_AT);
+    printf("  --setpoint <r/s>    First step target. Default: %.1f\n", SIM_DEFAULT_SETPOINT);
+    printf("  --setpoint2 <r/s>   Target from duration/2 on. Default: setpoint/2\n");
+    printf("  --hz2 <n>           Control rate from duration/2 on. Default: --hz\n");
+    printf("  --substep <us>      Plant integration step. Default: %.0f\n", SIM_DEFAULT_SUBSTEP);
+    printf("  --accel <r/s^2>     Setpoint acceleration limit. Default: 0 (off)\n");
+    printf("  --jerk <r/s^3>      Setpoint jerk limit. Default: 0 (off)\n");
+    printf("  --autotune <mode>   Run the firmware autotune (step|relay) instead.\n");
+    printf("  --ff-cal            Run the feed-forward calibration sweep instead.\n");
+    printf("  --ff-table <FF,..>  Install this feed-forward table on every axis.\n");
+    printf("\nGains (value or lo:hi:n range, ranges are swept):\n");
+    printf("  --kp --ki --kd --ff Defaults: 0.05 0.2 0.01 0.3\n");
+    printf("\nPlant:\n");
+    printf("  --vbus --r --l --ke --j --b --tc --load   see plant.h for units\n");
+    printf("\nOutput:\n");
+    printf("  -j, --jobs <n>      Parallel runs for a sweep. Default: online CPUs\n");
+    printf("  --top <n>           Print the n best sweep results. Default: %d\n", SIM_DEFAULT_TOP);
+    printf("  --csv <file>        Per-tick trace of a single run.\n");
+    printf("  -v, --verbose       Show firmware rt_kprintf output.\n");
+    printf("  -h, --help          Show this help.\n");
+}
+
+enum {
+    OPT_HZ = 256, OPT_DURATION, OPT_STEP_AT, OPT_SETPOINT, OPT_SETPOINT2,
+    OPT_SUBSTEP, OPT_KP, OPT_KI, OPT_KD, OPT_FF, OPT_VBUS, OPT_R, OPT_L,
+    OPT_KE, OPT_J, OPT_B, OPT_TC, OPT_LOAD, OPT_TOP, OPT_CSV, OPT_ACCEL, OPT_JERK,
+    OPT_AUTOTUNE, OPT_FF_CAL, OPT_FF_TABLE, OPT_HZ2,
+};
+
+static int parse_args(int argc, char **argv)
+{
+    static const struct option long_opts[] = {
+        {"hz", required_argument, NULL, OPT_HZ},
+        {"hz2", required_argument, NULL, OPT_HZ2},
+        {"duration", required_argument, NULL, OPT_DURATION},
+        {"step-at", required_argument, NULL, OPT_STEP_AT},
+        {"setpoint", required_argument, NULL, OPT_SETPOINT},
+        {"setpoint2", required_argument, NULL, OPT_SETPOINT2},
+        {"substep", required_argument, NULL, OPT_SUBSTEP},
+        {"accel", required_argument, NULL, OPT_ACCEL},
+        {"jerk", required_argument, NULL, OPT_JERK},
+        {"autotune", required_argument, NULL, OPT_AUTOTUNE},
+        {"ff-cal", no_argument, NULL, OPT_FF_CAL},
+        {"ff-table", required_argument, NULL, OPT_FF_TABLE},
+        {"kp", required_argument, NULL, OPT_KP},
+        {"ki", required_argument, NULL, OPT_KI},
+        {"kd", required_argument, NULL, OPT_KD},
+        {"ff", required_argument, NULL, OPT_FF},
+        {"vbus", required_argument, NULL, OPT_VBUS},
+        {"r", required_argument, NULL, OPT_R},
+        {"l", required_argument, NULL, OPT_L},
+        {"ke", required_argument, NULL, OPT_KE},
+        {"j", required_argument, NULL, OPT_J},
+        {"b", required_argument, NULL, OPT_B},
+        {"tc", required_argument, NULL, OPT_TC},
+        {"load", required_argument, NULL, OPT_LOAD},
+        {"jobs", required_argument, NULL, 'j'},
+        {"top", required_argument, NULL, OPT_TOP},
+        {"csv", required_argument, NULL, OPT_CSV},
+        {"verbose", no_argument, NULL, 'v'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    int setpoint2_set = 0;
+    int ff_axis;
+    sweep_range_t *range;
+    int c;
+
+    plant_params_default(&opt.plant);
+    opt.hz = SIM_DEFAULT_HZ;
+    opt.duration = SIM_DEFAULT_DURATION;
+    opt.step_at = SIM_DEFAULT_STEP_AT;
+    opt.setpoint = SIM_DEFAULT_SETPOINT;
+    opt.substep_us = SIM_DEFAULT_SUBSTEP;
+    opt.autotune = -1;
+    opt.jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    opt.top = SIM_DEFAULT_TOP;
+    opt.kp = (sweep_range_t){0.05, 0.05, 1};
+    opt.ki = (sweep_range_t){0.2, 0.2, 1};
+    opt.kd = (sweep_range_t){0.01, 0.01, 1};
+    opt.ff = (sweep_range_t){0.3, 0.3, 1};
+
+    while ((c = getopt_long(argc, argv, "j:vh", long_opts, NULL)) != -1) {
+        range = NULL;
+        switch (c) {
+        case OPT_HZ: opt.hz = atof(optarg); break;
+        case OPT_HZ2: opt.hz2 = atof(optarg); break;
+        case OPT_DURATION: opt.duration = atof(optarg); break;
+        case OPT_STEP_AT: opt.step_at = atof(optarg); break;
+        case OPT_SETPOINT: opt.setpoint = atof(optarg); break;
+        case OPT_SETPOINT2: opt.setpoint2 = atof(optarg); setpoint2_set = 1; break;
+        case OPT_SUBSTEP: opt.substep_us = atof(optarg); break;
+        case OPT_ACCEL: opt.accel = atof(optarg); break;
+        case OPT_JERK: opt.jerk = atof(optarg); break;
+        case OPT_AUTOTUNE:
+            if (strcmp(optarg, "step") == 0) {
+                opt.autotune = AUTOTUNE_MODE_STEP;
+            } else if (strcmp(optarg, "relay") == 0) {
+                opt.autotune = AUTOTUNE_MODE_RELAY;
+            } else {
+                fprintf(stderr, "invalid autotune mode '%s', expected step or relay\n", optarg);
+                return -1;
+            }
+            break;
+        case OPT_FF_CAL: opt.ff_cal = 1; break;
+        case OPT_FF_TABLE:
+            if (ff_table_parse(optarg, &ff_axis, &opt.ff_table) != RT_EOK ||
+                opt.ff_table.points < 2) {
+                fprintf(stderr, "invalid feed-forward table '%s', expected FF,<axis>,<step_mrs>,<d0>,...\n",
+                        optarg);
+                return -1;
+            }
+            break;
+        case OPT_KP: range = &opt.kp; break;
+        case OPT_KI: range = &opt.ki; break;
+        case OPT_KD: range = &opt.kd; break;
+        case OPT_FF: range = &opt.ff; break;
+        case OPT_VBUS: opt.plant.vbus = atof(optarg); break;
+        case OPT_R: opt.plant.r = atof(optarg); break;
+        case OPT_L: opt.plant.l = atof(optarg); break;
+        case OPT_KE: opt.plant.ke = atof(optarg); break;
+        case OPT_J: opt.plant.j = atof(optarg); break;
+        case OPT_B: opt.plant.b = atof(optarg); break;
+        case OPT_TC: opt.plant.tc = atof(optarg); break;
+        case OPT_LOAD: opt.plant.load = atof(optarg); break;
+        case 'j': opt.jobs = atoi(optarg); break;
+        case OPT_TOP: opt.top = atoi(optarg); break;
+        case OPT_CSV: opt.csv = optarg; break;
+        case 'v': opt.verbose = 1; break;
+        case 'h': print_usage(argv[0]); return 1;
+        default: print_usage(argv[0]); return -1;
+        }
+        if (range != NULL && range_parse(optarg, range) != 0) {
+            fprintf(stderr, "invalid gain '%s', expected value or lo:hi:n\n", optarg);
+            return -1;
+        }
+    }
+
+    if (!setpoint2_set) {
+        opt.setpoint2 = opt.setpoint / 2.0;
+    }
+    if (opt.jobs < 1) {
+        opt.jobs = 1;
+    }
+    if (opt.duration <= opt.step_at * 2.0 || opt.hz <= 0.0 || opt.substep_us <= 0.0) {
+        fprintf(stderr, "invalid scenario: need duration > 2 * step-at, hz > 0, substep > 0\n");
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    struct timespec t0, t1;
+    gains_t *sets;
+    sim_result_t *results;
+    int count, idx, a, b, c, d, ret;
+    double wall;
+
+    ret = parse_args(argc, argv);
+    if (ret != 0) {
+        return ret > 0 ? 0 : 1;
+    }
+
+    count = opt.kp.n * opt.ki.n * opt.kd.n * opt.ff.n;
+    sets = calloc((size_t)count, sizeof(*sets));
+    results = calloc((size_t)count, sizeof(*results));
+    if (sets == NULL || results == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    idx = 0;
+    for (a = 0; a < opt.kp.n; ++a) {
+        for (b = 0; b < opt.ki.n; ++b) {
+            for (c = 0; c < opt.kd.n; ++c) {
+                for (d = 0; d < opt.ff.n; ++d) {
+                    sets[idx].kp = range_value(&opt.kp, a);
+                    sets[idx].ki = range_value(&opt.ki, b);
+                    sets[idx].kd = range_value(&opt.kd, c);
+                    sets[idx].ff = range_value(&opt.ff, d);
+                    idx++;
+                }
+            }
+        }
+    }
+
+    if (opt.csv != NULL && count != 1) {
+        fprintf(stderr, "--csv needs a single gain set\n");
+        return 1;
+    }
+    if (opt.ff_cal) {
+        if (count != 1 || opt.autotune >= 0) {
+            fprintf(stderr, "--ff-cal needs a single gain set and no --autotune\n");
+            return 1;
+        }
+        opt.duration = fmax(opt.duration, FF_CAL_STEPS_DEFAULT * FF_CAL_HOLD_MS / 1000.0 + 0.5);
+    }
+    if (opt.autotune >= 0) {
+        if (count != 1) {
+            fprintf(stderr, "--autotune needs a single gain set\n");
+            return 1;
+        }
+        /* long enough for both holds and the relay timeout */
+        opt.duration = fmax(opt.duration, (2.0 * AUTOTUNE_HOLD_MS +
+                                           AUTOTUNE_RELAY_TIMEOUT_MS) / 1000.0 + 0.5);
+    }
+
+    printf("Simulating %d axes at %.0f Hz, step 0 -> %.2f -> %.2f r/s, %.1f s per run, %d run(s)\n",
+           MOTOR_AXIS_NUM, opt.hz, opt.setpoint, opt.setpoint2, opt.duration, count);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (count == 1) {
+        if (opt.csv != NULL) {
+            csv_file = fopen(opt.csv, "w");
+            if (csv_file == NULL) {
+                fprintf(stderr, "open %s: %s\n", opt.csv, strerror(errno));
+                return 1;
+            }
+        }
+        ret = run_job(&sets[0], &results[0]);
+        if (csv_file != NULL) {
+            fclose(csv_file);
+        }
+        if (ret != 0) {
+            return 1;
+        }
+        if (opt.ff_cal) {
+            print_ff_cal();
+            free(sets);
+            free(results);
+            return 0;
+        }
+        if (opt.autotune >= 0) {
+            print_autotune();
+            free(sets);
+            free(results);
+            return 0;
+        }
+    } else if (run_sweep(sets, count, results) != 0) {
+        fprintf(stderr, "sweep failed\n");
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    wall = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) * 1e-9;
+
+    qsort(results, (size_t)count, sizeof(*results), compare_result);
+    print_header();
+    for (idx = 0; idx < count && idx < opt.top; ++idx) {
+        print_result(&results[idx]);
+    }
+    printf("%.1f simulated s in %.3f s wall (%.0fx real time)\n", opt.duration * count,
+           wall, wall > 0.0 ? opt.duration * count / wall : 0.0);
+
+    free(sets);
+    free(results);
+    return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * Brushed DC gear motor and incremental encoder model.
+ */
+
+#include <math.h>
+
+#include "common.h"
+#include "plant.h"
+
+/*
+ * Defaults roughly match a 12 V, 1:56 gear motor: ~3.6 r/s no-load at the
+ * wheel, ~90 ms mechanical time constant, consistent with the firmware's
+ * default feed-forward of 0.3 duty per r/s.
+ */
+void plant_params_default(plant_params_t *p)
+{
+    p->vbus = 12.0;
+    p->r = 4.0;
+    p->l = 1.5e-3;
+    p->ke = 0.0095;
+    p->j = 2.0e-6;
+    p->b = 2.0e-7;
+    p->tc = 1.0e-4;
+    p->load = 0.0;
+    p->ratio = MOTOR_REDUCTION_RATIO;
+    p->ppr = MOTOR_ENCODER_PPR;
+}
+
+void plant_motor_init(plant_motor_t *m)
+{
+    m->i = 0.0;
+    m->w = 0.0;
+    m->theta = 0.0;
+    m->quad = 0;
+}
+
+void plant_motor_step(plant_motor_t *m, const plant_params_t *p,
+                      enum plant_drive drive, double duty, double dt)
+{
+    double v = 0.0;
+    double i_ss, torque, friction, w_old;
+
+    if (duty < 0.0) {
+        duty = 0.0;
+    } else if (duty > 1.0) {
+        duty = 1.0;
+    }
+
+    switch (drive) {
+    case PLANT_DRIVE_FORWARD:
+        v = duty * p->vbus;
+        break;
+    case PLANT_DRIVE_BACKWARD:
+        v = -duty * p->vbus;
+        break;
+    default:
+        v = 0.0;
+        break;
+    }
+
+    if (drive == PLANT_DRIVE_COAST) {
+        m->i = 0.0;
+    } else {
+        /* exact solution of the RL circuit with w held over the step */
+        i_ss = (v - p->ke * m->w) / p->r;
+        m->i = i_ss + (m->i - i_ss) * exp(-p->r * dt / p->l);
+    }
+
+    torque = p->ke * m->i - p->b * m->w - p->load;
+    w_old = m->w;
+    if (w_old == 0.0 && fabs(torque) <= p->tc) {
+        /* static friction holds the shaft */
+        return;
+    }
+    if (w_old > 0.0 || (w_old == 0.0 && torque > 0.0)) {
+        friction = p->tc;
+    } else {
+        friction = -p->tc;
+    }
+    m->w += (torque - friction) / p->j * dt;
+    if ((w_old > 0.0 && m->w < 0.0) || (w_old < 0.0 && m->w > 0.0)) {
+        /* friction stops the shaft, it does not reverse it */
+        m->w = 0.0;
+    }
+    m->theta += m->w * dt;
+}
+
+double plant_wheel_rps(const plant_motor_t *m, const plant_params_t *p)
+{
+    return m->w / (2.0 * M_PI) / p->ratio;
+}
+
+int64_t plant_quad_index(const plant_params_t *p, double theta)
+{
+    return (int64_t)floor(theta / (2.0 * M_PI) * p->ppr * 4.0);
+}
+
+/* forward sequence (A, B): 00 -> 10 -> 11 -> 01, A leads B */
+int plant_phase_a(int64_t quad)
+{
+    int phase = (int)(((quad % 4) + 4) % 4);
+    return phase == 1 || phase == 2;
+}
+
+int plant_phase_b(int64_t quad)
+{
+    int phase = (int)(((quad % 4) + 4) % 4);
+    return phase == 2 || phase == 3;
+}
@@ -0,0 +1,58 @@
+/*
+ * Brushed DC gear motor and incremental encoder model.
+ *
+ * Electrical: L di/dt = V - R i - Ke w   (solved exactly per step)
+ * Mechanical: J dw/dt = Kt i - b w - Tc sign(w) - T_load
+ * w is the motor shaft speed; the encoder sits on the motor shaft, the
+ * wheel turns 1/ratio as fast. V is the averaged H-bridge output
+ * (duty * Vbus), which holds while the winding current is continuous.
+ */
+
+#ifndef SIM_PLANT_H
+#define SIM_PLANT_H
+
+#include <stdint.h>
+
+enum plant_drive {
+    PLANT_DRIVE_COAST = 0, /* bridge off, current decays to 0 */
+    PLANT_DRIVE_FORWARD,
+    PLANT_DRIVE_BACKWARD,
+    PLANT_DRIVE_BRAKE,     /* winding shorted */
+};
+
+typedef struct {
+    double vbus;    /* V */
+    double r;       /* winding resistance, ohm */
+    double l;       /* winding inductance, H */
+    double ke;      /* back-EMF constant, V*s/rad (Kt = Ke in SI units) */
+    double j;       /* inertia at the motor shaft incl. reflected load, kg*m^2 */
+    double b;       /* viscous friction, N*m*s/rad */
+    double tc;      /* Coulomb friction, N*m */
+    double load;    /* external load torque at the motor shaft, N*m */
+    double ratio;   /* gearbox reduction */
+    double ppr;     /* encoder pulses per motor revolution */
+} plant_params_t;
+
+typedef struct {
+    double i;       /* A */
+    double w;       /* rad/s at the motor shaft */
+    double theta;   /* rad at the motor shaft */
+    int64_t quad;   /* encoder quadrature state index (4 per pulse) */
+} plant_motor_t;
+
+void plant_params_default(plant_params_t *p);
+void plant_motor_init(plant_motor_t *m);
+
+/* Advance one step with the given bridge state and duty (0..1). */
+void plant_motor_step(plant_motor_t *m, const plant_params_t *p,
+                      enum plant_drive drive, double duty, double dt);
+
+/* Wheel speed in r/s, sign = direction. */
+double plant_wheel_rps(const plant_motor_t *m, const plant_params_t *p);
+
+/* Quadrature index for a shaft angle; A/B levels for an index. */
+int64_t plant_quad_index(const plant_params_t *p, double theta);
+int plant_phase_a(int64_t quad);
+int plant_phase_b(int64_t quad);
+
+#endif /* SIM_PLANT_H */
@@ -0,0 +1,22 @@
+/*
+ * Host simulation stand-ins for src/profiler.c. Scheduler hooks, thread
+ * lists and stack fill patterns do not exist in the simulator, and host
+ * timings say nothing about the RCPU.
+ */
+
+#include <rtthread.h>
+
+#include "profiler.h"
+
+rt_err_t profiler_init(void)
+{
+    return RT_EOK;
+}
+
+void profiler_loop_begin(void)
+{
+}
+
+void profiler_loop_end(void)
+{
+}
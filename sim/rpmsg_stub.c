@@ -0,0 +1,48 @@
+/*
+ * Host simulation stand-ins for src/rpmsg_motor.c (OpenAMP is not available
+ * on the host). The simulator sets targets and gains directly.
+ */
+
+#include <rtthread.h>
+
+#include "rpmsg_motor.h"
+
+rt_err_t rpmsg_motor_init(void)
+{
+    return RT_EOK;
+}
+
+void rpmsg_motor_notify_sample(void)
+{
+}
+
+rt_err_t parse_speed_command(const char *cmd, int *dir1, double *speed1,
+                             int *dir2, double *speed2)
+{
+    (void)cmd;
+    (void)dir1;
+    (void)speed1;
+    (void)dir2;
+    (void)speed2;
+    return -RT_ENOSYS;
+}
+
+rt_err_t parse_cfg_command(const char *cmd, double *ratio, double *ff,
+                           double *kp, double *ki, double *kd,
+                           int *feedback_enable)
+{
+    (void)cmd;
+    (void)ratio;
+    (void)ff;
+    (void)kp;
+    (void)ki;
+    (void)kd;
+    (void)feedback_enable;
+    return -RT_ENOSYS;
+}
+
+rt_err_t rpmsg_motor_send_event(const char *text)
+{
+    (void)text;
+    return -RT_ENOSYS;
+}
@@ -0,0 +1,471 @@
+/*
+ * Host simulation of the RT-Thread services used by the control stack.
+ * See rtt_sim.h for the execution model.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rtt_sim.h"
+
+#define SIM_MAX_THREADS 16
+#define SIM_MAX_TIMERS  8
+#define SIM_MAX_PINS    512
+#define SIM_MAX_PWM     8
+
+struct sim_pin {
+    int level;
+    rt_uint8_t irq_mode;
+    rt_bool_t irq_enabled;
+    void (*hdr)(void *args);
+    void *args;
+};
+
+static uint64_t now_ns;
+static sim_advance_fn advance_hook;
+static int verbose;
+
+static struct rt_thread threads[SIM_MAX_THREADS];
+static int thread_num;
+static struct rt_timer timers[SIM_MAX_TIMERS];
+static int timer_num;
+static struct sim_pin pins[SIM_MAX_PINS];
+static struct rt_device_pwm pwm_devs[SIM_MAX_PWM];
+static int pwm_num;
+
+static void copy_name(char *dst, size_t size, const char *src)
+{
+    snprintf(dst, size, "%s", src != NULL ? src : "");
+}
+
+/* ================= simulator control ================= */
+
+void sim_set_advance_hook(sim_advance_fn fn)
+{
+    advance_hook = fn;
+}
+
+void sim_set_verbose(int v)
+{
+    verbose = v;
+}
+
+uint64_t sim_now_ns(void)
+{
+    return now_ns;
+}
+
+void sim_clock_set(uint64_t ns)
+{
+    if (ns > now_ns) {
+        now_ns = ns;
+    }
+}
+
+static struct rt_timer *next_timer(uint64_t limit_ns)
+{
+    struct rt_timer *best = NULL;
+    int i;
+
+    for (i = 0; i < timer_num; ++i) {
+        if (timers[i].active && timers[i].next_ns <= limit_ns &&
+            (best == NULL || timers[i].next_ns < best->next_ns)) {
+            best = &timers[i];
+        }
+    }
+    return best;
+}
+
+static void advance_plant(uint64_t to_ns)
+{
+    uint64_t from = now_ns;
+
+    if (to_ns <= from) {
+        return;
+    }
+    if (advance_hook != NULL) {
+        advance_hook(from, to_ns);
+    }
+    now_ns = to_ns;
+}
+
+void sim_advance_until(uint64_t ns)
+{
+    struct rt_timer *t;
+
+    uint64_t fired;
+
+    while ((t = next_timer(ns)) != NULL) {
+        fired = t->next_ns;
+        advance_plant(fired);
+        if (!(t->flag & RT_TIMER_FLAG_PERIODIC)) {
+            t->active = RT_FALSE;
+        }
+        t->timeout(t->parameter);
+        /* like RT-Thread, restart after the callback unless it was stopped or restarted */
+        if ((t->flag & RT_TIMER_FLAG_PERIODIC) && t->active && t->next_ns == fired) {
+            t->next_ns = fired + (uint64_t)t->period * (1000000000ULL / RT_TICK_PER_SECOND);
+        }
+    }
+    advance_plant(ns);
+}
+
+/* ================= kernel services ================= */
+
+int rt_kprintf(const char *fmt, ...)
+{
+    va_list ap;
+    int ret;
+
+    if (!verbose) {
+        return 0;
+    }
+    va_start(ap, fmt);
+    ret = vprintf(fmt, ap);
+    va_end(ap);
+    return ret;
+}
+
+int rt_snprintf(char *buf, rt_size_t size, const char *fmt, ...)
+{
+    va_list ap;
+    int ret;
+
+    va_start(ap, fmt);
+    ret = vsnprintf(buf, size, fmt, ap);
+    va_end(ap);
+    return ret;
+}
+
+void *rt_memset(void *s, int c, rt_ubase_t count)
+{
+    return memset(s, c, count);
+}
+
+void *rt_memcpy(void *dst, const void *src, rt_ubase_t count)
+{
+    return memcpy(dst, src, count);
+}
+
+rt_int32_t rt_strcmp(const char *a, const char *b)
+{
+    return strcmp(a, b);
+}
+
+rt_int32_t rt_strncmp(const char *a, const char *b, rt_ubase_t count)
+{
+    return strncmp(a, b, count);
+}
+
+rt_thread_t rt_thread_create(const char *name, void (*entry)(void *parameter),
+                             void *parameter, rt_uint32_t stack_size,
+                             rt_uint8_t priority, rt_uint32_t tick)
+{
+    rt_thread_t t;
+
+    (void)stack_size;
+    (void)tick;
+    if (thread_num >= SIM_MAX_THREADS) {
+        return RT_NULL;
+    }
+    t = &threads[thread_num++];
+    copy_name(t->name, sizeof(t->name), name);
+    t->entry = entry;
+    t->parameter = parameter;
+    t->priority = priority;
+    return t;
+}
+
+rt_err_t rt_thread_startup(rt_thread_t thread)
+{
+    /* threads only run when the simulator calls their entry */
+    thread->started = RT_TRUE;
+    return RT_EOK;
+}
+
+rt_thread_t sim_thread_find(const char *name)
+{
+    int i;
+
+    for (i = 0; i < thread_num; ++i) {
+        if (strncmp(threads[i].name, name, RT_NAME_MAX - 1) == 0) {
+            return &threads[i];
+        }
+    }
+    return RT_NULL;
+}
+
+rt_err_t rt_thread_mdelay(rt_int32_t ms)
+{
+    sim_advance_until(now_ns + (uint64_t)ms * 1000000ULL);
+    return RT_EOK;
+}
+
+rt_err_t rt_thread_delay(rt_tick_t tick)
+{
+    sim_advance_until(now_ns + (uint64_t)tick * (1000000000ULL / RT_TICK_PER_SECOND));
+    return RT_EOK;
+}
+
+rt_tick_t rt_tick_get(void)
+{
+    return (rt_tick_t)(now_ns / (1000000000ULL / RT_TICK_PER_SECOND));
+}
+
+rt_tick_t rt_tick_from_millisecond(rt_int32_t ms)
+{
+    return (rt_tick_t)ms * RT_TICK_PER_SECOND / 1000;
+}
+
+rt_base_t rt_hw_interrupt_disable(void)
+{
+    return 0;
+}
+
+void rt_hw_interrupt_enable(rt_base_t level)
+{
+    (void)level;
+}
+
+void rt_enter_critical(void)
+{
+}
+
+void rt_exit_critical(void)
+{
+}
+
+rt_sem_t rt_sem_create(const char *name, rt_uint32_t value, rt_uint8_t flag)
+{
+    rt_sem_t sem = calloc(1, sizeof(*sem));
+
+    (void)flag;
+    if (sem != RT_NULL) {
+        copy_name(sem->name, sizeof(sem->name), name);
+        sem->value = value;
+    }
+    return sem;
+}
+
+/*
+ * The only blocking point of the simulated thread: advance time to the next
+ * timer expiry until the semaphore is released (or the timeout passes).
+ */
+rt_err_t rt_sem_take(rt_sem_t sem, rt_int32_t time)
+{
+    uint64_t deadline = UINT64_MAX;
+    struct rt_timer *t;
+
+    if (time >= 0) {
+        deadline = now_ns + (uint64_t)time * (1000000000ULL / RT_TICK_PER_SECOND);
+    }
+
+    while (sem->value == 0) {
+        t = next_timer(deadline);
+        if (t == NULL) {
+            if (deadline == UINT64_MAX) {
+                fprintf(stderr, "sim: deadlock waiting on semaphore '%s'\n", sem->name);
+                abort();
+            }
+            sim_advance_until(deadline);
+            return -RT_ETIMEOUT;
+        }
+        sim_advance_until(t->next_ns);
+    }
+    sem->value--;
+    return RT_EOK;
+}
+
+rt_err_t rt_sem_release(rt_sem_t sem)
+{
+    sem->value++;
+    return RT_EOK;
+}
+
+rt_timer_t rt_timer_create(const char *name, void (*timeout)(void *parameter),
+                           void *parameter, rt_tick_t time, rt_uint8_t flag)
+{
+    rt_timer_t t;
+
+    if (timer_num >= SIM_MAX_TIMERS) {
+        return RT_NULL;
+    }
+    t = &timers[timer_num++];
+    copy_name(t->name, sizeof(t->name), name);
+    t->timeout = timeout;
+    t->parameter = parameter;
+    t->period = time > 0 ? time : 1;
+    t->flag = flag;
+    return t;
+}
+
+rt_err_t rt_timer_start(rt_timer_t timer)
+{
+    timer->next_ns = now_ns + (uint64_t)timer->period * (1000000000ULL / RT_TICK_PER_SECOND);
+    timer->active = RT_TRUE;
+    return RT_EOK;
+}
+
+rt_err_t rt_timer_stop(rt_timer_t timer)
+{
+    timer->active = RT_FALSE;
+    return RT_EOK;
+}
+
+rt_err_t rt_timer_control(rt_timer_t timer, int cmd, void *arg)
+{
+    if (cmd == RT_TIMER_CTRL_SET_TIME) {
+        /* like RT-Thread 5.x: an active timer is removed and stays stopped */
+        timer->active = RT_FALSE;
+        timer->period = *(rt_tick_t *)arg > 0 ? *(rt_tick_t *)arg : 1;
+    }
+    return RT_EOK;
+}
+
+/* ================= pins ================= */
+
+void rt_pin_mode(rt_base_t pin, rt_uint8_t mode)
+{
+    (void)pin;
+    (void)mode;
+}
+
+void rt_pin_write(rt_base_t pin, rt_uint8_t value)
+{
+    if (pin >= 0 && pin < SIM_MAX_PINS) {
+        pins[pin].level = value ? PIN_HIGH : PIN_LOW;
+    }
+}
+
+rt_int8_t rt_pin_read(rt_base_t pin)
+{
+    if (pin < 0 || pin >= SIM_MAX_PINS) {
+        return PIN_LOW;
+    }
+    return (rt_int8_t)pins[pin].level;
+}
+
+rt_err_t rt_pin_attach_irq(rt_base_t pin, rt_uint8_t mode,
+                           void (*hdr)(void *args), void *args)
+{
+    if (pin < 0 || pin >= SIM_MAX_PINS) {
+        return -RT_EINVAL;
+    }
+    pins[pin].irq_mode = mode;
+    pins[pin].hdr = hdr;
+    pins[pin].args = args;
+    return RT_EOK;
+}
+
+rt_err_t rt_pin_irq_enable(rt_base_t pin, rt_uint8_t enabled)
+{
+    if (pin < 0 || pin >= SIM_MAX_PINS) {
+        return -RT_EINVAL;
+    }
+    pins[pin].irq_enabled = enabled == PIN_IRQ_ENABLE;
+    return RT_EOK;
+}
+
+void sim_pin_input(rt_base_t pin, int level)
+{
+    struct sim_pin *p;
+    int fire;
+
+    if (pin < 0 || pin >= SIM_MAX_PINS) {
+        return;
+    }
+    p = &pins[pin];
+    level = level ? PIN_HIGH : PIN_LOW;
+    if (p->level == level) {
+        return;
+    }
+    p->level = level;
+    if (!p->irq_enabled || p->hdr == NULL) {
+        return;
+    }
+
+    switch (p->irq_mode) {
+    case PIN_IRQ_MODE_RISING:
+        fire = level == PIN_HIGH;
+        break;
+    case PIN_IRQ_MODE_FALLING:
+        fire = level == PIN_LOW;
+        break;
+    default:
+        fire = 1;
+        break;
+    }
+    if (fire) {
+        p->hdr(p->args);
+    }
+}
+
+int sim_pin_output(rt_base_t pin)
+{
+    return rt_pin_read(pin);
+}
+
+/* ================= PWM ================= */
+
+rt_device_t rt_device_find(const char *name)
+{
+    int i;
+
+    for (i = 0; i < pwm_num; ++i) {
+        if (strcmp(pwm_devs[i].parent.name, name) == 0) {
+            return &pwm_devs[i].parent;
+        }
+    }
+    /* every device the firmware looks up is a PWM controller */
+    if (pwm_num >= SIM_MAX_PWM) {
+        return RT_NULL;
+    }
+    copy_name(pwm_devs[pwm_num].parent.name, sizeof(pwm_devs[pwm_num].parent.name), name);
+    return &pwm_devs[pwm_num++].parent;
+}
+
+rt_err_t rt_pwm_set(struct rt_device_pwm *device, int channel,
+                    rt_uint32_t period, rt_uint32_t pulse)
+{
+    if (device == RT_NULL || channel < 0 || channel >= PWM_SIM_CHANNELS ||
+        pulse > period) {
+        return -RT_EINVAL;
+    }
+    device->period[channel] = period;
+    device->pulse[channel] = pulse;
+    return RT_EOK;
+}
+
+rt_err_t rt_pwm_enable(struct rt_device_pwm *device, int channel)
+{
+    if (device == RT_NULL || channel < 0 || channel >= PWM_SIM_CHANNELS) {
+        return -RT_EINVAL;
+    }
+    device->enabled[channel] = RT_TRUE;
+    return RT_EOK;
+}
+
+double sim_pwm_duty(const char *dev_name, int channel)
+{
+    struct rt_device_pwm *dev = (struct rt_device_pwm *)rt_device_find(dev_name);
+
+    if (dev == RT_NULL || channel < 0 || channel >= PWM_SIM_CHANNELS ||
+        !dev->enabled[channel] || dev->period[channel] == 0) {
+        return 0.0;
+    }
+    return (double)dev->pulse[channel] / (double)dev->period[channel];
+}
+
+/* ================= cputime ================= */
+
+uint64_t clock_cpu_gettime(void)
+{
+    return now_ns;
+}
+
+float clock_cpu_getres(void)
+{
+    return 1.0f;
+}
@@ -0,0 +1,42 @@
+/*
+ * Host simulation of the RT-Thread services used by the control stack.
+ *
+ * There is one simulated thread of execution per process: the simulator
+ * calls a firmware thread entry directly, and simulated time advances only
+ * when that thread blocks. Hardware timers fire at their exact expiry time,
+ * and the plant hook is called for every interval in between, so the
+ * firmware sees the same tick -> sample -> PID -> PWM ordering as on the RCPU.
+ */
+
+#ifndef RTT_SIM_H
+#define RTT_SIM_H
+
+#include <stdint.h>
+#include <rtdevice.h>
+
+/* Called for each advance of simulated time, [from_ns, to_ns). */
+typedef void (*sim_advance_fn)(uint64_t from_ns, uint64_t to_ns);
+
+void sim_set_advance_hook(sim_advance_fn fn);
+void sim_set_verbose(int verbose);
+
+uint64_t sim_now_ns(void);
+
+/* Move the clock inside an advance hook (monotonic, within [from, to]). */
+void sim_clock_set(uint64_t ns);
+
+/* Advance simulated time, firing timers and the plant hook on the way. */
+void sim_advance_until(uint64_t ns);
+
+/* Drive an input pin; fires its IRQ handler on a matching edge. */
+void sim_pin_input(rt_base_t pin, int level);
+
+/* Last level written to an output pin. */
+int sim_pin_output(rt_base_t pin);
+
+/* Duty cycle 0..1 of a PWM channel (0 while disabled). */
+double sim_pwm_duty(const char *dev_name, int channel);
+
+rt_thread_t sim_thread_find(const char *name);
+
+#endif /* RTT_SIM_H */
@@ -0,0 +1,2 @@
+/* Host simulation stub: PWM API lives in ../rtdevice.h */
+#include <rtdevice.h>
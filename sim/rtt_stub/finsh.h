@@ -0,0 +1,2 @@
+/* Host simulation stub: MSH_CMD_EXPORT lives in rtthread.h */
+#include <rtthread.h>
@@ -0,0 +1,92 @@
+/*
+ * Host simulation stub of the RT-Thread types used by the control stack.
+ * Only what control_main.c and the src/ modules (minus rpmsg) need.
+ */
+
+#ifndef RTDEF_H
+#define RTDEF_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int8_t rt_int8_t;
+typedef uint8_t rt_uint8_t;
+typedef int16_t rt_int16_t;
+typedef uint16_t rt_uint16_t;
+typedef int32_t rt_int32_t;
+typedef uint32_t rt_uint32_t;
+typedef int64_t rt_int64_t;
+typedef uint64_t rt_uint64_t;
+typedef long rt_base_t;
+typedef unsigned long rt_ubase_t;
+typedef rt_base_t rt_err_t;
+typedef rt_ubase_t rt_size_t;
+typedef rt_ubase_t rt_tick_t;
+typedef int rt_bool_t;
+typedef long rt_off_t;
+
+#define RT_TRUE  1
+#define RT_FALSE 0
+#define RT_NULL  ((void *)0)
+
+#define RT_EOK      0
+#define RT_ERROR    1
+#define RT_ETIMEOUT 2
+#define RT_EFULL    3
+#define RT_EEMPTY   4
+#define RT_ENOMEM   5
+#define RT_ENOSYS   6
+#define RT_EBUSY    7
+#define RT_EIO      8
+#define RT_EINTR    9
+#define RT_EINVAL   10
+
+#define RT_WAITING_FOREVER -1
+#define RT_WAITING_NO      0
+
+#define RT_TICK_PER_SECOND     1000
+#define RT_THREAD_PRIORITY_MAX 32
+#define RT_NAME_MAX            8
+
+#define RT_IPC_FLAG_FIFO 0
+#define RT_IPC_FLAG_PRIO 1
+
+#define RT_TIMER_FLAG_ONE_SHOT   0x0
+#define RT_TIMER_FLAG_PERIODIC   0x2
+#define RT_TIMER_FLAG_HARD_TIMER 0x0
+#define RT_TIMER_FLAG_SOFT_TIMER 0x4
+
+#define RT_TIMER_CTRL_SET_TIME 0x0
+
+struct rt_thread {
+    char name[RT_NAME_MAX];
+    void (*entry)(void *parameter);
+    void *parameter;
+    rt_uint8_t priority;
+    rt_bool_t started;
+};
+typedef struct rt_thread *rt_thread_t;
+
+struct rt_semaphore {
+    char name[RT_NAME_MAX];
+    rt_uint32_t value;
+};
+typedef struct rt_semaphore *rt_sem_t;
+
+struct rt_timer {
+    char name[RT_NAME_MAX];
+    void (*timeout)(void *parameter);
+    void *parameter;
+    rt_tick_t period;
+    rt_uint8_t flag;
+    rt_bool_t active;
+    rt_uint64_t next_ns; /* simulated time of the next expiry */
+};
+typedef struct rt_timer *rt_timer_t;
+
+struct rt_device {
+    char name[RT_NAME_MAX * 2];
+};
+typedef struct rt_device *rt_device_t;
+
+#endif /* RTDEF_H */
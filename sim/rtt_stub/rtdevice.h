@@ -0,0 +1,59 @@
+/*
+ * Host simulation stub of <rtdevice.h>: pins, PWM and cputime.
+ */
+
+#ifndef RTDEVICE_H
+#define RTDEVICE_H
+
+#include "rtthread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PIN_LOW  0
+#define PIN_HIGH 1
+
+#define PIN_MODE_OUTPUT         0
+#define PIN_MODE_INPUT          1
+#define PIN_MODE_INPUT_PULLUP   2
+#define PIN_MODE_INPUT_PULLDOWN 3
+
+#define PIN_IRQ_MODE_RISING         0
+#define PIN_IRQ_MODE_FALLING        1
+#define PIN_IRQ_MODE_RISING_FALLING 2
+
+#define PIN_IRQ_DISABLE 0
+#define PIN_IRQ_ENABLE  1
+
+void rt_pin_mode(rt_base_t pin, rt_uint8_t mode);
+void rt_pin_write(rt_base_t pin, rt_uint8_t value);
+rt_int8_t rt_pin_read(rt_base_t pin);
+rt_err_t rt_pin_attach_irq(rt_base_t pin, rt_uint8_t mode,
+                           void (*hdr)(void *args), void *args);
+rt_err_t rt_pin_irq_enable(rt_base_t pin, rt_uint8_t enabled);
+
+rt_device_t rt_device_find(const char *name);
+
+#define PWM_SIM_CHANNELS 8
+
+struct rt_device_pwm {
+    struct rt_device parent;
+    rt_uint32_t period[PWM_SIM_CHANNELS]; /* ns */
+    rt_uint32_t pulse[PWM_SIM_CHANNELS];  /* ns */
+    rt_bool_t enabled[PWM_SIM_CHANNELS];
+};
+
+rt_err_t rt_pwm_set(struct rt_device_pwm *device, int channel,
+                    rt_uint32_t period, rt_uint32_t pulse);
+rt_err_t rt_pwm_enable(struct rt_device_pwm *device, int channel);
+
+/* simulated time in ns, 1 ns per count */
+uint64_t clock_cpu_gettime(void);
+float clock_cpu_getres(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RTDEVICE_H */
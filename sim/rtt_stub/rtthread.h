@@ -0,0 +1,67 @@
+/*
+ * Host simulation stub of <rtthread.h>.
+ *
+ * Time only advances when the running thread blocks (rt_sem_take on an
+ * empty semaphore, rt_thread_mdelay); see sim/rtt_sim.c.
+ */
+
+#ifndef RTTHREAD_H
+#define RTTHREAD_H
+
+#include "rtdef.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* control_main.c's main() is run by the simulator for every job */
+#ifndef SIM_KEEP_MAIN
+#define main chassis_firmware_main
+#endif
+int chassis_firmware_main(void);
+
+int rt_kprintf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+int rt_snprintf(char *buf, rt_size_t size, const char *fmt, ...);
+void *rt_memset(void *s, int c, rt_ubase_t count);
+void *rt_memcpy(void *dst, const void *src, rt_ubase_t count);
+rt_int32_t rt_strcmp(const char *a, const char *b);
+rt_int32_t rt_strncmp(const char *a, const char *b, rt_ubase_t count);
+
+rt_thread_t rt_thread_create(const char *name, void (*entry)(void *parameter),
+                             void *parameter, rt_uint32_t stack_size,
+                             rt_uint8_t priority, rt_uint32_t tick);
+rt_err_t rt_thread_startup(rt_thread_t thread);
+rt_err_t rt_thread_mdelay(rt_int32_t ms);
+rt_err_t rt_thread_delay(rt_tick_t tick);
+
+rt_tick_t rt_tick_get(void);
+rt_tick_t rt_tick_from_millisecond(rt_int32_t ms);
+
+rt_base_t rt_hw_interrupt_disable(void);
+void rt_hw_interrupt_enable(rt_base_t level);
+void rt_enter_critical(void);
+void rt_exit_critical(void);
+
+rt_sem_t rt_sem_create(const char *name, rt_uint32_t value, rt_uint8_t flag);
+rt_err_t rt_sem_take(rt_sem_t sem, rt_int32_t time);
+rt_err_t rt_sem_release(rt_sem_t sem);
+
+rt_timer_t rt_timer_create(const char *name, void (*timeout)(void *parameter),
+                           void *parameter, rt_tick_t time, rt_uint8_t flag);
+rt_err_t rt_timer_start(rt_timer_t timer);
+rt_err_t rt_timer_stop(rt_timer_t timer);
+rt_err_t rt_timer_control(rt_timer_t timer, int cmd, void *arg);
+
+/* shell commands are never invoked; keep them referenced to avoid warnings */
+#define MSH_CMD_EXPORT(cmd, desc) \
+    static void *const sim_msh_##cmd __attribute__((unused)) = (void *)cmd;
+#define MSH_CMD_EXPORT_ALIAS(cmd, alias, desc) \
+    static void *const sim_msh_##alias __attribute__((unused)) = (void *)cmd;
+
+#define RT_USING_CPUTIME
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RTTHREAD_H */
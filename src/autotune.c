@@ -0,0 +1,656 @@
+/*
+ * PID 自整定
+ *
+ * 实验数据只由底盘控制线程写入; 实验结束 (状态离开 RUNNING) 后由报告线程 / MSH
+ * 读取并计算结果, 控制线程内只做累加和记录
+ *
+ * 每轴实验分阶段进行:
+ *   LOW   保持 duty_low, 后半段平均转速为 w_lo
+ *   HIGH  保持 duty_high, 记录阶跃响应, 最后 1/4 平均转速为 w_hi
+ *   RELAY (仅继电模式) 转速高于 (w_lo + w_hi) / 2 + h 时切到 duty_low,
+ *         低于中点 - h 时切到 duty_high, 统计振荡幅值和周期
+ */
+
+#include <rtthread.h>
+#include <math.h>
+#include <stdlib.h>
+#include "autotune.h"
+#include "ff_table.h"
+#include "rpmsg_motor.h"
+
+#define AUTOTUNE_PHASE_LOW   0
+#define AUTOTUNE_PHASE_HIGH  1
+#define AUTOTUNE_PHASE_RELAY 2
+#define AUTOTUNE_PHASE_DONE  3
+
+#define AUTOTUNE_PI           3.14159265f
+#define AUTOTUNE_MIN_RESPONSE 0.05f /* 两段稳态转速差低于此值 (r/s) 认为没有响应 */
+#define AUTOTUNE_RELAY_HYST   0.05f /* 继电滞环 h, 占两段稳态转速差的比例 */
+#define AUTOTUNE_RELAY_SKIP   1     /* 丢弃的起始振荡周期数 */
+
+#define AUTOTUNE_THREAD_STACK_SIZE 2048
+#define AUTOTUNE_THREAD_PRIORITY   20
+#define AUTOTUNE_THREAD_TIMESLICE  10
+#define AUTOTUNE_POLL_MS           50
+
+struct autotune_axis
+{
+    int phase;
+    int error;
+    rt_uint32_t ticks; /* 本阶段已执行节拍数 */
+    float low_sum;
+    rt_uint32_t low_n;
+    float high_sum;
+    rt_uint32_t high_n;
+    float trace[AUTOTUNE_TRACE_SAMPLES]; /* HIGH 阶段转速, 第 0 点为阶跃前 */
+    rt_uint32_t trace_n;
+    /* RELAY */
+    float relay_sp;
+    float relay_hyst;
+    rt_bool_t relay_high;
+    rt_bool_t cycle_started;
+    rt_uint32_t cycle_start; /* 本周期开始 (切到 duty_low) 的节拍 */
+    float cycle_max;
+    float cycle_min;
+    rt_uint32_t cycles;      /* 已完成的周期数, 包括丢弃的 */
+    rt_uint32_t measured;    /* 参与计算的周期数 */
+    float period_sum;
+    float amp_sum;
+};
+
+static struct autotune_config at_cfg;
+static struct autotune_axis at_axis[MOTOR_AXIS_NUM];
+static volatile int at_state = AUTOTUNE_STATE_IDLE;
+static volatile rt_bool_t at_abort_req = RT_FALSE;
+static volatile rt_bool_t at_reporting = RT_FALSE;
+
+/* 由第一个节拍的周期确定, 实验期间不变 */
+static float at_dt;
+static rt_uint32_t at_hold_ticks;
+static rt_uint32_t at_relay_ticks;
+static rt_uint32_t at_decim;
+
+void autotune_config_default(struct autotune_config *cfg, int mode)
+{
+    cfg->mode = mode;
+    cfg->duty_low = AUTOTUNE_DUTY_LOW_DEFAULT;
+    cfg->duty_high = AUTOTUNE_DUTY_HIGH_DEFAULT;
+    cfg->apply = RT_FALSE;
+    cfg->notify = RT_FALSE;
+}
+
+rt_err_t autotune_begin(const struct autotune_config *cfg)
+{
+    if (cfg->mode != AUTOTUNE_MODE_STEP && cfg->mode != AUTOTUNE_MODE_RELAY)
+    {
+        return -RT_EINVAL;
+    }
+    if (!(cfg->duty_low > 0.0f && cfg->duty_low < cfg->duty_high && cfg->duty_high <= 1.0f))
+    {
+        return -RT_EINVAL;
+    }
+    if (at_state == AUTOTUNE_STATE_RUNNING || ff_cal_active())
+    {
+        return -RT_EBUSY;
+    }
+
+    at_cfg = *cfg;
+    rt_memset(at_axis, 0, sizeof(at_axis));
+    at_dt = 0.0f;
+    at_abort_req = RT_FALSE;
+    __sync_synchronize();
+    /* 状态最后写入, 控制线程看到 RUNNING 时实验数据已清零 */
+    at_state = AUTOTUNE_STATE_RUNNING;
+    return RT_EOK;
+}
+
+void autotune_abort(void)
+{
+    if (at_state == AUTOTUNE_STATE_RUNNING)
+    {
+        at_abort_req = RT_TRUE;
+    }
+}
+
+rt_bool_t autotune_active(void)
+{
+    return at_state == AUTOTUNE_STATE_RUNNING;
+}
+
+int autotune_get_state(void)
+{
+    return at_state;
+}
+
+/**
+ * @brief 第一个节拍时按节拍周期换算各阶段长度
+ */
+static void autotune_timing_init(float dt)
+{
+    at_dt = dt;
+    at_hold_ticks = (rt_uint32_t)(AUTOTUNE_HOLD_MS / 1000.0f / dt + 0.5f);
+    if (at_hold_ticks < 8)
+    {
+        at_hold_ticks = 8;
+    }
+    at_relay_ticks = (rt_uint32_t)(AUTOTUNE_RELAY_TIMEOUT_MS / 1000.0f / dt + 0.5f);
+    at_decim = (at_hold_ticks + AUTOTUNE_TRACE_SAMPLES - 1) / AUTOTUNE_TRACE_SAMPLES;
+}
+
+static float autotune_mean(float sum, rt_uint32_t n)
+{
+    return (n > 0) ? sum / (float)n : 0.0f;
+}
+
+/**
+ * @brief HIGH 阶段结束: 进入继电反馈或结束本轴
+ */
+static void autotune_high_done(struct autotune_axis *ax)
+{
+    float w_lo = autotune_mean(ax->low_sum, ax->low_n);
+    float w_hi = autotune_mean(ax->high_sum, ax->high_n);
+
+    ax->ticks = 0;
+    if (w_hi - w_lo < AUTOTUNE_MIN_RESPONSE)
+    {
+        ax->error = AUTOTUNE_ERR_NO_RESPONSE;
+        ax->phase = AUTOTUNE_PHASE_DONE;
+    }
+    else if (at_cfg.mode == AUTOTUNE_MODE_RELAY)
+    {
+        ax->relay_sp = (w_lo + w_hi) * 0.5f;
+        ax->relay_hyst = (w_hi - w_lo) * AUTOTUNE_RELAY_HYST;
+        ax->relay_high = RT_TRUE;
+        ax->phase = AUTOTUNE_PHASE_RELAY;
+    }
+    else
+    {
+        ax->phase = AUTOTUNE_PHASE_DONE;
+    }
+}
+
+/**
+ * @brief 继电反馈一个节拍, 每次切到 duty_low 时结束一个周期
+ */
+static float autotune_relay_step(struct autotune_axis *ax, float speed)
+{
+    if (ax->relay_high && speed > ax->relay_sp + ax->relay_hyst)
+    {
+        ax->relay_high = RT_FALSE;
+        if (ax->cycle_started)
+        {
+            if (ax->cycles >= AUTOTUNE_RELAY_SKIP)
+            {
+                ax->period_sum += (float)(ax->ticks - ax->cycle_start) * at_dt;
+                ax->amp_sum += (ax->cycle_max - ax->cycle_min) * 0.5f;
+                ax->measured++;
+            }
+            ax->cycles++;
+        }
+        ax->cycle_started = RT_TRUE;
+        ax->cycle_start = ax->ticks;
+        ax->cycle_max = speed;
+        ax->cycle_min = speed;
+    }
+    else if (!ax->relay_high && speed < ax->relay_sp - ax->relay_hyst)
+    {
+        ax->relay_high = RT_TRUE;
+    }
+
+    if (speed > ax->cycle_max)
+    {
+        ax->cycle_max = speed;
+    }
+    if (speed < ax->cycle_min)
+    {
+        ax->cycle_min = speed;
+    }
+
+    ax->ticks++;
+    if (ax->measured >= AUTOTUNE_RELAY_CYCLES)
+    {
+        ax->phase = AUTOTUNE_PHASE_DONE;
+    }
+    else if (ax->ticks >= at_relay_ticks)
+    {
+        ax->error = AUTOTUNE_ERR_NO_OSCILLATION;
+        ax->phase = AUTOTUNE_PHASE_DONE;
+    }
+    return ax->relay_high ? at_cfg.duty_high : at_cfg.duty_low;
+}
+
+/**
+ * @brief 单轴一个节拍
+ * @return 本节拍占空比
+ */
+static float autotune_axis_step(struct autotune_axis *ax, float speed)
+{
+    switch (ax->phase)
+    {
+    case AUTOTUNE_PHASE_LOW:
+        if (ax->ticks >= at_hold_ticks / 2)
+        {
+            ax->low_sum += speed;
+            ax->low_n++;
+        }
+        if (++ax->ticks >= at_hold_ticks)
+        {
+            ax->ticks = 0;
+            ax->phase = AUTOTUNE_PHASE_HIGH;
+        }
+        return at_cfg.duty_low;
+
+    case AUTOTUNE_PHASE_HIGH:
+        /* 本节拍的转速是上一节拍占空比的结果, 第 0 点为阶跃前 */
+        if (ax->ticks % at_decim == 0 && ax->trace_n < AUTOTUNE_TRACE_SAMPLES)
+        {
+            ax->trace[ax->trace_n++] = speed;
+        }
+        if (ax->ticks >= at_hold_ticks * 3 / 4)
+        {
+            ax->high_sum += speed;
+            ax->high_n++;
+        }
+        if (++ax->ticks >= at_hold_ticks)
+        {
+            autotune_high_done(ax);
+        }
+        return at_cfg.duty_high;
+
+    case AUTOTUNE_PHASE_RELAY:
+        return autotune_relay_step(ax, speed);
+
+    default:
+        return 0.0f;
+    }
+}
+
+rt_bool_t autotune_update(const float *speed, float dt, float *duty)
+{
+    rt_bool_t done = RT_TRUE;
+    int i;
+
+    if (at_state != AUTOTUNE_STATE_RUNNING)
+    {
+        return RT_FALSE;
+    }
+
+    if (at_abort_req)
+    {
+        for (i = 0; i < MOTOR_AXIS_NUM; i++)
+        {
+            duty[i] = 0.0f;
+        }
+        at_state = AUTOTUNE_STATE_ABORTED;
+        return RT_TRUE;
+    }
+
+    if (at_dt <= 0.0f)
+    {
+        autotune_timing_init(dt);
+    }
+
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
+    {
+        duty[i] = autotune_axis_step(&at_axis[i], speed[i]);
+        if (at_axis[i].phase != AUTOTUNE_PHASE_DONE)
+        {
+            done = RT_FALSE;
+        }
+    }
+
+    if (done)
+    {
+        for (i = 0; i < MOTOR_AXIS_NUM; i++)
+        {
+            duty[i] = 0.0f;
+        }
+        at_state = AUTOTUNE_STATE_DONE;
+    }
+    return RT_TRUE;
+}
+
+/* ================= 结果计算 ================= */
+
+/**
+ * @brief 阶跃响应首次达到 level 的时刻 (相对阶跃, 相邻记录点之间线性插值)
+ * @return 时刻 (s), 没有达到时返回负值
+ */
+static float autotune_cross_time(const struct autotune_axis *ax, float level)
+{
+    float y0, y1, frac;
+    rt_uint32_t i;
+
+    for (i = 1; i < ax->trace_n; i++)
+    {
+        if (ax->trace[i] >= level)
+        {
+            y0 = ax->trace[i - 1];
+            y1 = ax->trace[i];
+            frac = (y1 > y0) ? (level - y0) / (y1 - y0) : 0.0f;
+            if (frac < 0.0f)
+            {
+                frac = 0.0f;
+            }
+            return ((float)(i - 1) + frac) * (float)at_decim * at_dt;
+        }
+    }
+    return -1.0f;
+}
+
+rt_err_t autotune_get_result(int axis, struct autotune_result *out)
+{
+    const struct autotune_axis *ax;
+    float w_lo, w_hi, dw, du;
+    float t28, t63, tc, ti, ku, a2, amp;
+
+    rt_memset(out, 0, sizeof(*out));
+    if (axis < 0 || axis >= MOTOR_AXIS_NUM)
+    {
+        return -RT_EINVAL;
+    }
+    ax = &at_axis[axis];
+
+    if (at_state != AUTOTUNE_STATE_DONE || ax->phase != AUTOTUNE_PHASE_DONE)
+    {
+        out->error = AUTOTUNE_ERR_INCOMPLETE;
+        return -RT_ERROR;
+    }
+    if (ax->error == AUTOTUNE_ERR_NO_RESPONSE)
+    {
+        out->error = ax->error;
+        return -RT_ERROR;
+    }
+
+    /* 稳态: 增益 K, 零转速截距, 过原点的前馈系数 (最小二乘, 与 ff * speed 的前馈形式一致) */
+    w_lo = autotune_mean(ax->low_sum, ax->low_n);
+    w_hi = autotune_mean(ax->high_sum, ax->high_n);
+    dw = w_hi - w_lo;
+    du = at_cfg.duty_high - at_cfg.duty_low;
+    out->gain = dw / du;
+    out->offset = at_cfg.duty_low - w_lo / out->gain;
+    out->ff = (w_lo * at_cfg.duty_low + w_hi * at_cfg.duty_high) / (w_lo * w_lo + w_hi * w_hi);
+
+    /* 两点法: tau = 1.5 (t63 - t28), L = t63 - tau, L 不小于一个节拍 (采样和输出延迟) */
+    t28 = autotune_cross_time(ax, w_lo + 0.283f * dw);
+    t63 = autotune_cross_time(ax, w_lo + 0.632f * dw);
+    if (t28 < 0.0f || t63 <= t28)
+    {
+        out->error = AUTOTUNE_ERR_NO_RESPONSE;
+        return -RT_ERROR;
+    }
+    out->tau = 1.5f * (t63 - t28);
+    out->dead_time = t63 - out->tau;
+    if (out->dead_time < at_dt)
+    {
+        out->dead_time = at_dt;
+    }
+
+    if (at_cfg.mode == AUTOTUNE_MODE_STEP)
+    {
+        /* SIMC PI: 闭环时间常数 tc 取 max(L, tau / 2) */
+        tc = out->dead_time;
+        if (tc < out->tau * 0.5f)
+        {
+            tc = out->tau * 0.5f;
+        }
+        out->kp = out->tau / (out->gain * (tc + out->dead_time));
+        ti = 4.0f * (tc + out->dead_time);
+        if (ti > out->tau)
+        {
+            ti = out->tau;
+        }
+        out->ki = out->kp / ti;
+        out->kd = 0.0f;
+        return RT_EOK;
+    }
+
+    /* 继电: Ku = 4d / (pi * sqrt(a^2 - h^2)); 按 Tyreus-Luyben PI (kp = Ku / 3.2, Ti = 2.2 Tu),
+     * 控制节拍相对电机时间常数较粗, ZN 规则的积分过强 */
+    if (ax->error != AUTOTUNE_ERR_NONE || ax->measured == 0)
+    {
+        out->error = AUTOTUNE_ERR_NO_OSCILLATION;
+        return -RT_ERROR;
+    }
+    amp = ax->amp_sum / (float)ax->measured;
+    a2 = amp * amp - ax->relay_hyst * ax->relay_hyst;
+    if (a2 <= 0.0f)
+    {
+        out->error = AUTOTUNE_ERR_NO_OSCILLATION;
+        return -RT_ERROR;
+    }
+    ku = 4.0f * (du * 0.5f) / (AUTOTUNE_PI * sqrtf(a2));
+    out->ku = ku;
+    out->tu = ax->period_sum / (float)ax->measured;
+    out->kp = ku / 3.2f;
+    out->ki = out->kp / (2.2f * out->tu);
+    out->kd = 0.0f;
+    return RT_EOK;
+}
+
+/* ================= 报告线程 ================= */
+
+static const char *autotune_error_name(int error)
+{
+    switch (error)
+    {
+    case AUTOTUNE_ERR_NONE:
+        return "ok";
+    case AUTOTUNE_ERR_NO_RESPONSE:
+        return "no_response";
+    case AUTOTUNE_ERR_NO_OSCILLATION:
+        return "no_oscillation";
+    default:
+        return "incomplete";
+    }
+}
+
+static void autotune_print_result(int axis, const struct autotune_result *res)
+{
+    if (res->error != AUTOTUNE_ERR_NONE)
+    {
+        rt_kprintf("  axis%d: %s\n", axis, autotune_error_name(res->error));
+        return;
+    }
+    rt_kprintf("  axis%d: K=%d mr/s tau=%d ms L=%d ms offset=%d ku=%d tu=%d ms (x1000)\n", axis,
+               (int)(res->gain * 1000), (int)(res->tau * 1000), (int)(res->dead_time * 1000),
+               (int)(res->offset * 1000), (int)(res->ku * 1000), (int)(res->tu * 1000));
+    rt_kprintf("         kp=%d ki=%d kd=%d ff=%d (x1000)\n", (int)(res->kp * 1000),
+               (int)(res->ki * 1000), (int)(res->kd * 1000), (int)(res->ff * 1000));
+}
+
+/**
+ * @brief 通过 RPMsg 上报一条结果
+ *        "TUNE,<axis>,<status>,K,tau,L,kp,ki,kd,ff" (x1000 整数)
+ */
+static void autotune_notify_result(int axis, const struct autotune_result *res)
+{
+    char text[128];
+
+    rt_snprintf(text, sizeof(text), "TUNE,%d,%s,%d,%d,%d,%d,%d,%d,%d", axis,
+                autotune_error_name(res->error), (int)(res->gain * 1000),
+                (int)(res->tau * 1000), (int)(res->dead_time * 1000), (int)(res->kp * 1000),
+                (int)(res->ki * 1000), (int)(res->kd * 1000), (int)(res->ff * 1000));
+    rpmsg_motor_send_event(text);
+}
+
+/**
+ * @brief 报告线程: 等待实验结束, 打印 / 上报各轴结果, 按配置应用有效轴的平均值
+ */
+static void autotune_thread_entry(void *parameter)
+{
+    struct autotune_result res;
+    double ratio, ff, kp, ki, kd;
+    double sum_ff = 0.0, sum_kp = 0.0, sum_ki = 0.0, sum_kd = 0.0;
+    char text[96];
+    int valid = 0;
+    int i;
+
+    (void)parameter;
+
+    while (at_state == AUTOTUNE_STATE_RUNNING)
+    {
+        rt_thread_mdelay(AUTOTUNE_POLL_MS);
+    }
+    /* 不恢复实验期间收到的目标值 */
+    chassis_emergency_stop();
+
+    if (at_state == AUTOTUNE_STATE_ABORTED)
+    {
+        rt_kprintf("[autotune] Aborted\n");
+        if (at_cfg.notify)
+        {
+            rpmsg_motor_send_event("TUNE,aborted");
+        }
+        at_reporting = RT_FALSE;
+        return;
+    }
+
+    rt_kprintf("[autotune] %s test finished:\n",
+               (at_cfg.mode == AUTOTUNE_MODE_RELAY) ? "Relay" : "Step");
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
+    {
+        if (autotune_get_result(i, &res) == RT_EOK)
+        {
+            sum_ff += res.ff;
+            sum_kp += res.kp;
+            sum_ki += res.ki;
+            sum_kd += res.kd;
+            valid++;
+        }
+        autotune_print_result(i, &res);
+        if (at_cfg.notify)
+        {
+            autotune_notify_result(i, &res);
+        }
+    }
+
+    /* 底盘参数各轴共用一组, 取有效轴的平均值 */
+    if (at_cfg.apply && valid > 0)
+    {
+        chassis_get_cfg(&ratio, &ff, &kp, &ki, &kd);
+        ff = sum_ff / valid;
+        kp = sum_kp / valid;
+        ki = sum_ki / valid;
+        kd = sum_kd / valid;
+        chassis_set_cfg(ratio, ff, kp, ki, kd);
+        if (at_cfg.notify)
+        {
+            rt_snprintf(text, sizeof(text), "TUNE,applied,%d,%d,%d,%d", (int)(ff * 1000),
+                        (int)(kp * 1000), (int)(ki * 1000), (int)(kd * 1000));
+            rpmsg_motor_send_event(text);
+        }
+    }
+    else if (at_cfg.apply)
+    {
+        rt_kprintf("[autotune] No valid axis, parameters unchanged\n");
+    }
+
+    if (at_cfg.notify)
+    {
+        rpmsg_motor_send_event("TUNE,done");
+    }
+    at_reporting = RT_FALSE;
+}
+
+rt_err_t autotune_start(const struct autotune_config *cfg)
+{
+    rt_thread_t thread;
+    rt_err_t ret;
+
+    if (at_reporting)
+    {
+        return -RT_EBUSY;
+    }
+
+    /* 实验从静止开始, 结束后不恢复之前的目标值 */
+    chassis_emergency_stop();
+    ret = autotune_begin(cfg);
+    if (ret != RT_EOK)
+    {
+        return ret;
+    }
+
+    at_reporting = RT_TRUE;
+    thread = rt_thread_create("tune", autotune_thread_entry, RT_NULL, AUTOTUNE_THREAD_STACK_SIZE,
+                              AUTOTUNE_THREAD_PRIORITY, AUTOTUNE_THREAD_TIMESLICE);
+    if (thread == RT_NULL)
+    {
+        autotune_abort();
+        at_reporting = RT_FALSE;
+        return -RT_ENOMEM;
+    }
+    rt_thread_startup(thread);
+
+    rt_kprintf("[autotune] %s test started: duty %d -> %d (x1000), keep the chassis lifted\n",
+               (cfg->mode == AUTOTUNE_MODE_RELAY) ? "Relay" : "Step",
+               (int)(cfg->duty_low * 1000), (int)(cfg->duty_high * 1000));
+    return RT_EOK;
+}
+
+/* ================= 调试用 MSH 命令 ================= */
+
+/**
+ * @brief MSH 命令: 启动 / 中止自整定, 查看上次结果
+ *        用法: autotune [step|relay [duty_low duty_high] [apply]] | stop
+ */
+static void autotune_cmd(int argc, char *argv[])
+{
+    struct autotune_config cfg;
+    struct autotune_result res;
+    rt_err_t ret;
+    int i;
+
+    if (argc < 2)
+    {
+        rt_kprintf("Autotune state: %d (0=idle, 1=running, 2=done, 3=aborted)\n", at_state);
+        if (at_state == AUTOTUNE_STATE_DONE)
+        {
+            for (i = 0; i < MOTOR_AXIS_NUM; i++)
+            {
+                autotune_get_result(i, &res);
+                autotune_print_result(i, &res);
+            }
+        }
+        return;
+    }
+
+    if (rt_strcmp(argv[1], "stop") == 0)
+    {
+        autotune_abort();
+        return;
+    }
+
+    if (rt_strcmp(argv[1], "step") == 0)
+    {
+        autotune_config_default(&cfg, AUTOTUNE_MODE_STEP);
+    }
+    else if (rt_strcmp(argv[1], "relay") == 0)
+    {
+        autotune_config_default(&cfg, AUTOTUNE_MODE_RELAY);
+    }
+    else
+    {
+        rt_kprintf("Usage: autotune [step|relay [duty_low duty_high] [apply]] | stop\n");
+        return;
+    }
+
+    i = 2;
+    if (argc >= 4 && rt_strcmp(argv[2], "apply") != 0)
+    {
+        cfg.duty_low = (float)atof(argv[2]);
+        cfg.duty_high = (float)atof(argv[3]);
+        i = 4;
+    }
+    if (argc > i && rt_strcmp(argv[i], "apply") == 0)
+    {
+        cfg.apply = RT_TRUE;
+    }
+
+    ret = autotune_start(&cfg);
+    if (ret != RT_EOK)
+    {
+        rt_kprintf("[autotune] Start failed: %d\n", ret);
+    }
+}
+MSH_CMD_EXPORT_ALIAS(autotune_cmd, autotune, PID auto tuning by step or relay test);
@@ -0,0 +1,358 @@
+/*
+ * 控制环基准测试
+ *
+ * 每次迭代关中断, 前后各读一次 hrtime 计数器, 不受线程切换和中断影响;
+ * 被测函数通过函数指针调用, "empty" 项给出计时本身 (含一次间接调用) 的开销
+ *
+ * 输入序列由固定种子的线性同余发生器产生, 每次运行结果可直接对比
+ * (定点/浮点 PID, 文本/二进制协议, 不同编译选项)
+ *
+ * 执行器测试会先把底盘目标置零, 期间电机以 0 占空比输出
+ */
+
+#include <rtthread.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "common.h"
+#include "control_tick.h"
+#include "encoder.h"
+#include "hrtime.h"
+#include "motor_control.h"
+#include "motor_proto.h"
+#include "pid.h"
+#include "pid_fixed.h"
+#include "rpmsg_motor.h"
+
+/* 测试分组 */
+#define BENCH_GROUP_PID   (1U << 0)
+#define BENCH_GROUP_MOTOR (1U << 1)
+#define BENCH_GROUP_PARSE (1U << 2)
+#define BENCH_GROUP_ISR   (1U << 3)
+#define BENCH_GROUP_TICK  (1U << 4)
+#define BENCH_GROUP_ALL   0xFFU
+
+/* 被测对象 (只在 MSH 线程中访问) */
+static PID_Controller bench_pid;
+#ifdef PID_USING_FIXED
+static PID_Fixed_Controller bench_pid_fixed;
+#endif
+static struct motor_proto_wheel_frame bench_frame;
+static rt_uint32_t bench_seed;
+static volatile float bench_sink; /* 防止结果被优化掉 */
+
+static const char bench_speed_cmd[] = "1,0.500;2,0.250";
+static const char bench_cfg_cmd[] = "CFG,56.000,0.300,0.050,0.200,0.010,1";
+
+void bench_stats_reset(struct bench_stats *st)
+{
+    rt_memset(st, 0, sizeof(*st));
+}
+
+void bench_stats_add(struct bench_stats *st, rt_uint64_t counts)
+{
+    if (st->count == 0 || counts < st->min)
+    {
+        st->min = counts;
+    }
+    if (counts > st->max)
+    {
+        st->max = counts;
+    }
+    st->sum += counts;
+    st->sum_sq += counts * counts;
+    st->count++;
+}
+
+/**
+ * @brief 线性同余发生器, 固定种子保证输入序列可复现
+ */
+static rt_uint32_t bench_rand(void)
+{
+    bench_seed = bench_seed * 1103515245U + 12345U;
+    return bench_seed >> 16;
+}
+
+/**
+ * @brief 打印一项统计 (单位 ns)
+ */
+static void bench_print(const char *name, const struct bench_stats *st)
+{
+    float ns_per_count = hrtime_to_sec(1000000) * 1e3f;
+    double mean, var;
+
+    if (st->count == 0)
+    {
+        rt_kprintf("  %-14s (no samples)\n", name);
+        return;
+    }
+
+    mean = (double)st->sum / st->count;
+    var = (double)st->sum_sq / st->count - mean * mean;
+    if (var < 0.0)
+    {
+        var = 0.0;
+    }
+
+    rt_kprintf("  %-14s %7u %9d %9d %9d %9d\n", name, st->count,
+               (int)(st->min * ns_per_count), (int)(mean * ns_per_count),
+               (int)(st->max * ns_per_count), (int)(sqrt(var) * ns_per_count));
+}
+
+/**
+ * @brief 对 fn 计时 n 次, 每次迭代关中断
+ */
+static void bench_run(const char *name, void (*fn)(rt_uint32_t i), rt_uint32_t n)
+{
+    struct bench_stats st;
+    rt_uint64_t t0, t1;
+    rt_base_t level;
+    rt_uint32_t i;
+
+    bench_stats_reset(&st);
+    bench_seed = 12345U;
+
+    for (i = 0; i < n; i++)
+    {
+        level = rt_hw_interrupt_disable();
+        t0 = hrtime_now();
+        fn(i);
+        t1 = hrtime_now();
+        rt_hw_interrupt_enable(level);
+        bench_stats_add(&st, t1 - t0);
+    }
+
+    bench_print(name, &st);
+}
+
+/* ================= 被测函数 ================= */
+
+static void bench_empty(rt_uint32_t i)
+{
+    (void)i;
+}
+
+static void bench_pid_ff(rt_uint32_t i)
+{
+    (void)i;
+    bench_sink = PID_FF_Update(&bench_pid, 1.5f + (float)(bench_rand() % 1000) * 0.001f,
+                               0.6f);
+}
+
+#ifdef PID_USING_FIXED
+static void bench_pid_fixed_ff(rt_uint32_t i)
+{
+    (void)i;
+    bench_sink = (float)PID_Fixed_FF_Update(
+        &bench_pid_fixed,
+        PID_Q16_FROM_FLOAT(1.5f + (float)(bench_rand() % 1000) * 0.001f),
+        PID_Q16_FROM_FLOAT(0.6f));
+}
+#endif
+
+static void bench_motor(rt_uint32_t i)
+{
+    (void)i;
+    motor_control(1, 0, 0.0f);
+}
+
+static void bench_parse_speed(rt_uint32_t i)
+{
+    int dir1, dir2;
+    double speed1, speed2;
+
+    (void)i;
+    parse_speed_command(bench_speed_cmd, &dir1, &speed1, &dir2, &speed2);
+    bench_sink = (float)speed2;
+}
+
+static void bench_parse_cfg(rt_uint32_t i)
+{
+    double ratio, ff, kp, ki, kd;
+    int fb;
+
+    (void)i;
+    parse_cfg_command(bench_cfg_cmd, &ratio, &ff, &kp, &ki, &kd, &fb);
+    bench_sink = (float)kd;
+}
+
+static void bench_proto_check(rt_uint32_t i)
+{
+    (void)i;
+    bench_sink = (float)motor_proto_check(&bench_frame, sizeof(bench_frame));
+}
+
+/* ================= 分组 ================= */
+
+static void bench_group_pid(rt_uint32_t n)
+{
+    float dt = control_tick_get_dt();
+
+    PID_Controller_Init(&bench_pid, 0.05f, 0.2f, 0.01f, dt, 10.0f, 1.0f);
+    bench_pid.setpoint = 2.0f;
+    bench_run("pid_ff", bench_pid_ff, n);
+
+#ifdef PID_USING_FIXED
+    PID_Fixed_Init(&bench_pid_fixed, 0.05f, 0.2f, 0.01f, dt, 10.0f, 1.0f);
+    bench_pid_fixed.setpoint = PID_Q16_FROM_FLOAT(2.0f);
+    bench_run("pid_fixed_ff", bench_pid_fixed_ff, n);
+#endif
+}
+
+/**
+ * @brief 执行器: 缓存命中 (方向和脉宽不变) 与强制写驱动两种情况
+ */
+static void bench_group_motor(rt_uint32_t n)
+{
+    struct bench_stats st;
+    rt_uint64_t t0, t1;
+    rt_base_t level;
+    rt_uint32_t i;
+
+    /* 底盘线程与本测试都输出 0 占空比, 互不干扰 */
+    chassis_set_target(0, 0.0, 0, 0.0);
+    rt_thread_mdelay(2 * 1000 / control_tick_get_hz() + 1);
+
+    motor_control(1, 0, 0.0f);
+    bench_run("motor_cached", bench_motor, n);
+
+    bench_stats_reset(&st);
+    for (i = 0; i < n; i++)
+    {
+        motor_actuator_invalidate(0);
+        level = rt_hw_interrupt_disable();
+        t0 = hrtime_now();
+        motor_control(1, 0, 0.0f);
+        t1 = hrtime_now();
+        rt_hw_interrupt_enable(level);
+        bench_stats_add(&st, t1 - t0);
+    }
+    bench_print("motor_write", &st);
+
+    motor_actuator_invalidate(-1);
+}
+
+static void bench_group_parse(rt_uint32_t n)
+{
+    bench_run("parse_speed", bench_parse_speed, n);
+    bench_run("parse_cfg", bench_parse_cfg, n);
+
+    /* 二进制协议对应的开销: 定长帧校验 (CRC) */
+    rt_memset(&bench_frame, 0, sizeof(bench_frame));
+    bench_frame.setpoint_mrs[0] = 500;
+    bench_frame.setpoint_mrs[1] = -250;
+    motor_proto_finalize(&bench_frame, MOTOR_PROTO_TYPE_CMD, 0, 1, 0);
+    bench_run("proto_check", bench_proto_check, n);
+}
+
+static void bench_group_isr(rt_uint32_t n)
+{
+    struct bench_stats st;
+    rt_uint32_t i;
+
+    bench_stats_reset(&st);
+    for (i = 0; i < n; i++)
+    {
+        bench_stats_add(&st, encoder_bench_isr(0));
+    }
+    bench_print("encoder_isr", &st);
+}
+
+static void bench_group_tick(rt_uint32_t ticks)
+{
+    struct bench_stats st;
+    rt_err_t ret;
+
+    ret = chassis_bench_ticks(&st, ticks);
+    if (ret != RT_EOK)
+    {
+        rt_kprintf("  %-14s failed (%d)\n", "control_tick", ret);
+        return;
+    }
+    bench_print("control_tick", &st);
+}
+
+/* ================= MSH 命令 ================= */
+
+/**
+ * @brief MSH 命令: 基准测试
+ *        用法: bench [all|pid|motor|parse|isr|tick] [iterations]
+ *        tick 的次数为控制节拍数, 在底盘控制线程中实测
+ */
+static void bench_cmd(int argc, char *argv[])
+{
+    rt_uint32_t groups = BENCH_GROUP_ALL;
+    rt_uint32_t n = BENCH_DEFAULT_ITERATIONS;
+    rt_uint32_t ticks = BENCH_DEFAULT_TICKS;
+    int arg;
+
+    if (argc >= 2)
+    {
+        if (rt_strcmp(argv[1], "pid") == 0)
+        {
+            groups = BENCH_GROUP_PID;
+        }
+        else if (rt_strcmp(argv[1], "motor") == 0)
+        {
+            groups = BENCH_GROUP_MOTOR;
+        }
+        else if (rt_strcmp(argv[1], "parse") == 0)
+        {
+            groups = BENCH_GROUP_PARSE;
+        }
+        else if (rt_strcmp(argv[1], "isr") == 0)
+        {
+            groups = BENCH_GROUP_ISR;
+        }
+        else if (rt_strcmp(argv[1], "tick") == 0)
+        {
+            groups = BENCH_GROUP_TICK;
+        }
+        else if (rt_strcmp(argv[1], "all") != 0)
+        {
+            rt_kprintf("Usage: bench [all|pid|motor|parse|isr|tick] [iterations]\n");
+            return;
+        }
+    }
+    if (argc >= 3)
+    {
+        arg = atoi(argv[2]);
+        if (arg < 1)
+        {
+            arg = 1;
+        }
+        else if (arg > BENCH_MAX_ITERATIONS)
+        {
+            arg = BENCH_MAX_ITERATIONS;
+        }
+        n = (rt_uint32_t)arg;
+        ticks = (rt_uint32_t)arg;
+    }
+
+    rt_kprintf("[Bench] %u iterations (tick: %u ticks @ %dHz), IRQ off per iteration\n",
+               n, ticks, control_tick_get_hz());
+    rt_kprintf("  %-14s %7s %9s %9s %9s %9s\n", "item", "n", "min_ns", "mean_ns",
+               "max_ns", "stddev_ns");
+
+    bench_run("empty", bench_empty, n);
+    if (groups & BENCH_GROUP_PID)
+    {
+        bench_group_pid(n);
+    }
+    if (groups & BENCH_GROUP_MOTOR)
+    {
+        bench_group_motor(n);
+    }
+    if (groups & BENCH_GROUP_PARSE)
+    {
+        bench_group_parse(n);
+    }
+    if (groups & BENCH_GROUP_ISR)
+    {
+        bench_group_isr(n);
+    }
+    if (groups & BENCH_GROUP_TICK)
+    {
+        bench_group_tick(ticks);
+    }
+}
+MSH_CMD_EXPORT_ALIAS(bench_cmd, bench, Benchmark control loop functions);
@@ -0,0 +1,253 @@
+/*
+ * 底盘运动学与里程计
+ *
+ * 几何参数邮箱: cfg 线程 / MSH 写, RPMsg 回调和底盘控制线程读 (seqlock)
+ * 里程计: 累加量只在底盘控制线程中访问, 每次积分后发布到快照邮箱 (seqlock)
+ *
+ * 积分使用中点航向: 每个节拍内按匀速圆弧近似,
+ *   ds = (dl + dr) / 2, dyaw = (dr - dl) / b
+ *   x += ds * cos(yaw + dyaw / 2), y += ds * sin(yaw + dyaw / 2)
+ */
+
+#include <rtthread.h>
+#include <math.h>
+#include <stdlib.h>
+#include "chassis_kin.h"
+#include "hrtime.h"
+#include "motor_axis.h"
+#include "rpmsg_motor.h"
+#include "seqlock.h"
+
+#define CHASSIS_KIN_PI     3.14159265358979323846
+#define CHASSIS_KIN_MIN_MPS 1e-3f /* 低于此轮缘速度时目标为 0, 与大核换算一致 */
+
+static struct chassis_geometry geo_box = {
+    CHASSIS_WHEEL_RADIUS_M, CHASSIS_WHEEL_BASE_M, { 1.0f, 1.0f },
+};
+static seqlock_t geo_lock = SEQLOCK_INIT;
+
+static struct chassis_odom odom_box;
+static seqlock_t odom_lock = SEQLOCK_INIT;
+
+/* 底盘控制线程私有 */
+static struct chassis_odom odom_acc;
+static volatile rt_bool_t odom_reset_req = RT_FALSE;
+
+void chassis_kin_set_geometry(const struct chassis_geometry *geo)
+{
+    rt_base_t level;
+    int ch;
+
+    level = seqlock_write_begin(&geo_lock);
+    if (geo->wheel_radius_m > 0.0f)
+    {
+        geo_box.wheel_radius_m = geo->wheel_radius_m;
+    }
+    if (geo->wheel_base_m > 0.0f)
+    {
+        geo_box.wheel_base_m = geo->wheel_base_m;
+    }
+    for (ch = 0; ch < MOTOR_PROTO_WHEELS; ch++)
+    {
+        if (geo->motor_factor[ch] > 0.0f)
+        {
+            geo_box.motor_factor[ch] = geo->motor_factor[ch];
+        }
+    }
+    seqlock_write_end(&geo_lock, level);
+}
+
+void chassis_kin_get_geometry(struct chassis_geometry *out)
+{
+    rt_uint32_t seq;
+
+    do
+    {
+        seq = seqlock_read_begin(&geo_lock);
+        *out = geo_box;
+    } while (seqlock_read_retry(&geo_lock, seq));
+}
+
+void chassis_kin_inverse(float v, float w, float *wheel_rps)
+{
+    struct chassis_geometry geo;
+    float wheel_v[MOTOR_PROTO_WHEELS];
+    float circumference;
+    int ch;
+
+    chassis_kin_get_geometry(&geo);
+    circumference = (float)(2.0 * CHASSIS_KIN_PI) * geo.wheel_radius_m;
+
+    wheel_v[MOTOR_AXIS_CHANNEL_LEFT] = v - w * geo.wheel_base_m * 0.5f;
+    wheel_v[MOTOR_AXIS_CHANNEL_RIGHT] = v + w * geo.wheel_base_m * 0.5f;
+    for (ch = 0; ch < MOTOR_PROTO_WHEELS; ch++)
+    {
+        if (fabsf(wheel_v[ch]) < CHASSIS_KIN_MIN_MPS)
+        {
+            wheel_rps[ch] = 0.0f;
+        }
+        else
+        {
+            wheel_rps[ch] = wheel_v[ch] / circumference * geo.motor_factor[ch];
+        }
+    }
+}
+
+/**
+ * @brief 航向角归一化到 [-pi, pi)
+ */
+static double chassis_kin_wrap(double yaw)
+{
+    while (yaw >= CHASSIS_KIN_PI)
+    {
+        yaw -= 2.0 * CHASSIS_KIN_PI;
+    }
+    while (yaw < -CHASSIS_KIN_PI)
+    {
+        yaw += 2.0 * CHASSIS_KIN_PI;
+    }
+    return yaw;
+}
+
+void chassis_kin_odom_update(const rt_int32_t *counts, float counts_per_rev,
+                             rt_uint64_t hr_time)
+{
+    struct chassis_geometry geo;
+    double dist[MOTOR_PROTO_WHEELS];
+    double ds, dyaw, heading;
+    float dt = 0.0f;
+    rt_base_t level;
+    int ch;
+
+    chassis_kin_get_geometry(&geo);
+
+    if (odom_reset_req)
+    {
+        odom_acc.x = 0.0;
+        odom_acc.y = 0.0;
+        odom_acc.yaw = 0.0;
+        odom_reset_req = RT_FALSE;
+    }
+    if (odom_acc.updates > 0)
+    {
+        dt = hrtime_to_sec(hr_time - odom_acc.hr_time);
+    }
+
+    for (ch = 0; ch < MOTOR_PROTO_WHEELS; ch++)
+    {
+        dist[ch] = (double)counts[ch] / counts_per_rev * 2.0 * CHASSIS_KIN_PI *
+                   geo.wheel_radius_m;
+    }
+    ds = (dist[MOTOR_AXIS_CHANNEL_LEFT] + dist[MOTOR_AXIS_CHANNEL_RIGHT]) * 0.5;
+    dyaw = (dist[MOTOR_AXIS_CHANNEL_RIGHT] - dist[MOTOR_AXIS_CHANNEL_LEFT]) /
+           geo.wheel_base_m;
+    heading = odom_acc.yaw + dyaw * 0.5;
+
+    odom_acc.x += ds * cos(heading);
+    odom_acc.y += ds * sin(heading);
+    odom_acc.yaw = chassis_kin_wrap(odom_acc.yaw + dyaw);
+    if (dt > 0.0f)
+    {
+        odom_acc.v = (float)ds / dt;
+        odom_acc.w = (float)dyaw / dt;
+        for (ch = 0; ch < MOTOR_PROTO_WHEELS; ch++)
+        {
+            odom_acc.wheel_v[ch] = (float)dist[ch] / dt;
+        }
+    }
+    odom_acc.hr_time = hr_time;
+    odom_acc.updates++;
+
+    level = seqlock_write_begin(&odom_lock);
+    odom_box = odom_acc;
+    seqlock_write_end(&odom_lock, level);
+}
+
+void chassis_kin_get_odom(struct chassis_odom *out)
+{
+    rt_uint32_t seq;
+
+    do
+    {
+        seq = seqlock_read_begin(&odom_lock);
+        *out = odom_box;
+    } while (seqlock_read_retry(&odom_lock, seq));
+}
+
+void chassis_kin_odom_reset(void)
+{
+    odom_reset_req = RT_TRUE;
+}
+
+/* ================= 调试用 MSH 命令 ================= */
+
+/**
+ * @brief MSH 命令: 查看里程计, 清零位姿, 设置几何参数
+ *        用法: odom [reset|geo <radius_m> <base_m> [factor1 factor2]]
+ */
+static void odom_cmd(int argc, char *argv[])
+{
+    struct chassis_geometry geo;
+    struct chassis_odom odom;
+
+    if (argc >= 2)
+    {
+        if (rt_strcmp(argv[1], "reset") == 0)
+        {
+            chassis_kin_odom_reset();
+        }
+        else if (rt_strcmp(argv[1], "geo") == 0 && argc >= 4)
+        {
+            geo.wheel_radius_m = (float)atof(argv[2]);
+            geo.wheel_base_m = (float)atof(argv[3]);
+            geo.motor_factor[0] = (argc >= 6) ? (float)atof(argv[4]) : 0.0f;
+            geo.motor_factor[1] = (argc >= 6) ? (float)atof(argv[5]) : 0.0f;
+            chassis_kin_set_geometry(&geo);
+        }
+        else
+        {
+            rt_kprintf("Usage: odom [reset|geo <radius_m> <base_m> [factor1 factor2]]\n");
+            return;
+        }
+    }
+
+    chassis_kin_get_geometry(&geo);
+    chassis_kin_get_odom(&odom);
+    rt_kprintf("Odometry: x=%d mm, y=%d mm, yaw=%d mrad, v=%d mm/s, w=%d mrad/s (%u updates)\n",
+               (int)(odom.x * 1000), (int)(odom.y * 1000), (int)(odom.yaw * 1000),
+               (int)(odom.v * 1000), (int)(odom.w * 1000), odom.updates);
+    rt_kprintf("  geometry: radius=%d um, base=%d um, factor=%d/%d (x1000)\n",
+               (int)(geo.wheel_radius_m * 1e6f), (int)(geo.wheel_base_m * 1e6f),
+               (int)(geo.motor_factor[0] * 1000), (int)(geo.motor_factor[1] * 1000));
+}
+MSH_CMD_EXPORT_ALIAS(odom_cmd, odom, Show chassis odometry or set geometry);
+
+/**
+ * @brief MSH 命令: 按底盘速度设置目标值 (经过逆运动学)
+ *        用法: cmd_vel <v_mps> <w_radps>
+ */
+static int cmd_vel(int argc, char *argv[])
+{
+    float rps[MOTOR_PROTO_WHEELS];
+    int dir[MOTOR_PROTO_WHEELS];
+    int ch;
+
+    if (argc < 3)
+    {
+        rt_kprintf("Usage: cmd_vel <v_mps> <w_radps>\n");
+        return -1;
+    }
+
+    chassis_kin_inverse((float)atof(argv[1]), (float)atof(argv[2]), rps);
+    for (ch = 0; ch < MOTOR_PROTO_WHEELS; ch++)
+    {
+        dir[ch] = (rps[ch] > 0.0f) ? 1 : ((rps[ch] < 0.0f) ? 2 : 0);
+        rps[ch] = fabsf(rps[ch]);
+    }
+    chassis_set_target(dir[0], rps[0], dir[1], rps[1]);
+
+    rt_kprintf("[cmd_vel] left: dir=%d, speed=%d mr/s, right: dir=%d, speed=%d mr/s\n",
+               dir[0], (int)(rps[0] * 1000), dir[1], (int)(rps[1] * 1000));
+    return 0;
+}
+MSH_CMD_EXPORT(cmd_vel, Set chassis velocity in m / s and rad / s);
@@ -0,0 +1,335 @@
+/*
+ * 控制节拍模块
+ *
+ * 默认使用 RT_TIMER_FLAG_HARD_TIMER 周期定时器, 在时钟中断上下文中
+ * 释放订阅者信号量; 定义 CONTROL_TICK_HWTIMER_DEV 后改用硬件定时器设备,
+ * 频率不再受 RT_TICK_PER_SECOND 限制
+ *
+ * 频率切换在节拍中断中完成: 先改周期, 再更新 hz / dt / 版本号,
+ * 最后释放信号量, 订阅者被唤醒时看到的总是新旧之一的完整参数
+ */
+
+#include <rtthread.h>
+#include <rtdevice.h>
+#include <stdlib.h>
+#include "common.h"
+#include "control_tick.h"
+
+/* 订阅者信号量 */
+static rt_sem_t tick_subscribers[CONTROL_TICK_MAX_SUBSCRIBERS];
+static rt_uint32_t tick_subscriber_num = 0;
+
+/* 节拍参数 */
+static rt_uint32_t tick_hz = CONTROL_TICK_DEFAULT_HZ;
+static float tick_dt = 1.0f / CONTROL_TICK_DEFAULT_HZ;
+static volatile rt_uint32_t tick_generation = 0;
+static volatile rt_uint32_t tick_pending_hz = 0; /* 0 = 没有待切换的频率 */
+
+/* 统计 */
+static volatile rt_uint32_t tick_count = 0;
+static volatile rt_uint32_t tick_overruns = 0;
+
+static rt_bool_t tick_initialized = RT_FALSE;
+static rt_bool_t tick_started = RT_FALSE;
+
+#ifdef CONTROL_TICK_HWTIMER_DEV
+static rt_device_t tick_hwtimer = RT_NULL;
+#else
+static rt_timer_t tick_timer = RT_NULL;
+#endif
+
+/**
+ * @brief 限幅并按定时器分辨率取整
+ */
+static rt_uint32_t control_tick_round_hz(rt_uint32_t hz)
+{
+    if (hz < CONTROL_TICK_MIN_HZ)
+    {
+        hz = CONTROL_TICK_MIN_HZ;
+    }
+    else if (hz > CONTROL_TICK_MAX_HZ)
+    {
+        hz = CONTROL_TICK_MAX_HZ;
+    }
+
+#ifndef CONTROL_TICK_HWTIMER_DEV
+    /* rt_timer 以系统节拍为分辨率, 周期取整后重新计算实际频率 */
+    rt_tick_t period = RT_TICK_PER_SECOND / hz;
+    if (period == 0)
+    {
+        period = 1;
+    }
+    hz = RT_TICK_PER_SECOND / period;
+#endif
+    return hz;
+}
+
+/**
+ * @brief 切换到待生效的频率 (节拍中断中, 或启动前关中断调用)
+ *        周期从本节拍开始按新值计算
+ */
+static void control_tick_apply_rate(void)
+{
+    rt_uint32_t hz = tick_pending_hz;
+
+    if (hz == 0)
+    {
+        return;
+    }
+    tick_pending_hz = 0;
+    if (hz == tick_hz)
+    {
+        return;
+    }
+
+#ifdef CONTROL_TICK_HWTIMER_DEV
+    rt_hwtimer_t timeout;
+
+    timeout.sec = 0;
+    timeout.usec = 1000000 / hz;
+    if (tick_started)
+    {
+        /* 重新写入超时值即从当前时刻重新开始计时 */
+        rt_device_write(tick_hwtimer, 0, &timeout, sizeof(timeout));
+    }
+#else
+    rt_tick_t period = RT_TICK_PER_SECOND / hz;
+
+    /*
+     * 对运行中的定时器 SET_TIME 会把它从定时器链表中移除并清除 ACTIVATED 标志,
+     * 回调返回后不再重新启动 (RT-Thread 5.x), 所以先停止, 改周期后重新启动;
+     * 在回调中重新启动时从当前节拍开始按新周期计时
+     */
+    if (tick_started)
+    {
+        rt_timer_stop(tick_timer);
+    }
+    rt_timer_control(tick_timer, RT_TIMER_CTRL_SET_TIME, &period);
+    if (tick_started)
+    {
+        rt_timer_start(tick_timer);
+    }
+#endif
+
+    tick_hz = hz;
+    tick_dt = 1.0f / (float)hz;
+    tick_generation++;
+}
+
+/**
+ * @brief 节拍处理 (中断上下文)
+ *        订阅者信号量仍有值说明上一个节拍未被处理, 记为超时
+ */
+static void control_tick_fire(void)
+{
+    rt_uint32_t i;
+
+    control_tick_apply_rate();
+    tick_count++;
+
+    for (i = 0; i < tick_subscriber_num; i++)
+    {
+        if (tick_subscribers[i]->value > 0)
+        {
+            /* 不累积节拍, 订阅者只会处理最新的一个 */
+            tick_overruns++;
+            continue;
+        }
+        rt_sem_release(tick_subscribers[i]);
+    }
+}
+
+#ifdef CONTROL_TICK_HWTIMER_DEV
+static rt_err_t control_tick_hwtimer_cb(rt_device_t dev, rt_size_t size)
+{
+    (void)dev;
+    (void)size;
+    control_tick_fire();
+    return RT_EOK;
+}
+#else
+static void control_tick_timer_cb(void *parameter)
+{
+    (void)parameter;
+    control_tick_fire();
+}
+#endif
+
+/**
+ * @brief 初始化控制节拍
+ */
+rt_err_t control_tick_init(rt_uint32_t hz)
+{
+    if (tick_initialized)
+    {
+        return RT_EOK;
+    }
+
+    hz = control_tick_round_hz(hz);
+
+#ifdef CONTROL_TICK_HWTIMER_DEV
+    rt_hwtimer_mode_t mode = HWTIMER_MODE_PERIOD;
+
+    tick_hwtimer = rt_device_find(CONTROL_TICK_HWTIMER_DEV);
+    if (tick_hwtimer == RT_NULL)
+    {
+        rt_kprintf("[Tick] hwtimer '%s' not found!\n", CONTROL_TICK_HWTIMER_DEV);
+        return -RT_ENOSYS;
+    }
+    if (rt_device_open(tick_hwtimer, RT_DEVICE_OFLAG_RDWR) != RT_EOK)
+    {
+        rt_kprintf("[Tick] Failed to open hwtimer '%s'!\n", CONTROL_TICK_HWTIMER_DEV);
+        return -RT_ERROR;
+    }
+    rt_device_set_rx_indicate(tick_hwtimer, control_tick_hwtimer_cb);
+    rt_device_control(tick_hwtimer, HWTIMER_CTRL_MODE_SET, &mode);
+#else
+    tick_timer = rt_timer_create("ctl_tick", control_tick_timer_cb, RT_NULL,
+                                 RT_TICK_PER_SECOND / hz,
+                                 RT_TIMER_FLAG_PERIODIC | RT_TIMER_FLAG_HARD_TIMER);
+    if (tick_timer == RT_NULL)
+    {
+        rt_kprintf("[Tick] Failed to create timer!\n");
+        return -RT_ERROR;
+    }
+#endif
+
+    tick_hz = hz;
+    tick_dt = 1.0f / (float)hz;
+    tick_initialized = RT_TRUE;
+
+    rt_kprintf("[Tick] Init OK (%dHz)\n", tick_hz);
+    return RT_EOK;
+}
+
+/**
+ * @brief 启动控制节拍
+ */
+rt_err_t control_tick_start(void)
+{
+    if (!tick_initialized)
+    {
+        return -RT_ERROR;
+    }
+
+#ifdef CONTROL_TICK_HWTIMER_DEV
+    rt_hwtimer_t timeout;
+
+    timeout.sec = 0;
+    timeout.usec = 1000000 / tick_hz;
+    if (rt_device_write(tick_hwtimer, 0, &timeout, sizeof(timeout)) != sizeof(timeout))
+    {
+        rt_kprintf("[Tick] Failed to start hwtimer!\n");
+        return -RT_ERROR;
+    }
+#else
+    if (rt_timer_start(tick_timer) != RT_EOK)
+    {
+        rt_kprintf("[Tick] Failed to start timer!\n");
+        return -RT_ERROR;
+    }
+#endif
+
+    tick_started = RT_TRUE;
+    rt_kprintf("[Tick] Started (%dHz, %d subscribers)\n", tick_hz, tick_subscriber_num);
+    return RT_EOK;
+}
+
+/**
+ * @brief 运行中修改控制频率
+ */
+rt_uint32_t control_tick_set_hz(rt_uint32_t hz)
+{
+    rt_base_t level;
+
+    if (!tick_initialized)
+    {
+        return 0;
+    }
+
+    hz = control_tick_round_hz(hz);
+    level = rt_hw_interrupt_disable();
+    tick_pending_hz = hz;
+    if (!tick_started)
+    {
+        control_tick_apply_rate();
+    }
+    rt_hw_interrupt_enable(level);
+    return hz;
+}
+
+rt_uint32_t control_tick_get_generation(void)
+{
+    return tick_generation;
+}
+
+/**
+ * @brief 订阅控制节拍
+ */
+rt_err_t control_tick_attach(rt_sem_t sem)
+{
+    rt_base_t level;
+
+    if (sem == RT_NULL)
+    {
+        return -RT_EINVAL;
+    }
+
+    level = rt_hw_interrupt_disable();
+    if (tick_subscriber_num >= CONTROL_TICK_MAX_SUBSCRIBERS)
+    {
+        rt_hw_interrupt_enable(level);
+        rt_kprintf("[Tick] Too many subscribers!\n");
+        return -RT_EFULL;
+    }
+    tick_subscribers[tick_subscriber_num++] = sem;
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+
+rt_uint32_t control_tick_get_hz(void)
+{
+    return tick_hz;
+}
+
+float control_tick_get_dt(void)
+{
+    return tick_dt;
+}
+
+rt_uint32_t control_tick_get_count(void)
+{
+    return tick_count;
+}
+
+rt_uint32_t control_tick_get_overruns(void)
+{
+    return tick_overruns;
+}
+
+/* ================= 调试用 MSH 命令 ================= */
+
+/**
+ * @brief MSH 命令: 查看控制节拍状态 / 修改控制频率
+ *        用法: ctrl_tick [hz <n>]
+ */
+static void ctrl_tick_cmd(int argc, char *argv[])
+{
+    if (argc >= 3 && rt_strcmp(argv[1], "hz") == 0)
+    {
+        rt_kprintf("Control tick: switching to %dHz at the next tick\n",
+                   control_tick_set_hz((rt_uint32_t)atoi(argv[2])));
+        return;
+    }
+    if (argc >= 2)
+    {
+        rt_kprintf("Usage: ctrl_tick [hz <%d-%d>]\n", CONTROL_TICK_MIN_HZ, CONTROL_TICK_MAX_HZ);
+        return;
+    }
+
+    rt_kprintf("Control tick: %dHz, dt=%dus, count=%u, overruns=%u, subscribers=%d, rate gen=%u\n",
+               tick_hz, (int)(tick_dt * 1000000), tick_count, tick_overruns,
+               tick_subscriber_num, tick_generation);
+}
+MSH_CMD_EXPORT_ALIAS(ctrl_tick_cmd, ctrl_tick, Show control tick status or change the rate);
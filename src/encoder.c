@@ -1,115 +1,215 @@
 /*
  * 编码器模块 (防抖版)
  *
- * 通过 GPIO 中断计数霍尔编码器脉冲
- * 只使用 A 相，使用状态机消除信号抖动
+ * 通过 GPIO 中断计数霍尔编码器脉冲, 引脚取自轴描述表, 状态按轴下标存放
+ * 默认只使用 A 相，使用状态机消除信号抖动
  * 只有完整的 上升沿 -> 下降沿 才计为一个脉冲
+ *
+ * 定义 ENCODER_USING_QUADRATURE 时使用 A/B 两相 4 倍频正交解码:
+ * A/B 任一边沿查表得到 +1/-1/0, 有符号计数, 可识别反转和被动转动,
+ * 非法跳变 (两相同时变化) 查表为 0, 天然抑制抖动
+ *
+ * 测速:
+ * - M 法: 窗口内脉冲数 / 窗口时间, 高速时精度高
+ * - T 法: 中断中用高精度计数器记录完整脉冲的边沿时刻, 速度 = 1 / 脉冲周期, 低速时精度高
+ * - 自动: 按窗口内脉冲数在两者之间线性过渡
  */
 
 #include <rtthread.h>
 #include <rtdevice.h>
 #include "common.h"
+#include "control_tick.h"
 #include "encoder.h"
-
-static rt_int32_t encoder_interval_ms = ENCODER_INTERVAL_MS; /* 编码器读取线程周期 (ms) */
+#include "hrtime.h"
+#include "motor_axis.h"
+#include "profiler.h"
+#include "seqlock.h"
 
 /* 编码器计数器 (无符号，只累加) */
-static volatile rt_uint32_t encoder1_count = 0;
-static volatile rt_uint32_t encoder2_count = 0;
+static volatile rt_uint32_t encoder_count[MOTOR_AXIS_NUM];
 
 /* 上一次读取时的计数值 (用于计算增量) */
-static rt_uint32_t encoder1_last_count = 0;
-static rt_uint32_t encoder2_last_count = 0;
+static rt_uint32_t encoder_last_count[MOTOR_AXIS_NUM];
 
 /* 状态机：是否已检测到上升沿 (用于消抖) */
-static volatile rt_bool_t encoder1_has_rising = RT_FALSE;
-static volatile rt_bool_t encoder2_has_rising = RT_FALSE;
+static volatile rt_bool_t encoder_has_rising[MOTOR_AXIS_NUM];
+
+/* T 法测周: 最近一个完整脉冲的时刻和周期 (hrtime 计数) */
+static volatile rt_uint64_t encoder_edge_time[MOTOR_AXIS_NUM];
+static volatile rt_uint64_t encoder_edge_period[MOTOR_AXIS_NUM];
+
+#ifdef ENCODER_USING_QUADRATURE
+/* 正交解码状态 (一个轴的 A/B 相中断共用) */
+struct encoder_quad
+{
+    rt_base_t pin_a;
+    rt_base_t pin_b;
+    volatile rt_uint8_t state;        /* 上一次 (A << 1) | B */
+    volatile rt_int32_t count;        /* 有符号计数 */
+    volatile rt_uint64_t edge_time;   /* 最近一次有效跳变时刻 */
+    volatile rt_uint64_t edge_period; /* 最近两次有效跳变间隔 */
+};
+
+static struct encoder_quad encoder_quad[MOTOR_AXIS_NUM];
+
+/*
+ * 4 倍频查表: 下标 = (上一状态 << 2) | 当前状态
+ * 正转序列 (A 超前 B): 00 -> 10 -> 11 -> 01 -> 00, 每步 +1
+ */
+static const rt_int8_t encoder_quad_table[16] = {
+     0, -1, +1,  0,
+    +1,  0,  0, -1,
+    -1,  0,  0, +1,
+     0, +1, -1,  0,
+};
+
+#define ENCODER_COUNTS_PER_PULSE 4
+#else
+#define ENCODER_COUNTS_PER_PULSE 1
+#endif
 
 /* 初始化标志 */
-static rt_bool_t encoder1_initialized = RT_FALSE;
-static rt_bool_t encoder2_initialized = RT_FALSE;
+static rt_bool_t encoder_initialized[MOTOR_AXIS_NUM];
 
+#ifndef ENCODER_USING_QUADRATURE
 /**
- * @brief 编码器1 A相中断回调
+ * @brief 编码器 A相中断回调 (各轴共用)
  *        使用状态机消抖：上升沿 + 下降沿 = 一个完整脉冲
+ * @param args 轴号
  */
-static void encoder1_a_irq_callback(void *args)
+static void encoder_a_irq_callback(void *args)
 {
-    (void)args;
-    rt_uint8_t level = rt_pin_read(ENCODER_GPIO_MOTOR1_A);
+    int axis = (int)(rt_ubase_t)args;
+    rt_uint8_t level = rt_pin_read(motor_axis_table[axis].enc_pin_a);
 
     if (level) /* 高电平 = 上升沿 */
     {
-        encoder1_has_rising = RT_TRUE;
+        encoder_has_rising[axis] = RT_TRUE;
     }
     else /* 低电平 = 下降沿 */
     {
-        if (encoder1_has_rising)
+        if (encoder_has_rising[axis])
         {
-            encoder1_count++;
-            encoder1_has_rising = RT_FALSE;
+            rt_uint64_t now = hrtime_now();
+
+            /* 第一个脉冲没有上一个边沿, 周期记为 0 (无效) */
+            encoder_edge_period[axis] = encoder_edge_time[axis] ? now - encoder_edge_time[axis] : 0;
+            encoder_edge_time[axis] = now;
+            encoder_count[axis]++;
+            encoder_has_rising[axis] = RT_FALSE;
         }
     }
 }
+#endif
 
+#ifdef ENCODER_USING_QUADRATURE
 /**
- * @brief 编码器2 A相中断回调
- *        使用状态机消抖：上升沿 + 下降沿 = 一个完整脉冲
+ * @brief 正交编码器 A/B 相中断回调 (两相共用)
+ * @param args 对应的 struct encoder_quad
  */
-static void encoder2_a_irq_callback(void *args)
+static void encoder_quad_irq_callback(void *args)
 {
-    (void)args;
-    rt_uint8_t level = rt_pin_read(ENCODER_GPIO_MOTOR2_A);
+    struct encoder_quad *q = (struct encoder_quad *)args;
+    rt_uint8_t state = (rt_pin_read(q->pin_a) ? 2 : 0) | (rt_pin_read(q->pin_b) ? 1 : 0);
+    rt_int8_t step = encoder_quad_table[(q->state << 2) | state];
 
-    if (level) /* 高电平 = 上升沿 */
+    q->state = state;
+    if (step != 0)
     {
-        encoder2_has_rising = RT_TRUE;
+        rt_uint64_t now = hrtime_now();
+
+        q->edge_period = q->edge_time ? now - q->edge_time : 0;
+        q->edge_time = now;
+        q->count += step;
     }
-    else /* 低电平 = 下降沿 */
-    {
-        if (encoder2_has_rising)
-        {
-            encoder2_count++;
-            encoder2_has_rising = RT_FALSE;
+}
 
-        }
+/**
+ * @brief 初始化一个正交编码器 (A/B 相双边沿中断)
+ */
+static rt_err_t encoder_quad_init(struct encoder_quad *q, int id)
+{
+    rt_err_t ret = RT_EOK;
+
+    rt_pin_mode(q->pin_a, PIN_MODE_INPUT_PULLUP);
+    rt_pin_mode(q->pin_b, PIN_MODE_INPUT_PULLUP);
+
+    q->state = (rt_pin_read(q->pin_a) ? 2 : 0) | (rt_pin_read(q->pin_b) ? 1 : 0);
+    q->count = 0;
+    q->edge_time = 0;
+    q->edge_period = 0;
+
+    if (rt_pin_attach_irq(q->pin_a, PIN_IRQ_MODE_RISING_FALLING, encoder_quad_irq_callback, q) != RT_EOK ||
+        rt_pin_attach_irq(q->pin_b, PIN_IRQ_MODE_RISING_FALLING, encoder_quad_irq_callback, q) != RT_EOK ||
+        rt_pin_irq_enable(q->pin_a, PIN_IRQ_ENABLE) != RT_EOK ||
+        rt_pin_irq_enable(q->pin_b, PIN_IRQ_ENABLE) != RT_EOK)
+    {
+        rt_kprintf("[Encoder%d] WARNING: quadrature IRQ setup may have failed!\n", id);
+        ret = -RT_ERROR;
     }
+
+    rt_kprintf("[Encoder%d] Init OK (quadrature A=GPIO%d B=GPIO%d)\n", id,
+               (int)q->pin_a, (int)q->pin_b);
+    return ret;
 }
+#endif
 
 /**
- * @brief 初始化编码器1
+ * @brief 初始化一个轴的编码器
+ * @param axis 轴号 (0 ~ MOTOR_AXIS_NUM-1)
  */
-rt_err_t encoder1_init(void)
+rt_err_t encoder_axis_init(int axis)
 {
-    if (encoder1_initialized)
+    const struct motor_axis_desc *desc;
+
+    if (!MOTOR_AXIS_VALID(axis))
+    {
+        return -RT_EINVAL;
+    }
+    if (encoder_initialized[axis])
     {
         return RT_EOK;
     }
-
+    desc = &motor_axis_table[axis];
+
+#ifdef ENCODER_USING_QUADRATURE
+    encoder_last_count[axis] = 0;
+    encoder_initialized[axis] = RT_TRUE;
+    encoder_quad[axis].pin_a = desc->enc_pin_a;
+    encoder_quad[axis].pin_b = desc->enc_pin_b;
+    return encoder_quad_init(&encoder_quad[axis], axis + 1);
+#else
     /* 配置 A 相为输入模式 (内部上拉) */
-    rt_pin_mode(ENCODER_GPIO_MOTOR1_A, PIN_MODE_INPUT_PULLUP);
-
-    /* 绑定 A 相中断，双边沿触发 */
-    rt_err_t attach_ret = rt_pin_attach_irq(ENCODER_GPIO_MOTOR1_A, PIN_IRQ_MODE_RISING_FALLING,
-                                            encoder1_a_irq_callback, RT_NULL);
-    rt_kprintf("[Encoder1] rt_pin_attach_irq returned: %d\n", attach_ret);
+    rt_pin_mode(desc->enc_pin_a, PIN_MODE_INPUT_PULLUP);
 
-    rt_err_t enable_ret = rt_pin_irq_enable(ENCODER_GPIO_MOTOR1_A, PIN_IRQ_ENABLE);
-    rt_kprintf("[Encoder1] rt_pin_irq_enable returned: %d\n", enable_ret);
+    /* 绑定 A 相中断，双边沿触发, 回调参数为轴号 */
+    rt_err_t attach_ret = rt_pin_attach_irq(desc->enc_pin_a, PIN_IRQ_MODE_RISING_FALLING,
+                                            encoder_a_irq_callback, (void *)(rt_ubase_t)axis);
+    rt_err_t enable_ret = rt_pin_irq_enable(desc->enc_pin_a, PIN_IRQ_ENABLE);
 
     if (attach_ret != RT_EOK || enable_ret != RT_EOK)
     {
-        rt_kprintf("[Encoder1] WARNING: IRQ setup may have failed!\n");
+        rt_kprintf("[Encoder%d] WARNING: IRQ setup may have failed! (attach=%d, enable=%d)\n",
+                   axis + 1, attach_ret, enable_ret);
     }
 
-    encoder1_count = 0;
-    encoder1_last_count = 0;
-    encoder1_has_rising = RT_FALSE;
-    encoder1_initialized = RT_TRUE;
+    encoder_count[axis] = 0;
+    encoder_last_count[axis] = 0;
+    encoder_has_rising[axis] = RT_FALSE;
+    encoder_initialized[axis] = RT_TRUE;
 
-    rt_kprintf("[Encoder1] Init OK (A=GPIO%d)\n", ENCODER_GPIO_MOTOR1_A);
+    rt_kprintf("[Encoder%d] Init OK (A=GPIO%d)\n", axis + 1, (int)desc->enc_pin_a);
 
     return RT_EOK;
+#endif
+}
+
+/**
+ * @brief 初始化编码器1
+ */
+rt_err_t encoder1_init(void)
+{
+    return encoder_axis_init(0);
 }
 
 /**
@@ -117,98 +217,317 @@ rt_err_t encoder1_init(void)
  */
 rt_err_t encoder2_init(void)
 {
-    if (encoder2_initialized)
-    {
-        return RT_EOK;
-    }
-
-    /* 配置 A 相为输入模式 (内部上拉) */
-    rt_pin_mode(ENCODER_GPIO_MOTOR2_A, PIN_MODE_INPUT_PULLUP);
-
-    /* 绑定 A 相中断，双边沿触发 */
-    rt_pin_attach_irq(ENCODER_GPIO_MOTOR2_A, PIN_IRQ_MODE_RISING_FALLING, encoder2_a_irq_callback, RT_NULL);
-    rt_pin_irq_enable(ENCODER_GPIO_MOTOR2_A, PIN_IRQ_ENABLE);
-
-    encoder2_count = 0;
-    encoder2_last_count = 0;
-    encoder2_has_rising = RT_FALSE;
-    encoder2_initialized = RT_TRUE;
+    return encoder_axis_init(1);
+}
 
-    rt_kprintf("[Encoder2] Init OK (A=GPIO%d)\n", ENCODER_GPIO_MOTOR2_A);
+/**
+ * @brief 初始化所有编码器
+ */
+rt_err_t encoders_init(void)
+{
+    int i;
 
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
+    {
+        encoder_axis_init(i);
+    }
     return RT_EOK;
 }
 
 /**
- * @brief 初始化两个编码器
+ * @brief 获取有符号累计计数 (正交模式下正转递增、反转递减)
  */
-rt_err_t encoders_init(void)
+rt_int32_t encoder_axis_get_signed_count(int axis)
 {
-    encoder1_init();
-    encoder2_init();
-    return RT_EOK;
+    if (!MOTOR_AXIS_VALID(axis))
+    {
+        return 0;
+    }
+#ifdef ENCODER_USING_QUADRATURE
+    return encoder_quad[axis].count;
+#else
+    return (rt_int32_t)encoder_count[axis];
+#endif
+}
+
+/**
+ * @brief 获取累计脉冲数 (正交模式下为有符号计数的补码)
+ */
+rt_uint32_t encoder_axis_get_count(int axis)
+{
+    return (rt_uint32_t)encoder_axis_get_signed_count(axis);
 }
 
 /**
- * @brief 获取编码器1在一个周期内的脉冲增量
+ * @brief 获取一个周期内的脉冲增量
+ *        与采样器共用 last_count, 采样器运行时请使用 encoder_get_sample()
  * @return 自上次调用以来的脉冲增量
  */
-rt_uint32_t encoder1_get_delta(void)
+rt_uint32_t encoder_axis_get_delta(int axis)
 {
-    rt_uint32_t current = encoder1_count;
-    rt_uint32_t delta = current - encoder1_last_count;
-    encoder1_last_count = current;
+    rt_uint32_t current, delta;
+
+    if (!MOTOR_AXIS_VALID(axis))
+    {
+        return 0;
+    }
+    current = encoder_axis_get_count(axis);
+    delta = current - encoder_last_count[axis];
+    encoder_last_count[axis] = current;
 
     return delta;
 }
 
 /**
- * @brief 获取编码器2在一个周期内的脉冲增量
- * @return 自上次调用以来的脉冲增量
+ * @brief 重置一个轴的编码器计数
  */
+void encoder_axis_reset(int axis)
+{
+    rt_base_t level;
+
+    if (!MOTOR_AXIS_VALID(axis))
+    {
+        return;
+    }
+
+    level = rt_hw_interrupt_disable();
+    encoder_count[axis] = 0;
+    encoder_last_count[axis] = 0;
+    encoder_has_rising[axis] = RT_FALSE;
+    encoder_edge_time[axis] = 0;
+    encoder_edge_period[axis] = 0;
+#ifdef ENCODER_USING_QUADRATURE
+    encoder_quad[axis].count = 0;
+    encoder_quad[axis].edge_time = 0;
+    encoder_quad[axis].edge_period = 0;
+#endif
+    rt_hw_interrupt_enable(level);
+}
+
+/* 电机1/电机2 兼容接口 (轴 0/轴 1) */
+
+rt_uint32_t encoder1_get_count(void)
+{
+    return encoder_axis_get_count(0);
+}
+
+rt_int32_t encoder1_get_signed_count(void)
+{
+    return encoder_axis_get_signed_count(0);
+}
+
+rt_uint32_t encoder2_get_count(void)
+{
+    return encoder_axis_get_count(1);
+}
+
+rt_int32_t encoder2_get_signed_count(void)
+{
+    return encoder_axis_get_signed_count(1);
+}
+
+rt_uint32_t encoder1_get_delta(void)
+{
+    return encoder_axis_get_delta(0);
+}
+
 rt_uint32_t encoder2_get_delta(void)
 {
-    rt_uint32_t current = encoder2_count;
-    rt_uint32_t delta = current - encoder2_last_count;
-    encoder2_last_count = current;
+    return encoder_axis_get_delta(1);
+}
 
-    return delta;
+void encoder1_reset(void)
+{
+    encoder_axis_reset(0);
 }
 
-/* ================= 编码器读取线程 ================= */
+void encoder2_reset(void)
+{
+    encoder_axis_reset(1);
+}
+
+/**
+ * @brief 重置所有编码器计数
+ */
+void encoders_reset(void)
+{
+    int i;
+
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
+    {
+        encoder_axis_reset(i);
+    }
+}
 
-#define ENCODER1_THREAD_STACK_SIZE  2048
-#define ENCODER1_THREAD_PRIORITY    8
-#define ENCODER1_THREAD_TIMESLICE   5
+/* ================= 编码器采样器 ================= */
 
-#define ENCODER2_THREAD_STACK_SIZE  2048
-#define ENCODER2_THREAD_PRIORITY    8
-#define ENCODER2_THREAD_TIMESLICE   5
+#define ENCODER_THREAD_STACK_SIZE  2048
+#define ENCODER_THREAD_PRIORITY    8
+#define ENCODER_THREAD_TIMESLICE   5
 
-static rt_thread_t encoder1_thread = RT_NULL;
-static rt_thread_t encoder2_thread = RT_NULL;
+#ifndef ENCODER_SAMPLE_INLINE
+static rt_thread_t encoder_thread = RT_NULL;
 
-/* 共享的速度值 (转/秒)，供底盘控制线程读取 */
-static volatile float shared_speed1 = 0.0f;
-static volatile float shared_speed2 = 0.0f;
+/* 控制节拍信号量 (每个节拍采样一次) */
+static rt_sem_t encoder_tick_sem = RT_NULL;
+#endif
 
 /* 动态减速比配置 */
 static volatile float encoder_reduction_ratio = MOTOR_REDUCTION_RATIO;
 
-/* 共享的 delta 值 (保留用于调试) */
-static volatile rt_uint32_t shared_delta1 = 0;
-static volatile rt_uint32_t shared_delta2 = 0;
+/* 最新一次采样结果, 由 seqlock 保护 */
+static struct encoder_sample shared_sample;
+static seqlock_t sample_lock = SEQLOCK_INIT;
+
+/* 上次采样时间 (所有编码器共用) */
+static rt_tick_t encoder_last_tick = 0;
+static rt_uint64_t encoder_last_hrtime = 0;
+
+/* 测速模式 */
+static volatile int encoder_speed_mode = ENCODER_SPEED_MODE_DEFAULT;
+
+/**
+ * @brief 估算单个编码器转速 (转/秒)
+ * @param delta 窗口内脉冲数
+ * @param window_s 窗口时间 (秒)
+ * @param period 最近一个完整脉冲的周期 (hrtime 计数, 0 表示无效)
+ * @param since_edge 距最近一个脉冲的时间 (hrtime 计数)
+ */
+static float encoder_estimate_speed(rt_uint32_t delta, float window_s,
+                                    rt_uint64_t period, rt_uint64_t since_edge)
+{
+    float pulses_per_rev = MOTOR_ENCODER_PPR * ENCODER_COUNTS_PER_PULSE * encoder_reduction_ratio;
+    float m_speed, t_speed, weight;
+    int mode = encoder_speed_mode;
+
+    m_speed = (float)delta / (pulses_per_rev * window_s);
+    if (mode == ENCODER_SPEED_MODE_M)
+    {
+        return m_speed;
+    }
+
+    /* T 法: 超过超时时间没有脉冲认为已停止;
+     * 减速时距上次边沿的时间会超过上一个周期, 以它作为周期上界 */
+    t_speed = 0.0f;
+    if (period != 0 && since_edge < hrtime_from_us(ENCODER_T_TIMEOUT_MS * 1000))
+    {
+        if (since_edge > period)
+        {
+            period = since_edge;
+        }
+        t_speed = 1.0f / (pulses_per_rev * hrtime_to_sec(period));
+    }
+    if (mode == ENCODER_SPEED_MODE_T)
+    {
+        return t_speed;
+    }
+
+    /* 自动: 脉冲少用 T 法, 脉冲多用 M 法, 中间线性过渡 */
+    if (delta <= ENCODER_MT_LOW_PULSES)
+    {
+        return t_speed;
+    }
+    if (delta >= ENCODER_MT_HIGH_PULSES)
+    {
+        return m_speed;
+    }
+    weight = (float)(delta - ENCODER_MT_LOW_PULSES) /
+             (float)(ENCODER_MT_HIGH_PULSES - ENCODER_MT_LOW_PULSES);
+    return weight * m_speed + (1.0f - weight) * t_speed;
+}
+
+/**
+ * @brief 执行一次采样
+ *        关中断同时读取所有计数器, 各轴使用同一个时间戳和窗口
+ */
+void encoder_sample_update(void)
+{
+    struct encoder_sample sample;
+    rt_uint32_t count[MOTOR_AXIS_NUM];
+    rt_uint64_t edge_time[MOTOR_AXIS_NUM], period[MOTOR_AXIS_NUM];
+    rt_uint64_t hr_now, hr_window;
+    rt_tick_t now, elapsed;
+    rt_base_t level;
+    float window_s;
+    int i;
+
+    level = rt_hw_interrupt_disable();
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
+    {
+#ifdef ENCODER_USING_QUADRATURE
+        count[i] = (rt_uint32_t)encoder_quad[i].count;
+        edge_time[i] = encoder_quad[i].edge_time;
+        period[i] = encoder_quad[i].edge_period;
+#else
+        count[i] = encoder_count[i];
+        edge_time[i] = encoder_edge_time[i];
+        period[i] = encoder_edge_period[i];
+#endif
+    }
+    hr_now = hrtime_now();
+    now = rt_tick_get();
+    rt_hw_interrupt_enable(level);
+
+    /* 采样窗口, 漏掉控制节拍时按实际窗口计算 */
+    elapsed = now - encoder_last_tick;
+    encoder_last_tick = now;
+    if (elapsed == 0)
+    {
+        elapsed = 1;
+    }
+
+    hr_window = hr_now - encoder_last_hrtime;
+    encoder_last_hrtime = hr_now;
+    window_s = hrtime_to_sec(hr_window);
+    if (window_s <= 0.0f)
+    {
+        window_s = (float)elapsed / RT_TICK_PER_SECOND;
+    }
 
-/* 上次采样时间 (每个编码器独立) */
-static rt_tick_t encoder1_last_tick = 0;
-static rt_tick_t encoder2_last_tick = 0;
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
+    {
+        /* 无符号回绕相减后转为有符号, A 相模式下始终为正 */
+        sample.sdelta[i] = (rt_int32_t)(count[i] - encoder_last_count[i]);
+        sample.delta[i] = sample.sdelta[i] < 0 ? (rt_uint32_t)-sample.sdelta[i]
+                                               : (rt_uint32_t)sample.sdelta[i];
+        encoder_last_count[i] = count[i];
+
+        sample.speed[i] = encoder_estimate_speed(sample.delta[i], window_s, period[i],
+                                                 hr_now - edge_time[i]);
+        sample.sspeed[i] = sample.sdelta[i] < 0 ? -sample.speed[i] : sample.speed[i];
+    }
+    sample.tick = now;
+    sample.window = elapsed;
+    sample.hr_time = hr_now;
+
+    level = seqlock_write_begin(&sample_lock);
+    sample.seq = shared_sample.seq + 1;
+    shared_sample = sample;
+    seqlock_write_end(&sample_lock, level);
+}
+
+/**
+ * @brief 获取最新一次采样结果 (无锁)
+ */
+void encoder_get_sample(struct encoder_sample *out)
+{
+    rt_uint32_t seq;
+
+    do
+    {
+        seq = seqlock_read_begin(&sample_lock);
+        *out = shared_sample;
+    } while (seqlock_read_retry(&sample_lock, seq));
+}
 
 /**
  * @brief 获取共享的速度1 (转/秒)
  */
 float encoder_get_shared_speed1(void)
 {
-    return shared_speed1;
+    struct encoder_sample sample;
+    encoder_get_sample(&sample);
+    return sample.speed[0];
 }
 
 /**
@@ -216,7 +535,29 @@ float encoder_get_shared_speed1(void)
  */
 float encoder_get_shared_speed2(void)
 {
-    return shared_speed2;
+    struct encoder_sample sample;
+    encoder_get_sample(&sample);
+    return sample.speed[1];
+}
+
+/**
+ * @brief 获取共享的有符号速度1 (转/秒, 正交模式下负值表示反转)
+ */
+float encoder_get_signed_speed1(void)
+{
+    struct encoder_sample sample;
+    encoder_get_sample(&sample);
+    return sample.sspeed[0];
+}
+
+/**
+ * @brief 获取共享的有符号速度2 (转/秒, 正交模式下负值表示反转)
+ */
+float encoder_get_signed_speed2(void)
+{
+    struct encoder_sample sample;
+    encoder_get_sample(&sample);
+    return sample.sspeed[1];
 }
 
 /**
@@ -234,167 +575,159 @@ void encoder_set_reduction_ratio(float ratio)
 }
 
 /**
- * @brief 获取共享的 delta1 值 (用于调试)
+ * @brief 轮子每转计数
  */
-rt_uint32_t encoder_get_shared_delta1(void)
+float encoder_get_counts_per_rev(void)
 {
-    return shared_delta1;
+    return MOTOR_ENCODER_PPR * ENCODER_COUNTS_PER_PULSE * encoder_reduction_ratio;
 }
 
 /**
- * @brief 获取共享的 delta2 值 (用于调试)
+ * @brief 设置测速模式
  */
-rt_uint32_t encoder_get_shared_delta2(void)
+void encoder_set_speed_mode(int mode)
 {
-    return shared_delta2;
+    if (mode < ENCODER_SPEED_MODE_M || mode > ENCODER_SPEED_MODE_AUTO)
+    {
+        return;
+    }
+    encoder_speed_mode = mode;
 }
 
 /**
- * @brief 编码器1读取线程入口函数
- *        以 20Hz 频率读取编码器1脉冲增量，计算速度（转/秒）
+ * @brief 获取测速模式
  */
-static void encoder1_thread_entry(void *parameter)
+int encoder_get_speed_mode(void)
 {
-    (void)parameter;
-
-    encoder1_last_tick = rt_tick_get();  /* 上次采样时间 */
-
-    while (1)
-    {
-        /* 读取 delta 值 */
-        rt_uint32_t delta1 = encoder1_get_delta();
-
-        // rt_kprintf("[Encoder] Delta1=%u\n", delta1);
-
-        /* 计算实际采样间隔 (毫秒) */
-        rt_tick_t now = rt_tick_get();
-        rt_uint32_t elapsed_ms = (now - encoder1_last_tick) * 1000 / RT_TICK_PER_SECOND;
-        encoder1_last_tick = now;
-
-        /* 计算速度 (转/秒) = delta / PPR / 减速比 / (elapsed_ms / 1000) */
-
-        if (elapsed_ms == 0)
-        {
-            elapsed_ms = 1;
-        }
-
-        shared_speed1 = (float)delta1 * 1000.0f /
-                        (MOTOR_ENCODER_PPR * encoder_reduction_ratio * elapsed_ms);
-
-        /* 保存 delta 用于调试 */
-        shared_delta1 = delta1;
-
-        rt_thread_mdelay(encoder_interval_ms);
-    }
+    return encoder_speed_mode;
 }
 
 /**
- * @brief 编码器2读取线程入口函数
- *        以 20Hz 频率读取编码器2脉冲增量，计算速度（转/秒）
+ * @brief 获取共享的 delta1 值 (用于调试)
  */
-static void encoder2_thread_entry(void *parameter)
+rt_uint32_t encoder_get_shared_delta1(void)
 {
-    (void)parameter;
-
-    encoder2_last_tick = rt_tick_get();  /* 上次采样时间 */
-
-    while (1)
-    {
-        /* 读取 delta 值 */
-        rt_uint32_t delta2 = encoder2_get_delta();
-
-        // rt_kprintf("[Encoder] Delta2=%u\n", delta2);
-
-        /* 计算实际采样间隔 (毫秒) */
-        rt_tick_t now = rt_tick_get();
-        rt_uint32_t elapsed_ms = (now - encoder2_last_tick) * 1000 / RT_TICK_PER_SECOND;
-        encoder2_last_tick = now;
-
-        /* 计算速度 (转/秒) = delta / PPR / 减速比 / (elapsed_ms / 1000) */
-        if (elapsed_ms == 0)
-        {
-            elapsed_ms = 1;
-        }
-
-        shared_speed2 = (float)delta2 * 1000.0f /
-                        (MOTOR_ENCODER_PPR * encoder_reduction_ratio * elapsed_ms);
-
-        /* 保存 delta 用于调试 */
-        shared_delta2 = delta2;
+    struct encoder_sample sample;
+    encoder_get_sample(&sample);
+    return sample.delta[0];
+}
 
-        rt_thread_mdelay(encoder_interval_ms);
-    }
+/**
+ * @brief 获取共享的 delta2 值 (用于调试)
+ */
+rt_uint32_t encoder_get_shared_delta2(void)
+{
+    struct encoder_sample sample;
+    encoder_get_sample(&sample);
+    return sample.delta[1];
 }
 
 /**
- * @brief 启动编码器1线程
- * @return RT_EOK 成功, -RT_ERROR 失败
+ * @brief 调用一次中断回调并返回其耗时 (基准测试用)
+ *        关中断执行, 调用前后保存/恢复该轴计数状态, 不影响测速;
+ *        A 相模式预置上升沿标志, 引脚为低电平时走完整的计数分支
+ * @return 回调耗时 (hrtime 计数)
  */
-static rt_err_t encoder1_thread_start(void)
+rt_uint64_t encoder_bench_isr(int axis)
 {
-    encoder1_thread = rt_thread_create("enc1",
-                                       encoder1_thread_entry,
-                                       RT_NULL,
-                                       ENCODER1_THREAD_STACK_SIZE,
-                                       ENCODER1_THREAD_PRIORITY,
-                                       ENCODER1_THREAD_TIMESLICE);
-    if (encoder1_thread != RT_NULL)
-    {
-        rt_thread_startup(encoder1_thread);
-        rt_kprintf("[Encoder1] Thread started (%dHz)\n", 1000 / encoder_interval_ms);
-        return RT_EOK;
-    }
-    else
-    {
-        rt_kprintf("[Encoder1] Failed to create thread!\n");
-        return -RT_ERROR;
-    }
+    rt_uint64_t t0, t1;
+    rt_base_t level;
+#ifdef ENCODER_USING_QUADRATURE
+    struct encoder_quad saved;
+
+    level = rt_hw_interrupt_disable();
+    saved = encoder_quad[axis];
+    t0 = hrtime_now();
+    encoder_quad_irq_callback(&encoder_quad[axis]);
+    t1 = hrtime_now();
+    encoder_quad[axis] = saved;
+    rt_hw_interrupt_enable(level);
+#else
+    rt_uint32_t count;
+    rt_bool_t has_rising;
+    rt_uint64_t edge_time, edge_period;
+
+    level = rt_hw_interrupt_disable();
+    count = encoder_count[axis];
+    has_rising = encoder_has_rising[axis];
+    edge_time = encoder_edge_time[axis];
+    edge_period = encoder_edge_period[axis];
+    encoder_has_rising[axis] = RT_TRUE;
+    t0 = hrtime_now();
+    encoder_a_irq_callback((void *)(rt_ubase_t)axis);
+    t1 = hrtime_now();
+    encoder_count[axis] = count;
+    encoder_has_rising[axis] = has_rising;
+    encoder_edge_time[axis] = edge_time;
+    encoder_edge_period[axis] = edge_period;
+    rt_hw_interrupt_enable(level);
+#endif
+
+    return t1 - t0;
 }
 
+#ifndef ENCODER_SAMPLE_INLINE
 /**
- * @brief 启动编码器2线程
- * @return RT_EOK 成功, -RT_ERROR 失败
+ * @brief 编码器采样线程入口函数
+ *        每个控制节拍对所有编码器采样一次
  */
-static rt_err_t encoder2_thread_start(void)
+static void encoder_thread_entry(void *parameter)
 {
-    encoder2_thread = rt_thread_create("enc2",
-                                       encoder2_thread_entry,
-                                       RT_NULL,
-                                       ENCODER2_THREAD_STACK_SIZE,
-                                       ENCODER2_THREAD_PRIORITY,
-                                       ENCODER2_THREAD_TIMESLICE);
-    if (encoder2_thread != RT_NULL)
-    {
-        rt_thread_startup(encoder2_thread);
-        rt_kprintf("[Encoder2] Thread started (%dHz)\n", 1000 / encoder_interval_ms);
-        return RT_EOK;
-    }
-    else
+    (void)parameter;
+
+    while (1)
     {
-        rt_kprintf("[Encoder2] Failed to create thread!\n");
-        return -RT_ERROR;
+        /* 等待控制节拍 */
+        rt_sem_take(encoder_tick_sem, RT_WAITING_FOREVER);
+
+        profiler_loop_begin();
+        encoder_sample_update();
+        profiler_loop_end();
     }
 }
+#endif
 
 /**
- * @brief 启动编码器线程（启动两个独立线程）
+ * @brief 启动编码器采样
+ *        ENCODER_SAMPLE_INLINE 模式下只初始化采样时间, 由底盘控制线程调用 encoder_sample_update()
+ *        否则启动一个订阅控制节拍的采样线程
  * @return RT_EOK 成功, -RT_ERROR 失败
  */
 rt_err_t encoder_print_thread_start(void)
 {
-    rt_err_t ret1 = encoder1_thread_start();
-    rt_err_t ret2 = encoder2_thread_start();
+    encoder_last_tick = rt_tick_get();
+    encoder_last_hrtime = hrtime_now();
 
-    if (ret1 == RT_EOK && ret2 == RT_EOK)
+#ifdef ENCODER_SAMPLE_INLINE
+    rt_kprintf("[Encoder] Sampler runs inline in control tick (%dHz)\n",
+               control_tick_get_hz());
+    return RT_EOK;
+#else
+    encoder_tick_sem = rt_sem_create("enc_tk", 0, RT_IPC_FLAG_FIFO);
+    if (encoder_tick_sem == RT_NULL || control_tick_attach(encoder_tick_sem) != RT_EOK)
     {
-        rt_kprintf("[Encoder] Both encoder threads started (%dHz)\n", 1000 / encoder_interval_ms);
+        rt_kprintf("[Encoder] Failed to attach control tick!\n");
+        return -RT_ERROR;
+    }
+
+    encoder_thread = rt_thread_create("enc",
+                                      encoder_thread_entry,
+                                      RT_NULL,
+                                      ENCODER_THREAD_STACK_SIZE,
+                                      ENCODER_THREAD_PRIORITY,
+                                      ENCODER_THREAD_TIMESLICE);
+    if (encoder_thread != RT_NULL)
+    {
+        rt_thread_startup(encoder_thread);
+        rt_kprintf("[Encoder] Sampler thread started (%dHz)\n", control_tick_get_hz());
         return RT_EOK;
     }
     else
     {
-        rt_kprintf("[Encoder] Failed to start encoder threads!\n");
+        rt_kprintf("[Encoder] Failed to create sampler thread!\n");
         return -RT_ERROR;
     }
+#endif
 }
 
 /* ================= 调试用 MSH 命令 ================= */
@@ -408,14 +741,50 @@ static void enc_info_cmd(int argc, char *argv[])
     (void)argc;
     (void)argv;
 
-    rt_uint32_t delta1 = encoder_get_shared_delta1();
-    rt_uint32_t delta2 = encoder_get_shared_delta2();
-    float speed1 = encoder_get_shared_speed1();
-    float speed2 = encoder_get_shared_speed2();
+    struct encoder_sample sample;
+    int i;
+
+    encoder_get_sample(&sample);
 
-    rt_kprintf("Encoder1: delta=%u, speed=%d mr/s\n",
-               delta1, (int)(speed1 * 1000));
-    rt_kprintf("Encoder2: delta=%u, speed=%d mr/s\n",
-               delta2, (int)(speed2 * 1000));
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
+    {
+        rt_kprintf("Encoder%d: delta=%d, speed=%d mr/s, count=%d\n", i + 1,
+                   sample.sdelta[i], (int)(sample.sspeed[i] * 1000),
+                   encoder_axis_get_signed_count(i));
+    }
+    rt_kprintf("Sample: seq=%u, tick=%u, window=%u ticks\n",
+               sample.seq, (rt_uint32_t)sample.tick, (rt_uint32_t)sample.window);
 }
 MSH_CMD_EXPORT_ALIAS(enc_info_cmd, enc_info, Read encoder delta and speed for debug);
+
+/**
+ * @brief MSH 命令: 查看/设置测速模式
+ *        用法: enc_mode [m|t|auto]
+ */
+static void enc_mode_cmd(int argc, char *argv[])
+{
+    static const char *mode_names[] = {"m", "t", "auto"};
+    int i;
+
+    if (argc >= 2)
+    {
+        for (i = 0; i < 3; i++)
+        {
+            if (rt_strcmp(argv[1], mode_names[i]) == 0)
+            {
+                encoder_set_speed_mode(i);
+                break;
+            }
+        }
+        if (i == 3)
+        {
+            rt_kprintf("Usage: enc_mode [m|t|auto]\n");
+            return;
+        }
+    }
+
+    rt_kprintf("Encoder speed mode: %s (M/T blend %d~%d pulses, T timeout %dms)\n",
+               mode_names[encoder_speed_mode], ENCODER_MT_LOW_PULSES,
+               ENCODER_MT_HIGH_PULSES, ENCODER_T_TIMEOUT_MS);
+}
+MSH_CMD_EXPORT_ALIAS(enc_mode_cmd, enc_mode, Show or set encoder speed mode m t auto);
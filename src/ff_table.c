@@ -0,0 +1,491 @@
+/*
+ * 前馈查表与开环标定
+ *
+ * 表邮箱: cfg 线程 / MSH 写, 底盘控制线程在版本号变化时整体复制 (seqlock)
+ * 标定数据只由底盘控制线程写入, 扫描结束后由 MSH 读取并生成表
+ */
+
+#include <rtthread.h>
+#include <stdlib.h>
+#include "autotune.h"
+#include "ff_table.h"
+#include "rpmsg_motor.h"
+#include "seqlock.h"
+
+#define FF_CAL_STATE_IDLE    0
+#define FF_CAL_STATE_RUNNING 1
+#define FF_CAL_STATE_DONE    2
+#define FF_CAL_STATE_ABORTED 3
+
+#define FF_CAL_MIN_RPS  0.05f /* 平均转速低于此值认为没有转动 (死区内) */
+#define FF_CAL_POLL_MS  50
+
+static struct ff_table ff_box[MOTOR_AXIS_NUM];
+static seqlock_t ff_lock = SEQLOCK_INIT;
+static volatile rt_uint32_t ff_generation = 0;
+
+/* 标定 */
+static volatile int cal_state = FF_CAL_STATE_IDLE;
+static volatile rt_bool_t cal_abort_req = RT_FALSE;
+static float cal_duty_max;
+static int cal_steps;
+static int cal_step;
+static rt_uint32_t cal_ticks;
+static rt_uint32_t cal_hold_ticks;
+static float cal_sum[MOTOR_AXIS_NUM];
+static rt_uint32_t cal_n;
+static float cal_speed[MOTOR_AXIS_NUM][FF_CAL_MAX_STEPS];
+
+rt_err_t ff_table_set(int axis, const struct ff_table *t)
+{
+    rt_base_t level;
+    int i;
+
+    if (axis < 0 || axis >= MOTOR_AXIS_NUM)
+    {
+        return -RT_EINVAL;
+    }
+    if (t->points != 0)
+    {
+        if (t->points < 2 || t->points > FF_TABLE_POINTS || t->step_mrs == 0)
+        {
+            return -RT_EINVAL;
+        }
+        for (i = 0; i < t->points; i++)
+        {
+            if (t->duty[i] > FF_TABLE_DUTY_SCALE || (i > 0 && t->duty[i] < t->duty[i - 1]))
+            {
+                return -RT_EINVAL;
+            }
+        }
+    }
+
+    level = seqlock_write_begin(&ff_lock);
+    ff_box[axis] = *t;
+    ff_generation++;
+    seqlock_write_end(&ff_lock, level);
+    return RT_EOK;
+}
+
+void ff_table_get(int axis, struct ff_table *out)
+{
+    rt_uint32_t seq;
+
+    if (axis < 0 || axis >= MOTOR_AXIS_NUM)
+    {
+        rt_memset(out, 0, sizeof(*out));
+        return;
+    }
+    do
+    {
+        seq = seqlock_read_begin(&ff_lock);
+        *out = ff_box[axis];
+    } while (seqlock_read_retry(&ff_lock, seq));
+}
+
+rt_uint32_t ff_table_generation(void)
+{
+    return ff_generation;
+}
+
+rt_uint32_t ff_table_snapshot(struct ff_table *tables)
+{
+    rt_uint32_t seq, generation;
+
+    do
+    {
+        seq = seqlock_read_begin(&ff_lock);
+        rt_memcpy(tables, ff_box, sizeof(ff_box));
+        generation = ff_generation;
+    } while (seqlock_read_retry(&ff_lock, seq));
+    return generation;
+}
+
+int ff_table_format(int axis, char *buf, int size)
+{
+    struct ff_table t;
+    int len, i;
+
+    ff_table_get(axis, &t);
+    if (t.points == 0)
+    {
+        return rt_snprintf(buf, size, "FF,%d,off", axis);
+    }
+
+    len = rt_snprintf(buf, size, "FF,%d,%u", axis, t.step_mrs);
+    for (i = 0; i < t.points && len < size; i++)
+    {
+        len += rt_snprintf(buf + len, size - len, ",%u", t.duty[i]);
+    }
+    return len;
+}
+
+rt_err_t ff_table_parse(const char *text, int *axis, struct ff_table *t)
+{
+    const char *p;
+    char *end;
+    long value;
+
+    if (text == RT_NULL || rt_strncmp(text, "FF,", 3) != 0)
+    {
+        return -RT_ERROR;
+    }
+
+    rt_memset(t, 0, sizeof(*t));
+    *axis = (int)strtol(text + 3, &end, 10);
+    if (end == text + 3 || *end != ',')
+    {
+        return -RT_ERROR;
+    }
+    p = end + 1;
+    if (rt_strcmp(p, "off") == 0)
+    {
+        return RT_EOK;
+    }
+
+    value = strtol(p, &end, 10);
+    if (end == p || value <= 0 || value > 0xFFFF)
+    {
+        return -RT_ERROR;
+    }
+    t->step_mrs = (rt_uint16_t)value;
+
+    while (*end == ',' && t->points < FF_TABLE_POINTS)
+    {
+        p = end + 1;
+        value = strtol(p, &end, 10);
+        if (end == p || value < 0 || value > 0xFFFF)
+        {
+            return -RT_ERROR;
+        }
+        t->duty[t->points++] = (rt_uint16_t)value;
+    }
+    return (*end == '\0') ? RT_EOK : -RT_ERROR;
+}
+
+/* ================= 开环标定 ================= */
+
+rt_err_t ff_cal_begin(float duty_max, int steps)
+{
+    if (!(duty_max > 0.0f && duty_max <= 1.0f) || steps < 2 || steps > FF_CAL_MAX_STEPS)
+    {
+        return -RT_EINVAL;
+    }
+    if (cal_state == FF_CAL_STATE_RUNNING || autotune_active())
+    {
+        return -RT_EBUSY;
+    }
+
+    cal_duty_max = duty_max;
+    cal_steps = steps;
+    cal_step = 0;
+    cal_ticks = 0;
+    cal_hold_ticks = 0;
+    cal_n = 0;
+    rt_memset(cal_sum, 0, sizeof(cal_sum));
+    rt_memset(cal_speed, 0, sizeof(cal_speed));
+    cal_abort_req = RT_FALSE;
+    __sync_synchronize();
+    cal_state = FF_CAL_STATE_RUNNING;
+    return RT_EOK;
+}
+
+void ff_cal_abort(void)
+{
+    if (cal_state == FF_CAL_STATE_RUNNING)
+    {
+        cal_abort_req = RT_TRUE;
+    }
+}
+
+rt_bool_t ff_cal_active(void)
+{
+    return cal_state == FF_CAL_STATE_RUNNING;
+}
+
+static float ff_cal_duty(int step)
+{
+    return cal_duty_max * (float)(step + 1) / (float)cal_steps;
+}
+
+rt_bool_t ff_cal_update(const float *speed, float dt, float *duty)
+{
+    int i;
+
+    if (cal_state != FF_CAL_STATE_RUNNING)
+    {
+        return RT_FALSE;
+    }
+
+    if (cal_abort_req)
+    {
+        for (i = 0; i < MOTOR_AXIS_NUM; i++)
+        {
+            duty[i] = 0.0f;
+        }
+        cal_state = FF_CAL_STATE_ABORTED;
+        return RT_TRUE;
+    }
+
+    if (cal_hold_ticks == 0)
+    {
+        cal_hold_ticks = (rt_uint32_t)(FF_CAL_HOLD_MS / 1000.0f / dt + 0.5f);
+        if (cal_hold_ticks < 4)
+        {
+            cal_hold_ticks = 4;
+        }
+    }
+
+    /* 本节拍的转速是上一节拍占空比的结果, 每级后半段取平均 */
+    if (cal_ticks >= cal_hold_ticks / 2)
+    {
+        for (i = 0; i < MOTOR_AXIS_NUM; i++)
+        {
+            cal_sum[i] += speed[i];
+        }
+        cal_n++;
+    }
+
+    if (++cal_ticks >= cal_hold_ticks)
+    {
+        for (i = 0; i < MOTOR_AXIS_NUM; i++)
+        {
+            cal_speed[i][cal_step] = cal_sum[i] / (float)cal_n;
+            cal_sum[i] = 0.0f;
+        }
+        cal_n = 0;
+        cal_ticks = 0;
+        if (++cal_step >= cal_steps)
+        {
+            for (i = 0; i < MOTOR_AXIS_NUM; i++)
+            {
+                duty[i] = 0.0f;
+            }
+            cal_state = FF_CAL_STATE_DONE;
+            return RT_TRUE;
+        }
+    }
+
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
+    {
+        duty[i] = ff_cal_duty(cal_step);
+    }
+    return RT_TRUE;
+}
+
+rt_err_t ff_cal_build(int axis, struct ff_table *out)
+{
+    float w[FF_CAL_MAX_STEPS + 1];
+    float d[FF_CAL_MAX_STEPS + 1];
+    float s, duty, w_max;
+    int n = 0, k0 = -1, k, j, seg;
+    rt_uint32_t step;
+
+    rt_memset(out, 0, sizeof(*out));
+    if (cal_state != FF_CAL_STATE_DONE || axis < 0 || axis >= MOTOR_AXIS_NUM)
+    {
+        return -RT_ERROR;
+    }
+
+    for (k = 0; k < cal_steps; k++)
+    {
+        if (cal_speed[axis][k] > FF_CAL_MIN_RPS)
+        {
+            k0 = k;
+            break;
+        }
+    }
+    if (k0 < 0 || k0 >= cal_steps - 1 || cal_speed[axis][k0 + 1] <= cal_speed[axis][k0])
+    {
+        return -RT_ERROR;
+    }
+
+    /* 零转速截距: 最低两级有效转速连线外推, 不低于 0, 不高于第一级有效占空比 */
+    d[0] = ff_cal_duty(k0) - cal_speed[axis][k0] * (ff_cal_duty(k0 + 1) - ff_cal_duty(k0)) /
+                                 (cal_speed[axis][k0 + 1] - cal_speed[axis][k0]);
+    if (d[0] < 0.0f)
+    {
+        d[0] = 0.0f;
+    }
+    if (d[0] > ff_cal_duty(k0))
+    {
+        d[0] = ff_cal_duty(k0);
+    }
+    w[0] = 0.0f;
+    n = 1;
+
+    /* 实测曲线, 跳过转速没有升高的级 (饱和或测量抖动) */
+    for (k = k0; k < cal_steps; k++)
+    {
+        if (cal_speed[axis][k] > w[n - 1])
+        {
+            w[n] = cal_speed[axis][k];
+            d[n] = ff_cal_duty(k);
+            n++;
+        }
+    }
+
+    w_max = w[n - 1];
+    step = (rt_uint32_t)(w_max * 1000.0f / (FF_TABLE_POINTS - 1) + 0.999f);
+    if (step == 0 || step > 0xFFFF)
+    {
+        return -RT_ERROR;
+    }
+
+    /* 按等间隔断点反插值 */
+    out->step_mrs = (rt_uint16_t)step;
+    out->points = FF_TABLE_POINTS;
+    seg = 0;
+    for (j = 0; j < FF_TABLE_POINTS; j++)
+    {
+        s = (float)(j * step) / 1000.0f;
+        while (seg < n - 2 && s > w[seg + 1])
+        {
+            seg++;
+        }
+        duty = d[seg] + (s - w[seg]) * (d[seg + 1] - d[seg]) / (w[seg + 1] - w[seg]);
+        if (duty < 0.0f)
+        {
+            duty = 0.0f;
+        }
+        if (duty > 1.0f)
+        {
+            duty = 1.0f;
+        }
+        out->duty[j] = (rt_uint16_t)(duty * FF_TABLE_DUTY_SCALE + 0.5f);
+        if (j > 0 && out->duty[j] < out->duty[j - 1])
+        {
+            out->duty[j] = out->duty[j - 1];
+        }
+    }
+    return RT_EOK;
+}
+
+/* ================= 调试用 MSH 命令 ================= */
+
+static void ff_table_print(int axis)
+{
+    char line[160];
+
+    ff_table_format(axis, line, sizeof(line));
+    rt_kprintf("  %s\n", line);
+}
+
+/**
+ * @brief MSH 命令: 查看 / 设置 / 删除前馈表
+ *        用法: ff [set <axis> <step_mrs> <d0> <d1> ... | off <axis>]
+ *        占空比单位 1e-4, 输出格式与 RPMsg "FF" 指令相同
+ */
+static void ff_cmd(int argc, char *argv[])
+{
+    struct ff_table t;
+    int axis, i;
+
+    if (argc >= 3 && rt_strcmp(argv[1], "off") == 0)
+    {
+        rt_memset(&t, 0, sizeof(t));
+        if (ff_table_set(atoi(argv[2]), &t) != RT_EOK)
+        {
+            rt_kprintf("Invalid axis\n");
+        }
+    }
+    else if (argc >= 6 && rt_strcmp(argv[1], "set") == 0)
+    {
+        rt_memset(&t, 0, sizeof(t));
+        axis = atoi(argv[2]);
+        t.step_mrs = (rt_uint16_t)atoi(argv[3]);
+        for (i = 4; i < argc && t.points < FF_TABLE_POINTS; i++)
+        {
+            t.duty[t.points++] = (rt_uint16_t)atoi(argv[i]);
+        }
+        if (ff_table_set(axis, &t) != RT_EOK)
+        {
+            rt_kprintf("Invalid table\n");
+            return;
+        }
+    }
+    else if (argc >= 2)
+    {
+        rt_kprintf("Usage: ff [set <axis> <step_mrs> <d0> <d1> ... | off <axis>]\n");
+        return;
+    }
+
+    rt_kprintf("Feed-forward tables (generation %u, duty 1e-4):\n", ff_table_generation());
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
+    {
+        ff_table_print(i);
+    }
+}
+MSH_CMD_EXPORT_ALIAS(ff_cmd, ff, Show or set feed-forward tables);
+
+/**
+ * @brief MSH 命令: 开环扫描标定前馈表 (阻塞, 底盘须架空)
+ *        用法: ff_cal [duty_max [steps]]
+ */
+static void ff_cal_cmd(int argc, char *argv[])
+{
+    struct ff_table t;
+    float duty_max = FF_CAL_DUTY_MAX_DEFAULT;
+    int steps = FF_CAL_STEPS_DEFAULT;
+    rt_int32_t wait_ms;
+    rt_err_t ret;
+    int i, k;
+
+    if (argc >= 2)
+    {
+        duty_max = (float)atof(argv[1]);
+    }
+    if (argc >= 3)
+    {
+        steps = atoi(argv[2]);
+    }
+
+    /* 从静止开始, 结束后不恢复之前的目标值 */
+    chassis_emergency_stop();
+    ret = ff_cal_begin(duty_max, steps);
+    if (ret != RT_EOK)
+    {
+        rt_kprintf("[ff_cal] Start failed: %d\n", ret);
+        return;
+    }
+    rt_kprintf("[ff_cal] Sweeping %d steps up to duty %d (x1000), %d ms each, keep the chassis lifted\n",
+               steps, (int)(duty_max * 1000), FF_CAL_HOLD_MS);
+
+    /* 最多等待理论时间的 2 倍 */
+    wait_ms = 2 * steps * FF_CAL_HOLD_MS + 1000;
+    while (cal_state == FF_CAL_STATE_RUNNING && wait_ms > 0)
+    {
+        rt_thread_mdelay(FF_CAL_POLL_MS);
+        wait_ms -= FF_CAL_POLL_MS;
+    }
+    if (cal_state == FF_CAL_STATE_RUNNING)
+    {
+        ff_cal_abort();
+    }
+    chassis_emergency_stop();
+    if (cal_state != FF_CAL_STATE_DONE)
+    {
+        rt_kprintf("[ff_cal] Aborted\n");
+        return;
+    }
+
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
+    {
+        rt_kprintf("  axis%d:", i);
+        for (k = 0; k < cal_steps; k++)
+        {
+            rt_kprintf(" %d", (int)(cal_speed[i][k] * 1000));
+        }
+        rt_kprintf(" mr/s\n");
+
+        if (ff_cal_build(i, &t) == RT_EOK && ff_table_set(i, &t) == RT_EOK)
+        {
+            ff_table_print(i);
+        }
+        else
+        {
+            rt_kprintf("  axis%d: no response, table unchanged\n", i);
+        }
+    }
+}
+MSH_CMD_EXPORT_ALIAS(ff_cal_cmd, ff_cal, Calibrate feed-forward tables by open loop sweep);
@@ -0,0 +1,206 @@
+/*
+ * 电机健康监测
+ *
+ * 检测状态只在底盘控制线程中修改; 故障标志为单字变量, 其他线程直接读取
+ */
+
+#include <rtthread.h>
+#include <stdlib.h>
+#include "common.h"
+#include "health.h"
+
+/* 指令计数: 写入端递增, 控制线程比较是否变化 */
+static volatile rt_uint32_t health_kicks = 0;
+static volatile rt_bool_t health_clear_req = RT_FALSE;
+static volatile rt_uint32_t health_cmd_timeout_ms = HEALTH_CMD_TIMEOUT_MS;
+
+/* 对外发布的状态 */
+static volatile rt_uint32_t health_faults = 0;
+static volatile rt_uint32_t health_fault_axes = 0;
+
+/* 控制线程内部状态 */
+static rt_uint32_t health_seen_kicks = 0;
+static rt_bool_t health_armed = RT_FALSE; /* 收到过指令, 超时后解除 */
+static float health_cmd_age = 0.0f;
+static float health_enc_time[MOTOR_AXIS_NUM];
+static float health_stall_time[MOTOR_AXIS_NUM];
+
+/* 统计 (MSH 查看) */
+static rt_uint32_t health_trips[3]; /* 超时 / 堵转 / 编码器 */
+
+void health_kick(void)
+{
+    health_kicks++;
+}
+
+/**
+ * @brief 指令超时检查
+ * @return RT_TRUE 本节拍超时
+ */
+static rt_bool_t health_check_cmd(rt_bool_t open_loop, float dt)
+{
+    rt_uint32_t kicks = health_kicks;
+    rt_uint32_t timeout_ms = health_cmd_timeout_ms;
+
+    if (kicks != health_seen_kicks || open_loop)
+    {
+        health_seen_kicks = kicks;
+        health_armed = RT_TRUE;
+        health_cmd_age = 0.0f;
+        return RT_FALSE;
+    }
+    if (!health_armed || timeout_ms == 0)
+    {
+        return RT_FALSE;
+    }
+
+    health_cmd_age += dt;
+    if (health_cmd_age * 1000.0f < (float)timeout_ms)
+    {
+        return RT_FALSE;
+    }
+    /* 下一条指令之前不再触发 */
+    health_armed = RT_FALSE;
+    return RT_TRUE;
+}
+
+rt_uint32_t health_update(const struct encoder_sample *sample, const float *duty,
+                          rt_bool_t open_loop, float dt)
+{
+    rt_uint32_t faults = health_faults;
+    rt_uint32_t axes = health_fault_axes;
+    int i;
+
+    if (health_clear_req)
+    {
+        health_clear_req = RT_FALSE;
+        faults &= ~HEALTH_FAULT_LATCHED;
+        axes = 0;
+        for (i = 0; i < MOTOR_AXIS_NUM; i++)
+        {
+            health_enc_time[i] = 0.0f;
+            health_stall_time[i] = 0.0f;
+        }
+    }
+
+    if (health_check_cmd(open_loop, dt))
+    {
+        faults |= MOTOR_PROTO_FAULT_CMD_TIMEOUT;
+        health_trips[0]++;
+    }
+    else if (health_armed)
+    {
+        faults &= ~MOTOR_PROTO_FAULT_CMD_TIMEOUT;
+    }
+
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
+    {
+        /* 编码器无脉冲 */
+        if (duty[i] >= HEALTH_ENC_DUTY && sample->delta[i] == 0)
+        {
+            health_enc_time[i] += dt;
+        }
+        else
+        {
+            health_enc_time[i] = 0.0f;
+        }
+        if (health_enc_time[i] * 1000.0f >= (float)HEALTH_ENC_LOSS_MS &&
+            !(faults & MOTOR_PROTO_FAULT_ENCODER))
+        {
+            faults |= MOTOR_PROTO_FAULT_ENCODER;
+            axes |= 1U << i;
+            health_trips[2]++;
+        }
+
+        /* 堵转: 有脉冲但转速过低 */
+        if (duty[i] >= HEALTH_STALL_DUTY && sample->delta[i] != 0 &&
+            sample->speed[i] < HEALTH_STALL_SPEED)
+        {
+            health_stall_time[i] += dt;
+        }
+        else
+        {
+            health_stall_time[i] = 0.0f;
+        }
+        if (health_stall_time[i] * 1000.0f >= (float)HEALTH_STALL_MS &&
+            !(faults & MOTOR_PROTO_FAULT_STALL))
+        {
+            faults |= MOTOR_PROTO_FAULT_STALL;
+            axes |= 1U << i;
+            health_trips[1]++;
+        }
+    }
+
+    health_fault_axes = axes;
+    health_faults = faults;
+    return faults;
+}
+
+rt_uint32_t health_get_faults(void)
+{
+    return health_faults;
+}
+
+rt_uint32_t health_get_fault_axes(void)
+{
+    return health_fault_axes;
+}
+
+void health_clear(void)
+{
+    health_clear_req = RT_TRUE;
+}
+
+void health_set_cmd_timeout(rt_uint32_t ms)
+{
+    health_cmd_timeout_ms = ms;
+}
+
+rt_uint32_t health_get_cmd_timeout(void)
+{
+    return health_cmd_timeout_ms;
+}
+
+/* ================= 调试用 MSH 命令 ================= */
+
+/**
+ * @brief MSH 命令: 查看健康状态 / 清除锁存故障 / 设置指令超时
+ *        用法: health [clear | timeout <ms>]
+ */
+static void health_cmd(int argc, char *argv[])
+{
+    rt_uint32_t faults;
+
+    if (argc >= 2 && rt_strcmp(argv[1], "clear") == 0)
+    {
+        health_clear();
+        rt_kprintf("Latched faults cleared\n");
+        return;
+    }
+    if (argc >= 3 && rt_strcmp(argv[1], "timeout") == 0)
+    {
+        health_set_cmd_timeout((rt_uint32_t)atoi(argv[2]));
+    }
+    else if (argc >= 2)
+    {
+        rt_kprintf("Usage: health [clear | timeout <ms>]\n");
+        return;
+    }
+
+    faults = health_get_faults();
+    rt_kprintf("Faults: 0x%02x%s%s%s, axes=0x%02x\n", faults,
+               (faults & MOTOR_PROTO_FAULT_CMD_TIMEOUT) ? " cmd_timeout" : "",
+               (faults & MOTOR_PROTO_FAULT_STALL) ? " stall" : "",
+               (faults & MOTOR_PROTO_FAULT_ENCODER) ? " encoder" : "",
+               health_get_fault_axes());
+    rt_kprintf("Command timeout: %u ms (%s)\n", health_get_cmd_timeout(),
+               health_get_cmd_timeout() == 0 ? "off" : (health_armed ? "armed" : "idle"));
+    rt_kprintf("Encoder loss: duty >= %d, no pulse for %d ms\n",
+               (int)(HEALTH_ENC_DUTY * 1000), HEALTH_ENC_LOSS_MS);
+    rt_kprintf("Stall: duty >= %d, speed < %d mr/s for %d ms (x1000)\n",
+               (int)(HEALTH_STALL_DUTY * 1000), (int)(HEALTH_STALL_SPEED * 1000),
+               HEALTH_STALL_MS);
+    rt_kprintf("Trips: cmd_timeout=%u stall=%u encoder=%u\n", health_trips[0],
+               health_trips[1], health_trips[2]);
+}
+MSH_CMD_EXPORT_ALIAS(health_cmd, health, Show motor health or clear latched faults);
@@ -0,0 +1,143 @@
+/*
+ * 高精度时间戳
+ *
+ * clock_cpu_getres() 的返回值随 RT-Thread 版本不同:
+ * - 4.x: float, 每个计数对应的纳秒数
+ * - 5.x: uint64_t, 每个计数对应的纳秒数 * HRTIME_RES_SCALE (clock_cpu_microsecond()
+ *   同样按这个倍数换算)
+ * 初始化时按 RT_VER_NUM 换算成纳秒并缓存, 换算只做一次浮点乘法;
+ * 再用系统节拍测量一次计数频率, 与分辨率相差超过一倍时改用实测值
+ */
+
+#include <rtthread.h>
+#include <rtdevice.h>
+#include "hrtime.h"
+
+#if defined(RT_VER_NUM) && (RT_VER_NUM >= 0x50000)
+#define HRTIME_RES_SCALE 1000000.0f
+#else
+#define HRTIME_RES_SCALE 1.0f
+#endif
+
+#define HRTIME_CHECK_TICKS (RT_TICK_PER_SECOND / 50) /* 自检测量时长, 约 20ms */
+
+/* 每个计数对应的纳秒数 */
+static float hrtime_ns_per_count = 1000000000.0f / RT_TICK_PER_SECOND;
+
+/* 每个计数对应的微秒数, 整数部分 + Q0.32 小数部分, 绝对时刻换算时不经过 float */
+static rt_uint64_t hrtime_us_mult_int = 0;
+static rt_uint64_t hrtime_us_mult_frac = 0;
+
+#ifdef RT_USING_CPUTIME
+/**
+ * @brief 用系统节拍测量每个计数对应的纳秒数 (线程上下文, 阻塞约 20ms)
+ * @return 实测值, 计数器不走时返回 0
+ */
+static float hrtime_measure_ns_per_count(void)
+{
+    rt_tick_t t0, t1;
+    rt_uint64_t c0, c1;
+
+    /* 从节拍边沿开始, 减小节拍量化误差 */
+    rt_thread_delay(1);
+    t0 = rt_tick_get();
+    c0 = clock_cpu_gettime();
+    rt_thread_delay(HRTIME_CHECK_TICKS > 0 ? HRTIME_CHECK_TICKS : 1);
+    t1 = rt_tick_get();
+    c1 = clock_cpu_gettime();
+
+    if (c1 == c0)
+    {
+        return 0.0f;
+    }
+    return (float)(t1 - t0) * (1000000000.0f / RT_TICK_PER_SECOND) / (float)(c1 - c0);
+}
+#endif
+
+/**
+ * @brief 初始化 (缓存计数器分辨率, 并用系统节拍自检)
+ */
+void hrtime_init(void)
+{
+    double us_per_count;
+
+#ifdef RT_USING_CPUTIME
+    float measured;
+
+    hrtime_ns_per_count = (float)clock_cpu_getres() / HRTIME_RES_SCALE;
+    measured = hrtime_measure_ns_per_count();
+    if (measured > 0.0f &&
+        (hrtime_ns_per_count <= 0.0f || hrtime_ns_per_count > measured * 2.0f ||
+         hrtime_ns_per_count < measured * 0.5f))
+    {
+        rt_kprintf("[HRTime] clock_cpu_getres() gives %d ps/count, measured %d, using measured\n",
+                   (int)(hrtime_ns_per_count * 1000), (int)(measured * 1000));
+        hrtime_ns_per_count = measured;
+    }
+    if (hrtime_ns_per_count <= 0.0f)
+    {
+        hrtime_ns_per_count = 1.0f;
+    }
+#endif
+
+    us_per_count = (double)hrtime_ns_per_count / 1000.0;
+    hrtime_us_mult_int = (rt_uint64_t)us_per_count;
+    hrtime_us_mult_frac = (rt_uint64_t)((us_per_count - (double)hrtime_us_mult_int) * 4294967296.0);
+
+    rt_kprintf("[HRTime] Resolution: %d ps/count\n", (int)(hrtime_ns_per_count * 1000));
+}
+
+/**
+ * @brief 读取当前计数值
+ */
+rt_uint64_t hrtime_now(void)
+{
+#ifdef RT_USING_CPUTIME
+    return clock_cpu_gettime();
+#else
+    return rt_tick_get();
+#endif
+}
+
+/**
+ * @brief 计数差值转换为秒
+ */
+float hrtime_to_sec(rt_uint64_t counts)
+{
+    return (float)counts * hrtime_ns_per_count * 1e-9f;
+}
+
+/**
+ * @brief 计数差值转换为微秒
+ */
+rt_uint32_t hrtime_to_us(rt_uint64_t counts)
+{
+    return (rt_uint32_t)((float)counts * hrtime_ns_per_count * 1e-3f);
+}
+
+/**
+ * @brief 计数值 (时刻) 转换为微秒 (允许回绕)
+ *        计数分为高低 32 位分别乘以换算系数, 64 位整数运算, 长时间运行后
+ *        分辨率不下降 (hrtime_to_us 经过 float, 只适合较短的差值)
+ */
+rt_uint32_t hrtime_abs_to_us(rt_uint64_t counts)
+{
+    rt_uint64_t hi = counts >> 32;
+    rt_uint64_t lo = counts & 0xFFFFFFFFULL;
+
+    return (rt_uint32_t)(counts * hrtime_us_mult_int + hi * hrtime_us_mult_frac +
+                         ((lo * hrtime_us_mult_frac) >> 32));
+}
+
+rt_uint32_t hrtime_now_us(void)
+{
+    return hrtime_abs_to_us(hrtime_now());
+}
+
+/**
+ * @brief 微秒转换为计数差值
+ */
+rt_uint64_t hrtime_from_us(rt_uint32_t us)
+{
+    return (rt_uint64_t)((float)us * 1000.0f / hrtime_ns_per_count);
+}
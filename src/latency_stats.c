@@ -0,0 +1,88 @@
+/*
+ * 时延统计
+ *
+ * 写端关中断更新计数和样本窗口; 查询时关中断拷贝窗口到静态缓冲区,
+ * 开中断后再排序, 关中断时间只与窗口长度有关
+ */
+
+#include <rtthread.h>
+#include <string.h>
+#include "latency_stats.h"
+
+/* 查询用排序缓冲区, 只在 MSH 线程中使用 */
+static rt_uint32_t latency_sorted[LATENCY_STATS_WINDOW];
+
+void latency_stats_reset(struct latency_stats *st)
+{
+    rt_base_t level = rt_hw_interrupt_disable();
+    st->count = 0;
+    st->min_us = 0;
+    st->max_us = 0;
+    st->sum_us = 0;
+    rt_hw_interrupt_enable(level);
+}
+
+void latency_stats_add(struct latency_stats *st, rt_uint32_t us)
+{
+    rt_base_t level = rt_hw_interrupt_disable();
+
+    if (st->count == 0 || us < st->min_us)
+    {
+        st->min_us = us;
+    }
+    if (us > st->max_us)
+    {
+        st->max_us = us;
+    }
+    st->sum_us += us;
+    st->window[st->count % LATENCY_STATS_WINDOW] = us;
+    st->count++;
+
+    rt_hw_interrupt_enable(level);
+}
+
+void latency_stats_summary(const struct latency_stats *st, struct latency_summary *out)
+{
+    rt_base_t level;
+    rt_uint32_t n, i, j, v;
+    rt_uint64_t sum;
+
+    level = rt_hw_interrupt_disable();
+    out->count = st->count;
+    out->min_us = st->min_us;
+    out->max_us = st->max_us;
+    sum = st->sum_us;
+    n = st->count < LATENCY_STATS_WINDOW ? st->count : LATENCY_STATS_WINDOW;
+    memcpy(latency_sorted, st->window, n * sizeof(latency_sorted[0]));
+    rt_hw_interrupt_enable(level);
+
+    out->avg_us = out->count > 0 ? (rt_uint32_t)(sum / out->count) : 0;
+    out->p99_us = 0;
+    if (n == 0)
+    {
+        return;
+    }
+
+    /* 插入排序, 窗口只有几百个样本 */
+    for (i = 1; i < n; i++)
+    {
+        v = latency_sorted[i];
+        for (j = i; j > 0 && latency_sorted[j - 1] > v; j--)
+        {
+            latency_sorted[j] = latency_sorted[j - 1];
+        }
+        latency_sorted[j] = v;
+    }
+
+    /* 向上取整的秩, 样本少时即为最大值 */
+    out->p99_us = latency_sorted[(n * 99 + 99) / 100 - 1];
+}
+
+void latency_stats_print(const char *name, const struct latency_stats *st)
+{
+    struct latency_summary sum;
+
+    latency_stats_summary(st, &sum);
+    rt_kprintf("  %-12s n=%u min=%u avg=%u p99=%u max=%u us\n", name, sum.count,
+               sum.min_us, sum.avg_us, sum.p99_us, sum.max_us);
+}
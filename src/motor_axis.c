@@ -0,0 +1,28 @@
+/*
+ * 电机轴描述表
+ *
+ * 增加轴时在 common.h 中修改 MOTOR_AXIS_NUM 并补充引脚定义, 然后在此追加表项
+ */
+
+#include <rtthread.h>
+#include "common.h"
+#include "motor_axis.h"
+
+const struct motor_axis_desc motor_axis_table[] = {
+    /* 电机1 (左) */
+    {
+        PWM_DEV_NAME_MOTOR_1, PWM_CHANNEL, MOTOR_AXIS_CHANNEL_LEFT,
+        GPIO_OUTPUT_IO_MOTOR1_0, GPIO_OUTPUT_IO_MOTOR1_1,
+        ENCODER_GPIO_MOTOR1_A, ENCODER_GPIO_MOTOR1_B,
+    },
+    /* 电机2 (右) */
+    {
+        PWM_DEV_NAME_MOTOR_2, PWM_CHANNEL, MOTOR_AXIS_CHANNEL_RIGHT,
+        GPIO_OUTPUT_IO_MOTOR2_0, GPIO_OUTPUT_IO_MOTOR2_1,
+        ENCODER_GPIO_MOTOR2_A, ENCODER_GPIO_MOTOR2_B,
+    },
+};
+
+/* 表项数必须与 MOTOR_AXIS_NUM 一致 */
+typedef char motor_axis_table_size_check
+    [(sizeof(motor_axis_table) / sizeof(motor_axis_table[0]) == MOTOR_AXIS_NUM) ? 1 : -1];
@@ -9,66 +9,232 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "common.h"
+#include "motor_axis.h"
 #include "motor_pwm.h"
 #include "motor_gpio.h"
 #include "motor_control.h"
 
+/* ================= 执行器缓存 ================= */
+
+/*
+ * 记录每个轴最近一次成功写入驱动的方向和脉宽 (按轴下标),
+ * 方向和按 PWM_PERIOD 量化后的脉宽都未变化时跳过驱动调用;
+ * 每 actuator_refresh_cycles 次调用强制重写一次, 防止寄存器被意外改写后一直不恢复
+ */
+static rt_bool_t actuator_valid[MOTOR_AXIS_NUM];
+static rt_uint8_t actuator_dir[MOTOR_AXIS_NUM];
+static rt_uint32_t actuator_pulse[MOTOR_AXIS_NUM];
+static rt_uint32_t actuator_age[MOTOR_AXIS_NUM];
+
+static volatile rt_uint32_t actuator_refresh_cycles = MOTOR_ACTUATOR_REFRESH_CYCLES;
+
+/* 统计: 实际驱动写入次数 / 跳过次数 */
+static rt_uint32_t actuator_writes = 0;
+static rt_uint32_t actuator_skips = 0;
+
 /**
- * @brief 控制单个电机
- * @param motor_id 电机编号 (1 或 2)
+ * @brief 占空比量化为脉宽 (ns), 与 motor_axis_set_duty 一致
+ */
+static rt_uint32_t motor_duty_to_pulse(float duty)
+{
+    if (duty < 0.0f)
+    {
+        duty = 0.0f;
+    }
+    else if (duty > 1.0f)
+    {
+        duty = 1.0f;
+    }
+    return (rt_uint32_t)(PWM_PERIOD * duty);
+}
+
+/**
+ * @brief 使一个轴的缓存失效, 下一次 motor_axis_control 必定写入驱动
+ * @param axis 轴号, 传入 -1 表示所有轴
+ */
+void motor_actuator_invalidate(int axis)
+{
+    int i;
+
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
+    {
+        if (axis < 0 || axis == i)
+        {
+            actuator_valid[i] = RT_FALSE;
+        }
+    }
+}
+
+/**
+ * @brief 设置强制刷新间隔
+ * @param cycles 每个轴每 cycles 次调用强制写一次驱动, 0 表示只在变化时写入
+ */
+void motor_actuator_set_refresh(rt_uint32_t cycles)
+{
+    actuator_refresh_cycles = cycles;
+}
+
+/**
+ * @brief 按缓存更新一个轴的方向引脚, 并计算本次脉宽
+ * @param[out] pulse 量化后的脉宽 (ns)
+ * @return 1 脉宽需要写入驱动, 0 脉宽未变化, -1 方向无效
+ */
+static int motor_actuator_prepare(int axis, int direction, float duty, rt_uint32_t *pulse)
+{
+    rt_uint32_t refresh = actuator_refresh_cycles;
+    rt_bool_t force;
+
+    switch (direction)
+    {
+    case MOTOR_DIR_STOP:
+        *pulse = 0;
+        break;
+    case MOTOR_DIR_FORWARD:
+    case MOTOR_DIR_BACKWARD:
+        *pulse = motor_duty_to_pulse(duty);
+        break;
+    default:
+        rt_kprintf("[Motor%d] Invalid direction: %d\n", axis + 1, direction);
+        return -1;
+    }
+
+    force = !actuator_valid[axis] || (refresh != 0 && ++actuator_age[axis] >= refresh);
+    if (force)
+    {
+        actuator_age[axis] = 0;
+    }
+
+    if (force || actuator_dir[axis] != direction)
+    {
+        if (direction == MOTOR_DIR_FORWARD)
+        {
+            motor_axis_forward(axis);
+        }
+        else if (direction == MOTOR_DIR_BACKWARD)
+        {
+            motor_axis_backward(axis);
+        }
+        else
+        {
+            motor_axis_coast(axis);
+        }
+        actuator_dir[axis] = (rt_uint8_t)direction;
+        actuator_writes++;
+    }
+    else
+    {
+        actuator_skips++;
+    }
+
+    if (force || actuator_pulse[axis] != *pulse)
+    {
+        return 1;
+    }
+    actuator_skips++;
+    return 0;
+}
+
+/**
+ * @brief 控制单个轴
+ *        方向和量化后的脉宽都与上次写入相同时不调用驱动
+ * @param axis 轴号 (0 ~ MOTOR_AXIS_NUM-1)
  * @param direction 方向 (0=停止, 1=正转, 2=反转)
  * @param duty 占空比 (0.0 ~ 1.0)
  */
-void motor_control(int motor_id, int direction, float duty)
+void motor_axis_control(int axis, int direction, float duty)
+{
+    rt_uint32_t pulse;
+    int ret;
+
+    if (!MOTOR_AXIS_VALID(axis))
+    {
+        return;
+    }
+
+    ret = motor_actuator_prepare(axis, direction, duty, &pulse);
+    if (ret < 0)
+    {
+        return;
+    }
+    if (ret > 0)
+    {
+        /* PWM 未初始化或写入失败时保持缓存无效, 下次重试 */
+        if (motor_axis_set_pulse(axis, pulse) != RT_EOK)
+        {
+            actuator_valid[axis] = RT_FALSE;
+            return;
+        }
+        actuator_pulse[axis] = pulse;
+        actuator_writes++;
+    }
+
+    actuator_valid[axis] = RT_TRUE;
+}
+
+/**
+ * @brief 同时控制所有轴
+ *        先更新各轴方向引脚, 再把变化的脉宽放在同一个临界区内写入
+ *        (motors_set_pulses), 减小轮间偏差
+ * @param direction 各轴方向, MOTOR_AXIS_NUM 项
+ * @param duty 各轴占空比, MOTOR_AXIS_NUM 项
+ */
+void motors_control_all(const int *direction, const float *duty)
 {
-    if (motor_id == 1)
+    rt_uint32_t pulse[MOTOR_AXIS_NUM];
+    rt_uint32_t mask = 0, valid = 0;
+    int i, ret;
+
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
     {
-        switch (direction)
+        ret = motor_actuator_prepare(i, direction[i], duty[i], &pulse[i]);
+        if (ret < 0)
+        {
+            continue;
+        }
+        valid |= 1U << i;
+        if (ret > 0)
         {
-        case 0:  /* 停止 */
-            motor1_coast();
-            motor1_set_duty(0.0f);
-            break;
-        case 1:  /* 正转 */
-            motor1_forward();
-            motor1_set_duty(duty);
-            break;
-        case 2:  /* 反转 */
-            motor1_backward();
-            motor1_set_duty(duty);
-            break;
-        default:
-            rt_kprintf("[Motor1] Invalid direction: %d\n", direction);
-            break;
+            mask |= 1U << i;
         }
     }
-    else if (motor_id == 2)
+
+    /* 写入失败时无法区分具体通道, 本次写入的轴全部保持缓存无效 */
+    if (mask != 0 && motors_set_pulses(pulse, mask) != RT_EOK)
     {
-        switch (direction)
+        valid &= ~mask;
+        mask = 0;
+    }
+
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
+    {
+        if (mask & (1U << i))
         {
-        case 0:  /* 停止 */
-            motor2_coast();
-            motor2_set_duty(0.0f);
-            break;
-        case 1:  /* 正转 */
-            motor2_forward();
-            motor2_set_duty(duty);
-            break;
-        case 2:  /* 反转 */
-            motor2_backward();
-            motor2_set_duty(duty);
-            break;
-        default:
-            rt_kprintf("[Motor2] Invalid direction: %d\n", direction);
-            break;
+            actuator_pulse[i] = pulse[i];
+            actuator_writes++;
         }
+        actuator_valid[i] = (valid & (1U << i)) ? RT_TRUE : RT_FALSE;
+    }
+}
+
+/**
+ * @brief 控制单个电机
+ * @param motor_id 电机编号 (1 ~ MOTOR_AXIS_NUM)
+ * @param direction 方向 (0=停止, 1=正转, 2=反转)
+ * @param duty 占空比 (0.0 ~ 1.0)
+ */
+void motor_control(int motor_id, int direction, float duty)
+{
+    if (MOTOR_AXIS_VALID(motor_id - 1))
+    {
+        motor_axis_control(motor_id - 1, direction, duty);
     }
 }
 
 /**
  * @brief 解析单个电机的控制指令
  * @param cmd 指令字符串，格式: "1,0.5"
- * @param motor_id 电机编号 (1 或 2)
+ * @param motor_id 电机编号 (1 ~ MOTOR_AXIS_NUM)
  */
 static void parse_motor_cmd(const char *cmd, int motor_id)
 {
@@ -113,16 +279,18 @@ static void parse_motor_cmd(const char *cmd, int motor_id)
  * @param argv 参数列表
  *
  * 用法: motor 1,0.5;2,0.1
+ * 按分号依次对应电机1 ~ 电机N, 缺省的电机保持不变
  */
 static int cmd_motor(int argc, char *argv[])
 {
     char *cmd;
     char *semicolon;
-    char buf[64];
+    char buf[128];
+    int motor_id;
 
     if (argc < 2)
     {
-        rt_kprintf("Usage: motor <dir1,duty1>[;<dir2,duty2>]\n");
+        rt_kprintf("Usage: motor <dir1,duty1>[;<dir2,duty2>...] (up to %d motors)\n", MOTOR_AXIS_NUM);
         rt_kprintf("  dir: 0=stop, 1=forward, 2=backward\n");
         rt_kprintf("  duty: 0.0 ~ 1.0\n");
         rt_kprintf("Example:\n");
@@ -132,29 +300,23 @@ static int cmd_motor(int argc, char *argv[])
         return -1;
     }
 
-    cmd = argv[1];
-
     /* 复制命令到缓冲区 */
-    strncpy(buf, cmd, sizeof(buf) - 1);
+    strncpy(buf, argv[1], sizeof(buf) - 1);
     buf[sizeof(buf) - 1] = '\0';
 
-    /* 查找分号，分隔两个电机的指令 */
-    semicolon = strchr(buf, ';');
-    if (semicolon != RT_NULL)
+    /* 按分号分隔各电机的指令 */
+    cmd = buf;
+    for (motor_id = 1; motor_id <= MOTOR_AXIS_NUM && cmd != RT_NULL; motor_id++)
     {
-        /* 分割字符串 */
-        *semicolon = '\0';
+        semicolon = strchr(cmd, ';');
+        if (semicolon != RT_NULL)
+        {
+            *semicolon = '\0';
+        }
 
-        /* 解析电机1指令 */
-        parse_motor_cmd(buf, 1);
+        parse_motor_cmd(cmd, motor_id);
 
-        /* 解析电机2指令 */
-        parse_motor_cmd(semicolon + 1, 2);
-    }
-    else
-    {
-        /* 只有一个电机的指令，默认控制电机1 */
-        parse_motor_cmd(buf, 1);
+        cmd = (semicolon != RT_NULL) ? semicolon + 1 : RT_NULL;
     }
 
     return 0;
@@ -166,9 +328,40 @@ MSH_CMD_EXPORT(cmd_motor, Control motors);
  */
 static int cmd_motor_stop(int argc, char *argv[])
 {
+    (void)argc;
+    (void)argv;
+
+    /* 绕过缓存直接写驱动, 之后的 motor_control 需要重新写入 */
     motors_coast();
     motors_stop();
+    motor_actuator_invalidate(-1);
     rt_kprintf("All motors stopped.\n");
     return 0;
 }
 MSH_CMD_EXPORT(cmd_motor_stop, Stop all motors);
+
+/**
+ * @brief MSH命令: 查看/设置执行器缓存
+ *        用法: motor_cache [refresh <cycles>|flush]
+ */
+static int cmd_motor_cache(int argc, char *argv[])
+{
+    if (argc >= 3 && rt_strcmp(argv[1], "refresh") == 0)
+    {
+        motor_actuator_set_refresh((rt_uint32_t)atoi(argv[2]));
+    }
+    else if (argc >= 2 && rt_strcmp(argv[1], "flush") == 0)
+    {
+        motor_actuator_invalidate(-1);
+    }
+    else if (argc >= 2)
+    {
+        rt_kprintf("Usage: motor_cache [refresh <cycles>|flush]\n");
+        return -1;
+    }
+
+    rt_kprintf("Actuator cache: refresh=%u cycles, writes=%u, skipped=%u\n",
+               actuator_refresh_cycles, actuator_writes, actuator_skips);
+    return 0;
+}
+MSH_CMD_EXPORT(cmd_motor_cache, Show or set motor actuator cache);
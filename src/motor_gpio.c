@@ -1,26 +1,100 @@
 /*
  * 电机 GPIO 控制模块
  *
- * 提供两个电机的 GPIO 初始化和方向控制接口
+ * 按轴描述表提供电机的 GPIO 初始化和方向控制接口
  * 用于控制电机正转、反转、刹车和滑行
  */
 
 #include <rtthread.h>
 #include <rtdevice.h>
 #include "common.h"
+#include "motor_axis.h"
 #include "motor_gpio.h"
 
+/* ==================== 按轴控制 ==================== */
+
 /**
- * @brief 初始化电机1的GPIO引脚
+ * @brief 初始化一个轴的方向引脚
+ * @param axis 轴号 (0 ~ MOTOR_AXIS_NUM-1)
  */
-void motor1_gpio_init(void)
+void motor_axis_gpio_init(int axis)
 {
-    rt_pin_mode(GPIO_OUTPUT_IO_MOTOR1_0, PIN_MODE_OUTPUT);
-    rt_pin_mode(GPIO_OUTPUT_IO_MOTOR1_1, PIN_MODE_OUTPUT);
+    const struct motor_axis_desc *desc;
+
+    if (!MOTOR_AXIS_VALID(axis))
+    {
+        return;
+    }
+    desc = &motor_axis_table[axis];
+
+    rt_pin_mode(desc->dir_pin0, PIN_MODE_OUTPUT);
+    rt_pin_mode(desc->dir_pin1, PIN_MODE_OUTPUT);
 
     /* 初始化为停止状态 */
-    rt_pin_write(GPIO_OUTPUT_IO_MOTOR1_0, PIN_LOW);
-    rt_pin_write(GPIO_OUTPUT_IO_MOTOR1_1, PIN_LOW);
+    rt_pin_write(desc->dir_pin0, PIN_LOW);
+    rt_pin_write(desc->dir_pin1, PIN_LOW);
+}
+
+/**
+ * @brief 设置一个轴的两个方向引脚电平
+ * @param axis 轴号
+ * @param pin0_level GPIO_0引脚电平 (0: LOW, 非0: HIGH)
+ * @param pin1_level GPIO_1引脚电平 (0: LOW, 非0: HIGH)
+ */
+void motor_axis_set_pins(int axis, rt_uint8_t pin0_level, rt_uint8_t pin1_level)
+{
+    const struct motor_axis_desc *desc;
+
+    if (!MOTOR_AXIS_VALID(axis))
+    {
+        return;
+    }
+    desc = &motor_axis_table[axis];
+
+    rt_pin_write(desc->dir_pin0, pin0_level ? PIN_HIGH : PIN_LOW);
+    rt_pin_write(desc->dir_pin1, pin1_level ? PIN_HIGH : PIN_LOW);
+}
+
+/**
+ * @brief 正转 (pin0=HIGH, pin1=LOW)
+ */
+void motor_axis_forward(int axis)
+{
+    motor_axis_set_pins(axis, 1, 0);
+}
+
+/**
+ * @brief 反转 (pin0=LOW, pin1=HIGH)
+ */
+void motor_axis_backward(int axis)
+{
+    motor_axis_set_pins(axis, 0, 1);
+}
+
+/**
+ * @brief 刹车 (pin0=HIGH, pin1=HIGH)
+ */
+void motor_axis_brake(int axis)
+{
+    motor_axis_set_pins(axis, 1, 1);
+}
+
+/**
+ * @brief 滑行/停止 (pin0=LOW, pin1=LOW)
+ */
+void motor_axis_coast(int axis)
+{
+    motor_axis_set_pins(axis, 0, 0);
+}
+
+/* ==================== 初始化函数 ==================== */
+
+/**
+ * @brief 初始化电机1的GPIO引脚
+ */
+void motor1_gpio_init(void)
+{
+    motor_axis_gpio_init(0);
 }
 
 /**
@@ -28,25 +102,24 @@ void motor1_gpio_init(void)
  */
 void motor2_gpio_init(void)
 {
-    rt_pin_mode(GPIO_OUTPUT_IO_MOTOR2_0, PIN_MODE_OUTPUT);
-    rt_pin_mode(GPIO_OUTPUT_IO_MOTOR2_1, PIN_MODE_OUTPUT);
-
-    /* 初始化为停止状态 */
-    rt_pin_write(GPIO_OUTPUT_IO_MOTOR2_0, PIN_LOW);
-    rt_pin_write(GPIO_OUTPUT_IO_MOTOR2_1, PIN_LOW);
+    motor_axis_gpio_init(1);
 }
 
 /**
- * @brief 初始化两个电机的GPIO引脚
+ * @brief 初始化所有电机的GPIO引脚
  */
 void motors_gpio_init(void)
 {
-    motor1_gpio_init();
-    motor2_gpio_init();
-    rt_kprintf("[Motors] GPIO initialized.\n");
+    int i;
+
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
+    {
+        motor_axis_gpio_init(i);
+    }
+    rt_kprintf("[Motors] GPIO initialized (%d axes).\n", MOTOR_AXIS_NUM);
 }
 
-/* ==================== 电机1 GPIO 控制 ==================== */
+/* ==================== 电机1 GPIO 控制 (兼容接口, 轴 0) ==================== */
 
 /**
  * @brief 设置电机1的GPIO_0引脚电平
@@ -54,7 +127,7 @@ void motors_gpio_init(void)
  */
 void motor1_set_pin0(rt_uint8_t level)
 {
-    rt_pin_write(GPIO_OUTPUT_IO_MOTOR1_0, level ? PIN_HIGH : PIN_LOW);
+    rt_pin_write(motor_axis_table[0].dir_pin0, level ? PIN_HIGH : PIN_LOW);
 }
 
 /**
@@ -63,53 +136,38 @@ void motor1_set_pin0(rt_uint8_t level)
  */
 void motor1_set_pin1(rt_uint8_t level)
 {
-    rt_pin_write(GPIO_OUTPUT_IO_MOTOR1_1, level ? PIN_HIGH : PIN_LOW);
+    rt_pin_write(motor_axis_table[0].dir_pin1, level ? PIN_HIGH : PIN_LOW);
 }
 
 /**
  * @brief 设置电机1的两个引脚电平
- * @param pin0_level GPIO_0引脚电平 (0: LOW, 非0: HIGH)
- * @param pin1_level GPIO_1引脚电平 (0: LOW, 非0: HIGH)
  */
 void motor1_set_pins(rt_uint8_t pin0_level, rt_uint8_t pin1_level)
 {
-    rt_pin_write(GPIO_OUTPUT_IO_MOTOR1_0, pin0_level ? PIN_HIGH : PIN_LOW);
-    rt_pin_write(GPIO_OUTPUT_IO_MOTOR1_1, pin1_level ? PIN_HIGH : PIN_LOW);
+    motor_axis_set_pins(0, pin0_level, pin1_level);
 }
 
-/**
- * @brief 电机1正转 (pin0=HIGH, pin1=LOW)
- */
 void motor1_forward(void)
 {
-    motor1_set_pins(1, 0);
+    motor_axis_forward(0);
 }
 
-/**
- * @brief 电机1反转 (pin0=LOW, pin1=HIGH)
- */
 void motor1_backward(void)
 {
-    motor1_set_pins(0, 1);
+    motor_axis_backward(0);
 }
 
-/**
- * @brief 电机1刹车 (pin0=HIGH, pin1=HIGH)
- */
 void motor1_brake(void)
 {
-    motor1_set_pins(1, 1);
+    motor_axis_brake(0);
 }
 
-/**
- * @brief 电机1滑行/停止 (pin0=LOW, pin1=LOW)
- */
 void motor1_coast(void)
 {
-    motor1_set_pins(0, 0);
+    motor_axis_coast(0);
 }
 
-/* ==================== 电机2 GPIO 控制 ==================== */
+/* ==================== 电机2 GPIO 控制 (兼容接口, 轴 1) ==================== */
 
 /**
  * @brief 设置电机2的GPIO_0引脚电平
@@ -117,7 +175,7 @@ void motor1_coast(void)
  */
 void motor2_set_pin0(rt_uint8_t level)
 {
-    rt_pin_write(GPIO_OUTPUT_IO_MOTOR2_0, level ? PIN_HIGH : PIN_LOW);
+    rt_pin_write(motor_axis_table[1].dir_pin0, level ? PIN_HIGH : PIN_LOW);
 }
 
 /**
@@ -126,86 +184,87 @@ void motor2_set_pin0(rt_uint8_t level)
  */
 void motor2_set_pin1(rt_uint8_t level)
 {
-    rt_pin_write(GPIO_OUTPUT_IO_MOTOR2_1, level ? PIN_HIGH : PIN_LOW);
+    rt_pin_write(motor_axis_table[1].dir_pin1, level ? PIN_HIGH : PIN_LOW);
 }
 
 /**
  * @brief 设置电机2的两个引脚电平
- * @param pin0_level GPIO_0引脚电平 (0: LOW, 非0: HIGH)
- * @param pin1_level GPIO_1引脚电平 (0: LOW, 非0: HIGH)
  */
 void motor2_set_pins(rt_uint8_t pin0_level, rt_uint8_t pin1_level)
 {
-    rt_pin_write(GPIO_OUTPUT_IO_MOTOR2_0, pin0_level ? PIN_HIGH : PIN_LOW);
-    rt_pin_write(GPIO_OUTPUT_IO_MOTOR2_1, pin1_level ? PIN_HIGH : PIN_LOW);
+    motor_axis_set_pins(1, pin0_level, pin1_level);
 }
 
-/**
- * @brief 电机2正转 (pin0=HIGH, pin1=LOW)
- */
 void motor2_forward(void)
 {
-    motor2_set_pins(1, 0);
+    motor_axis_forward(1);
 }
 
-/**
- * @brief 电机2反转 (pin0=LOW, pin1=HIGH)
- */
 void motor2_backward(void)
 {
-    motor2_set_pins(0, 1);
+    motor_axis_backward(1);
 }
 
-/**
- * @brief 电机2刹车 (pin0=HIGH, pin1=HIGH)
- */
 void motor2_brake(void)
 {
-    motor2_set_pins(1, 1);
+    motor_axis_brake(1);
 }
 
-/**
- * @brief 电机2滑行/停止 (pin0=LOW, pin1=LOW)
- */
 void motor2_coast(void)
 {
-    motor2_set_pins(0, 0);
+    motor_axis_coast(1);
 }
 
-/* ==================== 两个电机同时控制 ==================== */
+/* ==================== 所有电机同时控制 ==================== */
 
 /**
- * @brief 两个电机同时正转
+ * @brief 所有电机同时正转
  */
 void motors_forward(void)
 {
-    motor1_forward();
-    motor2_forward();
+    int i;
+
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
+    {
+        motor_axis_forward(i);
+    }
 }
 
 /**
- * @brief 两个电机同时反转
+ * @brief 所有电机同时反转
  */
 void motors_backward(void)
 {
-    motor1_backward();
-    motor2_backward();
+    int i;
+
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
+    {
+        motor_axis_backward(i);
+    }
 }
 
 /**
- * @brief 两个电机同时刹车
+ * @brief 所有电机同时刹车
  */
 void motors_brake(void)
 {
-    motor1_brake();
-    motor2_brake();
+    int i;
+
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
+    {
+        motor_axis_brake(i);
+    }
 }
 
 /**
- * @brief 两个电机同时滑行/停止
+ * @brief 所有电机同时滑行/停止
  */
 void motors_coast(void)
 {
-    motor1_coast();
-    motor2_coast();
+    int i;
+
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
+    {
+        motor_axis_coast(i);
+    }
 }
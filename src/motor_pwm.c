@@ -1,139 +1,110 @@
 /*
  * 电机 PWM 控制模块
  *
- * 提供两个电机的 PWM 初始化和占空比设置接口
+ * 按轴描述表提供电机的 PWM 初始化和占空比设置接口
  */
 
 #include <rtthread.h>
 #include <rtdevice.h>
 #include <drivers/rt_drv_pwm.h>
 #include "common.h"
+#include "hrtime.h"
+#include "motor_axis.h"
 #include "motor_pwm.h"
 
-/* PWM 设备句柄 */
-static struct rt_device_pwm *pwm_dev_motor1 = RT_NULL;
-static struct rt_device_pwm *pwm_dev_motor2 = RT_NULL;
+/* PWM 设备句柄 (按轴下标, RT_NULL 表示未初始化) */
+static struct rt_device_pwm *pwm_dev[MOTOR_AXIS_NUM];
 
-/* 初始化标志 */
-static rt_bool_t motor1_pwm_initialized = RT_FALSE;
-static rt_bool_t motor2_pwm_initialized = RT_FALSE;
+/* 同步更新统计 (hrtime 计数, 由 motors_set_pulses 写, MSH 读) */
+static rt_uint32_t pwm_sync_count = 0;
+static rt_uint64_t pwm_sync_last_latency = 0;
+static rt_uint64_t pwm_sync_max_latency = 0;
+static rt_uint64_t pwm_sync_last_skew = 0;
+static rt_uint64_t pwm_sync_max_skew = 0;
 
 /**
- * @brief 初始化电机1的PWM
+ * @brief 初始化一个轴的PWM
+ * @param axis 轴号 (0 ~ MOTOR_AXIS_NUM-1)
  * @return RT_EOK 成功, 其他值表示失败
  */
-rt_err_t motor1_pwm_init(void)
+rt_err_t motor_axis_pwm_init(int axis)
 {
+    const struct motor_axis_desc *desc;
+    struct rt_device_pwm *dev;
     rt_err_t ret;
 
-    if (motor1_pwm_initialized)
+    if (!MOTOR_AXIS_VALID(axis))
+    {
+        return -RT_EINVAL;
+    }
+    if (pwm_dev[axis] != RT_NULL)
     {
         return RT_EOK;
     }
+    desc = &motor_axis_table[axis];
 
     /* 查找PWM设备 */
-    pwm_dev_motor1 = (struct rt_device_pwm *)rt_device_find(PWM_DEV_NAME_MOTOR_1);
-    if (pwm_dev_motor1 == RT_NULL)
+    dev = (struct rt_device_pwm *)rt_device_find(desc->pwm_dev);
+    if (dev == RT_NULL)
     {
-        rt_kprintf("[Motor1] PWM device '%s' not found!\n", PWM_DEV_NAME_MOTOR_1);
+        rt_kprintf("[Motor%d] PWM device '%s' not found!\n", axis + 1, desc->pwm_dev);
         return -RT_ENOSYS;
     }
-    rt_kprintf("[Motor1] PWM device '%s' found.\n", PWM_DEV_NAME_MOTOR_1);
+    rt_kprintf("[Motor%d] PWM device '%s' found.\n", axis + 1, desc->pwm_dev);
 
     /* 设置初始PWM参数，占空比为0 */
-    ret = rt_pwm_set(pwm_dev_motor1, PWM_CHANNEL, PWM_PERIOD, 0);
+    ret = rt_pwm_set(dev, desc->pwm_channel, PWM_PERIOD, 0);
     if (ret != RT_EOK)
     {
-        rt_kprintf("[Motor1] Failed to set PWM parameters! (err=%d)\n", ret);
+        rt_kprintf("[Motor%d] Failed to set PWM parameters! (err=%d)\n", axis + 1, ret);
         return ret;
     }
 
     /* 启用PWM */
-    ret = rt_pwm_enable(pwm_dev_motor1, PWM_CHANNEL);
+    ret = rt_pwm_enable(dev, desc->pwm_channel);
     if (ret != RT_EOK)
     {
-        rt_kprintf("[Motor1] Failed to enable PWM! (err=%d)\n", ret);
+        rt_kprintf("[Motor%d] Failed to enable PWM! (err=%d)\n", axis + 1, ret);
         return ret;
     }
 
-    motor1_pwm_initialized = RT_TRUE;
-    rt_kprintf("[Motor1] PWM initialized successfully.\n");
+    pwm_dev[axis] = dev;
+    rt_kprintf("[Motor%d] PWM initialized successfully.\n", axis + 1);
     return RT_EOK;
 }
 
 /**
- * @brief 初始化电机2的PWM
+ * @brief 设置一个轴的原始脉冲宽度
+ * @param axis 轴号
+ * @param pulse_ns 脉冲宽度 (纳秒), 0 ~ PWM_PERIOD
  * @return RT_EOK 成功, 其他值表示失败
  */
-rt_err_t motor2_pwm_init(void)
+rt_err_t motor_axis_set_pulse(int axis, rt_uint32_t pulse_ns)
 {
-    rt_err_t ret;
-
-    if (motor2_pwm_initialized)
-    {
-        return RT_EOK;
-    }
-
-    /* 查找PWM设备 */
-    pwm_dev_motor2 = (struct rt_device_pwm *)rt_device_find(PWM_DEV_NAME_MOTOR_2);
-    if (pwm_dev_motor2 == RT_NULL)
-    {
-        rt_kprintf("[Motor2] PWM device '%s' not found!\n", PWM_DEV_NAME_MOTOR_2);
-        return -RT_ENOSYS;
-    }
-    rt_kprintf("[Motor2] PWM device '%s' found.\n", PWM_DEV_NAME_MOTOR_2);
-
-    /* 设置初始PWM参数，占空比为0 */
-    ret = rt_pwm_set(pwm_dev_motor2, PWM_CHANNEL, PWM_PERIOD, 0);
-    if (ret != RT_EOK)
+    if (!MOTOR_AXIS_VALID(axis) || pwm_dev[axis] == RT_NULL)
     {
-        rt_kprintf("[Motor2] Failed to set PWM parameters! (err=%d)\n", ret);
-        return ret;
+        return -RT_ERROR;
     }
 
-    /* 启用PWM */
-    ret = rt_pwm_enable(pwm_dev_motor2, PWM_CHANNEL);
-    if (ret != RT_EOK)
+    if (pulse_ns > PWM_PERIOD)
     {
-        rt_kprintf("[Motor2] Failed to enable PWM! (err=%d)\n", ret);
-        return ret;
+        pulse_ns = PWM_PERIOD;
     }
 
-    motor2_pwm_initialized = RT_TRUE;
-    rt_kprintf("[Motor2] PWM initialized successfully.\n");
-    return RT_EOK;
-}
-
-/**
- * @brief 初始化两个电机的PWM
- * @return RT_EOK 成功, 其他值表示失败
- */
-rt_err_t motors_pwm_init(void)
-{
-    rt_err_t ret1, ret2;
-
-    ret1 = motor1_pwm_init();
-    ret2 = motor2_pwm_init();
-
-    if (ret1 != RT_EOK || ret2 != RT_EOK)
-    {
-        return -RT_ERROR;
-    }
-    return RT_EOK;
+    return rt_pwm_set(pwm_dev[axis], motor_axis_table[axis].pwm_channel, PWM_PERIOD, pulse_ns);
 }
 
 /**
- * @brief 设置电机1的占空比
+ * @brief 设置一个轴的占空比
+ * @param axis 轴号
  * @param duty 占空比 (0.0 ~ 1.0)
  * @return RT_EOK 成功, 其他值表示失败
  */
-rt_err_t motor1_set_duty(float duty)
+rt_err_t motor_axis_set_duty(int axis, float duty)
 {
-    rt_uint32_t pulse;
-
-    if (!motor1_pwm_initialized || pwm_dev_motor1 == RT_NULL)
+    if (!MOTOR_AXIS_VALID(axis) || pwm_dev[axis] == RT_NULL)
     {
-        rt_kprintf("[Motor1] PWM not initialized!\n");
+        rt_kprintf("[Motor%d] PWM not initialized!\n", axis + 1);
         return -RT_ERROR;
     }
 
@@ -148,107 +119,231 @@ rt_err_t motor1_set_duty(float duty)
     }
 
     /* 计算脉冲宽度 (ns) */
-    pulse = (rt_uint32_t)(PWM_PERIOD * duty);
-
-    return rt_pwm_set(pwm_dev_motor1, PWM_CHANNEL, PWM_PERIOD, pulse);
+    return motor_axis_set_pulse(axis, (rt_uint32_t)(PWM_PERIOD * duty));
 }
 
 /**
- * @brief 设置电机2的占空比
- * @param duty 占空比 (0.0 ~ 1.0)
+ * @brief 停止一个轴 (占空比设为0)
  * @return RT_EOK 成功, 其他值表示失败
  */
-rt_err_t motor2_set_duty(float duty)
+rt_err_t motor_axis_stop(int axis)
+{
+    return motor_axis_set_duty(axis, 0);
+}
+
+/* ==================== 多轴同步更新 ==================== */
+
+/**
+ * @brief 在同一个临界区内写入多个轴的脉宽
+ *        锁调度器期间连续调用 rt_pwm_set, 各轴之间不会被其他线程插入;
+ *        rt_pwm_set 经过设备驱动, 驱动内部可能加锁, 不能在关中断期间调用,
+ *        中断仍可能插入, 由 skew 统计反映;
+ *        RT-Thread PWM 框架没有影子寄存器/同步装载接口, 新脉宽由控制器
+ *        在各自周期结束时装载, 最坏再晚一个 PWM_PERIOD 生效
+ * @param pulse_ns 各轴脉宽 (纳秒), MOTOR_AXIS_NUM 项
+ * @param mask 需要写入的轴 (bit i 对应轴 i)
+ * @return RT_EOK 成功, 任一轴失败返回 -RT_ERROR
+ */
+rt_err_t motors_set_pulses(const rt_uint32_t *pulse_ns, rt_uint32_t mask)
 {
+    rt_uint64_t t_enter, t_first = 0, t_last = 0;
+    rt_uint64_t latency, skew;
+    rt_err_t ret = RT_EOK;
     rt_uint32_t pulse;
+    int i, written = 0;
+
+    t_enter = hrtime_now();
 
-    if (!motor2_pwm_initialized || pwm_dev_motor2 == RT_NULL)
+    rt_enter_critical();
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
     {
-        rt_kprintf("[Motor2] PWM not initialized!\n");
-        return -RT_ERROR;
+        if (!(mask & (1U << i)))
+        {
+            continue;
+        }
+        if (pwm_dev[i] == RT_NULL)
+        {
+            ret = -RT_ERROR;
+            continue;
+        }
+
+        pulse = pulse_ns[i] > PWM_PERIOD ? PWM_PERIOD : pulse_ns[i];
+        if (rt_pwm_set(pwm_dev[i], motor_axis_table[i].pwm_channel, PWM_PERIOD, pulse) != RT_EOK)
+        {
+            ret = -RT_ERROR;
+        }
+
+        t_last = hrtime_now();
+        if (written++ == 0)
+        {
+            t_first = t_last;
+        }
     }
+    rt_exit_critical();
 
-    /* 限制占空比范围 */
-    if (duty < 0.0f)
+    if (written == 0)
     {
-        duty = 0.0f;
+        return ret;
     }
-    else if (duty > 1.0f)
+
+    /* 延迟: 调用到最后一个通道写入完成; 偏差: 第一个到最后一个通道写入完成 */
+    latency = t_last - t_enter;
+    skew = t_last - t_first;
+    pwm_sync_count++;
+    pwm_sync_last_latency = latency;
+    pwm_sync_last_skew = skew;
+    if (latency > pwm_sync_max_latency)
     {
-        duty = 1.0f;
+        pwm_sync_max_latency = latency;
+    }
+    if (skew > pwm_sync_max_skew)
+    {
+        pwm_sync_max_skew = skew;
     }
 
-    /* 计算脉冲宽度 (ns) */
-    pulse = (rt_uint32_t)(PWM_PERIOD * duty);
-
-    return rt_pwm_set(pwm_dev_motor2, PWM_CHANNEL, PWM_PERIOD, pulse);
+    return ret;
 }
 
 /**
- * @brief 设置电机1的原始脉冲宽度
- * @param pulse_ns 脉冲宽度 (纳秒), 0 ~ PWM_PERIOD
+ * @brief 同步设置电机1/电机2的占空比
  * @return RT_EOK 成功, 其他值表示失败
  */
-rt_err_t motor1_set_pulse(rt_uint32_t pulse_ns)
+rt_err_t motors_set_duty_pair(float duty1, float duty2)
 {
-    if (!motor1_pwm_initialized || pwm_dev_motor1 == RT_NULL)
-    {
-        return -RT_ERROR;
-    }
+    rt_uint32_t pulse[MOTOR_AXIS_NUM] = {0};
+    float duty[2];
+    int i;
 
-    if (pulse_ns > PWM_PERIOD)
+    duty[0] = duty1;
+    duty[1] = duty2;
+    for (i = 0; i < 2; i++)
     {
-        pulse_ns = PWM_PERIOD;
+        if (duty[i] < 0.0f)
+        {
+            duty[i] = 0.0f;
+        }
+        else if (duty[i] > 1.0f)
+        {
+            duty[i] = 1.0f;
+        }
+        pulse[i] = (rt_uint32_t)(PWM_PERIOD * duty[i]);
     }
 
-    return rt_pwm_set(pwm_dev_motor1, PWM_CHANNEL, PWM_PERIOD, pulse_ns);
+    return motors_set_pulses(pulse, 0x3);
 }
 
 /**
- * @brief 设置电机2的原始脉冲宽度
- * @param pulse_ns 脉冲宽度 (纳秒), 0 ~ PWM_PERIOD
- * @return RT_EOK 成功, 其他值表示失败
+ * @brief 获取同步更新统计
  */
-rt_err_t motor2_set_pulse(rt_uint32_t pulse_ns)
+void motors_pwm_get_sync_stats(struct motor_pwm_sync_stats *out)
 {
-    if (!motor2_pwm_initialized || pwm_dev_motor2 == RT_NULL)
-    {
-        return -RT_ERROR;
-    }
+    out->count = pwm_sync_count;
+    out->last_latency_ns = (rt_uint32_t)(hrtime_to_sec(pwm_sync_last_latency) * 1e9f);
+    out->max_latency_ns = (rt_uint32_t)(hrtime_to_sec(pwm_sync_max_latency) * 1e9f);
+    out->last_skew_ns = (rt_uint32_t)(hrtime_to_sec(pwm_sync_last_skew) * 1e9f);
+    out->max_skew_ns = (rt_uint32_t)(hrtime_to_sec(pwm_sync_max_skew) * 1e9f);
+}
 
-    if (pulse_ns > PWM_PERIOD)
-    {
-        pulse_ns = PWM_PERIOD;
-    }
+/* ==================== 兼容接口 (电机1 = 轴 0, 电机2 = 轴 1) ==================== */
+
+rt_err_t motor1_pwm_init(void)
+{
+    return motor_axis_pwm_init(0);
+}
 
-    return rt_pwm_set(pwm_dev_motor2, PWM_CHANNEL, PWM_PERIOD, pulse_ns);
+rt_err_t motor2_pwm_init(void)
+{
+    return motor_axis_pwm_init(1);
 }
 
 /**
- * @brief 停止电机1 (占空比设为0)
+ * @brief 初始化所有电机的PWM
  * @return RT_EOK 成功, 其他值表示失败
  */
+rt_err_t motors_pwm_init(void)
+{
+    rt_err_t ret = RT_EOK;
+    int i;
+
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
+    {
+        if (motor_axis_pwm_init(i) != RT_EOK)
+        {
+            ret = -RT_ERROR;
+        }
+    }
+    return ret;
+}
+
+rt_err_t motor1_set_duty(float duty)
+{
+    return motor_axis_set_duty(0, duty);
+}
+
+rt_err_t motor2_set_duty(float duty)
+{
+    return motor_axis_set_duty(1, duty);
+}
+
+rt_err_t motor1_set_pulse(rt_uint32_t pulse_ns)
+{
+    return motor_axis_set_pulse(0, pulse_ns);
+}
+
+rt_err_t motor2_set_pulse(rt_uint32_t pulse_ns)
+{
+    return motor_axis_set_pulse(1, pulse_ns);
+}
+
 rt_err_t motor1_stop(void)
 {
-    return motor1_set_duty(0);
+    return motor_axis_stop(0);
 }
 
-/**
- * @brief 停止电机2 (占空比设为0)
- * @return RT_EOK 成功, 其他值表示失败
- */
 rt_err_t motor2_stop(void)
 {
-    return motor2_set_duty(0);
+    return motor_axis_stop(1);
 }
 
 /**
- * @brief 停止两个电机
+ * @brief 停止所有电机
  * @return RT_EOK 成功, 其他值表示失败
  */
 rt_err_t motors_stop(void)
 {
-    motor1_stop();
-    motor2_stop();
+    int i;
+
+    for (i = 0; i < MOTOR_AXIS_NUM; i++)
+    {
+        motor_axis_stop(i);
+    }
     return RT_EOK;
 }
+
+/* ================= 调试用 MSH 命令 ================= */
+
+/**
+ * @brief MSH 命令: 查看同步更新延迟
+ *        用法: pwm_sync [reset]
+ */
+static void pwm_sync_cmd(int argc, char *argv[])
+{
+    struct motor_pwm_sync_stats stats;
+
+    if (argc >= 2 && rt_strcmp(argv[1], "reset") == 0)
+    {
+        rt_base_t level = rt_hw_interrupt_disable();
+        pwm_sync_count = 0;
+        pwm_sync_max_latency = 0;
+        pwm_sync_max_skew = 0;
+        rt_hw_interrupt_enable(level);
+    }
+
+    motors_pwm_get_sync_stats(&stats);
+    rt_kprintf("PWM sync: updates=%u, latency=%u/%u ns (last/max), skew=%u/%u ns (last/max)\n",
+               stats.count, stats.last_latency_ns, stats.max_latency_ns,
+               stats.last_skew_ns, stats.max_skew_ns);
+    rt_kprintf("  new pulse takes effect at the end of the running period (+%u ns worst case)\n",
+               (rt_uint32_t)PWM_PERIOD);
+}
+MSH_CMD_EXPORT_ALIAS(pwm_sync_cmd, pwm_sync, Show synchronized PWM update latency);
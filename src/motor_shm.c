@@ -0,0 +1,141 @@
+/*
+ * 大小核共享内存状态块
+ *
+ * 只有底盘控制线程写入; 写入期间关中断, 同核上的 MSH 读端不会看到奇数 seq 后自旋.
+ *
+ * 状态块所在内存对大核不带缓存一致性时 (RT_USING_CACHE), 96 字节跨两个缓存行,
+ * 行 0 是头部 (含 seq) 和 state 前 48 字节. 写回只保证每一行完整, 不保证行之间的
+ * 先后, 并且脏行随时可能被替换出去, 所以按下面的顺序写入并逐步写回:
+ *   1. seq 置为奇数, 写回行 0 -> 大核在任何 state 数据到达内存之前看到奇数 seq
+ *   2. 写 state, 写回整个状态块 -> 新 state 全部到达内存, seq 仍为奇数
+ *   3. seq 置为偶数, 写回行 0
+ * 第 2 步之前行 0 被替换出去只会提前写入奇数 seq; 偶数 seq 只能在第 3 步到达内存,
+ * 此时其余各行已经写回, 大核读到偶数 seq 时 state 完整
+ */
+
+#include <rtthread.h>
+#include "common.h"
+#include "hrtime.h"
+#include "motor_shm.h"
+
+#ifdef MOTOR_SHM_BASE_ADDR
+#define motor_shm_block_ptr ((struct motor_shm_block *)(rt_ubase_t)(MOTOR_SHM_BASE_ADDR))
+#else
+/* 按缓存行对齐, 写回时不影响相邻变量 */
+static struct motor_shm_block motor_shm_static __attribute__((aligned(64)));
+#define motor_shm_block_ptr (&motor_shm_static)
+#endif
+
+static volatile struct motor_shm_block *const motor_shm = motor_shm_block_ptr;
+
+#ifndef MOTOR_SHM_CACHE_LINE
+#define MOTOR_SHM_CACHE_LINE 64
+#endif
+
+/* seq 所在缓存行只能是第一行 */
+typedef char motor_shm_seq_line_check
+    [(offsetof(struct motor_shm_block, seq) + sizeof(rt_uint32_t) <= MOTOR_SHM_CACHE_LINE) ? 1 : -1];
+
+/* 发布耗时统计 (MSH 查看) */
+static rt_uint32_t motor_shm_publish_max_us = 0;
+
+/**
+ * @brief 把状态块的前 size 字节写回内存, 大核 mmap 的是不带缓存的映射
+ *        (MOTOR_SHM_BASE_ADDR 须按缓存行对齐)
+ */
+static void motor_shm_flush(rt_uint32_t size)
+{
+#ifdef RT_USING_CACHE
+    rt_hw_cpu_dcache_ops(RT_HW_CACHE_FLUSH, (void *)motor_shm, size);
+    __sync_synchronize();
+#else
+    (void)size;
+#endif
+}
+
+void motor_shm_init(void)
+{
+    rt_memset((void *)motor_shm, 0, sizeof(*motor_shm));
+    motor_shm->version = MOTOR_SHM_VERSION;
+    motor_shm->state_size = sizeof(struct motor_shm_state);
+    __sync_synchronize();
+    /* magic 最后写入, 大核看到 magic 时头部已完整 */
+    motor_shm->magic = MOTOR_SHM_MAGIC;
+    motor_shm_flush(sizeof(*motor_shm));
+
+    rt_kprintf("[motor_shm] Status block at 0x%08x (phys 0x%08x), %d bytes\n",
+               (rt_uint32_t)(rt_ubase_t)motor_shm, (rt_uint32_t)motor_shm_get_phys_addr(),
+               (int)sizeof(*motor_shm));
+}
+
+void motor_shm_publish(const struct motor_shm_state *state)
+{
+    rt_uint64_t start = hrtime_now();
+    rt_uint32_t us;
+    rt_base_t level;
+
+    /* 写入顺序见文件头部 */
+    level = rt_hw_interrupt_disable();
+    motor_shm->seq++;
+    __sync_synchronize();
+    motor_shm_flush(MOTOR_SHM_CACHE_LINE);
+    rt_memcpy((void *)&motor_shm->state, state, sizeof(*state));
+    __sync_synchronize();
+    motor_shm_flush(sizeof(*motor_shm));
+    motor_shm->seq++;
+    __sync_synchronize();
+    motor_shm_flush(MOTOR_SHM_CACHE_LINE);
+    rt_hw_interrupt_enable(level);
+
+    us = hrtime_to_us(hrtime_now() - start);
+    if (us > motor_shm_publish_max_us)
+    {
+        motor_shm_publish_max_us = us;
+    }
+}
+
+uint64_t motor_shm_get_phys_addr(void)
+{
+    return (uint64_t)(rt_ubase_t)motor_shm + MOTOR_SHM_PHYS_OFFSET;
+}
+
+/* ================= 调试用 MSH 命令 ================= */
+
+/**
+ * @brief MSH 命令: 查看共享内存状态块
+ *        用法: shm
+ */
+static void shm_cmd(int argc, char *argv[])
+{
+    struct motor_shm_state state;
+    rt_uint32_t seq;
+    int ch;
+
+    (void)argc;
+    (void)argv;
+
+    seq = motor_shm->seq;
+    if (motor_shm_read(motor_shm, &state, 16) != 0)
+    {
+        rt_kprintf("Status block busy (seq=%u)\n", seq);
+        return;
+    }
+
+    rt_kprintf("Status block: phys=0x%08x%08x, size=%d, seq=%u, publish max=%uus\n",
+               (rt_uint32_t)(motor_shm_get_phys_addr() >> 32),
+               (rt_uint32_t)motor_shm_get_phys_addr(), (int)sizeof(*motor_shm), seq,
+               motor_shm_publish_max_us);
+    rt_kprintf("  tick=%u, t=%uus, flags=0x%08x, overruns=%u, cmd_seq=%u\n", state.tick,
+               state.timestamp_us, state.flags, state.overruns, state.cmd_seq);
+    rt_kprintf("  pose: x=%d mm, y=%d mm, yaw=%d mrad, v=%d mm/s, w=%d mrad/s\n",
+               state.x_mm, state.y_mm, state.yaw_urad / 1000, state.v_mmps,
+               state.w_mradps);
+    for (ch = 0; ch < MOTOR_PROTO_WHEELS; ch++)
+    {
+        rt_kprintf("  ch%d: set=%d mr/s, meas=%d mr/s, duty=%d, pid=%d/%d/%d (1e-4)\n", ch,
+                   state.wheel[ch].setpoint_mrs, state.wheel[ch].speed_mrs,
+                   state.wheel[ch].duty, state.wheel[ch].p_out, state.wheel[ch].i_out,
+                   state.wheel[ch].d_out);
+    }
+}
+MSH_CMD_EXPORT_ALIAS(shm_cmd, shm, Show shared memory status block);
@@ -21,70 +21,121 @@ void PID_Controller_Init(PID_Controller *pid,
     pid->last_err = 0;
     pid->integral = 0;
     pid->output = 0;
+
+    /* 可选项默认关闭 */
+    pid->aw_mode = PID_AW_NONE;
+    pid->aw_kb = 0;
+    pid->d_on_meas = 0;
+    pid->d_alpha = 1.0f;
+    pid->slew_step = 0;
+    pid->last_feedback = 0;
+    pid->d_filt = 0;
 }
 
-// 普通PID
-float PID_Update(PID_Controller *pid, float feedback)
+void PID_Set_AntiWindup(PID_Controller *pid, int mode, float kb)
 {
-    pid->feedback = feedback;
-    pid->err = pid->setpoint - feedback;
-
-    /* P */
-    pid->p_out = pid->kp * pid->err;
-
-    /* I（积分分离 + 限幅） */
-    pid->integral += pid->err * pid->dt;
-    if(pid->integral > pid->i_limit)  pid->integral = pid->i_limit;
-    if(pid->integral < -pid->i_limit) pid->integral = -pid->i_limit;
-    pid->i_out = pid->ki * pid->integral;
-
-    /* D */
-    pid->d_out = pid->kd * (pid->err - pid->last_err) / pid->dt;
-
-    pid->output = pid->p_out + pid->i_out + pid->d_out;
-
-    /* 输出限幅 */
-    if(pid->output > pid->out_limit)  pid->output = pid->out_limit;
-    if(pid->output < -pid->out_limit) pid->output = pid->out_limit;
+    pid->aw_mode = mode;
+    if(kb <= 0 && pid->kp > 0) kb = pid->ki / pid->kp;
+    pid->aw_kb = kb > 0 ? kb : 0;
+}
 
-    pid->last_err = pid->err;
-	
-	if (pid->output < 0) pid->output = 0;
+void PID_Set_Derivative(PID_Controller *pid, int on_measurement, float filter_tau)
+{
+    pid->d_on_meas = on_measurement;
+    pid->d_alpha = filter_tau > 0 ? pid->dt / (filter_tau + pid->dt) : 1.0f;
+    pid->d_filt = 0;
+}
 
-    return pid->output;
+void PID_Set_Slew(PID_Controller *pid, float rate)
+{
+    pid->slew_step = rate > 0 ? rate * pid->dt : 0;
 }
 
-// 前馈 + PID
-float PID_FF_Update(PID_Controller *pid, float feedback, float pwm_ff)
+/* P + I + D + 前馈, 不含输出限幅 */
+static float pid_terms(PID_Controller *pid, float feedback, float pwm_ff)
 {
+    float d_raw, integral, out;
+
     pid->feedback = feedback;
     pid->err = pid->setpoint - feedback;
 
-    /* ---------- PID 计算 ---------- */
     /* P */
     pid->p_out = pid->kp * pid->err;
 
-    /* I（积分分离 + 限幅） */
-    pid->integral += pid->err * pid->dt;
-    if(pid->integral > pid->i_limit)  pid->integral = pid->i_limit;
-    if(pid->integral < -pid->i_limit) pid->integral = -pid->i_limit;
+    /* D (误差或测量值的变化率, 可选低通) */
+    if(pid->d_on_meas)
+        d_raw = (pid->last_feedback - feedback) / pid->dt;
+    else
+        d_raw = (pid->err - pid->last_err) / pid->dt;
+    if(pid->d_alpha < 1.0f)
+        pid->d_filt += pid->d_alpha * (d_raw - pid->d_filt);
+    else
+        pid->d_filt = d_raw;
+    pid->d_out = pid->kd * pid->d_filt;
+
+    pid->last_err = pid->err;
+    pid->last_feedback = feedback;
+
+    /* I（限幅） */
+    integral = pid->integral + pid->err * pid->dt;
+    if(integral > pid->i_limit)  integral = pid->i_limit;
+    if(integral < -pid->i_limit) integral = -pid->i_limit;
+
+    /* 条件积分: 积分后输出饱和且误差继续推向饱和方向时保持积分不变 */
+    if(pid->aw_mode == PID_AW_CLAMP)
+    {
+        out = pwm_ff + pid->p_out + pid->ki * integral + pid->d_out;
+        if((out > pid->out_limit && pid->err > 0) || (out < 0 && pid->err < 0))
+            integral = pid->integral;
+    }
+    pid->integral = integral;
     pid->i_out = pid->ki * pid->integral;
 
-    /* D */
-    pid->d_out = pid->kd * (pid->err - pid->last_err) / pid->dt;
+    return pwm_ff + pid->p_out + pid->i_out + pid->d_out;
+}
 
-    pid->output = pid->p_out + pid->i_out + pid->d_out;
+/* 变化率限制 + 输出限幅 [0, out_limit] + 反算抗饱和 */
+static float pid_output(PID_Controller *pid, float out)
+{
+    float u = out, sat = out;
+
+    /* 只按输出限幅得到的饱和值, 变化率限制不参与反算 */
+    if(sat > pid->out_limit) sat = pid->out_limit;
+    if(sat < 0) sat = 0;
+
+    if(pid->slew_step > 0)
+    {
+        if(u > pid->output + pid->slew_step) u = pid->output + pid->slew_step;
+        if(u < pid->output - pid->slew_step) u = pid->output - pid->slew_step;
+    }
+
+    if(u > pid->out_limit) u = pid->out_limit;
+    if(u < 0) u = 0;
+
+    /* 反算: d(i_out)/dt 增加 kb * (sat - out), 只在饱和时计算 */
+    if(pid->aw_mode == PID_AW_BACK_CALC && sat != out && pid->ki != 0)
+    {
+        pid->integral += pid->aw_kb * (sat - out) * pid->dt / pid->ki;
+        if(pid->integral > pid->i_limit)  pid->integral = pid->i_limit;
+        if(pid->integral < -pid->i_limit) pid->integral = -pid->i_limit;
+        pid->i_out = pid->ki * pid->integral;
+    }
+
+    pid->output = u;
+    return pid->output;
+}
 
-    pid->last_err = pid->err;
+// 普通PID
+float PID_Update(PID_Controller *pid, float feedback)
+{
+    return pid_output(pid, pid_terms(pid, feedback, 0));
+}
 
+// 前馈 + PID
+float PID_FF_Update(PID_Controller *pid, float feedback, float pwm_ff)
+{
     /* ---------- 合成 ---------- */
-    pid->output = pwm_ff + pid->output;
-
-    /* -------- 输出限幅 --------- */
-    if(pid->output > pid->out_limit)  pid->output = pid->out_limit;
-	if (pid->output < 0) pid->output = 0;
-
-    return pid->output;
+    return pid_output(pid, pid_terms(pid, feedback, pwm_ff));
 }
 
 
@@ -102,29 +153,7 @@ float PID_BangBang_Update(PID_Controller *pid, float feedback)
             pid->output = 1;
         }
         return pid->output;
-    } 
-
-    /* P */
-    pid->p_out = pid->kp * pid->err;
-
-    /* I（积分分离 + 限幅） */
-    pid->integral += pid->err * pid->dt;
-    if(pid->integral > pid->i_limit)  pid->integral = pid->i_limit;
-    if(pid->integral < -pid->i_limit) pid->integral = -pid->i_limit;
-    pid->i_out = pid->ki * pid->integral;
+    }
 
-    /* D */
-    pid->d_out = pid->kd * (pid->err - pid->last_err) / pid->dt;
-
-    pid->output = pid->p_out + pid->i_out + pid->d_out;
-
-    /* 输出限幅 */
-    if(pid->output > pid->out_limit)  pid->output = pid->out_limit;
-    if(pid->output < -pid->out_limit) pid->output = pid->out_limit;
-
-    pid->last_err = pid->err;
-	
-	if (pid->output < 0) pid->output = 0;
-
-    return pid->output;
+    return PID_Update(pid, feedback);
 }
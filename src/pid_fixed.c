@@ -0,0 +1,184 @@
+
+#include "pid_fixed.h"
+
+/* Q16.16 乘法, 64 位中间结果, 四舍五入 */
+static inline pid_q16_t q16_mul(pid_q16_t a, pid_q16_t b)
+{
+    return (pid_q16_t)(((int64_t)a * b + (1 << (PID_Q16_SHIFT - 1))) >> PID_Q16_SHIFT);
+}
+
+/* Q32.32 系数 * Q16.16 -> Q32.32 增量, 四舍五入 */
+static inline int64_t q32_mul(int64_t k, pid_q16_t x)
+{
+    return (k * x + (1 << (PID_Q16_SHIFT - 1))) >> PID_Q16_SHIFT;
+}
+
+static inline int64_t q32_clamp(int64_t x, int64_t limit)
+{
+    if(x > limit) return limit;
+    if(x < -limit) return -limit;
+    return x;
+}
+
+/* Q32.32 累加器 -> Q16.16, 四舍五入 */
+static inline pid_q16_t q32_to_q16(int64_t x)
+{
+    return (pid_q16_t)((x + ((int64_t)1 << (PID_Q32_SHIFT - PID_Q16_SHIFT - 1))) >>
+                       (PID_Q32_SHIFT - PID_Q16_SHIFT));
+}
+
+static inline pid_q16_t q16_clamp(pid_q16_t x, pid_q16_t lo, pid_q16_t hi)
+{
+    if(x > hi) return hi;
+    if(x < lo) return lo;
+    return x;
+}
+
+void PID_Fixed_Init(PID_Fixed_Controller *pid,
+              float kp, float ki, float kd,
+              float dt,
+              float i_limit,
+              float out_limit)
+{
+    /* 除法只在这里做一次 */
+    pid->kp = PID_Q16_FROM_FLOAT(kp);
+    pid->ki_dt = PID_Q32_FROM_FLOAT(ki * dt);
+    pid->kd_dt = dt > 0 ? PID_Q16_FROM_FLOAT(kd / dt) : 0;
+
+    pid->i_out_limit = PID_Q16_FROM_FLOAT(ki * i_limit);
+    if(pid->i_out_limit < 0) pid->i_out_limit = -pid->i_out_limit;
+    pid->i_acc_limit = (int64_t)pid->i_out_limit << (PID_Q32_SHIFT - PID_Q16_SHIFT);
+    pid->out_limit = PID_Q16_FROM_FLOAT(out_limit);
+
+    pid->setpoint = 0;
+    pid->feedback = 0;
+    pid->err = 0;
+    pid->last_err = 0;
+    pid->p_out = 0;
+    pid->i_out = 0;
+    pid->i_acc = 0;
+    pid->d_out = 0;
+    pid->output = 0;
+
+    /* 可选项默认关闭 */
+    pid->aw_mode = PID_AW_NONE;
+    pid->aw_kb_dt = 0;
+    pid->d_on_meas = 0;
+    pid->d_alpha = PID_Q16_ONE;
+    pid->slew_step = 0;
+    pid->last_feedback = 0;
+    pid->d_filt = 0;
+}
+
+void PID_Fixed_Set_AntiWindup(PID_Fixed_Controller *pid, int mode, float kb, float kp, float ki,
+              float dt)
+{
+    pid->aw_mode = mode;
+    if(kb <= 0 && kp > 0) kb = ki / kp;
+    pid->aw_kb_dt = kb > 0 ? PID_Q32_FROM_FLOAT(kb * dt) : 0;
+}
+
+void PID_Fixed_Set_Derivative(PID_Fixed_Controller *pid, int on_measurement, float filter_tau,
+              float dt)
+{
+    pid->d_on_meas = on_measurement;
+    pid->d_alpha = filter_tau > 0 ? PID_Q16_FROM_FLOAT(dt / (filter_tau + dt)) : PID_Q16_ONE;
+    pid->d_filt = 0;
+}
+
+void PID_Fixed_Set_Slew(PID_Fixed_Controller *pid, float rate, float dt)
+{
+    pid->slew_step = rate > 0 ? PID_Q16_FROM_FLOAT(rate * dt) : 0;
+}
+
+/* P + I + D + 前馈, 不含输出限幅 */
+static pid_q16_t pid_fixed_terms(PID_Fixed_Controller *pid, pid_q16_t feedback, pid_q16_t pwm_ff)
+{
+    pid_q16_t diff, i_out;
+    int64_t i_acc;
+
+    pid->feedback = feedback;
+    pid->err = pid->setpoint - feedback;
+
+    /* P */
+    pid->p_out = q16_mul(pid->kp, pid->err);
+
+    /* D (误差或测量值的变化量, 可选低通) */
+    diff = pid->d_on_meas ? pid->last_feedback - feedback : pid->err - pid->last_err;
+    if(pid->d_alpha < PID_Q16_ONE)
+        pid->d_filt += q16_mul(pid->d_alpha, diff - pid->d_filt);
+    else
+        pid->d_filt = diff;
+    pid->d_out = q16_mul(pid->kd_dt, pid->d_filt);
+
+    pid->last_err = pid->err;
+    pid->last_feedback = feedback;
+
+    /* I（限幅） */
+    i_acc = q32_clamp(pid->i_acc + q32_mul(pid->ki_dt, pid->err), pid->i_acc_limit);
+    i_out = q32_to_q16(i_acc);
+
+    /* 条件积分 */
+    if(pid->aw_mode == PID_AW_CLAMP)
+    {
+        pid_q16_t out = pwm_ff + pid->p_out + i_out + pid->d_out;
+        if((out > pid->out_limit && pid->err > 0) || (out < 0 && pid->err < 0))
+        {
+            i_acc = pid->i_acc;
+            i_out = pid->i_out;
+        }
+    }
+    pid->i_acc = i_acc;
+    pid->i_out = i_out;
+
+    return pwm_ff + pid->p_out + pid->i_out + pid->d_out;
+}
+
+/* 变化率限制 + 输出限幅 (与浮点版本一致, 不输出负值) + 反算抗饱和 */
+static pid_q16_t pid_fixed_output(PID_Fixed_Controller *pid, pid_q16_t out)
+{
+    pid_q16_t u = out;
+    pid_q16_t sat = q16_clamp(out, 0, pid->out_limit); /* 变化率限制不参与反算 */
+
+    if(pid->slew_step > 0)
+        u = q16_clamp(u, pid->output - pid->slew_step, pid->output + pid->slew_step);
+
+    u = q16_clamp(u, 0, pid->out_limit);
+
+    if(pid->aw_mode == PID_AW_BACK_CALC && sat != out)
+    {
+        pid->i_acc = q32_clamp(pid->i_acc + q32_mul(pid->aw_kb_dt, sat - out), pid->i_acc_limit);
+        pid->i_out = q32_to_q16(pid->i_acc);
+    }
+
+    pid->output = u;
+    return pid->output;
+}
+
+// 普通PID
+pid_q16_t PID_Fixed_Update(PID_Fixed_Controller *pid, pid_q16_t feedback)
+{
+    return pid_fixed_output(pid, pid_fixed_terms(pid, feedback, 0));
+}
+
+// 前馈 + PID
+pid_q16_t PID_Fixed_FF_Update(PID_Fixed_Controller *pid, pid_q16_t feedback, pid_q16_t pwm_ff)
+{
+    /* ---------- 合成 ---------- */
+    return pid_fixed_output(pid, pid_fixed_terms(pid, feedback, pwm_ff));
+}
+
+// 极限变化
+pid_q16_t PID_Fixed_BangBang_Update(PID_Fixed_Controller *pid, pid_q16_t feedback)
+{
+    pid_q16_t err = pid->setpoint - feedback;
+
+    if (err > PID_Q16_ONE / 2 || err < -PID_Q16_ONE / 2) {
+        pid->feedback = feedback;
+        pid->err = err;
+        pid->output = err > 0 ? pid->out_limit : PID_Q16_ONE;
+        return pid->output;
+    }
+
+    return PID_Fixed_Update(pid, feedback);
+}
@@ -0,0 +1,613 @@
+/*
+ * 线程剖析
+ *
+ * 调度钩子和中断钩子都在关中断状态下调用, 只做一次 hrtime 读取、
+ * 一次按指针的线性查找和几次加法; 槽表只在关中断时修改.
+ * 按单核设计: 多核时各核的切换会记到同一个 "当前线程" 上
+ *
+ * 栈高水位沿用 RT-Thread list_thread 的做法: 线程创建时栈被填充为 '#',
+ * 从栈底开始第一个被改写的字节即历史最深位置
+ */
+
+#include <rtthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "common.h"
+#include "hrtime.h"
+#include "profiler.h"
+
+#define PROFILER_IDLE_PREFIX "tidle"
+
+struct profiler_slot
+{
+    rt_thread_t thread;        /* 线程已退出时置 RT_NULL, 槽保留到 reset */
+    rt_bool_t used;
+    char name[RT_NAME_MAX];
+    rt_uint8_t priority;
+    rt_uint32_t stack_size;
+    rt_uint32_t stack_used;    /* 最近一次扫描结果 */
+    rt_uint32_t switches;
+    rt_uint64_t runtime;
+    rt_uint64_t report_base;   /* 上一个上报窗口结束时的 runtime */
+    /* 循环统计 (只由本线程写) */
+    rt_bool_t loop_active;
+    rt_uint64_t loop_wall;     /* 本次迭代开始时刻 */
+    rt_uint64_t loop_run;      /* 本次迭代开始时的 runtime */
+    rt_uint32_t loops;
+    rt_uint64_t exec_sum;
+    rt_uint64_t exec_max;
+    rt_uint64_t resp_max;
+};
+
+static struct profiler_slot profiler_slots[PROFILER_MAX_THREADS];
+static int profiler_current = -1;        /* 当前线程的槽, -1 表示记入 other */
+static rt_uint32_t profiler_irq_nest = 0;
+static rt_uint64_t profiler_last = 0;    /* 上次记账时刻 */
+static rt_uint64_t profiler_start = 0;   /* reset 时刻 */
+static rt_uint64_t profiler_irq = 0;
+static rt_uint64_t profiler_other = 0;
+static rt_bool_t profiler_hooked = RT_FALSE;
+
+/* 上报窗口 */
+static rt_uint32_t profiler_report_ms = PROFILER_REPORT_MS_DEFAULT;
+static rt_uint64_t profiler_report_start = 0;
+static rt_uint64_t profiler_report_irq = 0;
+static rt_uint64_t profiler_report_other = 0;
+
+/**
+ * @brief 按线程查找槽, 没有时分配空闲槽 (调用方关中断)
+ * @return 槽下标, 槽表已满返回 -1
+ */
+static int profiler_slot_find(rt_thread_t thread)
+{
+    struct profiler_slot *s;
+    int i, free_slot = -1;
+
+    for (i = 0; i < PROFILER_MAX_THREADS; i++)
+    {
+        if (profiler_slots[i].used)
+        {
+            if (profiler_slots[i].thread == thread)
+            {
+                return i;
+            }
+        }
+        else if (free_slot < 0)
+        {
+            free_slot = i;
+        }
+    }
+    if (free_slot < 0 || thread == RT_NULL)
+    {
+        return -1;
+    }
+
+    s = &profiler_slots[free_slot];
+    rt_memset(s, 0, sizeof(*s));
+    s->thread = thread;
+    s->used = RT_TRUE;
+    /* 4.x 与 5.x 的线程控制块都以内核对象头开始 */
+    rt_strncpy(s->name, ((struct rt_object *)thread)->name, RT_NAME_MAX);
+    return free_slot;
+}
+
+/**
+ * @brief 把上次记账以来的时间记到当前执行体上 (调用方关中断)
+ */
+static void profiler_charge(rt_uint64_t now)
+{
+    rt_uint64_t delta = now - profiler_last;
+
+    profiler_last = now;
+    if (profiler_irq_nest > 0)
+    {
+        profiler_irq += delta;
+    }
+    else if (profiler_current >= 0)
+    {
+        profiler_slots[profiler_current].runtime += delta;
+    }
+    else
+    {
+        profiler_other += delta;
+    }
+}
+
+#ifdef RT_USING_HOOK
+static void profiler_sched_hook(struct rt_thread *from, struct rt_thread *to)
+{
+    (void)from;
+
+    profiler_charge(hrtime_now());
+    profiler_current = profiler_slot_find(to);
+    if (profiler_current >= 0)
+    {
+        profiler_slots[profiler_current].switches++;
+    }
+}
+
+static void profiler_irq_enter_hook(void)
+{
+    if (profiler_irq_nest == 0)
+    {
+        profiler_charge(hrtime_now());
+    }
+    profiler_irq_nest++;
+}
+
+static void profiler_irq_leave_hook(void)
+{
+    if (profiler_irq_nest == 0)
+    {
+        return;
+    }
+    if (profiler_irq_nest == 1)
+    {
+        profiler_charge(hrtime_now());
+    }
+    profiler_irq_nest--;
+}
+
+/**
+ * @brief 内核对象删除钩子: 线程退出后保留统计, 避免控制块地址被新线程复用后串号
+ */
+static void profiler_object_detach_hook(struct rt_object *object)
+{
+    rt_base_t level;
+    int i;
+
+    if ((object->type & ~RT_Object_Class_Static) != RT_Object_Class_Thread)
+    {
+        return;
+    }
+
+    level = rt_hw_interrupt_disable();
+    for (i = 0; i < PROFILER_MAX_THREADS; i++)
+    {
+        if (profiler_slots[i].used && profiler_slots[i].thread == (rt_thread_t)object)
+        {
+            profiler_slots[i].thread = RT_NULL;
+            profiler_slots[i].stack_size = 0;
+            if (profiler_current == i)
+            {
+                profiler_current = -1;
+            }
+            break;
+        }
+    }
+    rt_hw_interrupt_enable(level);
+}
+#endif
+
+/**
+ * @brief 初始化剖析器
+ */
+rt_err_t profiler_init(void)
+{
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    rt_memset(profiler_slots, 0, sizeof(profiler_slots));
+    profiler_start = hrtime_now();
+    profiler_last = profiler_start;
+    profiler_report_start = profiler_start;
+    profiler_current = profiler_slot_find(rt_thread_self());
+    rt_hw_interrupt_enable(level);
+
+#ifdef RT_USING_HOOK
+    rt_scheduler_sethook(profiler_sched_hook);
+    rt_interrupt_enter_sethook(profiler_irq_enter_hook);
+    rt_interrupt_leave_sethook(profiler_irq_leave_hook);
+    rt_object_detach_sethook(profiler_object_detach_hook);
+    profiler_hooked = RT_TRUE;
+    rt_kprintf("[Profiler] Init OK (scheduler hook, %d threads)\n", PROFILER_MAX_THREADS);
+#else
+    rt_kprintf("[Profiler] RT_USING_HOOK disabled, only loop and stack stats\n");
+#endif
+    return RT_EOK;
+}
+
+void profiler_reset(void)
+{
+    struct profiler_slot *s;
+    rt_base_t level;
+    int i;
+
+    level = rt_hw_interrupt_disable();
+    profiler_start = hrtime_now();
+    profiler_last = profiler_start;
+    profiler_irq = 0;
+    profiler_other = 0;
+    for (i = 0; i < PROFILER_MAX_THREADS; i++)
+    {
+        s = &profiler_slots[i];
+        if (!s->used)
+        {
+            continue;
+        }
+        if (s->thread == RT_NULL)
+        {
+            s->used = RT_FALSE;
+            continue;
+        }
+        s->switches = 0;
+        s->runtime = 0;
+        s->report_base = 0;
+        s->loop_active = RT_FALSE;
+        s->loops = 0;
+        s->exec_sum = 0;
+        s->exec_max = 0;
+        s->resp_max = 0;
+    }
+    profiler_report_start = profiler_start;
+    profiler_report_irq = 0;
+    profiler_report_other = 0;
+    rt_hw_interrupt_enable(level);
+}
+
+/**
+ * @brief 当前线程的槽 (调用方关中断)
+ */
+static struct profiler_slot *profiler_self(void)
+{
+    int idx = profiler_hooked ? profiler_current : profiler_slot_find(rt_thread_self());
+
+    return idx >= 0 ? &profiler_slots[idx] : RT_NULL;
+}
+
+void profiler_loop_begin(void)
+{
+    struct profiler_slot *s;
+    rt_base_t level;
+    rt_uint64_t now;
+
+    level = rt_hw_interrupt_disable();
+    now = hrtime_now();
+    s = profiler_self();
+    if (s != RT_NULL)
+    {
+        if (profiler_hooked)
+        {
+            profiler_charge(now);
+        }
+        s->loop_wall = now;
+        s->loop_run = s->runtime;
+        s->loop_active = RT_TRUE;
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+void profiler_loop_end(void)
+{
+    struct profiler_slot *s;
+    rt_base_t level;
+    rt_uint64_t now, exec, resp;
+
+    level = rt_hw_interrupt_disable();
+    now = hrtime_now();
+    s = profiler_self();
+    if (s != RT_NULL && s->loop_active)
+    {
+        resp = now - s->loop_wall;
+        if (profiler_hooked)
+        {
+            profiler_charge(now);
+            exec = s->runtime - s->loop_run;
+        }
+        else
+        {
+            exec = resp;
+        }
+        s->loop_active = RT_FALSE;
+        s->loops++;
+        s->exec_sum += exec;
+        if (exec > s->exec_max)
+        {
+            s->exec_max = exec;
+        }
+        if (resp > s->resp_max)
+        {
+            s->resp_max = resp;
+        }
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+/**
+ * @brief 扫描线程栈的历史最大使用量 (字节)
+ */
+static rt_uint32_t profiler_stack_used(rt_thread_t thread)
+{
+    rt_uint8_t *base = (rt_uint8_t *)thread->stack_addr;
+    rt_uint8_t *ptr;
+
+#ifdef ARCH_CPU_STACK_GROWS_UPWARD
+    ptr = base + thread->stack_size;
+    while (ptr > base && *(ptr - 1) == '#')
+    {
+        ptr--;
+    }
+    return (rt_uint32_t)(ptr - base);
+#else
+    rt_uint8_t *end = base + thread->stack_size;
+
+    ptr = base;
+    while (ptr < end && *ptr == '#')
+    {
+        ptr++;
+    }
+    return (rt_uint32_t)(end - ptr);
+#endif
+}
+
+/**
+ * @brief 登记所有线程并刷新栈高水位 (锁调度器, 线程不会在扫描期间退出)
+ */
+static void profiler_scan_threads(void)
+{
+    struct rt_object_information *info;
+    struct rt_list_node *node;
+    rt_thread_t thread;
+    rt_uint32_t used;
+    rt_base_t level;
+    int idx;
+
+    info = rt_object_get_information(RT_Object_Class_Thread);
+    if (info == RT_NULL)
+    {
+        return;
+    }
+
+    rt_list_for_each(node, &info->object_list)
+    {
+        thread = (rt_thread_t)rt_list_entry(node, struct rt_object, list);
+        used = profiler_stack_used(thread);
+
+        level = rt_hw_interrupt_disable();
+        idx = profiler_slot_find(thread);
+        if (idx >= 0)
+        {
+            profiler_slots[idx].priority = thread->current_priority;
+            profiler_slots[idx].stack_size = thread->stack_size;
+            profiler_slots[idx].stack_used = used;
+        }
+        rt_hw_interrupt_enable(level);
+    }
+}
+
+static rt_size_t profiler_collect(struct profiler_thread_info *out, rt_size_t max,
+                                  struct profiler_summary *summary, rt_bool_t window)
+{
+    struct profiler_thread_info *o;
+    struct profiler_slot *s;
+    struct profiler_summary sum;
+    rt_base_t level;
+    rt_uint64_t now;
+    rt_size_t n = 0;
+    int i;
+
+    rt_enter_critical();
+    profiler_scan_threads();
+
+    rt_memset(&sum, 0, sizeof(sum));
+    sum.hooked = profiler_hooked;
+
+    level = rt_hw_interrupt_disable();
+    now = hrtime_now();
+    if (profiler_hooked)
+    {
+        profiler_charge(now);
+    }
+    sum.elapsed = now - (window ? profiler_report_start : profiler_start);
+    sum.irq = profiler_irq - (window ? profiler_report_irq : 0);
+    sum.other = profiler_other - (window ? profiler_report_other : 0);
+
+    for (i = 0; i < PROFILER_MAX_THREADS; i++)
+    {
+        s = &profiler_slots[i];
+        if (!s->used)
+        {
+            continue;
+        }
+        if (n < max)
+        {
+            o = &out[n++];
+            rt_memcpy(o->name, s->name, RT_NAME_MAX);
+            o->name[RT_NAME_MAX] = '\0';
+            o->alive = s->thread != RT_NULL;
+            o->priority = s->priority;
+            o->switches = s->switches;
+            o->runtime = s->runtime - (window ? s->report_base : 0);
+            o->stack_size = s->stack_size;
+            o->stack_used = s->stack_used;
+            o->loops = s->loops;
+            o->exec_sum = s->exec_sum;
+            o->exec_max = s->exec_max;
+            o->resp_max = s->resp_max;
+        }
+        if (rt_strncmp(s->name, PROFILER_IDLE_PREFIX, sizeof(PROFILER_IDLE_PREFIX) - 1) == 0)
+        {
+            sum.idle += s->runtime - (window ? s->report_base : 0);
+        }
+        if (window)
+        {
+            s->report_base = s->runtime;
+        }
+    }
+    if (window)
+    {
+        profiler_report_start = now;
+        profiler_report_irq = profiler_irq;
+        profiler_report_other = profiler_other;
+    }
+    rt_hw_interrupt_enable(level);
+    rt_exit_critical();
+
+    if (summary != RT_NULL)
+    {
+        *summary = sum;
+    }
+    return n;
+}
+
+rt_size_t profiler_snapshot(struct profiler_thread_info *out, rt_size_t max,
+                            struct profiler_summary *summary)
+{
+    return profiler_collect(out, max, summary, RT_FALSE);
+}
+
+rt_size_t profiler_report(struct profiler_thread_info *out, rt_size_t max,
+                          struct profiler_summary *summary)
+{
+    return profiler_collect(out, max, summary, RT_TRUE);
+}
+
+void profiler_set_report_ms(rt_uint32_t ms)
+{
+    if (ms > PROFILER_REPORT_MS_MAX)
+    {
+        ms = PROFILER_REPORT_MS_MAX;
+    }
+    profiler_report_ms = ms;
+}
+
+rt_uint32_t profiler_get_report_ms(void)
+{
+    return profiler_report_ms;
+}
+
+rt_err_t profiler_set_priority(const char *name, rt_uint8_t priority)
+{
+    char buf[RT_NAME_MAX + 1];
+    rt_thread_t thread;
+
+    rt_strncpy(buf, name, RT_NAME_MAX);
+    buf[RT_NAME_MAX] = '\0';
+    if (priority >= RT_THREAD_PRIORITY_MAX - 1 ||
+        rt_strncmp(buf, PROFILER_IDLE_PREFIX, sizeof(PROFILER_IDLE_PREFIX) - 1) == 0)
+    {
+        return -RT_EINVAL;
+    }
+    thread = rt_thread_find(buf);
+    if (thread == RT_NULL)
+    {
+        return -RT_EEMPTY;
+    }
+    /* 就绪线程按新优先级重新排队, "prof" 下次扫描时显示新值 */
+    return rt_thread_control(thread, RT_THREAD_CTRL_CHANGE_PRIORITY, &priority);
+}
+
+rt_bool_t profiler_report_due(void)
+{
+    rt_uint32_t ms = profiler_report_ms;
+
+    if (ms == 0)
+    {
+        return RT_FALSE;
+    }
+    return hrtime_now() - profiler_report_start >= hrtime_from_us(ms * 1000U);
+}
+
+/* ================= 调试用 MSH 命令 ================= */
+
+/* 命令输出缓冲区, 只在 MSH 线程中使用 */
+static struct profiler_thread_info profiler_info[PROFILER_MAX_THREADS];
+
+/**
+ * @brief 占比 (千分比)
+ */
+static int profiler_permille(rt_uint64_t part, rt_uint64_t total)
+{
+    return total > 0 ? (int)(part * 1000 / total) : 0;
+}
+
+/**
+ * @brief MSH 命令: 线程 CPU 占用、循环耗时和栈高水位
+ *        用法: prof [reset | report <ms> | prio <thread> <n>]
+ */
+static void prof_cmd(int argc, char *argv[])
+{
+    struct profiler_thread_info *t;
+    struct profiler_summary sum;
+    rt_size_t n, i;
+    int cpu, idle;
+
+    if (argc >= 2 && rt_strcmp(argv[1], "reset") == 0)
+    {
+        profiler_reset();
+        rt_kprintf("Profiler stats cleared\n");
+        return;
+    }
+    if (argc >= 3 && rt_strcmp(argv[1], "report") == 0)
+    {
+        profiler_set_report_ms((rt_uint32_t)atoi(argv[2]));
+        rt_kprintf("Profiler RPMsg report: %s (%ums, binary protocol only)\n",
+                   profiler_report_ms ? "on" : "off", profiler_report_ms);
+        return;
+    }
+    if (argc >= 4 && rt_strcmp(argv[1], "prio") == 0)
+    {
+        switch (profiler_set_priority(argv[2], (rt_uint8_t)atoi(argv[3])))
+        {
+        case RT_EOK:
+            rt_kprintf("Thread %s priority set to %d\n", argv[2], atoi(argv[3]));
+            break;
+        case -RT_EEMPTY:
+            rt_kprintf("No thread named %s\n", argv[2]);
+            break;
+        default:
+            rt_kprintf("Priority must be 0-%d and the thread not idle\n",
+                       RT_THREAD_PRIORITY_MAX - 2);
+            break;
+        }
+        return;
+    }
+    if (argc >= 2)
+    {
+        rt_kprintf("Usage: prof [reset | report <ms> | prio <thread> <n>]\n");
+        return;
+    }
+
+    n = profiler_snapshot(profiler_info, PROFILER_MAX_THREADS, &sum);
+
+    idle = profiler_permille(sum.idle, sum.elapsed);
+    rt_kprintf("Profiler: %ums, report=%ums%s\n", hrtime_to_us(sum.elapsed) / 1000,
+               profiler_report_ms, sum.hooked ? "" : " (no RT_USING_HOOK: cpu% unavailable)");
+    if (sum.hooked)
+    {
+        rt_kprintf("  cpu load %d.%d%%, irq %d.%d%%, untracked %d.%d%%\n",
+                   (1000 - idle) / 10, (1000 - idle) % 10,
+                   profiler_permille(sum.irq, sum.elapsed) / 10,
+                   profiler_permille(sum.irq, sum.elapsed) % 10,
+                   profiler_permille(sum.other, sum.elapsed) / 10,
+                   profiler_permille(sum.other, sum.elapsed) % 10);
+    }
+    rt_kprintf("thread    pri  cpu%%   switches  stack used/size    loops  exec avg/max(us)  resp max(us)\n");
+    for (i = 0; i < n; i++)
+    {
+        t = &profiler_info[i];
+        cpu = profiler_permille(t->runtime, sum.elapsed);
+        rt_kprintf("%-8s %4d %3d.%d %10u ", t->name, t->priority, cpu / 10, cpu % 10,
+                   t->switches);
+        if (t->alive)
+        {
+            rt_kprintf(" %5u/%-5u %3d%% ", t->stack_used, t->stack_size,
+                       profiler_permille(t->stack_used, t->stack_size) / 10);
+        }
+        else
+        {
+            rt_kprintf(" %-16s ", "(exited)");
+        }
+        if (t->loops > 0)
+        {
+            rt_kprintf("%8u %8u/%-8u %12u\n", t->loops,
+                       hrtime_to_us(t->exec_sum / t->loops), hrtime_to_us(t->exec_max),
+                       hrtime_to_us(t->resp_max));
+        }
+        else
+        {
+            rt_kprintf("%8s\n", "-");
+        }
+    }
+}
+MSH_CMD_EXPORT_ALIAS(prof_cmd, prof, Show thread cpu load loop time and stack usage);
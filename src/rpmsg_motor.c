@@ -6,6 +6,65 @@
  * 协议:
  * - 接收速度指令: "1,0.5;1,0.5" (方向1,转速1;方向2,转速2)
  * - 发送状态反馈: "1,500;2,480" (方向1,转速1 mr/s;方向2,转速2 mr/s)
+ * - 二进制帧 (motor_proto.h): 大核发送 HELLO 协商成功后, 反馈改用二进制帧;
+ *   未协商时保持文本协议. HELLO 应答中通告共享内存状态块 (motor_shm.h) 地址,
+ *   大核可以关闭反馈, 直接读取状态块
+ *
+ * 零拷贝:
+ * - 发送: rpmsg_get_tx_payload_buffer 取得 vring 缓冲区, 直接在其中组帧,
+ *   再用 rpmsg_send_nocopy 提交
+ * - 接收: 速度指令在回调中直接解析 vring 缓冲区, 不复制;
+ *   CFG 指令用 rpmsg_hold_rx_buffer 保留缓冲区, 交给 cfg 线程解析后释放
+ *
+ * 反馈发布:
+ * - 采样模式 (默认): 底盘控制线程每次发布新状态后调用 rpmsg_motor_notify_sample,
+ *   每 N 个采样唤醒一次反馈线程, 反馈与控制节拍同相
+ * - 定时模式: 反馈线程按 feedback_interval_ms 周期发送
+ * - 端点未绑定或反馈关闭时反馈线程阻塞在事件上, 不产生唤醒
+ * - 批量遥测 (telemetry.c, 需二进制协议): 代替状态反馈, 攒够批量或超时后
+ *   一帧发送多个控制周期的记录
+ *
+ * 时延测量:
+ * - 二进制 FEEDBACK / TELEMETRY 帧之后追加 motor_proto_echo 尾部, 回显最近一条
+ *   已输出到 PWM 的 CMD 帧序号和时间戳, 大核据此计算往返时延
+ * - 小核侧统计 收到 -> PWM 更新 -> 反馈发送 各段时延, 用 rpmsg_latency 查看
+ *
+ * 线程剖析:
+ * - "prof report <ms>" 开启后, 反馈线程每次唤醒时检查上报周期, 到期发送一帧
+ *   MOTOR_PROTO_TYPE_PROFILE (需二进制协议, 反馈关闭时不发送)
+ *
+ * 轨迹:
+ * - MOTOR_PROTO_TYPE_TRAJ 帧在回调中装入 setpoint.c 的轨迹邮箱, 由底盘控制线程插值
+ *
+ * 底盘运动学:
+ * - MOTOR_PROTO_TYPE_TWIST 帧在回调中按 CFG 下发的几何参数逆解为轮速, 与 CMD 相同处理
+ * - feedback_enable=3 时反馈改为 MOTOR_PROTO_TYPE_ODOM 位姿帧 (需二进制协议),
+ *   位姿由底盘控制线程每节拍积分, 反馈频率不影响里程计精度
+ *
+ * 自整定:
+ * - 文本指令 "TUNE,..." 与 CFG 一样交给 cfg 线程, 结果以 "TUNE,..." 文本事件上报
+ *
+ * 前馈表:
+ * - "FF,..." 下发一个轴的表, "FFGET" 读回所有轴, 都由 cfg 线程处理, 以 "FF,..." 文本应答
+ *
+ * 健康监测:
+ * - 速度指令、CMD / TWIST / 轨迹帧都复位 health.c 的指令超时
+ * - 二进制状态帧的 hdr.flags 携带当前故障标志 MOTOR_PROTO_FAULT_*;
+ *   故障标志变化时反馈线程额外发送文本事件 "FAULT,<flags>,<axes>"
+ * - 文本指令 "FAULTCLR" 在回调中直接请求清除锁存故障
+ *
+ * 运行参数:
+ * - "CFG,rate,<hz>[,<feedback_ms>]" 修改控制频率 (下一个节拍生效) 和反馈间隔,
+ *   "CFG,prio,<thread>,<n>" 修改线程优先级, 由 cfg 线程处理并以同格式应答实际值
+ * - 采样模式的抽取系数 N 随控制频率重新计算, 反馈间隔保持不变
+ *
+ * 通道:
+ * - 控制端点 "rpmsg:motor_ctrl" (1002 <-> 1003): 速度指令 / 轨迹 / HELLO 在回调中
+ *   直接处理, 状态反馈、遥测和 FAULT 事件从这里发出
+ * - 诊断端点 "rpmsg:motor_diag" (1004 <-> 1005): 回调只保留缓冲区交给 cfg 线程,
+ *   不做任何解析. "DIAG" 应答 "DIAG,ok", 大核据此确认小核有诊断端点
+ * - 控制端点仍接受 CFG / TUNE / FF (旧版大核). 应答走请求所在的端点,
+ *   自整定结果等异步事件和剖析帧跟随最近一条请求所在的端点
  */
 
 #include <openamp/remoteproc.h>
@@ -18,17 +77,46 @@
 #include <string.h>
 #include <stdio.h>
 #include "rpmsg_motor.h"
+#include "motor_proto.h"
+#include "motor_shm.h"
+#include "autotune.h"
+#include "chassis_kin.h"
 #include "common.h"
+#include "ff_table.h"
+#include "control_tick.h"
+#include "health.h"
+#include "hrtime.h"
+#include "latency_stats.h"
+#include "profiler.h"
+#include "setpoint.h"
+#include "telemetry.h"
 /* ================= 配置参数 ================= */
 
 #define RPMSG_MOTOR_SERVICE_NAME "rpmsg:motor_ctrl"
 #define RPMSG_MOTOR_ADDR_SRC 1002
 #define RPMSG_MOTOR_ADDR_DST 1003
 
+/* 配置与诊断通道 */
+#define RPMSG_MOTOR_DIAG_SERVICE_NAME "rpmsg:motor_diag"
+#define RPMSG_MOTOR_DIAG_ADDR_SRC 1004
+#define RPMSG_MOTOR_DIAG_ADDR_DST 1005
+
 #define FEEDBACK_THREAD_STACK_SIZE 4096
 #define FEEDBACK_THREAD_PRIORITY 15
 #define FEEDBACK_THREAD_TIMESLICE 5
 
+#define CFG_THREAD_STACK_SIZE 4096
+#define CFG_THREAD_PRIORITY 16
+#define CFG_THREAD_TIMESLICE 5
+#define CFG_MAILBOX_SIZE 4 /* 最多同时保留的接收缓冲区数 */
+#define CFG_MSG_FROM_DIAG 0x1U /* 邮件最低位: 缓冲区来自诊断端点 (缓冲区地址 4 字节对齐) */
+
+/* 反馈线程事件 */
+#define FEEDBACK_EVT_BOUND (1U << 0)   /* 端点已绑定 (保持置位) */
+#define FEEDBACK_EVT_ENABLED (1U << 1) /* 反馈已开启 (保持置位) */
+#define FEEDBACK_EVT_SAMPLE (1U << 2)  /* 有新采样待发送 */
+#define FEEDBACK_EVT_TELEMETRY (1U << 3) /* 遥测达到发送条件 */
+
 /* ================= 外部依赖 ================= */
 
 extern struct rpmsg_device *rpdev;
@@ -39,62 +127,82 @@ struct rpmsg_motor_ctx {
   char *service_name;
   struct rpmsg_endpoint endp;
   rt_bool_t endpoint_ready;
+  rt_bool_t binary_mode; /* 已通过 HELLO 协商为二进制协议 */
+  rt_uint32_t tx_seq;    /* 二进制帧发送序号 */
+  rt_uint32_t rx_seq;    /* 最近一次接收的二进制帧序号 */
+
+  struct rpmsg_endpoint diag_endp;
+  rt_bool_t diag_ready;           /* 诊断端点已创建 */
+  volatile rt_bool_t diag_active; /* 最近一条请求来自诊断端点, 应答走该端点 */
+
+  /* 通道统计 (MSH rpmsg_channel 查看) */
+  rt_uint32_t ctrl_rx;
+  rt_uint32_t diag_rx;
+  rt_uint32_t diag_tx;
+  rt_uint32_t cfg_dropped;
 };
 
 static struct rpmsg_motor_ctx motor_ctx;
 static rt_thread_t feedback_thread = RT_NULL;
+static rt_thread_t cfg_thread = RT_NULL;
+static rt_mailbox_t cfg_mailbox = RT_NULL;
+static rt_event_t feedback_event = RT_NULL;
 static int feedback_interval_ms = DEFAULT_FEEDBACK_INTERVAL_MS;
 static rt_bool_t feedback_enabled = RT_TRUE;
+static volatile rt_bool_t feedback_odom = RT_FALSE; /* 以 ODOM 位姿帧代替状态反馈 */
+static rt_bool_t feedback_on_sample = RT_TRUE; /* 采样模式 / 定时模式 */
+static rt_uint32_t feedback_decimation = 1;    /* 采样模式: 每 N 个采样发送一次 */
+static rt_uint32_t feedback_rate_generation;   /* 计算 N 时的控制频率版本号 */
+static rt_uint32_t feedback_sample_count = 0;  /* 只在底盘控制线程中访问 */
+
+/* 时延统计 (反馈线程写, MSH 读), 每条 CMD 只在首次回显时记录 */
+static struct latency_stats lat_rx_to_apply;
+static struct latency_stats lat_apply_to_tx;
+static struct latency_stats lat_rx_to_tx;
+static rt_bool_t lat_recorded = RT_FALSE;
+static rt_uint32_t lat_recorded_seq = 0;
 
 /* ================= 速度指令解析 ================= */
 
+/**
+ * @brief 解析一组 "方向,转速", 不修改输入
+ * @return 指向本组之后的 ';', 没有下一组时返回 RT_NULL
+ */
+static const char *parse_motor_pair(const char *str, int *dir,
+                                    double *speed) {
+  const char *semicolon = strchr(str, ';');
+  const char *comma = strchr(str, ',');
+
+  if (comma != RT_NULL && (semicolon == RT_NULL || comma < semicolon)) {
+    /* strtol/strtod 遇到 ',' / ';' 自然停止, 无需截断字符串 */
+    *dir = (int)strtol(str, RT_NULL, 10);
+    *speed = strtod(comma + 1, RT_NULL);
+  }
+
+  return semicolon;
+}
+
 /**
  * @brief 解析速度指令
  *        格式: "1,0.5;1,0.5" (方向1,转速1;方向2,转速2)
+ *        直接在接收缓冲区上解析, cmd 必须以 '\0' 结尾
  */
-static rt_err_t parse_speed_command(const char *cmd, int *dir1, double *speed1,
-                                    int *dir2, double *speed2) {
-  char buf[64];
-  char *semicolon;
-  char *comma;
+rt_err_t parse_speed_command(const char *cmd, int *dir1, double *speed1,
+                             int *dir2, double *speed2) {
+  const char *semicolon;
 
   if (cmd == RT_NULL || *cmd == '\0') {
     return -RT_ERROR;
   }
 
-  strncpy(buf, cmd, sizeof(buf) - 1);
-  buf[sizeof(buf) - 1] = '\0';
-
   *dir1 = 0;
   *speed1 = 0.0;
   *dir2 = 0;
   *speed2 = 0.0;
 
-  semicolon = strchr(buf, ';');
+  semicolon = parse_motor_pair(cmd, dir1, speed1);
   if (semicolon != RT_NULL) {
-    *semicolon = '\0';
-
-    comma = strchr(buf, ',');
-    if (comma != RT_NULL) {
-      *comma = '\0';
-      *dir1 = atoi(buf);
-      *speed1 = atof(comma + 1);
-    }
-
-    char *motor2_str = semicolon + 1;
-    comma = strchr(motor2_str, ',');
-    if (comma != RT_NULL) {
-      *comma = '\0';
-      *dir2 = atoi(motor2_str);
-      *speed2 = atof(comma + 1);
-    }
-  } else {
-    comma = strchr(buf, ',');
-    if (comma != RT_NULL) {
-      *comma = '\0';
-      *dir1 = atoi(buf);
-      *speed1 = atof(comma + 1);
-    }
+    parse_motor_pair(semicolon + 1, dir2, speed2);
   }
 
   return RT_EOK;
@@ -104,9 +212,9 @@ static rt_err_t parse_speed_command(const char *cmd, int *dir1, double *speed1,
  * @brief 解析 CFG 指令
  *        格式: "CFG,ratio,ff,kp,ki,kd[,feedback_enable]"
  */
-static rt_err_t parse_cfg_command(const char *cmd, double *ratio, double *ff,
-                                  double *kp, double *ki, double *kd,
-                                  int *feedback_enable) {
+rt_err_t parse_cfg_command(const char *cmd, double *ratio, double *ff,
+                           double *kp, double *ki, double *kd,
+                           int *feedback_enable) {
   int matched = 0;
 
   if (cmd == RT_NULL) {
@@ -126,6 +234,278 @@ static rt_err_t parse_cfg_command(const char *cmd, double *ratio, double *ff,
   return -RT_ERROR;
 }
 
+/**
+ * @brief 解析 CFG 指令中的底盘几何参数
+ *        格式: "CFG,ratio,ff,kp,ki,kd,feedback_enable,radius,base[,factor1,factor2]"
+ *        没有的系数为 0 (保持当前值)
+ */
+rt_err_t parse_cfg_geometry(const char *cmd, struct chassis_geometry *geo) {
+  double ratio, ff, kp, ki, kd;
+  double radius = 0.0, base = 0.0, f1 = 0.0, f2 = 0.0;
+  int fb;
+  int matched;
+
+  if (cmd == RT_NULL) {
+    return -RT_ERROR;
+  }
+
+  matched = sscanf(cmd, "CFG,%lf,%lf,%lf,%lf,%lf,%d,%lf,%lf,%lf,%lf", &ratio,
+                   &ff, &kp, &ki, &kd, &fb, &radius, &base, &f1, &f2);
+  if (matched < 8) {
+    return -RT_ERROR;
+  }
+
+  geo->wheel_radius_m = (float)radius;
+  geo->wheel_base_m = (float)base;
+  geo->motor_factor[0] = (float)f1;
+  geo->motor_factor[1] = (float)f2;
+  return RT_EOK;
+}
+
+/**
+ * @brief 解析自整定指令
+ *        格式: "TUNE,step|relay[,duty_low,duty_high[,apply]]"
+ */
+rt_err_t parse_tune_command(const char *cmd, struct autotune_config *cfg) {
+  char mode[8];
+  double duty_low, duty_high;
+  int apply = 0;
+  int matched;
+
+  if (cmd == RT_NULL) {
+    return -RT_ERROR;
+  }
+
+  matched = sscanf(cmd, "TUNE,%7[a-z],%lf,%lf,%d", mode, &duty_low, &duty_high,
+                   &apply);
+  if (matched < 1) {
+    return -RT_ERROR;
+  }
+  if (strcmp(mode, "step") == 0) {
+    autotune_config_default(cfg, AUTOTUNE_MODE_STEP);
+  } else if (strcmp(mode, "relay") == 0) {
+    autotune_config_default(cfg, AUTOTUNE_MODE_RELAY);
+  } else {
+    return -RT_ERROR;
+  }
+
+  if (matched >= 3) {
+    cfg->duty_low = (float)duty_low;
+    cfg->duty_high = (float)duty_high;
+  }
+  cfg->apply = (matched == 4 && apply != 0);
+  return RT_EOK;
+}
+
+/* ================= 二进制协议 ================= */
+
+/**
+ * @brief 当前单调时间 (us, hrtime 分辨率), 用于二进制帧时间戳
+ */
+static rt_uint32_t proto_timestamp_us(void) { return hrtime_now_us(); }
+
+/**
+ * @brief 有符号 mr/s 转换为 方向 + r/s
+ */
+static void proto_mrs_to_target(rt_int32_t mrs, int *dir, double *speed) {
+  if (mrs > 0) {
+    *dir = 1;
+    *speed = (double)mrs / 1000.0;
+  } else if (mrs < 0) {
+    *dir = 2;
+    *speed = (double)(-mrs) / 1000.0;
+  } else {
+    *dir = 0;
+    *speed = 0.0;
+  }
+}
+
+/**
+ * @brief 有符号 r/s 转换为 方向 + r/s
+ */
+static void proto_rps_to_target(float rps, int *dir, double *speed) {
+  if (rps > 0.0f) {
+    *dir = 1;
+    *speed = rps;
+  } else if (rps < 0.0f) {
+    *dir = 2;
+    *speed = -rps;
+  } else {
+    *dir = 0;
+    *speed = 0.0;
+  }
+}
+
+/**
+ * @brief 方向 + mr/s 转换为有符号 mr/s
+ */
+static rt_int32_t proto_target_to_mrs(int dir, int mrs) {
+  if (dir == 1) {
+    return mrs;
+  }
+  if (dir == 2) {
+    return -mrs;
+  }
+  return 0;
+}
+
+/* ================= 零拷贝发送 ================= */
+
+/**
+ * @brief 申请 vring 发送缓冲区, 调用方直接在其中组帧
+ * @param ept 发送端点 (两个端点共用一组 vring 缓冲区)
+ * @param[out] size 缓冲区可用长度
+ * @param wait 无空闲缓冲区时是否等待 (回调上下文中必须为 0)
+ * @return 缓冲区地址, 失败返回 RT_NULL
+ */
+static void *rpmsg_motor_tx_reserve(struct rpmsg_endpoint *ept, uint32_t *size,
+                                    int wait) {
+  return rpmsg_get_tx_payload_buffer(ept, size, wait);
+}
+
+/**
+ * @brief 提交已组帧的发送缓冲区, 失败时归还缓冲区
+ * @return 发送字节数, 小于 0 表示失败
+ */
+static int rpmsg_motor_tx_commit(struct rpmsg_endpoint *ept, void *buf,
+                                 int len) {
+  int ret = rpmsg_send_nocopy(ept, buf, len);
+
+  if (ret < 0) {
+    rpmsg_release_tx_buffer(ept, buf);
+  } else if (ept == &motor_ctx.diag_endp) {
+    motor_ctx.diag_tx++;
+  }
+  return ret;
+}
+
+/**
+ * @brief 配置应答和诊断数据的发送端点: 最近一条请求来自诊断端点时用诊断端点
+ */
+static struct rpmsg_endpoint *rpmsg_motor_diag_ept(void) {
+  return motor_ctx.diag_active ? &motor_ctx.diag_endp : &motor_ctx.endp;
+}
+
+/**
+ * @brief 处理二进制帧
+ *        只做定长结构体访问和整数运算, 不调用 libc 解析函数
+ */
+static void rpmsg_motor_handle_binary(struct rpmsg_endpoint *ept,
+                                      const void *data, size_t len) {
+  const struct motor_proto_wheel_frame *frame =
+      (const struct motor_proto_wheel_frame *)data;
+  const struct motor_proto_traj_frame *traj;
+  const struct motor_proto_twist_frame *twist;
+  struct motor_proto_wheel_frame *reply;
+  float rps[MOTOR_PROTO_WHEELS];
+  uint32_t size;
+  int dir1, dir2;
+  double speed1, speed2;
+
+  (void)ept;
+
+  if (motor_proto_check(data, len) != 0) {
+    rt_kprintf("[rpmsg_motor] Bad binary frame (len=%d)\n", (int)len);
+    return;
+  }
+
+  motor_ctx.rx_seq = frame->hdr.seq;
+
+  switch (frame->hdr.type) {
+  case MOTOR_PROTO_TYPE_HELLO:
+    /* 协商: 回复 HELLO, 之后反馈改用二进制帧 */
+    reply = rpmsg_motor_tx_reserve(&motor_ctx.endp, &size, 0);
+    if (reply == RT_NULL || size < sizeof(*reply)) {
+      if (reply != RT_NULL) {
+        rpmsg_release_tx_buffer(&motor_ctx.endp, reply);
+      }
+      rt_kprintf("[rpmsg_motor] HELLO reply failed (no tx buffer)\n");
+      return;
+    }
+    rt_memset(reply, 0, sizeof(*reply));
+    /* 通告共享内存状态块, 旧版大核忽略这些字段 */
+    reply->setpoint_mrs[0] = (int32_t)(uint32_t)motor_shm_get_phys_addr();
+    reply->setpoint_mrs[1] = (int32_t)(uint32_t)(motor_shm_get_phys_addr() >> 32);
+    reply->measured_mrs[0] = MOTOR_SHM_SIZE;
+    motor_proto_finalize(reply, MOTOR_PROTO_TYPE_HELLO, 0, motor_ctx.tx_seq++,
+                         proto_timestamp_us());
+    if (rpmsg_motor_tx_commit(&motor_ctx.endp, reply, sizeof(*reply)) < 0) {
+      rt_kprintf("[rpmsg_motor] HELLO reply failed\n");
+      return;
+    }
+    motor_ctx.binary_mode = RT_TRUE;
+    /* 新会话: 收到诊断端点的请求前应答走控制端点 */
+    motor_ctx.diag_active = RT_FALSE;
+    rt_kprintf("[rpmsg_motor] Binary protocol v%d negotiated\n",
+               MOTOR_PROTO_VERSION);
+    break;
+  case MOTOR_PROTO_TYPE_CMD:
+    proto_mrs_to_target(frame->setpoint_mrs[0], &dir1, &speed1);
+    proto_mrs_to_target(frame->setpoint_mrs[1], &dir2, &speed2);
+    chassis_set_target_cmd(dir1, speed1, dir2, speed2, frame->hdr.seq,
+                           frame->hdr.timestamp_us);
+    break;
+  case MOTOR_PROTO_TYPE_TRAJ:
+    /* 航点直接从 vring 缓冲区装入轨迹邮箱, 限幅随帧更新 */
+    traj = (const struct motor_proto_traj_frame *)data;
+    if (traj->flags & MOTOR_PROTO_TRAJ_FLAG_LIMITS) {
+      setpoint_set_limits((float)traj->accel_mrs2 * 0.001f,
+                          (float)traj->jerk_mrs3 * 0.001f);
+    }
+    setpoint_traj_load(traj->points, traj->count);
+    /* 最后一个航点之后保持不变, 指令超时只看新帧 */
+    health_kick();
+    break;
+  case MOTOR_PROTO_TYPE_TWIST:
+    /* 逆运动学只做几次浮点运算, 在回调中完成 */
+    twist = (const struct motor_proto_twist_frame *)data;
+    chassis_kin_inverse((float)twist->v_mmps * 0.001f,
+                        (float)twist->w_mradps * 0.001f, rps);
+    proto_rps_to_target(rps[0], &dir1, &speed1);
+    proto_rps_to_target(rps[1], &dir2, &speed2);
+    chassis_set_target_cmd(dir1, speed1, dir2, speed2, twist->hdr.seq,
+                           twist->hdr.timestamp_us);
+    break;
+  default:
+    rt_kprintf("[rpmsg_motor] Unknown binary frame type: %d\n",
+               frame->hdr.type);
+    break;
+  }
+}
+
+/* ================= 反馈事件 ================= */
+
+/**
+ * @brief 设置/清除保持型事件位
+ */
+static void feedback_event_set(rt_uint32_t bits, rt_bool_t on) {
+  if (feedback_event == RT_NULL) {
+    return;
+  }
+  if (on) {
+    rt_event_send(feedback_event, bits);
+  } else {
+    /* RT-Thread 没有单独的清除接口, 用不等待的 recv + CLEAR 清除 */
+    rt_event_recv(feedback_event, bits, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR,
+                  0, RT_NULL);
+  }
+}
+
+/**
+ * @brief 开启/关闭反馈
+ */
+static void feedback_set_enabled(rt_bool_t on) {
+  feedback_enabled = on;
+  feedback_event_set(FEEDBACK_EVT_ENABLED, on);
+}
+
+/**
+ * @brief 是否以批量遥测代替状态反馈 (只在二进制协议下生效)
+ */
+static rt_bool_t feedback_telemetry_active(void) {
+  return telemetry_is_enabled() && motor_ctx.binary_mode;
+}
+
 /* ================= RPMsg 回调函数 ================= */
 
 /**
@@ -133,30 +513,44 @@ static rt_err_t parse_cfg_command(const char *cmd, double *ratio, double *ff,
  */
 static int rpmsg_motor_endpoint_cb(struct rpmsg_endpoint *ept, void *data,
                                    size_t len, uint32_t src, void *priv) {
-  char *recv_str = (char *)data;
+  const char *recv_str = (const char *)data;
   int dir1 = 0, dir2 = 0;
-  int feedback_cfg = -1;
   double speed1 = 0.0, speed2 = 0.0;
-  double ratio = 0.0, ff = 0.0, kp = 0.0, ki = 0.0, kd = 0.0;
 
-  (void)ept;
+  (void)src;
   (void)priv;
-  (void)len;
+
+  motor_ctx.ctrl_rx++;
+
+  /* 二进制帧优先, 不经过文本解析 */
+  if (motor_proto_is_binary(data, len)) {
+    rpmsg_motor_handle_binary(ept, data, len);
+    return 0;
+  }
+
+  /* 文本帧直接在接收缓冲区上解析, 必须在 len 之内结束 */
+  if (len == 0 || memchr(recv_str, '\0', len) == RT_NULL) {
+    rt_kprintf("[rpmsg_motor] Unterminated text frame (len=%d)\n", (int)len);
+    return 0;
+  }
 
   // rt_kprintf("[rpmsg_motor] Recv: \"%s\" (src=%d)\n", recv_str, src);
 
-  if (parse_cfg_command(recv_str, &ratio, &ff, &kp, &ki, &kd,
-                        &feedback_cfg) == RT_EOK) {
-    if (feedback_cfg == 0) {
-      feedback_enabled = RT_FALSE;
-    } else if (feedback_cfg == 1) {
-      feedback_enabled = RT_TRUE;
+  /* CFG / TUNE / FF 解析和打印较慢, 保留缓冲区交给 cfg 线程处理 */
+  if (strncmp(recv_str, "CFG,", 4) == 0 || strncmp(recv_str, "TUNE,", 5) == 0 ||
+      strncmp(recv_str, "FF", 2) == 0) {
+    rpmsg_hold_rx_buffer(ept, data);
+    if (rt_mb_send(cfg_mailbox, (rt_ubase_t)data) != RT_EOK) {
+      rpmsg_release_rx_buffer(ept, data);
+      motor_ctx.cfg_dropped++;
+      rt_kprintf("[rpmsg_motor] CFG dropped (worker busy)\n");
     }
+    return 0;
+  }
 
-    rt_kprintf("[rpmsg_motor] CFG ratio=%d ff=%d kp=%d ki=%d kd=%d fb=%d (x1000/flag)\n",
-               (int)(ratio * 1000), (int)(ff * 1000), (int)(kp * 1000),
-               (int)(ki * 1000), (int)(kd * 1000), feedback_enabled);
-    chassis_set_cfg(ratio, ff, kp, ki, kd);
+  /* 清除锁存故障只置一个请求位, 直接在回调中处理 */
+  if (strcmp(recv_str, "FAULTCLR") == 0) {
+    health_clear();
     return 0;
   }
 
@@ -180,53 +574,560 @@ static void rpmsg_motor_service_unbind(struct rpmsg_endpoint *ept) {
   (void)ept;
   rt_kprintf("[rpmsg_motor] Service unbound\n");
   motor_ctx.endpoint_ready = RT_FALSE;
+  feedback_event_set(FEEDBACK_EVT_BOUND, RT_FALSE);
+  /* 对端重新绑定后需要重新协商 */
+  motor_ctx.binary_mode = RT_FALSE;
+}
+
+/**
+ * @brief 诊断端点回调: 只保留缓冲区交给 cfg 线程, 不做解析
+ *        速度指令不走该端点, 诊断流量不会推迟控制端点的回调
+ */
+static int rpmsg_motor_diag_cb(struct rpmsg_endpoint *ept, void *data,
+                               size_t len, uint32_t src, void *priv) {
+  (void)src;
+  (void)priv;
+
+  motor_ctx.diag_rx++;
+
+  if (len == 0 || motor_proto_is_binary(data, len) ||
+      memchr(data, '\0', len) == RT_NULL) {
+    rt_kprintf("[rpmsg_motor] Diag channel accepts text only (len=%d)\n",
+               (int)len);
+    return 0;
+  }
+
+  rpmsg_hold_rx_buffer(ept, data);
+  if (rt_mb_send(cfg_mailbox, (rt_ubase_t)data | CFG_MSG_FROM_DIAG) != RT_EOK) {
+    rpmsg_release_rx_buffer(ept, data);
+    motor_ctx.cfg_dropped++;
+    rt_kprintf("[rpmsg_motor] Diag request dropped (worker busy)\n");
+  }
+  return 0;
+}
+
+/**
+ * @brief 诊断端点解绑回调, 应答退回控制端点
+ */
+static void rpmsg_motor_diag_unbind(struct rpmsg_endpoint *ept) {
+  (void)ept;
+  rt_kprintf("[rpmsg_motor] Diag service unbound\n");
+  motor_ctx.diag_active = RT_FALSE;
+}
+
+/* ================= CFG 处理线程 ================= */
+
+/**
+ * @brief 处理自整定指令 (cfg 线程中调用), 结果由自整定报告线程上报
+ */
+static void rpmsg_motor_handle_tune(const char *cmd) {
+  struct autotune_config cfg;
+  rt_err_t ret;
+
+  if (strcmp(cmd, "TUNE,stop") == 0) {
+    autotune_abort();
+    return;
+  }
+  if (parse_tune_command(cmd, &cfg) != RT_EOK) {
+    rt_kprintf("[rpmsg_motor] Bad TUNE command!\n");
+    rpmsg_motor_send_event("TUNE,error,format");
+    return;
+  }
+
+  cfg.notify = RT_TRUE;
+  ret = autotune_start(&cfg);
+  if (ret != RT_EOK) {
+    rt_kprintf("[rpmsg_motor] TUNE rejected: %d\n", ret);
+    rpmsg_motor_send_event((ret == -RT_EBUSY) ? "TUNE,error,busy"
+                                              : "TUNE,error,param");
+  }
+}
+
+/**
+ * @brief 处理前馈表指令 (cfg 线程中调用)
+ *        下发成功后应答该轴的表, "FFGET" 应答所有轴
+ */
+static void rpmsg_motor_handle_ff(const char *cmd) {
+  struct ff_table t;
+  char text[160];
+  int axis, i;
+
+  if (strcmp(cmd, "FFGET") == 0) {
+    for (i = 0; i < MOTOR_AXIS_NUM; i++) {
+      ff_table_format(i, text, sizeof(text));
+      rpmsg_motor_send_event(text);
+    }
+    return;
+  }
+
+  if (ff_table_parse(cmd, &axis, &t) != RT_EOK ||
+      ff_table_set(axis, &t) != RT_EOK) {
+    rt_kprintf("[rpmsg_motor] Bad FF command!\n");
+    rpmsg_motor_send_event("FF,error");
+    return;
+  }
+  ff_table_format(axis, text, sizeof(text));
+  rt_kprintf("[rpmsg_motor] %s\n", text);
+  rpmsg_motor_send_event(text);
+}
+
+/**
+ * @brief 处理运行参数指令 (cfg 线程中调用), 应答实际生效的值
+ *        "CFG,rate,<hz>[,<feedback_ms>]" / "CFG,prio,<thread>,<n>"
+ */
+static void rpmsg_motor_handle_runtime(const char *cmd) {
+  char text[48];
+  char name[RT_NAME_MAX + 1];
+  const char *comma;
+  int hz, ms = 0, prio = -1;
+
+  if (sscanf(cmd, "CFG,rate,%d,%d", &hz, &ms) >= 1 && hz > 0) {
+    hz = (int)control_tick_set_hz((rt_uint32_t)hz);
+    if (ms > 0) {
+      rpmsg_motor_set_feedback_interval(ms);
+    }
+    rt_snprintf(text, sizeof(text), "CFG,rate,%d,%d", hz, feedback_interval_ms);
+    rt_kprintf("[rpmsg_motor] %s\n", text);
+    rpmsg_motor_send_event(text);
+    return;
+  }
+
+  comma = strchr(cmd + 9, ',');
+  if (strncmp(cmd, "CFG,prio,", 9) == 0 && comma != RT_NULL &&
+      comma - (cmd + 9) > 0 && comma - (cmd + 9) <= RT_NAME_MAX) {
+    rt_memcpy(name, cmd + 9, comma - (cmd + 9));
+    name[comma - (cmd + 9)] = '\0';
+    prio = atoi(comma + 1);
+  }
+  if (prio >= 0 && profiler_set_priority(name, (rt_uint8_t)prio) == RT_EOK) {
+    rt_snprintf(text, sizeof(text), "CFG,prio,%s,%d", name, prio);
+  } else {
+    rt_snprintf(text, sizeof(text), "CFG,error");
+  }
+  rt_kprintf("[rpmsg_motor] %s\n", text);
+  rpmsg_motor_send_event(text);
+}
+
+/**
+ * @brief CFG 处理线程入口
+ *        解析保留的接收缓冲区, 应用参数后归还给 OpenAMP
+ */
+static void cfg_thread_entry(void *parameter) {
+  rt_ubase_t msg;
+  const char *cmd;
+  struct rpmsg_endpoint *ept;
+  int feedback_cfg = -1;
+  double ratio = 0.0, ff = 0.0, kp = 0.0, ki = 0.0, kd = 0.0;
+  struct chassis_geometry geo;
+
+  (void)parameter;
+
+  while (1) {
+    if (rt_mb_recv(cfg_mailbox, &msg, RT_WAITING_FOREVER) != RT_EOK) {
+      continue;
+    }
+    profiler_loop_begin();
+    ept = (msg & CFG_MSG_FROM_DIAG) ? &motor_ctx.diag_endp : &motor_ctx.endp;
+    cmd = (const char *)(msg & ~(rt_ubase_t)CFG_MSG_FROM_DIAG);
+
+    /* 应答走请求所在的端点 */
+    motor_ctx.diag_active = (ept == &motor_ctx.diag_endp);
+
+    if (strcmp(cmd, "DIAG") == 0) {
+      rpmsg_motor_send_event("DIAG,ok");
+    } else if (strcmp(cmd, "FAULTCLR") == 0) {
+      health_clear();
+    } else if (strncmp(cmd, "TUNE,", 5) == 0) {
+      rpmsg_motor_handle_tune(cmd);
+    } else if (strncmp(cmd, "FF", 2) == 0) {
+      rpmsg_motor_handle_ff(cmd);
+    } else if (strncmp(cmd, "CFG,rate,", 9) == 0 ||
+               strncmp(cmd, "CFG,prio,", 9) == 0) {
+      rpmsg_motor_handle_runtime(cmd);
+    } else if (parse_cfg_command(cmd, &ratio, &ff, &kp, &ki, &kd, &feedback_cfg) ==
+        RT_EOK) {
+      if (feedback_cfg == 0) {
+        feedback_set_enabled(RT_FALSE);
+      } else if (feedback_cfg >= 1 && feedback_cfg <= 3) {
+        /* 2: 开启反馈并使用批量遥测; 3: 开启反馈并使用位姿帧 */
+        telemetry_set_enabled(feedback_cfg == 2);
+        feedback_odom = (feedback_cfg == 3);
+        feedback_set_enabled(RT_TRUE);
+      }
+
+      if (parse_cfg_geometry(cmd, &geo) == RT_EOK) {
+        chassis_kin_set_geometry(&geo);
+        chassis_kin_get_geometry(&geo);
+        rt_kprintf("[rpmsg_motor] CFG radius=%d base=%d factor=%d/%d (um/x1000)\n",
+                   (int)(geo.wheel_radius_m * 1e6f), (int)(geo.wheel_base_m * 1e6f),
+                   (int)(geo.motor_factor[0] * 1000),
+                   (int)(geo.motor_factor[1] * 1000));
+      }
+
+      rt_kprintf("[rpmsg_motor] CFG ratio=%d ff=%d kp=%d ki=%d kd=%d fb=%d (x1000/flag)\n",
+                 (int)(ratio * 1000), (int)(ff * 1000), (int)(kp * 1000),
+                 (int)(ki * 1000), (int)(kd * 1000), feedback_enabled);
+      chassis_set_cfg(ratio, ff, kp, ki, kd);
+    } else {
+      rt_kprintf("[rpmsg_motor] Bad CFG command!\n");
+    }
+
+    rpmsg_release_rx_buffer(ept, (void *)cmd);
+    profiler_loop_end();
+  }
+}
+
+/* ================= 时延回显 ================= */
+
+/**
+ * @brief 在帧之后追加时延回显尾部 (只在反馈线程中调用)
+ *        还没有 CMD 输出过或缓冲区放不下时不追加
+ * @param tail 帧结束位置
+ * @param room tail 之后的可用字节数
+ * @return 追加的字节数
+ */
+static int rpmsg_motor_append_echo(void *tail, uint32_t room) {
+  struct motor_proto_echo *echo = (struct motor_proto_echo *)tail;
+  struct chassis_cmd_echo cmd;
+  rt_uint32_t apply_to_tx;
+
+  if (room < sizeof(*echo)) {
+    return 0;
+  }
+  chassis_get_cmd_echo(&cmd);
+  if (!cmd.valid) {
+    return 0;
+  }
+
+  apply_to_tx = hrtime_to_us(hrtime_now() - cmd.apply_hr);
+  echo->cmd_seq = cmd.cmd_seq;
+  echo->cmd_timestamp_us = cmd.cmd_timestamp_us;
+  echo->rx_to_apply_us = cmd.rx_to_apply_us;
+  echo->apply_to_tx_us = apply_to_tx;
+  motor_proto_echo_finalize(echo);
+
+  /* 同一条 CMD 可能被多帧反馈回显, 只统计第一帧 */
+  if (!lat_recorded || cmd.cmd_seq != lat_recorded_seq) {
+    latency_stats_add(&lat_rx_to_apply, cmd.rx_to_apply_us);
+    latency_stats_add(&lat_apply_to_tx, apply_to_tx);
+    latency_stats_add(&lat_rx_to_tx, cmd.rx_to_apply_us + apply_to_tx);
+    lat_recorded_seq = cmd.cmd_seq;
+    lat_recorded = RT_TRUE;
+  }
+
+  return sizeof(*echo);
+}
+
+/* ================= 文本事件 ================= */
+
+/**
+ * @brief 在指定端点发送一条文本, 文本和二进制协议下都以 '\0' 结尾的字符串发送
+ */
+static rt_err_t rpmsg_motor_send_text(struct rpmsg_endpoint *ept,
+                                      const char *text) {
+  char *buf;
+  uint32_t size;
+
+  if (!motor_ctx.endpoint_ready) {
+    return -RT_ERROR;
+  }
+
+  buf = (char *)rpmsg_motor_tx_reserve(ept, &size, 1);
+  if (buf == RT_NULL) {
+    return -RT_ERROR;
+  }
+  rt_snprintf(buf, size, "%s", text);
+  if (rpmsg_motor_tx_commit(ept, buf, strlen(buf) + 1) < 0) {
+    rt_kprintf("[rpmsg_motor] Send event failed\n");
+    return -RT_ERROR;
+  }
+  return RT_EOK;
+}
+
+/**
+ * @brief 发送一条文本事件 (配置应答 / 自整定结果), 诊断端点握手后走诊断端点
+ */
+rt_err_t rpmsg_motor_send_event(const char *text) {
+  return rpmsg_motor_send_text(rpmsg_motor_diag_ept(), text);
 }
 
 /* ================= 状态反馈线程 ================= */
 
 /**
- * @brief 状态反馈线程入口
- *        定期主动发送状态给大核
+ * @brief 发送一帧状态反馈
+ *        直接在 vring 缓冲区中组帧, 与 rpmsg_send 一样在缓冲区用尽时等待
  */
-static void feedback_thread_entry(void *parameter) {
-  char feedback_buf[64];
+static void rpmsg_motor_send_feedback(void) {
+  struct motor_proto_wheel_frame *frame;
+  char *text;
+  void *buf;
+  uint32_t size;
   int dir1, dir2;
   int speed1_mrs, speed2_mrs;
+  int setpoint1_mrs, setpoint2_mrs;
+  int ret;
+
+  chassis_get_status(&dir1, &speed1_mrs, &dir2, &speed2_mrs);
+
+  buf = rpmsg_motor_tx_reserve(&motor_ctx.endp, &size, 1);
+  if (buf == RT_NULL) {
+    ret = RPMSG_ERR_NO_BUFF;
+  } else if (motor_ctx.binary_mode && size >= sizeof(*frame)) {
+    frame = (struct motor_proto_wheel_frame *)buf;
+    chassis_get_setpoint(&setpoint1_mrs, &setpoint2_mrs);
+    frame->setpoint_mrs[0] = setpoint1_mrs;
+    frame->setpoint_mrs[1] = setpoint2_mrs;
+    frame->measured_mrs[0] = proto_target_to_mrs(dir1, speed1_mrs);
+    frame->measured_mrs[1] = proto_target_to_mrs(dir2, speed2_mrs);
+    motor_proto_finalize(frame, MOTOR_PROTO_TYPE_FEEDBACK,
+                         (uint8_t)health_get_faults(), motor_ctx.tx_seq++,
+                         proto_timestamp_us());
+    ret = rpmsg_motor_tx_commit(
+        &motor_ctx.endp, frame,
+        sizeof(*frame) + rpmsg_motor_append_echo(frame + 1,
+                                                 size - sizeof(*frame)));
+  } else {
+    text = (char *)buf;
+    rt_snprintf(text, size, "%d,%d;%d,%d", dir1, speed1_mrs, dir2,
+                speed2_mrs);
+    ret = rpmsg_motor_tx_commit(&motor_ctx.endp, text, strlen(text) + 1);
+  }
+
+  if (ret < 0) {
+    rt_kprintf("[rpmsg_motor] Send feedback failed: %d\n", ret);
+  }
+}
+
+/**
+ * @brief 发送一帧位姿反馈 (只在二进制协议下由反馈线程调用)
+ */
+static void rpmsg_motor_send_odom(void) {
+  struct motor_proto_odom_frame *frame;
+  struct chassis_odom odom;
+  uint32_t size;
+  int dir1, dir2;
+  int speed1_mrs, speed2_mrs;
+  int ret;
+
+  frame = rpmsg_motor_tx_reserve(&motor_ctx.endp, &size, 1);
+  if (frame == RT_NULL || size < sizeof(*frame)) {
+    if (frame != RT_NULL) {
+      rpmsg_release_tx_buffer(&motor_ctx.endp, frame);
+    }
+    rt_kprintf("[rpmsg_motor] Send odom failed: no tx buffer\n");
+    return;
+  }
+
+  chassis_kin_get_odom(&odom);
+  chassis_get_status(&dir1, &speed1_mrs, &dir2, &speed2_mrs);
+  frame->x_mm = (int32_t)(odom.x * 1000.0);
+  frame->y_mm = (int32_t)(odom.y * 1000.0);
+  frame->yaw_urad = (int32_t)(odom.yaw * 1000000.0);
+  frame->v_mmps = (int32_t)(odom.v * 1000.0f);
+  frame->w_mradps = (int32_t)(odom.w * 1000.0f);
+  frame->measured_mrs[0] = proto_target_to_mrs(dir1, speed1_mrs);
+  frame->measured_mrs[1] = proto_target_to_mrs(dir2, speed2_mrs);
+  frame->odom_us = hrtime_abs_to_us(odom.hr_time);
+  motor_proto_fixed_finalize(frame, sizeof(*frame), MOTOR_PROTO_TYPE_ODOM,
+                             (uint8_t)health_get_faults(), motor_ctx.tx_seq++,
+                             proto_timestamp_us());
+
+  ret = rpmsg_motor_tx_commit(
+      &motor_ctx.endp, frame,
+      sizeof(*frame) + rpmsg_motor_append_echo(frame + 1,
+                                               size - sizeof(*frame)));
+  if (ret < 0) {
+    rt_kprintf("[rpmsg_motor] Send odom failed: %d\n", ret);
+  }
+}
+
+/**
+ * @brief 发送批量遥测帧
+ *        记录从环形缓冲区直接取到 vring 缓冲区中, 积压时连续发送多帧
+ */
+static void rpmsg_motor_send_telemetry(void) {
+  struct motor_proto_telemetry_frame *frame;
+  uint32_t size;
+  uint32_t max;
+  size_t len;
+  int ret;
+
+  do {
+    frame = rpmsg_motor_tx_reserve(&motor_ctx.endp, &size, 1);
+    if (frame == RT_NULL) {
+      rt_kprintf("[rpmsg_motor] Send telemetry failed: no tx buffer\n");
+      return;
+    }
+
+    max = 0;
+    if (size >= motor_proto_telemetry_size(1)) {
+      max = (size - motor_proto_telemetry_size(0)) /
+            sizeof(struct motor_proto_telemetry_record);
+    }
+    if (max > MOTOR_PROTO_TELEMETRY_MAX_RECORDS) {
+      max = MOTOR_PROTO_TELEMETRY_MAX_RECORDS;
+    }
+
+    frame->count = (uint8_t)telemetry_pop(frame->records, max);
+    if (frame->count == 0) {
+      rpmsg_release_tx_buffer(&motor_ctx.endp, frame);
+      return;
+    }
+    frame->dropped = (uint16_t)telemetry_get_dropped();
+
+    len = motor_proto_telemetry_finalize(frame, (uint8_t)health_get_faults(),
+                                         motor_ctx.tx_seq++,
+                                         proto_timestamp_us());
+    len += rpmsg_motor_append_echo((uint8_t *)frame + len, size - len);
+    ret = rpmsg_motor_tx_commit(&motor_ctx.endp, frame, (int)len);
+    if (ret < 0) {
+      rt_kprintf("[rpmsg_motor] Send telemetry failed: %d\n", ret);
+      return;
+    }
+  } while (telemetry_flush_due());
+}
+
+/**
+ * @brief 故障标志变化时发送 "FAULT,<flags>,<axes>" 文本事件 (反馈线程中调用)
+ *        文本协议下大核看不到 hdr.flags, 只能靠这条事件得知故障
+ */
+static void rpmsg_motor_report_fault(void) {
+  static rt_uint32_t last_faults = 0;
+  rt_uint32_t faults = health_get_faults();
+  char text[32];
+
+  if (faults == last_faults) {
+    return;
+  }
+  rt_snprintf(text, sizeof(text), "FAULT,%u,%u", faults,
+              health_get_fault_axes());
+  /* 故障事件与状态帧同在控制端点, 不排在诊断流量之后 */
+  if (rpmsg_motor_send_text(&motor_ctx.endp, text) == RT_EOK) {
+    last_faults = faults;
+  }
+}
+
+/**
+ * @brief 发送线程剖析帧 (只由反馈线程调用)
+ */
+static void rpmsg_motor_send_profile(void) {
+  static struct profiler_thread_info info[MOTOR_PROTO_PROFILE_MAX_THREADS];
+  struct motor_proto_profile_frame *frame;
+  struct motor_proto_profile_thread *rec;
+  struct profiler_summary sum;
+  struct rpmsg_endpoint *ept = rpmsg_motor_diag_ept();
+  uint32_t size;
+  rt_size_t n, i, max;
+  size_t len;
+  int ret;
+
+  frame = rpmsg_motor_tx_reserve(ept, &size, 1);
+  if (frame == RT_NULL) {
+    rt_kprintf("[rpmsg_motor] Send profile failed: no tx buffer\n");
+    return;
+  }
+
+  max = 0;
+  if (size >= motor_proto_profile_size(1)) {
+    max = (size - motor_proto_profile_size(0)) /
+          sizeof(struct motor_proto_profile_thread);
+  }
+  if (max > MOTOR_PROTO_PROFILE_MAX_THREADS) {
+    max = MOTOR_PROTO_PROFILE_MAX_THREADS;
+  }
+
+  /* 即使放不下任何记录也取一次, 开始新的上报窗口 */
+  n = profiler_report(info, max, &sum);
+  for (i = 0; i < n; i++) {
+    rec = &frame->threads[i];
+    rt_memset(rec->name, 0, sizeof(rec->name));
+    rt_strncpy(rec->name, info[i].name, sizeof(rec->name));
+    rec->cpu_permille = (uint16_t)(sum.elapsed > 0
+                                       ? info[i].runtime * 1000 / sum.elapsed
+                                       : 0);
+    rec->priority = info[i].priority;
+    rec->alive = info[i].alive ? 1 : 0;
+    rec->stack_size = info[i].stack_size;
+    rec->stack_used = info[i].stack_used;
+    rec->exec_max_us = hrtime_to_us(info[i].exec_max);
+    rec->resp_max_us = hrtime_to_us(info[i].resp_max);
+  }
+  frame->count = (uint8_t)n;
+  frame->window_us = hrtime_to_us(sum.elapsed);
+  if (!sum.hooked || sum.elapsed == 0) {
+    frame->cpu_load_permille = 0xFFFF;
+    frame->irq_permille = 0;
+  } else {
+    frame->cpu_load_permille =
+        (uint16_t)(1000 - sum.idle * 1000 / sum.elapsed);
+    frame->irq_permille = (uint16_t)(sum.irq * 1000 / sum.elapsed);
+  }
+
+  len = motor_proto_profile_finalize(frame, motor_ctx.tx_seq++,
+                                     proto_timestamp_us());
+  ret = rpmsg_motor_tx_commit(ept, frame, (int)len);
+  if (ret < 0) {
+    rt_kprintf("[rpmsg_motor] Send profile failed: %d\n", ret);
+  }
+}
+
+/**
+ * @brief 状态反馈线程入口
+ *        采样模式下等待控制线程通知, 定时模式下周期发送;
+ *        批量遥测生效时只发送遥测帧
+ */
+static void feedback_thread_entry(void *parameter) {
+  rt_uint32_t recved;
+  rt_int32_t timeout;
+  rt_err_t ret;
 
   (void)parameter;
 
-  rt_kprintf("[rpmsg_motor] Feedback thread started (interval=%dms)\n",
-             feedback_interval_ms);
+  rt_kprintf("[rpmsg_motor] Feedback thread started (%s, interval=%dms)\n",
+             feedback_on_sample ? "on-sample" : "timer", feedback_interval_ms);
 
   while (1) {
-    /* 等待端点就绪 */
-    if (!motor_ctx.endpoint_ready) {
-      rt_thread_mdelay(100);
+    /* 端点绑定且反馈开启前一直阻塞 */
+    rt_event_recv(feedback_event, FEEDBACK_EVT_BOUND | FEEDBACK_EVT_ENABLED,
+                  RT_EVENT_FLAG_AND, RT_WAITING_FOREVER, RT_NULL);
+
+    /* 定时模式以等待超时作为发送周期; 未绑定或已关闭时控制线程不会发送事件 */
+    if (feedback_on_sample || feedback_telemetry_active()) {
+      timeout = RT_WAITING_FOREVER;
+    } else {
+      timeout = rt_tick_from_millisecond(feedback_interval_ms);
+    }
+
+    recved = 0;
+    ret = rt_event_recv(feedback_event,
+                        FEEDBACK_EVT_SAMPLE | FEEDBACK_EVT_TELEMETRY,
+                        RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, timeout,
+                        &recved);
+    if (ret != RT_EOK && ret != -RT_ETIMEOUT) {
+      continue;
+    }
+    if (!motor_ctx.endpoint_ready || !feedback_enabled) {
       continue;
     }
 
-    if (feedback_enabled) {
-      /* 发送电机状态反馈 */
-      chassis_get_status(&dir1, &speed1_mrs, &dir2, &speed2_mrs);
-      rt_snprintf(feedback_buf, sizeof(feedback_buf), "%d,%d;%d,%d", dir1,
-                  speed1_mrs, dir2, speed2_mrs);
-
-      /* 发送反馈 */
-      int ret =
-          rpmsg_send(&motor_ctx.endp, feedback_buf, strlen(feedback_buf) + 1);
-      if (ret < 0) {
-        rt_kprintf("[rpmsg_motor] Send feedback failed: %d\n", ret);
+    profiler_loop_begin();
+    if (feedback_telemetry_active()) {
+      if (recved & FEEDBACK_EVT_TELEMETRY) {
+        rpmsg_motor_send_telemetry();
       }
-
-      /* 调试: 每10次打印一次 */
-      // static int print_cnt = 0;
-      // if (++print_cnt >= 10) {
-      //   rt_kprintf("[rpmsg_motor] Feedback: %s\n", feedback_buf);
-      //   print_cnt = 0;
-      // }
+    } else if (feedback_odom && motor_ctx.binary_mode) {
+      rpmsg_motor_send_odom();
+    } else {
+      rpmsg_motor_send_feedback();
     }
+    profiler_loop_end();
+
+    rpmsg_motor_report_fault();
 
-    rt_thread_mdelay(feedback_interval_ms);
+    /* 剖析帧会扫描线程栈, 不计入反馈循环耗时 */
+    if (motor_ctx.binary_mode && profiler_report_due()) {
+      rpmsg_motor_send_profile();
+    }
   }
 }
 
@@ -259,10 +1160,25 @@ static void rpmsg_motor_init_thread_entry(void *parameter) {
   }
 
   motor_ctx.endpoint_ready = RT_TRUE;
+  feedback_event_set(FEEDBACK_EVT_BOUND, RT_TRUE);
 
   rt_kprintf("[rpmsg_motor] Endpoint created: %s (src=%d, dst=%d)\n",
              motor_ctx.service_name, RPMSG_MOTOR_ADDR_SRC,
              RPMSG_MOTOR_ADDR_DST);
+
+  /* 诊断端点失败不影响控制: 应答继续走控制端点 */
+  ret = rpmsg_create_ept(&motor_ctx.diag_endp, rpdev,
+                         RPMSG_MOTOR_DIAG_SERVICE_NAME,
+                         RPMSG_MOTOR_DIAG_ADDR_SRC, RPMSG_MOTOR_DIAG_ADDR_DST,
+                         rpmsg_motor_diag_cb, rpmsg_motor_diag_unbind);
+  if (ret) {
+    rt_kprintf("[rpmsg_motor] Create diag endpoint failed, ret=%d\n", ret);
+  } else {
+    motor_ctx.diag_ready = RT_TRUE;
+    rt_kprintf("[rpmsg_motor] Endpoint created: %s (src=%d, dst=%d)\n",
+               RPMSG_MOTOR_DIAG_SERVICE_NAME, RPMSG_MOTOR_DIAG_ADDR_SRC,
+               RPMSG_MOTOR_DIAG_ADDR_DST);
+  }
   rt_kprintf("[rpmsg_motor] Ready. Command format: dir1,speed1;dir2,speed2\n");
 }
 
@@ -277,6 +1193,30 @@ rt_err_t rpmsg_motor_init(void) {
   rt_memset(&motor_ctx, 0, sizeof(motor_ctx));
   motor_ctx.endpoint_ready = RT_FALSE;
 
+  /* 反馈事件: 开启状态在端点绑定前就确定 */
+  feedback_event = rt_event_create("rpmsg_fb", RT_IPC_FLAG_FIFO);
+  if (!feedback_event) {
+    rt_kprintf("[rpmsg_motor] Failed to create feedback event\n");
+    return -RT_ENOMEM;
+  }
+  feedback_set_enabled(feedback_enabled);
+  rpmsg_motor_set_feedback_interval(feedback_interval_ms);
+
+  /* CFG 邮箱和处理线程须在端点创建前就绪 */
+  cfg_mailbox = rt_mb_create("rpmsg_cfg", CFG_MAILBOX_SIZE, RT_IPC_FLAG_FIFO);
+  if (!cfg_mailbox) {
+    rt_kprintf("[rpmsg_motor] Failed to create cfg mailbox\n");
+    return -RT_ENOMEM;
+  }
+  cfg_thread = rt_thread_create("rpmsg_cfg", cfg_thread_entry, RT_NULL,
+                                CFG_THREAD_STACK_SIZE, CFG_THREAD_PRIORITY,
+                                CFG_THREAD_TIMESLICE);
+  if (!cfg_thread) {
+    rt_kprintf("[rpmsg_motor] Failed to create cfg thread\n");
+    return -RT_EINVAL;
+  }
+  rt_thread_startup(cfg_thread);
+
   /* 创建初始化线程 */
   tid = rt_thread_create("rpmsg_mi", rpmsg_motor_init_thread_entry, RT_NULL,
                          4096, RT_THREAD_PRIORITY_MAX / 3, 20);
@@ -301,14 +1241,63 @@ rt_err_t rpmsg_motor_init(void) {
   return RT_EOK;
 }
 
+/**
+ * @brief 按反馈间隔和当前控制频率计算抽取系数 N
+ */
+static void feedback_update_decimation(void) {
+  rt_uint32_t decimation;
+
+  feedback_rate_generation = control_tick_get_generation();
+  decimation = (rt_uint32_t)feedback_interval_ms * control_tick_get_hz() / 1000;
+  feedback_decimation = decimation > 0 ? decimation : 1;
+}
+
 /**
  * @brief 设置状态反馈间隔
+ *        采样模式下换算为抽取系数 N (每 N 个控制节拍发送一次)
  */
 void rpmsg_motor_set_feedback_interval(int ms) {
   if (ms < 10)
     ms = 10; /* 最小 10ms */
   feedback_interval_ms = ms;
-  rt_kprintf("[rpmsg_motor] Feedback interval set to %dms\n", ms);
+  feedback_update_decimation();
+
+  rt_kprintf("[rpmsg_motor] Feedback interval set to %dms (every %d samples)\n",
+             ms, feedback_decimation);
+}
+
+/**
+ * @brief 新采样就绪通知 (底盘控制线程发布状态后调用)
+ *        按抽取系数唤醒反馈线程; 端点未绑定或反馈关闭时直接返回
+ */
+void rpmsg_motor_notify_sample(void) {
+  if (feedback_event == RT_NULL || !feedback_enabled ||
+      !motor_ctx.endpoint_ready) {
+    return;
+  }
+
+  /* 批量遥测: 只在达到批量或时延条件时唤醒 */
+  if (feedback_telemetry_active()) {
+    if (telemetry_flush_due()) {
+      rt_event_send(feedback_event, FEEDBACK_EVT_TELEMETRY);
+    }
+    return;
+  }
+
+  if (!feedback_on_sample) {
+    return;
+  }
+
+  /* 控制频率变化后保持反馈间隔不变 */
+  if (feedback_rate_generation != control_tick_get_generation()) {
+    feedback_update_decimation();
+  }
+  if (++feedback_sample_count < feedback_decimation) {
+    return;
+  }
+  feedback_sample_count = 0;
+
+  rt_event_send(feedback_event, FEEDBACK_EVT_SAMPLE);
 }
 
 /* ================= MSH 命令 ================= */
@@ -318,18 +1307,33 @@ void rpmsg_motor_set_feedback_interval(int ms) {
  */
 static int cmd_rpmsg_feedback(int argc, char *argv[]) {
   if (argc < 2) {
-    rt_kprintf("Usage: rpmsg_feedback <on|off|interval_ms>\n");
-    rt_kprintf("Current: enabled=%d, interval=%dms\n", feedback_enabled,
-               feedback_interval_ms);
+    rt_kprintf("Usage: rpmsg_feedback <on|off|sample|timer|interval_ms>\n");
+    rt_kprintf("Current: enabled=%d, mode=%s, interval=%dms (every %d samples), protocol=%s%s\n",
+               feedback_enabled, feedback_on_sample ? "sample" : "timer",
+               feedback_interval_ms, feedback_decimation,
+               motor_ctx.binary_mode ? "binary" : "text",
+               feedback_telemetry_active() ? " (telemetry)" :
+               (feedback_odom && motor_ctx.binary_mode) ? " (odom)" : "");
     return 0;
   }
 
   if (strcmp(argv[1], "on") == 0) {
-    feedback_enabled = RT_TRUE;
+    feedback_set_enabled(RT_TRUE);
     rt_kprintf("[rpmsg_motor] Feedback enabled\n");
   } else if (strcmp(argv[1], "off") == 0) {
-    feedback_enabled = RT_FALSE;
+    feedback_set_enabled(RT_FALSE);
     rt_kprintf("[rpmsg_motor] Feedback disabled\n");
+  } else if (strcmp(argv[1], "sample") == 0) {
+    feedback_sample_count = 0;
+    feedback_on_sample = RT_TRUE;
+    rt_kprintf("[rpmsg_motor] Feedback published on new samples\n");
+  } else if (strcmp(argv[1], "timer") == 0) {
+    feedback_on_sample = RT_FALSE;
+    /* 唤醒可能正在等待采样事件的反馈线程 */
+    if (feedback_event != RT_NULL) {
+      rt_event_send(feedback_event, FEEDBACK_EVT_SAMPLE);
+    }
+    rt_kprintf("[rpmsg_motor] Feedback published by timer\n");
   } else {
     int interval = atoi(argv[1]);
     if (interval > 0) {
@@ -343,4 +1347,46 @@ static int cmd_rpmsg_feedback(int argc, char *argv[]) {
 }
 
 #include <finsh.h>
-MSH_CMD_EXPORT(cmd_rpmsg_feedback, rpmsg_feedback_control);
\ No newline at end of file
+MSH_CMD_EXPORT(cmd_rpmsg_feedback, rpmsg_feedback_control);
+
+/**
+ * @brief MSH 命令: 查看/清零指令时延统计
+ *        rx_to_apply: 收到 CMD -> PWM 更新; apply_to_tx: PWM 更新 -> 首帧回显发送
+ */
+static int cmd_rpmsg_latency(int argc, char *argv[]) {
+  if (argc >= 2 && strcmp(argv[1], "reset") == 0) {
+    latency_stats_reset(&lat_rx_to_apply);
+    latency_stats_reset(&lat_apply_to_tx);
+    latency_stats_reset(&lat_rx_to_tx);
+    rt_kprintf("[rpmsg_motor] Latency statistics reset\n");
+    return 0;
+  }
+
+  rt_kprintf("CMD latency (binary protocol, last seq=%u):\n", lat_recorded_seq);
+  latency_stats_print("rx_to_apply", &lat_rx_to_apply);
+  latency_stats_print("apply_to_tx", &lat_apply_to_tx);
+  latency_stats_print("rx_to_tx", &lat_rx_to_tx);
+  return 0;
+}
+MSH_CMD_EXPORT(cmd_rpmsg_latency, rpmsg_latency_stats [reset]);
+
+/**
+ * @brief MSH 命令: 查看通道状态和收发计数
+ */
+static int cmd_rpmsg_channel(int argc, char *argv[]) {
+  (void)argc;
+  (void)argv;
+
+  rt_kprintf("ctrl: %s (src=%d, dst=%d) rx=%u\n", RPMSG_MOTOR_SERVICE_NAME,
+             RPMSG_MOTOR_ADDR_SRC, RPMSG_MOTOR_ADDR_DST, motor_ctx.ctrl_rx);
+  rt_kprintf("diag: %s (src=%d, dst=%d) %s rx=%u tx=%u\n",
+             RPMSG_MOTOR_DIAG_SERVICE_NAME, RPMSG_MOTOR_DIAG_ADDR_SRC,
+             RPMSG_MOTOR_DIAG_ADDR_DST,
+             !motor_ctx.diag_ready ? "not created"
+                                   : (motor_ctx.diag_active ? "active" : "idle"),
+             motor_ctx.diag_rx, motor_ctx.diag_tx);
+  rt_kprintf("cfg worker: dropped=%u (mailbox %d)\n", motor_ctx.cfg_dropped,
+             CFG_MAILBOX_SIZE);
+  return 0;
+}
+MSH_CMD_EXPORT(cmd_rpmsg_channel, rpmsg_channel_status);
@@ -0,0 +1,295 @@
+/*
+ * 目标值队列与整形
+ *
+ * 轨迹邮箱使用 seqlock: RPMsg 回调 / MSH 写, 底盘控制线程读;
+ * 控制线程保存一份私有副本, 只在 generation 变化时重新拷贝
+ */
+
+#include <rtthread.h>
+#include <math.h>
+#include <stdlib.h>
+#include "common.h"
+#include "hrtime.h"
+#include "seqlock.h"
+#include "setpoint.h"
+
+struct setpoint_traj
+{
+    rt_uint32_t count;                               /* 0 表示没有轨迹 */
+    rt_uint64_t rx_hr;                               /* 收到轨迹的时刻 */
+    rt_uint32_t t_us[SETPOINT_QUEUE_SIZE];           /* 相对 rx_hr 的偏移 */
+    float speed[SETPOINT_QUEUE_SIZE][MOTOR_PROTO_WHEELS]; /* r/s, 带符号 */
+    rt_uint32_t generation;                          /* 每次装载 / 取消递增 */
+};
+
+static struct setpoint_traj traj_box;
+static struct setpoint_limits limits_box = {
+    SETPOINT_ACCEL_DEFAULT, SETPOINT_JERK_DEFAULT,
+};
+static seqlock_t setpoint_lock = SEQLOCK_INIT;
+
+/* 控制线程私有 */
+static struct setpoint_traj traj_local;
+static float traj_start[MOTOR_PROTO_WHEELS];
+
+/* 统计 (MSH 查看) */
+static volatile rt_uint32_t traj_loaded = 0;
+static volatile rt_uint32_t traj_truncated = 0;
+
+rt_uint32_t setpoint_traj_load(const struct motor_proto_traj_point *points,
+                               rt_uint32_t count)
+{
+    rt_uint64_t rx_hr = hrtime_now();
+    rt_uint32_t n = 0;
+    rt_base_t level;
+    int ch;
+
+    level = seqlock_write_begin(&setpoint_lock);
+    while (n < count && n < SETPOINT_QUEUE_SIZE)
+    {
+        /* 航点时间必须严格递增, 否则丢弃其后的航点 */
+        if (n > 0 && points[n].t_us <= traj_box.t_us[n - 1])
+        {
+            break;
+        }
+        traj_box.t_us[n] = points[n].t_us;
+        for (ch = 0; ch < MOTOR_PROTO_WHEELS; ch++)
+        {
+            traj_box.speed[n][ch] = (float)points[n].setpoint_mrs[ch] * 0.001f;
+        }
+        n++;
+    }
+    traj_box.count = n;
+    traj_box.rx_hr = rx_hr;
+    traj_box.generation++;
+    seqlock_write_end(&setpoint_lock, level);
+
+    if (n > 0)
+    {
+        traj_loaded++;
+    }
+    traj_truncated += count - n;
+    return n;
+}
+
+void setpoint_traj_cancel(void)
+{
+    rt_base_t level;
+
+    /* 没有轨迹时不改动邮箱, CMD 路径上不重复写 */
+    if (traj_box.count == 0)
+    {
+        return;
+    }
+    level = seqlock_write_begin(&setpoint_lock);
+    traj_box.count = 0;
+    traj_box.generation++;
+    seqlock_write_end(&setpoint_lock, level);
+}
+
+/**
+ * @brief 在 a 和 b 之间按 num/den 线性插值
+ */
+static float setpoint_lerp(float a, float b, rt_uint32_t num, rt_uint32_t den)
+{
+    return a + (b - a) * ((float)num / (float)den);
+}
+
+rt_bool_t setpoint_traj_sample(rt_uint64_t now, const float *current, float *out)
+{
+    rt_uint32_t seq;
+    rt_uint32_t t, k;
+    int ch;
+
+    if (traj_box.generation != traj_local.generation)
+    {
+        do
+        {
+            seq = seqlock_read_begin(&setpoint_lock);
+            traj_local = traj_box;
+        } while (seqlock_read_retry(&setpoint_lock, seq));
+
+        for (ch = 0; ch < MOTOR_PROTO_WHEELS; ch++)
+        {
+            traj_start[ch] = current[ch];
+        }
+    }
+
+    if (traj_local.count == 0)
+    {
+        return RT_FALSE;
+    }
+
+    /* 轨迹可能在本节拍开始之后才到达 */
+    t = (now > traj_local.rx_hr) ? hrtime_to_us(now - traj_local.rx_hr) : 0;
+
+    for (k = 0; k < traj_local.count && traj_local.t_us[k] <= t; k++)
+    {
+    }
+
+    for (ch = 0; ch < MOTOR_PROTO_WHEELS; ch++)
+    {
+        if (k == traj_local.count)
+        {
+            /* 最后一个航点之后保持 */
+            out[ch] = traj_local.speed[k - 1][ch];
+        }
+        else if (k == 0)
+        {
+            /* 从收到轨迹时的目标值过渡到第一个航点 */
+            out[ch] = setpoint_lerp(traj_start[ch], traj_local.speed[0][ch], t,
+                                    traj_local.t_us[0]);
+        }
+        else
+        {
+            out[ch] = setpoint_lerp(traj_local.speed[k - 1][ch], traj_local.speed[k][ch],
+                                    t - traj_local.t_us[k - 1],
+                                    traj_local.t_us[k] - traj_local.t_us[k - 1]);
+        }
+    }
+    return RT_TRUE;
+}
+
+void setpoint_set_limits(float accel, float jerk)
+{
+    rt_base_t level;
+
+    level = seqlock_write_begin(&setpoint_lock);
+    limits_box.accel = (accel > 0.0f) ? accel : 0.0f;
+    limits_box.jerk = (jerk > 0.0f) ? jerk : 0.0f;
+    seqlock_write_end(&setpoint_lock, level);
+}
+
+void setpoint_get_limits(struct setpoint_limits *out)
+{
+    rt_uint32_t seq;
+
+    do
+    {
+        seq = seqlock_read_begin(&setpoint_lock);
+        *out = limits_box;
+    } while (seqlock_read_retry(&setpoint_lock, seq));
+}
+
+void setpoint_shaper_reset(struct setpoint_shaper *s, float value)
+{
+    s->value = value;
+    s->rate = 0.0f;
+}
+
+float setpoint_shaper_step(struct setpoint_shaper *s, float target, float dt,
+                           const struct setpoint_limits *lim)
+{
+    float err = target - s->value;
+    float dir = (err > 0.0f) ? 1.0f : -1.0f;
+    float rate_want, step;
+
+    if (lim->accel <= 0.0f && lim->jerk <= 0.0f)
+    {
+        setpoint_shaper_reset(s, target);
+        return target;
+    }
+
+    if (lim->jerk <= 0.0f)
+    {
+        /* 只限加速度: 匀加速斜坡 */
+        step = lim->accel * dt;
+        if (fabsf(err) <= step)
+        {
+            setpoint_shaper_reset(s, target);
+            return target;
+        }
+        s->rate = dir * lim->accel;
+        s->value += s->rate * dt;
+        return s->value;
+    }
+
+    /*
+     * 限加加速度: 以 jerk 减小变化率时停下需要 rate^2 / (2 jerk) 的误差,
+     * 期望变化率取 sqrt(2 jerk |err|), 不超过加速度上限
+     */
+    rate_want = sqrtf(2.0f * lim->jerk * fabsf(err));
+    if (lim->accel > 0.0f && rate_want > lim->accel)
+    {
+        rate_want = lim->accel;
+    }
+    rate_want *= dir;
+
+    step = lim->jerk * dt;
+    if (rate_want > s->rate + step)
+    {
+        s->rate += step;
+    }
+    else if (rate_want < s->rate - step)
+    {
+        s->rate -= step;
+    }
+    else
+    {
+        s->rate = rate_want;
+    }
+    s->value += s->rate * dt;
+
+    /* 越过目标 (离散化误差) 时直接落到目标上 */
+    if ((target - s->value) * err <= 0.0f)
+    {
+        setpoint_shaper_reset(s, target);
+    }
+    return s->value;
+}
+
+/* ================= 调试用 MSH 命令 ================= */
+
+/**
+ * @brief MSH 命令: 查看轨迹状态, 取消轨迹, 设置加速度 / 加加速度上限
+ *        用法: traj [clear|limit <accel_rps2> <jerk_rps3>]
+ */
+static void traj_cmd(int argc, char *argv[])
+{
+    struct setpoint_limits lim;
+    struct setpoint_traj traj;
+    rt_uint32_t seq;
+    rt_uint32_t age_us;
+
+    if (argc >= 2)
+    {
+        if (rt_strcmp(argv[1], "clear") == 0)
+        {
+            setpoint_traj_cancel();
+        }
+        else if (rt_strcmp(argv[1], "limit") == 0 && argc >= 4)
+        {
+            setpoint_set_limits((float)atof(argv[2]), (float)atof(argv[3]));
+        }
+        else
+        {
+            rt_kprintf("Usage: traj [clear|limit <accel_rps2> <jerk_rps3>]\n");
+            rt_kprintf("  limits apply to wheel speed before the PID, 0 = unlimited\n");
+            return;
+        }
+    }
+
+    do
+    {
+        seq = seqlock_read_begin(&setpoint_lock);
+        traj = traj_box;
+        lim = limits_box;
+    } while (seqlock_read_retry(&setpoint_lock, seq));
+
+    if (traj.count > 0)
+    {
+        age_us = hrtime_to_us(hrtime_now() - traj.rx_hr);
+        rt_kprintf("Trajectory: %u points, span=%ums, age=%ums%s\n", traj.count,
+                   traj.t_us[traj.count - 1] / 1000, age_us / 1000,
+                   (age_us >= traj.t_us[traj.count - 1]) ? " (holding last point)" : "");
+    }
+    else
+    {
+        rt_kprintf("Trajectory: none (following CMD target)\n");
+    }
+    rt_kprintf("  loaded=%u, dropped points=%u, queue=%d\n", traj_loaded, traj_truncated,
+               SETPOINT_QUEUE_SIZE);
+    rt_kprintf("  limits: accel=%d mr/s^2, jerk=%d mr/s^3 (0 = unlimited)\n",
+               (int)(lim.accel * 1000), (int)(lim.jerk * 1000));
+}
+MSH_CMD_EXPORT_ALIAS(traj_cmd, traj, Show trajectory queue or set accel limits);
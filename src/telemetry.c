@@ -0,0 +1,181 @@
+/*
+ * 批量遥测
+ *
+ * 单生产者单消费者环形缓冲区, 读写索引自由递增, 下标取模,
+ * 生产者只写 head, 消费者只写 tail, 不需要关中断或加锁
+ */
+
+#include <rtthread.h>
+#include <stdlib.h>
+#include "common.h"
+#include "telemetry.h"
+
+#if (TELEMETRY_RING_SIZE & (TELEMETRY_RING_SIZE - 1)) != 0
+#error "TELEMETRY_RING_SIZE must be a power of 2"
+#endif
+
+#define TELEMETRY_RING_MASK (TELEMETRY_RING_SIZE - 1)
+
+static struct motor_proto_telemetry_record telemetry_ring[TELEMETRY_RING_SIZE];
+static volatile rt_uint32_t telemetry_head = 0; /* 生产者写 */
+static volatile rt_uint32_t telemetry_tail = 0; /* 消费者写 */
+
+static volatile rt_bool_t telemetry_enabled = RT_FALSE;
+static rt_uint32_t telemetry_batch = TELEMETRY_BATCH_DEFAULT;
+static rt_uint32_t telemetry_max_age_us = TELEMETRY_MAX_AGE_MS * 1000;
+
+/* 统计 */
+static volatile rt_uint32_t telemetry_pushed = 0;
+static volatile rt_uint32_t telemetry_dropped = 0;
+
+void telemetry_set_enabled(rt_bool_t on)
+{
+    if (on && !telemetry_enabled)
+    {
+        /* 关闭期间生产者和消费者都不访问缓冲区, 可以直接清空 */
+        telemetry_tail = telemetry_head;
+    }
+    telemetry_enabled = on;
+}
+
+rt_bool_t telemetry_is_enabled(void)
+{
+    return telemetry_enabled;
+}
+
+/**
+ * @brief 写入一条记录
+ */
+void telemetry_push(const struct motor_proto_telemetry_record *rec)
+{
+    rt_uint32_t head = telemetry_head;
+
+    if (head - telemetry_tail >= TELEMETRY_RING_SIZE)
+    {
+        telemetry_dropped++;
+        return;
+    }
+
+    telemetry_ring[head & TELEMETRY_RING_MASK] = *rec;
+
+    /* 记录写完后再发布索引 */
+    __sync_synchronize();
+    telemetry_head = head + 1;
+    telemetry_pushed++;
+}
+
+/**
+ * @brief 是否达到发送条件
+ */
+rt_bool_t telemetry_flush_due(void)
+{
+    rt_uint32_t head = telemetry_head;
+    rt_uint32_t tail = telemetry_tail;
+    rt_uint32_t age_us;
+
+    if (head == tail)
+    {
+        return RT_FALSE;
+    }
+    if (head - tail >= telemetry_batch)
+    {
+        return RT_TRUE;
+    }
+
+    age_us = telemetry_ring[(head - 1) & TELEMETRY_RING_MASK].timestamp_us -
+             telemetry_ring[tail & TELEMETRY_RING_MASK].timestamp_us;
+    return age_us >= telemetry_max_age_us;
+}
+
+/**
+ * @brief 取出最多 max 条记录
+ */
+rt_uint32_t telemetry_pop(struct motor_proto_telemetry_record *out, rt_uint32_t max)
+{
+    rt_uint32_t head = telemetry_head;
+    rt_uint32_t tail = telemetry_tail;
+    rt_uint32_t count = head - tail;
+    rt_uint32_t i;
+
+    if (count > max)
+    {
+        count = max;
+    }
+
+    /* 先看到 head 再读记录 */
+    __sync_synchronize();
+    for (i = 0; i < count; i++)
+    {
+        out[i] = telemetry_ring[(tail + i) & TELEMETRY_RING_MASK];
+    }
+
+    /* 记录读完后再释放槽位 */
+    __sync_synchronize();
+    telemetry_tail = tail + count;
+
+    return count;
+}
+
+rt_uint32_t telemetry_get_dropped(void)
+{
+    return telemetry_dropped;
+}
+
+void telemetry_set_batch(rt_uint32_t count)
+{
+    if (count < 1)
+    {
+        count = 1;
+    }
+    else if (count > MOTOR_PROTO_TELEMETRY_MAX_RECORDS)
+    {
+        count = MOTOR_PROTO_TELEMETRY_MAX_RECORDS;
+    }
+    telemetry_batch = count;
+}
+
+void telemetry_set_max_age_ms(rt_uint32_t ms)
+{
+    telemetry_max_age_us = ms * 1000;
+}
+
+/* ================= 调试用 MSH 命令 ================= */
+
+/**
+ * @brief MSH 命令: 查看/设置批量遥测
+ *        用法: telemetry [on|off|batch <n>|age <ms>]
+ */
+static void telemetry_cmd(int argc, char *argv[])
+{
+    if (argc >= 2)
+    {
+        if (rt_strcmp(argv[1], "on") == 0)
+        {
+            telemetry_set_enabled(RT_TRUE);
+        }
+        else if (rt_strcmp(argv[1], "off") == 0)
+        {
+            telemetry_set_enabled(RT_FALSE);
+        }
+        else if (rt_strcmp(argv[1], "batch") == 0 && argc >= 3)
+        {
+            telemetry_set_batch((rt_uint32_t)atoi(argv[2]));
+        }
+        else if (rt_strcmp(argv[1], "age") == 0 && argc >= 3)
+        {
+            telemetry_set_max_age_ms((rt_uint32_t)atoi(argv[2]));
+        }
+        else
+        {
+            rt_kprintf("Usage: telemetry [on|off|batch <n>|age <ms>]\n");
+            return;
+        }
+    }
+
+    rt_kprintf("Telemetry: %s, batch=%d (max %d), age=%dms, pending=%d, pushed=%u, dropped=%u\n",
+               telemetry_enabled ? "on" : "off", telemetry_batch,
+               (int)MOTOR_PROTO_TELEMETRY_MAX_RECORDS, telemetry_max_age_us / 1000,
+               telemetry_head - telemetry_tail, telemetry_pushed, telemetry_dropped);
+    rt_kprintf("  (frames are only sent after binary protocol negotiation)\n");
+}
+MSH_CMD_EXPORT_ALIAS(telemetry_cmd, telemetry, Show or set batched telemetry);
@@ -0,0 +1,255 @@
+/*
+ * 二进制跟踪缓冲区
+ *
+ * 静态环形缓冲区, 写满后覆盖最旧的记录 (飞行记录仪方式)
+ * 写端只在关中断期间领取一个序号, 其余为普通存储, 不格式化、不加锁
+ * 读端 (dump / stream) 在复制记录前后各读一次 seq, 两次都等于序号 + 1 才接受,
+ * 复制期间被更高优先级线程覆盖或未写完的记录丢弃
+ */
+
+#include <rtthread.h>
+#include <stdlib.h>
+#include "common.h"
+#include "hrtime.h"
+#include "trace.h"
+
+#if (TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) != 0
+#error "TRACE_RING_SIZE must be a power of 2"
+#endif
+
+#define TRACE_RING_MASK (TRACE_RING_SIZE - 1)
+
+#define TRACE_THREAD_STACK_SIZE 2048
+#define TRACE_THREAD_PRIORITY   25
+#define TRACE_THREAD_TIMESLICE  5
+#define TRACE_STREAM_PERIOD_MS  100
+
+/* 事件格式, 下标为 enum trace_event; 参数总是按 TRACE_MAX_ARGS 个传入 */
+static const char *const trace_formats[TRACE_EVT_NUM] = {
+    "[Chassis] D1=%d D2=%d S1=%d S2=%d mr/s | T:%d,%d mr/s D:%d%%,%d%%\n",
+    "[Chassis] CFG gen=%d kp=%d ki=%d kd=%d ff=%d (x1000)\n",
+    "[Chassis] FAULT flags=0x%02x axes=0x%02x, output cut off\n",
+    "[Chassis] RATE %dHz gen=%d, PID re-initialised\n",
+};
+
+static struct trace_record trace_ring[TRACE_RING_SIZE];
+static volatile rt_uint32_t trace_head = 0; /* 下一条记录的序号 */
+static rt_uint32_t trace_base = 0;          /* trace clear 时的序号, 之前的记录不再输出 */
+
+volatile rt_uint8_t trace_level = TRACE_COMPILE_LEVEL;
+
+/* 流式输出 */
+static rt_thread_t trace_thread = RT_NULL;
+static volatile rt_bool_t trace_streaming = RT_FALSE;
+
+/**
+ * @brief 写入一条记录
+ */
+void trace_write(rt_uint8_t level, rt_uint16_t event, const rt_int32_t *args)
+{
+    struct trace_record *rec;
+    rt_base_t irq;
+    rt_uint32_t idx;
+    int i;
+
+    irq = rt_hw_interrupt_disable();
+    idx = trace_head++;
+    rt_hw_interrupt_enable(irq);
+
+    rec = &trace_ring[idx & TRACE_RING_MASK];
+    rec->seq = 0;
+    __sync_synchronize();
+
+    rec->tick = (rt_uint32_t)rt_tick_get();
+    rec->hr = (rt_uint32_t)hrtime_now();
+    rec->event = event;
+    rec->level = level;
+    for (i = 0; i < TRACE_MAX_ARGS; i++)
+    {
+        rec->arg[i] = args[i];
+    }
+
+    __sync_synchronize();
+    rec->seq = idx + 1;
+}
+
+void trace_set_level(rt_uint8_t level)
+{
+    trace_level = level > TRACE_LEVEL_DEBUG ? TRACE_LEVEL_DEBUG : level;
+}
+
+void trace_clear(void)
+{
+    trace_base = trace_head;
+}
+
+/**
+ * @brief 读取序号为 idx 的记录
+ * @return RT_EOK 成功, -RT_ERROR 已被覆盖或尚未写完
+ */
+static rt_err_t trace_read(rt_uint32_t idx, struct trace_record *out)
+{
+    volatile struct trace_record *rec = &trace_ring[idx & TRACE_RING_MASK];
+    rt_uint32_t seq;
+
+    seq = rec->seq;
+    if (seq != idx + 1)
+    {
+        return -RT_ERROR;
+    }
+    __sync_synchronize();
+    *out = *(struct trace_record *)rec;
+    __sync_synchronize();
+    /* 复制期间被覆盖时 seq 已变为 0 或新的序号 */
+    return rec->seq == seq ? RT_EOK : -RT_ERROR;
+}
+
+/**
+ * @brief 格式化输出一条记录 (非实时路径)
+ * @param prev_hr 上一条记录的 hr, 用于显示间隔
+ */
+static void trace_print(const struct trace_record *rec, rt_uint32_t prev_hr)
+{
+    const rt_int32_t *a = rec->arg;
+
+    rt_kprintf("%8u +%6uus ", rec->tick, hrtime_to_us(rec->hr - prev_hr));
+    if (rec->event < TRACE_EVT_NUM)
+    {
+        rt_kprintf(trace_formats[rec->event], a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+    }
+    else
+    {
+        rt_kprintf("event %d: %d %d %d %d %d %d %d %d\n", rec->event,
+                   a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+    }
+}
+
+/**
+ * @brief 输出 [from, to) 之间仍然有效的记录
+ * @return 实际读到的最后位置 (to)
+ */
+static rt_uint32_t trace_print_range(rt_uint32_t from, rt_uint32_t to, rt_uint32_t *prev_hr)
+{
+    struct trace_record rec;
+    rt_uint32_t lost = 0;
+
+    /* 超出缓冲区长度的部分已被覆盖 */
+    if (to - from > TRACE_RING_SIZE)
+    {
+        lost = to - from - TRACE_RING_SIZE;
+        from = to - TRACE_RING_SIZE;
+    }
+
+    for (; from != to; from++)
+    {
+        if (trace_read(from, &rec) != RT_EOK)
+        {
+            lost++;
+            continue;
+        }
+        trace_print(&rec, *prev_hr);
+        *prev_hr = rec.hr;
+    }
+
+    if (lost > 0)
+    {
+        rt_kprintf("[Trace] %u records lost\n", lost);
+    }
+    return to;
+}
+
+/**
+ * @brief 流式输出线程: 周期性输出新记录
+ */
+static void trace_thread_entry(void *parameter)
+{
+    rt_uint32_t cursor = trace_head;
+    rt_uint32_t prev_hr = 0;
+
+    (void)parameter;
+
+    while (1)
+    {
+        rt_thread_mdelay(TRACE_STREAM_PERIOD_MS);
+        if (!trace_streaming)
+        {
+            cursor = trace_head;
+            continue;
+        }
+        cursor = trace_print_range(cursor, trace_head, &prev_hr);
+    }
+}
+
+/* ================= 调试用 MSH 命令 ================= */
+
+/**
+ * @brief MSH 命令: 跟踪缓冲区
+ *        用法: trace [dump [n]|stream on|off|clear|level <0-3>]
+ */
+static void trace_cmd(int argc, char *argv[])
+{
+    rt_uint32_t head = trace_head;
+    rt_uint32_t from;
+    rt_uint32_t prev_hr = 0;
+    rt_uint32_t n;
+
+    if (argc < 2)
+    {
+        rt_kprintf("Usage: trace [dump [n]|stream on|off|clear|level <0-3>]\n");
+        rt_kprintf("Trace: level=%d (compile %d), records=%u, buffer=%d, streaming=%d\n",
+                   trace_level, TRACE_COMPILE_LEVEL, head - trace_base,
+                   TRACE_RING_SIZE, trace_streaming);
+        return;
+    }
+
+    if (rt_strcmp(argv[1], "dump") == 0)
+    {
+        from = trace_base;
+        if (argc >= 3)
+        {
+            n = (rt_uint32_t)atoi(argv[2]);
+            if (n < head - from)
+            {
+                from = head - n;
+            }
+        }
+        trace_print_range(from, head, &prev_hr);
+    }
+    else if (rt_strcmp(argv[1], "stream") == 0 && argc >= 3)
+    {
+        if (rt_strcmp(argv[2], "on") == 0)
+        {
+            if (trace_thread == RT_NULL)
+            {
+                trace_thread = rt_thread_create("trace", trace_thread_entry, RT_NULL,
+                                                TRACE_THREAD_STACK_SIZE, TRACE_THREAD_PRIORITY,
+                                                TRACE_THREAD_TIMESLICE);
+                if (trace_thread == RT_NULL)
+                {
+                    rt_kprintf("[Trace] Failed to create stream thread!\n");
+                    return;
+                }
+                rt_thread_startup(trace_thread);
+            }
+            trace_streaming = RT_TRUE;
+        }
+        else
+        {
+            trace_streaming = RT_FALSE;
+        }
+    }
+    else if (rt_strcmp(argv[1], "clear") == 0)
+    {
+        trace_clear();
+    }
+    else if (rt_strcmp(argv[1], "level") == 0 && argc >= 3)
+    {
+        trace_set_level((rt_uint8_t)atoi(argv[2]));
+        rt_kprintf("[Trace] Level set to %d\n", trace_level);
+    }
+    else
+    {
+        rt_kprintf("Usage: trace [dump [n]|stream on|off|clear|level <0-3>]\n");
+    }
+}
+MSH_CMD_EXPORT_ALIAS(trace_cmd, trace, Dump stream or clear the binary trace buffer);